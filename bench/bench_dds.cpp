@@ -0,0 +1,699 @@
+// End-to-end DDS on loopback: sustained throughput, loss and latency
+// percentiles between a publisher and a subscriber in separate processes.
+//
+//   ./bench_dds [--mode throughput|pingpong|all] [--messages N] [--rate msgs/s]
+//               [--qos <profile>] [--format sensor|stamps|nlohmann] [--size <bytes>]
+//               [--batch N] [--domain <id>] [--json <file>|-]
+//
+// throughput: the parent publishes --messages samples (paced with --rate,
+// flushed every --batch writes) and a forked subscriber takes and parses
+// them. Each sample carries its send time (steady clock, shared by the
+// processes) in "timestamp", so the subscriber records one-way latency; an
+// unpaced run measures queueing as much as transport.
+//
+// pingpong: the parent writes a ping, a forked echo process writes it back
+// on a second topic, and the parent waits for it before the next ping (or
+// for the next --rate slot). Round-trip percentiles, first 100 excluded.
+//
+// --format picks the codec on both sides (message_codec, the same with
+// stage stamps, or nlohmann::json); --size pads messages with a "pad" key,
+// which readers skip. Children are forked before the parent touches DDS.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <dds/dds.h>
+#include "telemetry.h"
+
+#include "dds_bootstrap.h"
+#include "message_codec.h"
+#include "telemetry_types.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* THROUGHPUT_TOPIC = "bench_dds";
+constexpr const char* PING_TOPIC = "bench_dds_ping";
+constexpr const char* PONG_TOPIC = "bench_dds_pong";
+constexpr int TAKE_BATCH = 64;
+constexpr int WARMUP_PINGS = 100;
+constexpr auto IDLE_TIMEOUT = std::chrono::seconds(1);
+constexpr auto START_TIMEOUT = std::chrono::seconds(10);
+constexpr auto MATCH_TIMEOUT = std::chrono::seconds(10);
+constexpr auto PONG_TIMEOUT = std::chrono::seconds(1);
+// Stop pinging a peer that has gone away
+constexpr uint64_t MAX_CONSECUTIVE_TIMEOUTS = 10;
+
+enum class Mode { Throughput, PingPong };
+enum class Format { Sensor, Stamps, Nlohmann };
+
+const char* mode_name(Mode mode) {
+    return mode == Mode::Throughput ? "throughput" : "pingpong";
+}
+
+const char* format_name(Format format) {
+    switch (format) {
+        case Format::Sensor: return "sensor";
+        case Format::Stamps: return "stamps";
+        case Format::Nlohmann: return "nlohmann";
+    }
+    return "?";
+}
+
+struct Options {
+    std::vector<Mode> modes = {Mode::Throughput, Mode::PingPong};
+    uint64_t messages = 100000;   // pings: a tenth of this
+    uint64_t rate = 0;
+    telemetry::QosProfile qos = telemetry::QosProfile::HighThroughput;
+    Format format = Format::Sensor;
+    size_t size = 0;              // 0 = unpadded
+    uint64_t batch = 64;
+    dds_domainid_t domain = DDS_DOMAIN_DEFAULT;
+    std::string json_path;
+};
+
+// Order statistics of a latency sample, in ns. Sent through a pipe, so POD.
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean = 0.0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+};
+
+// What a child reports back through its result pipe
+struct ChildResult {
+    uint64_t received = 0;        // valid samples taken (echoed, for pingpong)
+    uint64_t parse_failures = 0;
+    uint64_t bytes = 0;
+    int64_t first_ns = 0;
+    int64_t last_ns = 0;
+    uint64_t cpu_us = 0;
+    LatencySummary latency;       // one-way, throughput only
+};
+
+uint64_t cpu_time_us() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           static_cast<uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+LatencySummary summarize(std::vector<uint64_t>& samples) {
+    LatencySummary s;
+    if (samples.empty()) {
+        return s;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<size_t>(q * static_cast<double>(samples.size() - 1))]; };
+    double sum = 0.0;
+    for (uint64_t v : samples) sum += static_cast<double>(v);
+    s.count = samples.size();
+    s.mean = sum / static_cast<double>(samples.size());
+    s.p50 = at(0.50);
+    s.p90 = at(0.90);
+    s.p99 = at(0.99);
+    s.p999 = at(0.999);
+    s.max = samples.back();
+    return s;
+}
+
+// ========== PAYLOADS ==========
+
+// Encodes sample `sequence` sent at `sent_ns` into `out`, padded to
+// options.size. Returns the length (without the NUL).
+size_t encode(const Options& options, std::vector<char>& out, uint64_t sequence, int64_t sent_ns) {
+    SensorData data{1, 21.5 + static_cast<double>(sequence % 100) * 0.01, static_cast<long>(sent_ns)};
+    telemetry::StageStamps stamps;
+    if (options.format == Format::Stamps) {
+        stamps.present = true;
+        stamps.sampled_us = telemetry::wall_clock_us();
+        stamps.enqueued_us = stamps.dequeued_us = stamps.written_us = stamps.sampled_us;
+    }
+    size_t len = telemetry::encode_sensor_message(out.data(), out.size(), data, sequence,
+                                                  options.format == Format::Stamps ? &stamps : nullptr);
+    // ',"pad":""' adds 9 bytes around the padding itself
+    size_t pad = options.size > len + 9 ? options.size - len - 9 : 0;
+    if (options.format == Format::Nlohmann) {
+        nlohmann::json j;
+        j["id"] = data.id;
+        j["sequence"] = sequence;
+        j["timestamp"] = data.timestamp;
+        j["value"] = data.value;
+        if (pad > 0) {
+            j["pad"] = std::string(pad, 'x');
+        }
+        std::string text = j.dump();
+        std::memcpy(out.data(), text.c_str(), text.size() + 1);
+        return text.size();
+    }
+    if (pad > 0) {
+        std::string tail = ",\"pad\":\"" + std::string(pad, 'x') + "\"}";
+        std::memcpy(out.data() + len - 1, tail.c_str(), tail.size() + 1);
+        len += tail.size() - 1;
+    }
+    return len;
+}
+
+bool decode(Format format, const char* payload, SensorData& data, uint64_t& sequence) {
+    if (format != Format::Nlohmann) {
+        telemetry::StageStamps stamps;
+        return telemetry::parse_sensor_message(payload, data, sequence, format == Format::Stamps ? &stamps : nullptr);
+    }
+    try {
+        nlohmann::json j = nlohmann::json::parse(payload);
+        data.id = j.at("id").get<int>();
+        data.value = j.at("value").get<double>();
+        data.timestamp = j.at("timestamp").get<long>();
+        sequence = j.at("sequence").get<uint64_t>();
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// ========== DDS HELPERS ==========
+
+// Blocks until `reader` has data, through a waitset with a read condition
+class ReaderWait {
+public:
+    ReaderWait(dds_entity_t participant, dds_entity_t reader) {
+        waitset_ = dds_create_waitset(participant);
+        condition_ = dds_create_readcondition(reader, DDS_ANY_STATE);
+        dds_waitset_attach(waitset_, condition_, reader);
+    }
+    ~ReaderWait() {
+        dds_waitset_detach(waitset_, condition_);
+        dds_delete(condition_);
+        dds_delete(waitset_);
+    }
+    bool wait(std::chrono::milliseconds timeout) {
+        dds_attach_t triggered;
+        return dds_waitset_wait(waitset_, &triggered, 1, DDS_MSECS(timeout.count())) > 0;
+    }
+
+private:
+    dds_entity_t waitset_ = 0;
+    dds_entity_t condition_ = 0;
+};
+
+template <typename Ready>
+bool wait_until(Ready ready, std::chrono::seconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (!ready()) {
+        if (Clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+bool writer_matched(dds_entity_t writer) {
+    dds_publication_matched_status_t status;
+    return dds_get_publication_matched_status(writer, &status) == DDS_RETCODE_OK && status.current_count > 0;
+}
+
+bool reader_matched(dds_entity_t reader) {
+    dds_subscription_matched_status_t status;
+    return dds_get_subscription_matched_status(reader, &status) == DDS_RETCODE_OK && status.current_count > 0;
+}
+
+bool open_session(telemetry::DdsSession& dds, const Options& options, const char* topic) {
+    std::streambuf* out = std::cout.rdbuf(nullptr);   // no "[DDS] ..." lines in the table
+    bool ok = dds.open(options.qos, options.domain, topic);
+    std::cout.rdbuf(out);
+    return ok;
+}
+
+// ========== CHILDREN ==========
+
+// A forked peer: waits for "go", opens DDS, reports "ready", runs, and
+// writes one ChildResult
+struct Child {
+    Mode mode;
+    pid_t pid = -1;
+    int go_fd = -1;       // parent -> child
+    int ready_fd = -1;    // child -> parent
+    int result_fd = -1;   // child -> parent
+};
+
+void run_subscriber(const Options& options, int ready_fd, ChildResult& result) {
+    telemetry::DdsSession dds;
+    if (!open_session(dds, options, THROUGHPUT_TOPIC)) ::_exit(1);
+    dds_entity_t reader = dds.create_reader();
+    ReaderWait wait(dds.participant(), reader);
+    char ready = 1;
+    (void)!::write(ready_fd, &ready, 1);
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(options.messages);
+    void* samples[TAKE_BATCH];
+    dds_sample_info_t infos[TAKE_BATCH];
+    uint64_t cpu_start = cpu_time_us();
+    auto last_data = Clock::now();
+    while (result.received < options.messages) {
+        if (!wait.wait(std::chrono::milliseconds(100))) {
+            if (Clock::now() - last_data > (result.received > 0 ? IDLE_TIMEOUT : START_TIMEOUT)) break;
+            continue;
+        }
+        std::fill(std::begin(samples), std::end(samples), nullptr);
+        int n = dds_take(reader, samples, infos, TAKE_BATCH, TAKE_BATCH);
+        int64_t taken_ns = now_ns();
+        for (int i = 0; i < n; ++i) {
+            if (!infos[i].valid_data) continue;
+            const char* payload = static_cast<Telemetry_JsonMessage*>(samples[i])->payload;
+            SensorData data;
+            uint64_t sequence;
+            if (payload == nullptr || !decode(options.format, payload, data, sequence)) {
+                result.parse_failures++;
+                continue;
+            }
+            result.bytes += std::strlen(payload);
+            latencies.push_back(taken_ns > data.timestamp ? static_cast<uint64_t>(taken_ns - data.timestamp) : 0);
+            if (result.received++ == 0) result.first_ns = taken_ns;
+            result.last_ns = taken_ns;
+        }
+        if (n > 0) {
+            dds_return_loan(reader, samples, n);
+            last_data = Clock::now();
+        }
+    }
+    result.cpu_us = cpu_time_us() - cpu_start;
+    result.latency = summarize(latencies);
+    dds.close();
+}
+
+// Writes every ping back unchanged
+void run_echo(const Options& options, int ready_fd, ChildResult& result) {
+    telemetry::DdsSession dds;
+    if (!open_session(dds, options, PING_TOPIC)) ::_exit(1);
+    dds_entity_t ping_reader = dds.create_reader();
+    dds_entity_t pong_writer = dds.create_writer(dds.create_topic(PONG_TOPIC), options.qos);
+    ReaderWait wait(dds.participant(), ping_reader);
+    char ready = 1;
+    (void)!::write(ready_fd, &ready, 1);
+
+    void* samples[TAKE_BATCH];
+    dds_sample_info_t infos[TAKE_BATCH];
+    uint64_t cpu_start = cpu_time_us();
+    auto last_data = Clock::now();
+    while (true) {
+        if (!wait.wait(std::chrono::milliseconds(100))) {
+            if (Clock::now() - last_data > (result.received > 0 ? IDLE_TIMEOUT + PONG_TIMEOUT : START_TIMEOUT)) break;
+            continue;
+        }
+        std::fill(std::begin(samples), std::end(samples), nullptr);
+        int n = dds_take(ping_reader, samples, infos, TAKE_BATCH, TAKE_BATCH);
+        for (int i = 0; i < n; ++i) {
+            if (!infos[i].valid_data) continue;
+            dds_write(pong_writer, samples[i]);
+            result.received++;
+        }
+        if (n > 0) {
+            dds.flush(pong_writer);
+            dds_return_loan(ping_reader, samples, n);
+            last_data = Clock::now();
+        }
+    }
+    result.cpu_us = cpu_time_us() - cpu_start;
+    dds.close();
+}
+
+Child fork_child(Mode mode, const Options& options) {
+    int go[2], ready[2], result[2];
+    Child child;
+    child.mode = mode;
+    if (::pipe(go) != 0 || ::pipe(ready) != 0 || ::pipe(result) != 0) {
+        std::cerr << "[ERROR] pipe failed\n";
+        return child;
+    }
+    child.pid = ::fork();
+    if (child.pid == 0) {
+        char go_byte;
+        if (::read(go[0], &go_byte, 1) != 1) ::_exit(0);   // parent gave up
+        ChildResult out;
+        if (mode == Mode::Throughput) {
+            run_subscriber(options, ready[1], out);
+        } else {
+            run_echo(options, ready[1], out);
+        }
+        (void)!::write(result[1], &out, sizeof(out));
+        ::_exit(0);
+    }
+    ::close(go[0]);
+    ::close(ready[1]);
+    ::close(result[1]);
+    child.go_fd = go[1];
+    child.ready_fd = ready[0];
+    child.result_fd = result[0];
+    return child;
+}
+
+// Starts the child and waits until its endpoints exist
+bool start_child(const Child& child) {
+    char byte = 1;
+    return child.pid > 0 && ::write(child.go_fd, &byte, 1) == 1 && ::read(child.ready_fd, &byte, 1) == 1;
+}
+
+bool finish_child(Child& child, ChildResult& result) {
+    bool ok = child.pid > 0 && ::read(child.result_fd, &result, sizeof(result)) == sizeof(result);
+    for (int fd : {child.go_fd, child.ready_fd, child.result_fd}) {
+        if (fd >= 0) ::close(fd);
+    }
+    if (child.pid > 0) ::waitpid(child.pid, nullptr, 0);
+    child.pid = -1;
+    return ok;
+}
+
+// Waits for the next --rate slot
+void pace(uint64_t rate, int64_t start_ns, uint64_t sent) {
+    if (rate == 0) return;
+    int64_t due = start_ns + static_cast<int64_t>(static_cast<double>(sent) * 1e9 / static_cast<double>(rate));
+    while (now_ns() < due) {
+        std::this_thread::yield();
+    }
+}
+
+// ========== MODES ==========
+
+nlohmann::json latency_json(const LatencySummary& s) {
+    return {{"count", s.count}, {"mean_us", s.mean / 1e3}, {"p50_us", s.p50 / 1e3}, {"p90_us", s.p90 / 1e3},
+            {"p99_us", s.p99 / 1e3}, {"p999_us", s.p999 / 1e3}, {"max_us", s.max / 1e3}};
+}
+
+void print_latency(const char* label, const LatencySummary& s) {
+    std::cout << "  " << label << " (us): mean " << std::fixed << std::setprecision(1) << s.mean / 1e3
+              << ", p50 " << s.p50 / 1e3 << ", p90 " << s.p90 / 1e3 << ", p99 " << s.p99 / 1e3
+              << ", p99.9 " << s.p999 / 1e3 << ", max " << s.max / 1e3 << "  (" << s.count << " samples)\n";
+}
+
+bool run_throughput(Child& child, const Options& options, nlohmann::json& report) {
+    if (!start_child(child)) {
+        std::cerr << "[ERROR] throughput: subscriber failed to start\n";
+        return false;
+    }
+    telemetry::DdsSession dds;
+    ChildResult result;
+    if (!open_session(dds, options, THROUGHPUT_TOPIC)) {
+        finish_child(child, result);
+        return false;
+    }
+    dds_entity_t writer = dds.create_writer();
+    if (!wait_until([&] { return writer_matched(writer); }, MATCH_TIMEOUT)) {
+        std::cerr << "[ERROR] throughput: subscriber never matched\n";
+    }
+
+    std::vector<char> payload(std::max(options.size + 1, telemetry::MAX_SENSOR_MESSAGE));
+    uint64_t write_errors = 0;
+    uint64_t bytes = 0;
+    uint64_t cpu_start = cpu_time_us();
+    int64_t start_ns = now_ns();
+    for (uint64_t seq = 0; seq < options.messages; ++seq) {
+        pace(options.rate, start_ns, seq);
+        bytes += encode(options, payload, seq, now_ns());
+        Telemetry_JsonMessage msg;
+        msg.payload = payload.data();
+        if (dds_write(writer, &msg) != DDS_RETCODE_OK) write_errors++;
+        if ((seq + 1) % options.batch == 0) dds.flush(writer);
+    }
+    dds.flush(writer);
+    int64_t sent_ns = now_ns();
+    uint64_t sender_cpu = cpu_time_us() - cpu_start;
+
+    bool have_result = finish_child(child, result);
+    dds.close();
+    if (!have_result) {
+        std::cerr << "[ERROR] throughput: no result from the subscriber\n";
+        return false;
+    }
+
+    uint64_t sent = options.messages;
+    int64_t end_ns = result.received > 0 ? std::max(result.last_ns, sent_ns) : sent_ns;
+    double seconds = static_cast<double>(end_ns - start_ns) / 1e9;
+    double rx_rate = seconds > 0 ? static_cast<double>(result.received) / seconds : 0.0;
+    double tx_rate = sent_ns > start_ns ? static_cast<double>(sent) * 1e9 / static_cast<double>(sent_ns - start_ns) : 0.0;
+    double loss = 100.0 * static_cast<double>(sent - std::min(sent, result.received)) / static_cast<double>(sent);
+    double mb_per_s = seconds > 0 ? static_cast<double>(result.bytes) / seconds / 1e6 : 0.0;
+
+    std::cout << "throughput: " << result.received << "/" << sent << " received (" << std::fixed
+              << std::setprecision(2) << loss << "% lost), " << std::setprecision(0) << rx_rate << " msgs/s ("
+              << std::setprecision(1) << mb_per_s << " MB/s), sender " << std::setprecision(0) << tx_rate
+              << " msgs/s\n";
+    std::cout << "  CPU per message (ns): tx " << sender_cpu * 1000.0 / static_cast<double>(sent) << ", rx "
+              << (result.received > 0 ? result.cpu_us * 1000.0 / static_cast<double>(result.received) : 0.0)
+              << "; avg payload " << bytes / std::max<uint64_t>(1, sent) << " B";
+    if (write_errors > 0 || result.parse_failures > 0) {
+        std::cout << "; write errors " << write_errors << ", parse failures " << result.parse_failures;
+    }
+    std::cout << "\n";
+    print_latency("one-way latency", result.latency);
+
+    report["throughput"] = {{"sent", sent},
+                            {"received", result.received},
+                            {"loss_percent", loss},
+                            {"msgs_per_sec", rx_rate},
+                            {"sender_msgs_per_sec", tx_rate},
+                            {"mb_per_sec", mb_per_s},
+                            {"avg_payload_bytes", bytes / std::max<uint64_t>(1, sent)},
+                            {"tx_cpu_ns_per_msg", sender_cpu * 1000.0 / static_cast<double>(sent)},
+                            {"rx_cpu_ns_per_msg", result.received > 0 ? result.cpu_us * 1000.0 / result.received : 0.0},
+                            {"write_errors", write_errors},
+                            {"parse_failures", result.parse_failures},
+                            {"one_way_latency", latency_json(result.latency)}};
+    return true;
+}
+
+bool run_pingpong(Child& child, const Options& options, nlohmann::json& report) {
+    if (!start_child(child)) {
+        std::cerr << "[ERROR] pingpong: echo process failed to start\n";
+        return false;
+    }
+    telemetry::DdsSession dds;
+    ChildResult result;
+    if (!open_session(dds, options, PING_TOPIC)) {
+        finish_child(child, result);
+        return false;
+    }
+    dds_entity_t ping_writer = dds.create_writer();
+    dds_entity_t pong_reader = dds.create_reader(dds.create_topic(PONG_TOPIC), options.qos);
+    if (!wait_until([&] { return writer_matched(ping_writer) && reader_matched(pong_reader); }, MATCH_TIMEOUT)) {
+        std::cerr << "[ERROR] pingpong: echo process never matched\n";
+    }
+    ReaderWait wait(dds.participant(), pong_reader);
+
+    uint64_t pings = std::max<uint64_t>(options.messages / 10, WARMUP_PINGS + 1);
+    std::vector<uint64_t> rtts;
+    rtts.reserve(pings);
+    std::vector<char> payload(std::max(options.size + 1, telemetry::MAX_SENSOR_MESSAGE));
+    void* samples[TAKE_BATCH];
+    dds_sample_info_t infos[TAKE_BATCH];
+    uint64_t timeouts = 0;
+    uint64_t consecutive_timeouts = 0;
+    uint64_t sent = 0;
+    int64_t start_ns = now_ns();
+    for (uint64_t seq = 0; seq < pings && consecutive_timeouts < MAX_CONSECUTIVE_TIMEOUTS; ++seq) {
+        pace(options.rate, start_ns, seq);
+        encode(options, payload, seq, now_ns());
+        Telemetry_JsonMessage msg;
+        msg.payload = payload.data();
+        dds_write(ping_writer, &msg);
+        dds.flush(ping_writer);
+        sent++;
+
+        // Late pongs of pings that already timed out are skipped
+        bool answered = false;
+        auto deadline = Clock::now() + PONG_TIMEOUT;
+        while (!answered && Clock::now() < deadline) {
+            if (!wait.wait(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()))) break;
+            std::fill(std::begin(samples), std::end(samples), nullptr);
+            int n = dds_take(pong_reader, samples, infos, TAKE_BATCH, TAKE_BATCH);
+            int64_t taken_ns = now_ns();
+            for (int i = 0; i < n; ++i) {
+                const char* pong = static_cast<Telemetry_JsonMessage*>(samples[i])->payload;
+                SensorData data;
+                uint64_t sequence;
+                if (infos[i].valid_data && pong != nullptr && decode(options.format, pong, data, sequence) &&
+                    sequence == seq) {
+                    answered = true;
+                    if (seq >= static_cast<uint64_t>(WARMUP_PINGS)) {
+                        rtts.push_back(static_cast<uint64_t>(taken_ns - data.timestamp));
+                    }
+                }
+            }
+            if (n > 0) dds_return_loan(pong_reader, samples, n);
+        }
+        if (answered) {
+            consecutive_timeouts = 0;
+        } else {
+            timeouts++;
+            consecutive_timeouts++;
+        }
+    }
+    if (consecutive_timeouts >= MAX_CONSECUTIVE_TIMEOUTS) {
+        std::cerr << "[ERROR] pingpong: " << MAX_CONSECUTIVE_TIMEOUTS << " pings in a row unanswered, stopping\n";
+    }
+
+    finish_child(child, result);
+    dds.close();
+
+    LatencySummary rtt = summarize(rtts);
+    std::cout << "pingpong: " << sent << " pings, " << timeouts << " timed out (" << PONG_TIMEOUT.count()
+              << " s), first " << WARMUP_PINGS << " not counted\n";
+    print_latency("round trip", rtt);
+    std::cout << "  one way ~ round trip / 2: p50 " << std::fixed << std::setprecision(1) << rtt.p50 / 2e3
+              << " us, p99 " << rtt.p99 / 2e3 << " us\n";
+
+    report["pingpong"] = {{"pings", sent},
+                          {"timeouts", timeouts},
+                          {"warmup", WARMUP_PINGS},
+                          {"echoed", result.received},
+                          {"round_trip", latency_json(rtt)}};
+    return true;
+}
+
+void print_usage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
+    std::cout << "Options:\n";
+    std::cout << "  --mode <m>       throughput, pingpong or all (default: all)\n";
+    std::cout << "  --messages <n>   Samples for throughput; pingpong sends a tenth as many pings\n";
+    std::cout << "                   (default: 100000)\n";
+    std::cout << "  --rate <n>       Messages (or pings) per second; 0 = as fast as possible (default)\n";
+    std::cout << "  --qos <profile>  DDS QoS profile for both sides (default: high-throughput)\n";
+    std::cout << telemetry::qos_profile_help();
+    std::cout << "  --format <f>     sensor (message_codec, default), stamps (with stage stamps)\n";
+    std::cout << "                   or nlohmann (nlohmann::json on both sides)\n";
+    std::cout << "  --size <bytes>   Pad messages to about this size with a \"pad\" key\n";
+    std::cout << "  --batch <n>      Flush the writer every n writes (batching profiles; default: 64)\n";
+    std::cout << "  --domain <id>    DDS domain (default: the default domain)\n";
+    std::cout << "  --json <file>    Also write the results as JSON ('-' for stdout)\n";
+    std::cout << "  --help           Show this help message\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "throughput") options.modes = {Mode::Throughput};
+            else if (mode == "pingpong") options.modes = {Mode::PingPong};
+            else if (mode != "all") {
+                std::cerr << "[ERROR] Unknown mode: " << mode << "\n";
+                return 1;
+            }
+        } else if (arg == "--messages" && i + 1 < argc) {
+            options.messages = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.rate = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--qos" && i + 1 < argc) {
+            if (!telemetry::parse_qos_profile(argv[++i], options.qos)) {
+                std::cerr << "[ERROR] Unknown QoS profile: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "sensor") options.format = Format::Sensor;
+            else if (format == "stamps") options.format = Format::Stamps;
+            else if (format == "nlohmann") options.format = Format::Nlohmann;
+            else {
+                std::cerr << "[ERROR] Unknown format: " << format << "\n";
+                return 1;
+            }
+        } else if (arg == "--size" && i + 1 < argc) {
+            options.size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.batch = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--domain" && i + 1 < argc) {
+            if (!telemetry::parse_domain_id(argv[++i], options.domain)) {
+                std::cerr << "[ERROR] Invalid domain id: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--json" && i + 1 < argc) {
+            options.json_path = argv[++i];
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "[ERROR] Unknown option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Every child before the first participant: forking a process that
+    // already runs Cyclone's threads is not safe
+    std::vector<Child> children;
+    for (Mode mode : options.modes) {
+        children.push_back(fork_child(mode, options));
+    }
+
+    // With --json -, the report goes to stderr so stdout stays parseable
+    std::streambuf* out = std::cout.rdbuf();
+    if (options.json_path == "-") {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    std::cout << "Loopback, " << telemetry::qos_profile_name(options.qos) << ", " << format_name(options.format)
+              << " payloads" << (options.size > 0 ? " padded to " + std::to_string(options.size) + " B" : "")
+              << ", batch " << options.batch << ", "
+              << (options.rate > 0 ? std::to_string(options.rate) + " msgs/s" : std::string("unpaced")) << "\n\n";
+
+    nlohmann::json report;
+    report["benchmark"] = "bench_dds";
+    nlohmann::json modes = nlohmann::json::array();
+    for (Mode mode : options.modes) {
+        modes.push_back(mode_name(mode));
+    }
+    report["config"] = {{"modes", modes},
+                        {"qos", telemetry::qos_profile_name(options.qos)},
+                        {"format", format_name(options.format)},
+                        {"size", options.size},
+                        {"batch", options.batch},
+                        {"rate", options.rate},
+                        {"messages", options.messages},
+                        {"domain", telemetry::domain_label(options.domain)}};
+    bool ok = true;
+    for (Child& child : children) {
+        ok = (child.mode == Mode::Throughput ? run_throughput(child, options, report)
+                                             : run_pingpong(child, options, report)) && ok;
+        std::cout << "\n";
+    }
+    std::cout << "Latency is steady-clock time from before dds_write to after dds_take; "
+                 "an unpaced run mostly measures queueing.\n";
+    std::cout.rdbuf(out);
+
+    if (!options.json_path.empty()) {
+        std::string text = report.dump(2);
+        if (options.json_path == "-") {
+            std::cout << text << "\n";
+        } else {
+            std::ofstream file(options.json_path);
+            file << text << "\n";
+            if (!file) {
+                std::cerr << "[ERROR] Failed to write " << options.json_path << "\n";
+                return 1;
+            }
+            std::cout << "Results written to " << options.json_path << "\n";
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Throughput of the block kernels (kernels.h) for every ISA this CPU runs.
+//
+//   ./bench_kernels [--iterations N]
+//
+// Each kernel runs over blocks sized to sit in L1 (16 KiB), L2 (256 KiB)
+// and main memory (64 MiB); the figure is input bandwidth in GB/s, with the
+// speedup over the scalar variant on the same block.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "kernels.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using telemetry::Isa;
+using telemetry::Kernels;
+
+// Keeps results alive so the compiler can't drop the work
+volatile double g_sink = 0.0;
+
+struct Block {
+    const char* label;
+    size_t values;
+};
+
+struct Op {
+    const char* name;
+    double (*run)(const Kernels& k, const double* values, size_t n);
+};
+
+uint64_t g_buckets[64];
+
+const Op OPS[] = {
+    {"min", [](const Kernels& k, const double* v, size_t n) { return k.min(v, n); }},
+    {"max", [](const Kernels& k, const double* v, size_t n) { return k.max(v, n); }},
+    {"sum", [](const Kernels& k, const double* v, size_t n) { return k.sum(v, n); }},
+    {"sum_squares", [](const Kernels& k, const double* v, size_t n) { return k.sum_squares(v, n); }},
+    {"count_in_range",
+     [](const Kernels& k, const double* v, size_t n) { return static_cast<double>(k.count_in_range(v, n, 0.0, 40.0)); }},
+    {"histogram",
+     [](const Kernels& k, const double* v, size_t n) {
+         k.histogram(v, n, -10.0, 50.0, g_buckets, 64);
+         return static_cast<double>(g_buckets[0]);
+     }},
+};
+
+// Best-of-iterations GB/s, with enough repeats per timing that small
+// blocks aren't dominated by clock overhead
+double measure(const Op& op, const Kernels& k, const std::vector<double>& values, size_t n, int iterations) {
+    size_t repeats = std::max<size_t>(1, (1u << 24) / n);
+    double best_ns = 1e30;
+    for (int it = 0; it < iterations; ++it) {
+        auto start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r) {
+            g_sink = g_sink + op.run(k, values.data(), n);
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / repeats;
+        best_ns = std::min(best_ns, ns);
+    }
+    return static_cast<double>(n * sizeof(double)) / best_ns;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--iterations N]\n";
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    const Block blocks[] = {{"L1", 2048}, {"L2", 32768}, {"memory", 8u << 20}};
+    std::vector<double> values(blocks[2].values);
+    std::mt19937 rng(42);
+    std::normal_distribution<double> dist(20.0, 15.0);
+    for (double& v : values) {
+        v = dist(rng);
+    }
+
+    std::vector<const Kernels*> variants;
+    for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (const Kernels* k = telemetry::kernels_for(isa)) {
+            variants.push_back(k);
+        }
+    }
+    std::cout << "[Bench] dispatch picks " << telemetry::isa_name(telemetry::kernels().isa) << ", "
+              << iterations << " iterations, GB/s of input\n";
+
+    for (const Block& block : blocks) {
+        std::cout << "\n  " << block.label << " block (" << block.values << " values)\n";
+        for (const Op& op : OPS) {
+            double scalar = 0.0;
+            std::cout << "  " << std::left << std::setw(16) << op.name << std::right;
+            for (const Kernels* k : variants) {
+                double gbps = measure(op, *k, values, block.values, iterations);
+                if (k->isa == Isa::Scalar) {
+                    scalar = gbps;
+                }
+                std::cout << "  " << std::setw(6) << telemetry::isa_name(k->isa) << std::fixed
+                          << std::setprecision(2) << std::setw(8) << gbps;
+                if (k->isa != Isa::Scalar && scalar > 0.0) {
+                    std::cout << " (" << std::setprecision(1) << gbps / scalar << "x)";
+                }
+            }
+            std::cout << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Work-stealing pool vs. naive thread spawning.
+//
+//   ./bench_thread_pool [--threads N] [--iterations N]
+//
+// Three workloads:
+//   tasks      many small independent tasks (pool submit vs. one std::thread each)
+//   uniform    sum over a large array (parallel_for vs. N threads spawned per call)
+//   skewed     per-element cost grows along the range, so static partitions
+//              leave threads idle while stealing rebalances
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_us(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Keeps results alive so the compiler can't drop the work
+std::atomic<double> g_sink{0.0};
+
+double small_task_work(size_t seed) {
+    double x = static_cast<double>(seed);
+    for (int i = 0; i < 256; ++i) {
+        x = x * 1.0000001 + 0.5;
+    }
+    return x;
+}
+
+double skewed_cost(size_t i, size_t n) {
+    // Element i costs ~ (i / n)^2 * 500 iterations
+    size_t rounds = 1 + (i * i / n) * 500 / n;
+    double x = static_cast<double>(i);
+    for (size_t r = 0; r < rounds; ++r) {
+        x = std::sqrt(x + 1.0);
+    }
+    return x;
+}
+
+// Splits [0, n) into `threads` equal slices, one freshly spawned thread each
+template <typename Fn>
+void spawn_static(size_t threads, size_t n, Fn fn) {
+    std::vector<std::thread> pool;
+    size_t slice = (n + threads - 1) / threads;
+    for (size_t t = 0; t < threads; ++t) {
+        size_t lo = t * slice;
+        size_t hi = std::min(n, lo + slice);
+        if (lo >= hi) break;
+        pool.emplace_back([=] { fn(lo, hi); });
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+void report(const std::string& workload, const std::string& variant, double value, const char* unit,
+            double baseline) {
+    std::cout << "  " << std::left << std::setw(10) << workload << std::setw(22) << variant << std::right
+              << std::fixed << std::setprecision(2) << std::setw(12) << value << " " << unit;
+    if (baseline > 0.0) {
+        std::cout << "   (" << std::setprecision(1) << baseline / value << "x vs. baseline)";
+    }
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    int iterations = 10;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--threads N] [--iterations N]\n";
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    telemetry::ThreadPool pool(threads, "bench");
+    std::cout << "[Bench] " << threads << " threads, " << iterations << " iterations\n";
+
+    // ========== SMALL TASKS ==========
+    {
+        constexpr size_t TASKS = 20000;
+        constexpr size_t SPAWNED = 2000;   // one thread per task is slow; measure fewer
+
+        auto start = Clock::now();
+        for (size_t i = 0; i < SPAWNED; ++i) {
+            std::thread t([i] { g_sink = g_sink + small_task_work(i); });
+            t.join();
+        }
+        double spawn_us = elapsed_us(start) / SPAWNED;
+        report("tasks", "std::thread per task", spawn_us, "us/task", 0.0);
+
+        double best = 1e30;
+        for (int it = 0; it < iterations; ++it) {
+            std::atomic<size_t> done{0};
+            start = Clock::now();
+            for (size_t i = 0; i < TASKS; ++i) {
+                pool.submit([i, &done] {
+                    g_sink = g_sink + small_task_work(i);
+                    done.fetch_add(1, std::memory_order_release);
+                });
+            }
+            pool.run_until([&] { return done.load(std::memory_order_acquire) == TASKS; });
+            best = std::min(best, elapsed_us(start) / TASKS);
+        }
+        report("tasks", "pool submit", best, "us/task", spawn_us);
+    }
+
+    // ========== UNIFORM DATA-PARALLEL ==========
+    {
+        std::vector<double> values(1 << 24);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<double>(i % 1000) * 0.001;
+        }
+        auto sum_range = [&](size_t lo, size_t hi) {
+            double sum = 0.0;
+            for (size_t i = lo; i < hi; ++i) sum += values[i];
+            g_sink = g_sink + sum;
+        };
+
+        double sequential = 1e30, spawned = 1e30, pooled = 1e30;
+        for (int it = 0; it < iterations; ++it) {
+            auto start = Clock::now();
+            sum_range(0, values.size());
+            sequential = std::min(sequential, elapsed_us(start) / 1000.0);
+
+            start = Clock::now();
+            spawn_static(threads, values.size(), sum_range);
+            spawned = std::min(spawned, elapsed_us(start) / 1000.0);
+
+            start = Clock::now();
+            telemetry::parallel_for(pool, 0, values.size(), 0, sum_range);
+            pooled = std::min(pooled, elapsed_us(start) / 1000.0);
+        }
+        report("uniform", "sequential", sequential, "ms", 0.0);
+        report("uniform", "spawn + static split", spawned, "ms", sequential);
+        report("uniform", "parallel_for", pooled, "ms", sequential);
+    }
+
+    // ========== SKEWED DATA-PARALLEL ==========
+    {
+        constexpr size_t N = 200000;
+        auto skewed_range = [](size_t lo, size_t hi) {
+            double sum = 0.0;
+            for (size_t i = lo; i < hi; ++i) sum += skewed_cost(i, N);
+            g_sink = g_sink + sum;
+        };
+
+        double sequential = 1e30, spawned = 1e30, pooled = 1e30;
+        for (int it = 0; it < iterations; ++it) {
+            auto start = Clock::now();
+            skewed_range(0, N);
+            sequential = std::min(sequential, elapsed_us(start) / 1000.0);
+
+            start = Clock::now();
+            spawn_static(threads, N, skewed_range);
+            spawned = std::min(spawned, elapsed_us(start) / 1000.0);
+
+            start = Clock::now();
+            telemetry::parallel_for(pool, 0, N, 0, skewed_range);
+            pooled = std::min(pooled, elapsed_us(start) / 1000.0);
+        }
+        report("skewed", "sequential", sequential, "ms", 0.0);
+        report("skewed", "spawn + static split", spawned, "ms", sequential);
+        report("skewed", "parallel_for", pooled, "ms", sequential);
+    }
+
+    telemetry::ThreadPool::Stats stats = pool.stats();
+    std::cout << "[Bench] pool executed " << stats.executed << " tasks (" << stats.stolen
+              << " stolen), caller helped with " << stats.helped << "\n";
+    return 0;
+}
@@ -0,0 +1,275 @@
+// Batched UDP (udp_transport.h) against DDS on loopback: messages per
+// second and CPU per message on each side.
+//
+//   ./bench_udp [--messages N] [--mode udp|udp-gso|dds|all] [--rate msgs/s]
+//
+// Each mode forks a receiver process, so neither side shares an address
+// space (Cyclone would otherwise deliver in-process without touching the
+// network). The sender publishes encoded sensor messages as fast as it can
+// (or at --rate), flushing after each 64. UDP drops what the receive buffer
+// cannot hold, so the loss column matters as much as the rate. DDS uses the
+// high-throughput profile (reliable, KEEP_ALL, writer batching).
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <dds/dds.h>
+#include "telemetry.h"
+
+#include "dds_bootstrap.h"
+#include "message_codec.h"
+#include "telemetry_types.h"
+#include "udp_transport.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int FLUSH_EVERY = 64;
+constexpr auto IDLE_TIMEOUT = std::chrono::seconds(1);
+constexpr auto START_TIMEOUT = std::chrono::seconds(10);
+constexpr const char* BENCH_TOPIC = "bench_udp_vs_dds";
+
+enum class Mode { Udp, UdpGso, Dds };
+
+const char* mode_name(Mode mode) {
+    switch (mode) {
+        case Mode::Udp: return "udp (sendmmsg)";
+        case Mode::UdpGso: return "udp (GSO)";
+        case Mode::Dds: return "dds";
+    }
+    return "?";
+}
+
+// What the receiver reports back through the pipe
+struct ReceiverResult {
+    uint64_t received = 0;
+    int64_t last_ns = 0;       // steady clock, comparable across processes
+    uint64_t cpu_us = 0;
+    uint64_t syscalls = 0;
+};
+
+uint64_t cpu_time_us() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           static_cast<uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Receives until `expected` messages arrived or the stream went quiet
+template <typename Take>
+ReceiverResult receive_loop(uint64_t expected, Take take) {
+    ReceiverResult result;
+    uint64_t cpu_start = cpu_time_us();
+    auto last_data = Clock::now();
+    while (result.received < expected) {
+        uint64_t got = take();
+        auto now = Clock::now();
+        if (got > 0) {
+            result.received += got;
+            result.last_ns = now_ns();
+            last_data = now;
+        } else if (now - last_data > (result.received > 0 ? IDLE_TIMEOUT : START_TIMEOUT)) {
+            break;
+        }
+    }
+    result.cpu_us = cpu_time_us() - cpu_start;
+    return result;
+}
+
+sockaddr_in bench_address() {
+    sockaddr_in addr{};
+    telemetry::parse_udp_address("127.0.0.1:17499", "127.0.0.1", addr);
+    return addr;
+}
+
+void run_receiver(Mode mode, uint64_t expected, int ready_fd, int result_fd) {
+    ReceiverResult result;
+    char ready = 1;
+    if (mode == Mode::Dds) {
+        telemetry::DdsSession dds;
+        if (!dds.open(telemetry::QosProfile::HighThroughput, DDS_DOMAIN_DEFAULT, BENCH_TOPIC)) {
+            ::_exit(1);
+        }
+        dds_entity_t reader = dds.create_reader();
+        (void)!::write(ready_fd, &ready, 1);
+        void* samples[FLUSH_EVERY] = {};
+        dds_sample_info_t infos[FLUSH_EVERY];
+        result = receive_loop(expected, [&]() -> uint64_t {
+            std::fill(std::begin(samples), std::end(samples), nullptr);
+            int n = dds_take(reader, samples, infos, FLUSH_EVERY, FLUSH_EVERY);
+            if (n <= 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                return 0;
+            }
+            uint64_t valid = 0;
+            for (int i = 0; i < n; ++i) valid += infos[i].valid_data ? 1 : 0;
+            dds_return_loan(reader, samples, n);
+            return valid;
+        });
+    } else {
+        telemetry::UdpReceiver udp;
+        if (!udp.open(bench_address(), "bench.udp.in")) {
+            ::_exit(1);
+        }
+        (void)!::write(ready_fd, &ready, 1);
+        result = receive_loop(expected, [&]() -> uint64_t {
+            if (!udp.wait(100)) {
+                return 0;
+            }
+            const char* payload;
+            size_t len;
+            uint64_t got = 0;
+            while (udp.take(payload, len)) got++;
+            return got;
+        });
+        result.syscalls = udp.stats().syscalls;
+    }
+    (void)!::write(result_fd, &result, sizeof(result));
+    ::_exit(0);
+}
+
+void run(Mode mode, uint64_t messages, uint64_t rate) {
+    int ready_pipe[2], result_pipe[2];
+    if (::pipe(ready_pipe) != 0 || ::pipe(result_pipe) != 0) {
+        std::cerr << "[ERROR] pipe failed\n";
+        return;
+    }
+    pid_t child = ::fork();
+    if (child == 0) {
+        run_receiver(mode, messages, ready_pipe[1], result_pipe[1]);
+    }
+    char ready;
+    if (::read(ready_pipe[0], &ready, 1) != 1) {
+        std::cerr << "[ERROR] " << mode_name(mode) << ": receiver failed to start\n";
+        ::waitpid(child, nullptr, 0);
+        return;
+    }
+
+    char payload[telemetry::MAX_SENSOR_MESSAGE];
+    SensorData data{1, 1013.25, 0};
+    uint64_t sender_syscalls = 0;
+
+    telemetry::DdsSession dds;
+    telemetry::UdpSender udp;
+    dds_entity_t writer = 0;
+    if (mode == Mode::Dds) {
+        if (!dds.open(telemetry::QosProfile::HighThroughput, DDS_DOMAIN_DEFAULT, BENCH_TOPIC)) {
+            ::waitpid(child, nullptr, 0);
+            return;
+        }
+        writer = dds.create_writer();
+        std::this_thread::sleep_for(std::chrono::seconds(1));   // discovery
+    } else {
+        telemetry::UdpSenderOptions options;
+        options.gso = mode == Mode::UdpGso;
+        udp.open({bench_address()}, options, "bench.udp.out");
+    }
+
+    uint64_t cpu_start = cpu_time_us();
+    int64_t start_ns = now_ns();
+    for (uint64_t seq = 0; seq < messages; ++seq) {
+        data.timestamp = static_cast<long>(seq);
+        size_t len = telemetry::encode_sensor_message(payload, sizeof(payload), data, seq);
+        if (mode == Mode::Dds) {
+            Telemetry_JsonMessage msg;
+            msg.payload = payload;
+            dds_write(writer, &msg);
+        } else {
+            udp.send(payload, len);
+        }
+        if ((seq + 1) % FLUSH_EVERY == 0) {
+            if (mode == Mode::Dds) dds.flush(writer); else udp.flush();
+        }
+        if (rate > 0) {
+            auto due = std::chrono::nanoseconds(static_cast<int64_t>((seq + 1) * 1e9 / rate));
+            while (now_ns() - start_ns < due.count()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    if (mode == Mode::Dds) dds.flush(writer); else udp.flush();
+    int64_t sent_ns = now_ns();
+    uint64_t sender_cpu = cpu_time_us() - cpu_start;
+    if (mode != Mode::Dds) {
+        sender_syscalls = udp.stats().syscalls;
+    }
+
+    ReceiverResult result;
+    bool have_result = ::read(result_pipe[0], &result, sizeof(result)) == sizeof(result);
+    ::waitpid(child, nullptr, 0);
+    dds.close();
+    udp.close();
+    for (int fd : {ready_pipe[0], ready_pipe[1], result_pipe[0], result_pipe[1]}) ::close(fd);
+    if (!have_result) {
+        std::cerr << "[ERROR] " << mode_name(mode) << ": no result from the receiver\n";
+        return;
+    }
+
+    int64_t end_ns = result.received > 0 ? std::max(result.last_ns, sent_ns) : sent_ns;
+    double seconds = static_cast<double>(end_ns - start_ns) / 1e9;
+    double loss = 100.0 * static_cast<double>(messages - std::min(messages, result.received)) / messages;
+    std::cout << std::left << std::setw(16) << mode_name(mode) << std::right << std::fixed
+              << std::setw(10) << result.received
+              << std::setw(8) << std::setprecision(2) << loss << "%"
+              << std::setw(12) << std::setprecision(0) << (seconds > 0 ? result.received / seconds : 0.0)
+              << std::setw(12) << std::setprecision(0) << sender_cpu * 1000.0 / messages
+              << std::setw(12) << (result.received > 0 ? result.cpu_us * 1000.0 / result.received : 0.0);
+    if (mode != Mode::Dds) {
+        std::cout << std::setw(9) << std::setprecision(3) << static_cast<double>(sender_syscalls) / messages
+                  << std::setw(9) << static_cast<double>(result.syscalls) / std::max<uint64_t>(1, result.received);
+    }
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t messages = 200000;
+    uint64_t rate = 0;
+    std::vector<Mode> modes = {Mode::Udp, Mode::UdpGso, Mode::Dds};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--messages" && i + 1 < argc) {
+            messages = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            rate = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "udp") modes = {Mode::Udp};
+            else if (mode == "udp-gso") modes = {Mode::UdpGso};
+            else if (mode == "dds") modes = {Mode::Dds};
+            else if (mode != "all") {
+                std::cerr << "[ERROR] Unknown mode: " << mode << "\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--messages N] [--mode udp|udp-gso|dds|all] [--rate msgs/s]\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Loopback, " << messages << " messages, "
+              << (rate > 0 ? std::to_string(rate) + " msgs/s" : std::string("unpaced")) << "\n\n";
+    std::cout << std::left << std::setw(16) << "transport" << std::right << std::setw(10) << "received"
+              << std::setw(9) << "loss" << std::setw(12) << "msgs/s" << std::setw(12) << "tx ns/msg"
+              << std::setw(12) << "rx ns/msg" << std::setw(9) << "tx sys" << std::setw(9) << "rx sys" << "\n";
+    for (Mode mode : modes) {
+        run(mode, messages, rate);
+    }
+    std::cout << "\nns/msg is CPU time (user + system) per message; sys is system calls per message.\n";
+    return 0;
+}
@@ -0,0 +1,611 @@
+// Microbenchmarks for the core hot paths: the queues under contention, JSON
+// encode/decode (nlohmann vs. message_codec), CSV rows, timestamps and stats
+// updates.
+//
+//   ./telemetry_bench [--filter <text>] [--min-time <ms>] [--repeats N]
+//                     [--json <file>|-] [--compare <baseline.json>] [--list]
+//
+// Each benchmark runs batches of operations sized so that one batch takes at
+// least --min-time; ns/op and ops/s come from the fastest of --repeats
+// batches. Allocations per op come from the counting operator new/delete
+// (telemetry_alloc_hooks, always linked into this target) and include the
+// queue benchmarks' producer and consumer threads. --json writes the results
+// for later runs to --compare against.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "alloc_accounting.h"
+#include "bounded_queue.h"
+#include "executor.h"
+#include "fan_in.h"
+#include "log_sink.h"
+#include "log_sinks.h"
+#include "message_codec.h"
+#include "metrics.h"
+#include "thread_safe_queue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps a value (and everything it depends on) from being optimized away
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// ========== HARNESS ==========
+
+struct Benchmark {
+    std::string name;
+    std::function<void(uint64_t ops)> run;
+};
+
+struct Result {
+    std::string name;
+    uint64_t ops = 0;             // per batch
+    double ns_per_op = 0.0;
+    double ops_per_sec = 0.0;
+    double allocs_per_op = 0.0;
+    double bytes_per_op = 0.0;
+};
+
+struct Options {
+    std::string filter;
+    uint64_t min_time_ms = 200;
+    int repeats = 3;
+    std::string json_path;
+    std::string compare_path;
+    bool list = false;
+};
+
+// Heap activity of benchmark threads other than the caller, added to its own
+std::atomic<uint64_t> g_worker_allocations{0};
+std::atomic<uint64_t> g_worker_bytes{0};
+
+// Counts the allocations of one worker thread from here to scope exit
+class WorkerAllocs {
+public:
+    WorkerAllocs() : start_(telemetry::thread_alloc_counts()) {}
+    ~WorkerAllocs() {
+        telemetry::AllocCounts end = telemetry::thread_alloc_counts();
+        g_worker_allocations += end.allocations - start_.allocations;
+        g_worker_bytes += end.bytes - start_.bytes;
+    }
+
+private:
+    telemetry::AllocCounts start_;
+};
+
+struct Batch {
+    double ns = 0.0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+Batch run_batch(const Benchmark& bench, uint64_t ops) {
+    g_worker_allocations = 0;
+    g_worker_bytes = 0;
+    telemetry::AllocCounts before = telemetry::thread_alloc_counts();
+    auto start = Clock::now();
+    bench.run(ops);
+    auto elapsed = Clock::now() - start;
+    telemetry::AllocCounts after = telemetry::thread_alloc_counts();
+    Batch batch;
+    batch.ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    batch.allocations = after.allocations - before.allocations + g_worker_allocations.load();
+    batch.bytes = after.bytes - before.bytes + g_worker_bytes.load();
+    return batch;
+}
+
+Result measure(const Benchmark& bench, const Options& options) {
+    // Grow the batch until it fills the minimum time
+    const double min_ns = static_cast<double>(options.min_time_ms) * 1e6;
+    uint64_t ops = 16;
+    Batch batch = run_batch(bench, ops);
+    while (batch.ns < min_ns && ops < (1ull << 34)) {
+        double scale = batch.ns > 0 ? min_ns * 1.2 / batch.ns : 100.0;
+        ops = static_cast<uint64_t>(static_cast<double>(ops) * std::clamp(scale, 2.0, 100.0));
+        batch = run_batch(bench, ops);
+    }
+
+    double best_ns = batch.ns;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    for (int i = 0; i < options.repeats; ++i) {
+        batch = run_batch(bench, ops);
+        best_ns = std::min(best_ns, batch.ns);
+        allocations += batch.allocations;
+        bytes += batch.bytes;
+    }
+
+    Result result;
+    result.name = bench.name;
+    result.ops = ops;
+    result.ns_per_op = best_ns / static_cast<double>(ops);
+    result.ops_per_sec = result.ns_per_op > 0 ? 1e9 / result.ns_per_op : 0.0;
+    double total_ops = static_cast<double>(ops) * options.repeats;
+    result.allocs_per_op = static_cast<double>(allocations) / total_ops;
+    result.bytes_per_op = static_cast<double>(bytes) / total_ops;
+    return result;
+}
+
+// ========== QUEUES ==========
+// `producers` threads push `ops` items between them, one consumer takes
+// them. ns/op is per item through the queue.
+
+constexpr size_t QUEUE_CAPACITY = 1024;
+
+template <typename Push>
+void produce(uint64_t ops, int producers, Push push) {
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        uint64_t count = ops / producers + (p == 0 ? ops % producers : 0);
+        threads.emplace_back([count, &push] {
+            WorkerAllocs allocs;
+            for (uint64_t i = 0; i < count; ++i) {
+                push(i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void thread_safe_queue(uint64_t ops, int producers) {
+    ThreadSafeQueue<uint64_t> queue;
+    std::thread consumer([&] {
+        WorkerAllocs allocs;
+        uint64_t value;
+        for (uint64_t i = 0; i < ops && queue.pop(value); ++i) {
+            keep(value);
+        }
+    });
+    produce(ops, producers, [&](uint64_t i) { queue.push(i); });
+    consumer.join();
+}
+
+void bounded_queue_block(uint64_t ops, int producers) {
+    BoundedQueue<uint64_t> queue(QUEUE_CAPACITY, OverflowPolicy::Block);
+    std::thread consumer([&] {
+        WorkerAllocs allocs;
+        uint64_t value;
+        for (uint64_t i = 0; i < ops;) {
+            if (queue.pop_for(value, std::chrono::milliseconds(100))) {
+                keep(value);
+                ++i;
+            }
+        }
+    });
+    produce(ops, producers, [&](uint64_t i) { queue.push(i); });
+    consumer.join();
+}
+
+// Drops instead of blocking, so the consumer runs until the producers are
+// done and the queue is empty; ns/op is per push
+void bounded_queue_drop_oldest(uint64_t ops, int producers) {
+    BoundedQueue<uint64_t> queue(QUEUE_CAPACITY, OverflowPolicy::DropOldest);
+    std::atomic<bool> produced{false};
+    std::thread consumer([&] {
+        WorkerAllocs allocs;
+        uint64_t value;
+        while (!produced || queue.size() > 0) {
+            if (queue.pop_for(value, std::chrono::milliseconds(1))) {
+                keep(value);
+            }
+        }
+    });
+    produce(ops, producers, [&](uint64_t i) { queue.push(i); });
+    produced = true;
+    consumer.join();
+}
+
+// A coroutine consumer on a one-thread executor; the producer retries
+// while the queue is full
+void async_queue(uint64_t ops, int producers) {
+    telemetry::Executor executor(1, "bench");
+    telemetry::AsyncQueue<uint64_t> queue(executor, QUEUE_CAPACITY);
+    executor.spawn([](telemetry::AsyncQueue<uint64_t>& queue, uint64_t ops) -> telemetry::Task<> {
+        WorkerAllocs allocs;   // the executor thread
+        for (uint64_t i = 0; i < ops; ++i) {
+            std::optional<uint64_t> value = co_await queue.pop();
+            keep(*value);
+        }
+    }(queue, ops));
+    produce(ops, producers, [&](uint64_t i) {
+        while (!queue.push(i)) {
+            std::this_thread::yield();
+        }
+    });
+    executor.run();
+}
+
+// ========== JSON ==========
+
+const SensorData SAMPLE{3, 22.5371, 1700000000123L};
+const uint64_t SEQUENCE = 123456;
+
+telemetry::StageStamps sample_stamps() {
+    telemetry::StageStamps stamps;
+    stamps.present = true;
+    stamps.sampled_us = 1700000000123000ULL;
+    stamps.enqueued_us = stamps.sampled_us + 4;
+    stamps.dequeued_us = stamps.sampled_us + 19;
+    stamps.written_us = stamps.sampled_us + 31;
+    return stamps;
+}
+
+std::string encoded_sample(bool with_stamps) {
+    char payload[telemetry::MAX_SENSOR_MESSAGE];
+    telemetry::StageStamps stamps = sample_stamps();
+    size_t len = telemetry::encode_sensor_message(payload, sizeof(payload), SAMPLE, SEQUENCE,
+                                                  with_stamps ? &stamps : nullptr);
+    return std::string(payload, len);
+}
+
+void json_encode_nlohmann(uint64_t ops) {
+    for (uint64_t i = 0; i < ops; ++i) {
+        nlohmann::json j;
+        j["id"] = SAMPLE.id;
+        j["sequence"] = SEQUENCE + i;
+        j["timestamp"] = SAMPLE.timestamp;
+        j["value"] = SAMPLE.value;
+        std::string text = j.dump();
+        keep(text.size());
+    }
+}
+
+void json_encode_fast(uint64_t ops, bool with_stamps) {
+    char payload[telemetry::MAX_SENSOR_MESSAGE];
+    telemetry::StageStamps stamps = sample_stamps();
+    for (uint64_t i = 0; i < ops; ++i) {
+        size_t len = telemetry::encode_sensor_message(payload, sizeof(payload), SAMPLE, SEQUENCE + i,
+                                                      with_stamps ? &stamps : nullptr);
+        keep(len);
+        keep(payload[0]);
+    }
+}
+
+void json_decode_nlohmann(uint64_t ops) {
+    const std::string payload = encoded_sample(false);
+    for (uint64_t i = 0; i < ops; ++i) {
+        nlohmann::json j = nlohmann::json::parse(payload);
+        SensorData data;
+        data.id = j["id"].get<int>();
+        data.value = j["value"].get<double>();
+        data.timestamp = j["timestamp"].get<long>();
+        uint64_t sequence = j["sequence"].get<uint64_t>();
+        keep(data);
+        keep(sequence);
+    }
+}
+
+void json_decode_fast(uint64_t ops, bool with_stamps) {
+    const std::string payload = encoded_sample(with_stamps);
+    telemetry::StageStamps stamps;
+    for (uint64_t i = 0; i < ops; ++i) {
+        SensorData data;
+        uint64_t sequence;
+        bool ok = telemetry::parse_sensor_message(payload.c_str(), data, sequence, with_stamps ? &stamps : nullptr);
+        keep(ok);
+        keep(data);
+    }
+}
+
+// ========== CSV ==========
+
+telemetry::LogRecord sample_record() {
+    telemetry::LogRecord record;
+    record.data = SAMPLE;
+    record.sequence = SEQUENCE;
+    record.received_ms = static_cast<uint64_t>(SAMPLE.timestamp) + 3;
+    return record;
+}
+
+// The logger's pattern: one buffer, cleared per row
+void csv_format_row(uint64_t ops) {
+    telemetry::LogRecord record = sample_record();
+    std::string row;
+    for (uint64_t i = 0; i < ops; ++i) {
+        row.clear();
+        record.sequence = SEQUENCE + i;
+        telemetry::format_csv_row(record, row);
+        keep(row.size());
+    }
+}
+
+void csv_parse_row(uint64_t ops) {
+    std::string row;
+    telemetry::format_csv_row(sample_record(), row);
+    row.pop_back();   // the newline, as getline leaves it
+    telemetry::LogRecord record;
+    for (uint64_t i = 0; i < ops; ++i) {
+        bool ok = telemetry::parse_csv_row(row, record);
+        keep(ok);
+        keep(record);
+    }
+}
+
+void csv_format_timestamp(uint64_t ops) {
+    char text[32];
+    uint64_t wall_ms = static_cast<uint64_t>(SAMPLE.timestamp);
+    for (uint64_t i = 0; i < ops; ++i) {
+        size_t len = telemetry::format_timestamp_ms(wall_ms + i, text, sizeof(text));
+        keep(len);
+        keep(text[0]);
+    }
+}
+
+void csv_format_timestamp_string(uint64_t ops) {
+    uint64_t wall_ms = static_cast<uint64_t>(SAMPLE.timestamp);
+    for (uint64_t i = 0; i < ops; ++i) {
+        std::string text = telemetry::format_timestamp_ms(wall_ms + i);
+        keep(text.size());
+    }
+}
+
+// ========== TIMESTAMPS ==========
+
+template <typename Now>
+void timestamps(uint64_t ops, Now now) {
+    for (uint64_t i = 0; i < ops; ++i) {
+        auto value = now();
+        keep(value);
+    }
+}
+
+uint64_t realtime_coarse_us() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+// ========== STATS ==========
+
+void stats_counter(uint64_t ops) {
+    telemetry::Counter counter = telemetry::metrics().counter("bench.counter");
+    for (uint64_t i = 0; i < ops; ++i) {
+        counter.add();
+    }
+}
+
+void stats_histogram(uint64_t ops) {
+    telemetry::Histogram histogram = telemetry::metrics().histogram("bench.histogram");
+    for (uint64_t i = 0; i < ops; ++i) {
+        histogram.record((i * 2654435761u) & 0xffff);
+    }
+}
+
+// The aggregator's per-sample path: 8 sensors, 1 s windows, two hubs
+void stats_window_aggregator(uint64_t ops) {
+    telemetry::WindowAggregator aggregator(1000);
+    telemetry::WindowSummary closed;
+    uint64_t closed_count = 0;
+    for (uint64_t i = 0; i < ops; ++i) {
+        telemetry::HubKey hub{0, i & 1};
+        uint64_t timestamp_ms = 1700000000000ULL + i / 8;
+        if (aggregator.add(static_cast<int>(i % 8), 20.0 + static_cast<double>(i % 13), timestamp_ms, hub, closed)) {
+            closed_count++;
+        }
+    }
+    keep(closed_count);
+}
+
+std::vector<Benchmark> benchmarks() {
+    return {
+        {"queue/thread_safe/1p1c", [](uint64_t n) { thread_safe_queue(n, 1); }},
+        {"queue/thread_safe/4p1c", [](uint64_t n) { thread_safe_queue(n, 4); }},
+        {"queue/bounded_block/1p1c", [](uint64_t n) { bounded_queue_block(n, 1); }},
+        {"queue/bounded_block/4p1c", [](uint64_t n) { bounded_queue_block(n, 4); }},
+        {"queue/bounded_drop_oldest/4p1c", [](uint64_t n) { bounded_queue_drop_oldest(n, 4); }},
+        {"queue/async/1p1c", [](uint64_t n) { async_queue(n, 1); }},
+        {"queue/async/4p1c", [](uint64_t n) { async_queue(n, 4); }},
+        {"json/encode/nlohmann", json_encode_nlohmann},
+        {"json/encode/fast", [](uint64_t n) { json_encode_fast(n, false); }},
+        {"json/encode/fast+stamps", [](uint64_t n) { json_encode_fast(n, true); }},
+        {"json/decode/nlohmann", json_decode_nlohmann},
+        {"json/decode/fast", [](uint64_t n) { json_decode_fast(n, false); }},
+        {"json/decode/fast+stamps", [](uint64_t n) { json_decode_fast(n, true); }},
+        {"csv/format_row", csv_format_row},
+        {"csv/parse_row", csv_parse_row},
+        {"csv/format_timestamp", csv_format_timestamp},
+        {"csv/format_timestamp/string", csv_format_timestamp_string},
+        {"time/steady_clock", [](uint64_t n) { timestamps(n, [] { return Clock::now(); }); }},
+        {"time/system_clock", [](uint64_t n) { timestamps(n, [] { return std::chrono::system_clock::now(); }); }},
+        {"time/wall_clock_us", [](uint64_t n) { timestamps(n, telemetry::wall_clock_us); }},
+        {"time/wall_clock_ms", [](uint64_t n) { timestamps(n, telemetry::wall_clock_ms); }},
+        {"time/realtime_coarse", [](uint64_t n) { timestamps(n, realtime_coarse_us); }},
+        {"stats/counter_add", stats_counter},
+        {"stats/histogram_record", stats_histogram},
+        {"stats/window_aggregator_add", stats_window_aggregator},
+    };
+}
+
+// ========== OUTPUT ==========
+
+nlohmann::json to_json(const std::vector<Result>& results, const Options& options) {
+    nlohmann::json j;
+    j["benchmark"] = "telemetry_bench";
+    j["timestamp_ms"] = telemetry::wall_clock_ms();
+    j["compiler"] = __VERSION__;
+#ifdef NDEBUG
+    j["build"] = "release";
+#else
+    j["build"] = "debug";
+#endif
+    j["cpus"] = std::thread::hardware_concurrency();
+    j["alloc_accounting"] = telemetry::alloc_accounting_enabled();
+    j["min_time_ms"] = options.min_time_ms;
+    j["repeats"] = options.repeats;
+    nlohmann::json rows = nlohmann::json::array();
+    for (const Result& r : results) {
+        rows.push_back({{"name", r.name},
+                        {"ops", r.ops},
+                        {"ns_per_op", r.ns_per_op},
+                        {"ops_per_sec", r.ops_per_sec},
+                        {"allocs_per_op", r.allocs_per_op},
+                        {"bytes_per_op", r.bytes_per_op}});
+    }
+    j["results"] = rows;
+    return j;
+}
+
+// ns/op by name from an earlier --json file
+bool load_baseline(const std::string& path, std::map<std::string, double>& baseline) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[ERROR] Cannot open baseline " << path << "\n";
+        return false;
+    }
+    try {
+        nlohmann::json j = nlohmann::json::parse(in);
+        for (const auto& row : j.at("results")) {
+            baseline[row.at("name").get<std::string>()] = row.at("ns_per_op").get<double>();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Invalid baseline " << path << ": " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+void print_header(bool compare) {
+    std::cout << std::left << std::setw(34) << "benchmark" << std::right << std::setw(12) << "ns/op"
+              << std::setw(14) << "ops/s" << std::setw(11) << "allocs/op" << std::setw(11) << "bytes/op";
+    if (compare) {
+        std::cout << std::setw(12) << "vs base";
+    }
+    std::cout << "\n";
+}
+
+void print_row(const Result& r, const std::map<std::string, double>* baseline) {
+    std::cout << std::left << std::setw(34) << r.name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(r.ns_per_op < 100 ? 2 : 1) << r.ns_per_op
+              << std::setw(14) << std::setprecision(0) << r.ops_per_sec;
+    if (telemetry::alloc_accounting_enabled()) {
+        std::cout << std::setw(11) << std::setprecision(2) << r.allocs_per_op
+                  << std::setw(11) << std::setprecision(1) << r.bytes_per_op;
+    } else {
+        std::cout << std::setw(11) << "-" << std::setw(11) << "-";
+    }
+    if (baseline != nullptr) {
+        auto base = baseline->find(r.name);
+        if (base != baseline->end() && base->second > 0) {
+            // Positive = slower than the baseline
+            double change = 100.0 * (r.ns_per_op - base->second) / base->second;
+            std::cout << std::setw(11) << std::showpos << std::setprecision(1) << change << "%" << std::noshowpos;
+        } else {
+            std::cout << std::setw(12) << "new";
+        }
+    }
+    std::cout << std::endl;
+}
+
+void print_usage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
+    std::cout << "Options:\n";
+    std::cout << "  --filter <text>       Only run benchmarks whose name contains <text>\n";
+    std::cout << "  --min-time <ms>       Minimum duration of one batch (default: 200)\n";
+    std::cout << "  --repeats <n>         Timed batches per benchmark, best one counts (default: 3)\n";
+    std::cout << "  --json <file>         Also write the results as JSON ('-' for stdout)\n";
+    std::cout << "  --compare <file>      Show the change against an earlier --json file\n";
+    std::cout << "  --list                List the benchmarks and exit\n";
+    std::cout << "  --help                Show this help message\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.min_time_ms = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            options.repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--json" && i + 1 < argc) {
+            options.json_path = argv[++i];
+        } else if (arg == "--compare" && i + 1 < argc) {
+            options.compare_path = argv[++i];
+        } else if (arg == "--list") {
+            options.list = true;
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "[ERROR] Unknown option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Benchmark> selected;
+    for (auto& bench : benchmarks()) {
+        if (bench.name.find(options.filter) != std::string::npos) {
+            selected.push_back(std::move(bench));
+        }
+    }
+    if (options.list) {
+        for (const auto& bench : selected) {
+            std::cout << bench.name << "\n";
+        }
+        return 0;
+    }
+    if (selected.empty()) {
+        std::cerr << "[ERROR] No benchmark matches '" << options.filter << "'\n";
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.compare_path.empty() && !load_baseline(options.compare_path, baseline)) {
+        return 1;
+    }
+
+    // With --json -, the table goes to stderr so stdout stays parseable
+    std::streambuf* table = std::cout.rdbuf();
+    if (options.json_path == "-") {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    if (!telemetry::alloc_accounting_enabled()) {
+        std::cout << "(allocation counting hooks not linked: allocs/op unavailable)\n";
+    }
+    print_header(!options.compare_path.empty());
+    std::vector<Result> results;
+    for (const auto& bench : selected) {
+        results.push_back(measure(bench, options));
+        print_row(results.back(), options.compare_path.empty() ? nullptr : &baseline);
+    }
+    std::cout.rdbuf(table);
+
+    if (!options.json_path.empty()) {
+        std::string text = to_json(results, options).dump(2);
+        if (options.json_path == "-") {
+            std::cout << text << "\n";
+        } else {
+            std::ofstream out(options.json_path);
+            out << text << "\n";
+            if (!out) {
+                std::cerr << "[ERROR] Failed to write " << options.json_path << "\n";
+                return 1;
+            }
+            std::cout << "Results written to " << options.json_path << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,543 @@
+#include <iostream>
+#include <atomic>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <map>
+#include <memory>
+#include <iomanip>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dds/dds.h>
+#include "telemetry.h"
+
+#include "../core/telemetry_types.h"
+#include "../core/dds_bootstrap.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "../core/async_console.h"
+#include "../core/message_codec.h"
+#include "../core/dds_health.h"
+#include "../core/log_sink.h"
+#include "../core/control_socket.h"
+#include "../core/fan_in.h"
+
+// Relay between many hubs and the top-level consumers: subscribes to the
+// telemetry topic in one or more domains, tracks a session per hub writer,
+// and republishes upstream (in another domain) either the merged raw
+// stream or per-sensor window rollups.
+
+std::atomic<bool> g_running{true};
+
+struct AggregatorMetrics {
+    telemetry::Counter received = telemetry::metrics().counter("aggregator.messages_received");
+    telemetry::Counter bytes = telemetry::metrics().counter("aggregator.bytes_received");
+    telemetry::Counter parse_failures = telemetry::metrics().counter("aggregator.parse_failures");
+    telemetry::Counter stale = telemetry::metrics().counter("aggregator.stale_dropped");
+    telemetry::Counter published = telemetry::metrics().counter("aggregator.messages_published");
+    telemetry::Counter publish_errors = telemetry::metrics().counter("aggregator.publish_errors");
+    telemetry::Gauge active_hubs = telemetry::metrics().gauge("aggregator.active_hubs");
+    telemetry::Histogram take_batch = telemetry::metrics().histogram("aggregator.take_batch");
+    telemetry::Histogram relay_ns = telemetry::metrics().histogram("aggregator.relay_ns");
+};
+AggregatorMetrics g_metrics;
+
+enum class OutputMode { Rollup, Raw };
+
+// Samples taken per dds_take; fan-in rates make one-at-a-time takes the
+// bottleneck
+constexpr uint32_t TAKE_BATCH = 256;
+
+// One subscribed domain
+struct Input {
+    dds_domainid_t domain = DDS_DOMAIN_DEFAULT;
+    std::string label;
+    telemetry::DdsSession dds;
+    dds_entity_t reader = 0;
+};
+
+// Hub sessions, shared with the control socket thread
+telemetry::HubSessionTable g_sessions;
+std::mutex g_session_mutex;
+
+// Upstream sequences per sensor id: the merged stream gets its own
+// numbering, since hub sequences collide across hubs
+std::map<int, uint64_t> g_upstream_sequences;
+
+void signal_handler(int signal) {
+    std::cout << "\n[Aggregator] Caught signal " << signal << ", shutting down...\n";
+    g_running = false;
+}
+
+// Hubs are named by their writer's publication handle
+std::string hub_name(const telemetry::HubKey& key) {
+    std::ostringstream out;
+    out << "hub " << std::hex << key.writer;
+    return out.str();
+}
+
+std::string describe_session(const telemetry::HubSession& session, uint64_t now_ms) {
+    std::ostringstream out;
+    out << hub_name(session.key) << " (" << session.origin << ")"
+        << "  " << (session.active ? "active" : "ended")
+        << "  messages " << session.messages << "  gaps " << session.gaps << "  stale " << session.stale
+        << "  up " << (session.last_seen_ms - session.first_seen_ms) / 1000 << " s"
+        << "  last seen " << (now_ms - session.last_seen_ms) << " ms ago";
+    return out.str();
+}
+
+// ========== CONTROL COMMANDS ==========
+
+std::string control_hubs(const std::string&) {
+    std::vector<telemetry::HubSession> sessions;
+    uint64_t dropped;
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        sessions = g_sessions.sessions();
+        dropped = g_sessions.dropped_count();
+    }
+    uint64_t now_ms = telemetry::wall_clock_ms();
+    std::ostringstream out;
+    for (const auto& session : sessions) {
+        out << "  " << describe_session(session, now_ms) << "\n";
+    }
+    if (sessions.empty() && dropped == 0) {
+        out << "no hubs seen yet\n";
+    }
+    if (dropped > 0) {
+        out << "  (" << dropped << " ended sessions past --hub-retention not shown)\n";
+    }
+    return out.str();
+}
+
+// ========== UPSTREAM PUBLISHING ==========
+
+class Upstream {
+public:
+    Upstream(telemetry::DdsSession& dds, dds_entity_t writer) : dds_(dds), writer_(writer) {}
+
+    void publish_raw(const SensorData& data, const telemetry::StageStamps& stamps) {
+        size_t len = telemetry::encode_sensor_message(buffer_, sizeof(buffer_), data,
+                                                      g_upstream_sequences[data.id]++, &stamps);
+        write(len);
+    }
+
+    void publish_rollup(const telemetry::WindowSummary& window, uint64_t window_ms) {
+        SensorData data;
+        data.id = window.sensor_id;
+        data.value = window.mean();
+        data.timestamp = static_cast<long>(window.start_ms + window_ms);
+        telemetry::RollupFields rollup;
+        rollup.count = window.count;
+        rollup.min = window.min;
+        rollup.max = window.max;
+        rollup.sources = window.sources;
+        size_t len = telemetry::encode_rollup_message(buffer_, sizeof(buffer_), data,
+                                                      g_upstream_sequences[data.id]++, rollup);
+        write(len);
+    }
+
+    void flush() { dds_.flush(writer_); }
+    uint64_t published() const { return published_; }
+
+private:
+    void write(size_t len) {
+        if (len == 0) {
+            g_metrics.publish_errors.add();
+            return;
+        }
+        Telemetry_JsonMessage msg;
+        msg.payload = buffer_;
+        int ret;
+        {
+            TRACE_SCOPE("write");
+            ret = dds_write(writer_, &msg);
+        }
+        if (ret == DDS_RETCODE_OK) {
+            g_metrics.published.add();
+            published_++;
+        } else {
+            g_metrics.publish_errors.add();
+            telemetry::log_err(errors_) << "[ERROR] Failed to publish upstream (code: " << ret << ")";
+        }
+    }
+
+    telemetry::DdsSession& dds_;
+    dds_entity_t writer_;
+    char buffer_[telemetry::MAX_SENSOR_MESSAGE];
+    uint64_t published_ = 0;
+    telemetry::RateLimit errors_{5, std::chrono::seconds(1)};
+};
+
+void print_usage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
+    std::cout << "Options:\n";
+    std::cout << "  --domain <id>          Subscribe to hubs in DDS domain <id> (repeatable; default: the default domain)\n";
+    std::cout << "  --partition <p>        Subscribe to DDS partition or pattern <p> in every input domain (repeatable)\n";
+    std::cout << "  --upstream-domain <id> Republish in DDS domain <id> (default: 1)\n";
+    std::cout << "  --upstream-partition <p>\n";
+    std::cout << "                         Republish into DDS partition <p> (repeatable); lets the upstream share\n";
+    std::cout << "                         a domain with an input whose partitions do not match it\n";
+    std::cout << "  --mode <mode>          rollup (per-sensor window summaries, default) or raw (merged stream)\n";
+    std::cout << "  --window <ms>          Rollup window length (default: 1000)\n";
+    std::cout << "  --hub-timeout <ms>     End a hub session after this long without data (default: 5000)\n";
+    std::cout << "  --hub-retention <ms>   Forget an ended hub session after this long without data (default: 600000)\n";
+    std::cout << "  --qos <profile>        DDS QoS profile for both sides (default: default)\n";
+    std::cout << telemetry::qos_profile_help();
+    std::cout << "  --trace <file>         Record a Chrome trace to <file>, written at exit and on SIGUSR1\n";
+    std::cout << "  --control <path>       Control socket for live state dumps (default: /tmp/telemetry_aggregator.ctl)\n";
+    std::cout << "  --no-control           Do not serve a control socket\n";
+    std::cout << "  --help                 Show this help message\n";
+    std::cout << "\nExample:\n";
+    std::cout << "  " << prog_name << " --domain 0 --domain 2 --upstream-domain 1 --window 5000\n";
+    std::cout << "  " << prog_name << " --partition 'site-a/*' --upstream-domain 0 --upstream-partition site-a\n";
+}
+
+int main(int argc, char** argv) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    std::vector<dds_domainid_t> domains;
+    dds_domainid_t upstream_domain = 1;
+    std::vector<std::string> partitions;
+    std::vector<std::string> upstream_partitions;
+    OutputMode mode = OutputMode::Rollup;
+    uint64_t window_ms = 1000;
+    uint64_t hub_timeout_ms = 5000;
+    uint64_t hub_retention_ms = 600000;
+    telemetry::QosProfile qos_profile = telemetry::QosProfile::Default;
+    std::string trace_file;
+    std::string control_path = "/tmp/telemetry_aggregator.ctl";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--domain" || arg == "--upstream-domain") && i + 1 < argc) {
+            dds_domainid_t domain;
+            if (!telemetry::parse_domain_id(argv[++i], domain)) {
+                std::cerr << "[ERROR] Invalid domain id: " << argv[i] << " (expected 0-"
+                          << telemetry::MAX_DOMAIN_ID << ")\n";
+                return 1;
+            }
+            if (arg == "--domain") {
+                domains.push_back(domain);
+            } else {
+                upstream_domain = domain;
+            }
+        } else if (arg == "--partition" && i + 1 < argc) {
+            partitions.push_back(argv[++i]);
+        } else if (arg == "--upstream-partition" && i + 1 < argc) {
+            upstream_partitions.push_back(argv[++i]);
+        } else if (arg == "--mode" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "rollup") {
+                mode = OutputMode::Rollup;
+            } else if (value == "raw") {
+                mode = OutputMode::Raw;
+            } else {
+                std::cerr << "[ERROR] Unknown mode: " << value << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--window" && i + 1 < argc) {
+            window_ms = static_cast<uint64_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--hub-timeout" && i + 1 < argc) {
+            hub_timeout_ms = static_cast<uint64_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--hub-retention" && i + 1 < argc) {
+            hub_retention_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg == "--control" && i + 1 < argc) {
+            control_path = argv[++i];
+        } else if (arg == "--no-control") {
+            control_path.clear();
+        } else if (arg == "--qos" && i + 1 < argc) {
+            if (!telemetry::parse_qos_profile(argv[++i], qos_profile)) {
+                std::cerr << "[ERROR] Unknown QoS profile: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "[ERROR] Unknown option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (domains.empty()) {
+        domains.push_back(DDS_DOMAIN_DEFAULT);
+    }
+    for (const auto& name : upstream_partitions) {
+        if (name.empty() || telemetry::is_partition_pattern(name)) {
+            std::cerr << "[ERROR] Upstream partition must be a literal name, not '" << name << "'\n";
+            return 1;
+        }
+    }
+    for (dds_domainid_t domain : domains) {
+        // Same topic on both sides: sharing a domain is only safe when the
+        // partitions keep the output from feeding back in
+        if (domain == upstream_domain && telemetry::partitions_match(partitions, upstream_partitions)) {
+            std::cerr << "[ERROR] Upstream " << telemetry::domain_label(upstream_domain) << ", "
+                      << telemetry::partition_label(upstream_partitions)
+                      << " would be read back by the input subscription\n";
+            return 1;
+        }
+    }
+
+    std::cout << "[Aggregator] Starting...\n";
+    g_sessions = telemetry::HubSessionTable(hub_timeout_ms, hub_retention_ms);
+
+    if (!trace_file.empty()) {
+        telemetry::enable_tracing();
+        telemetry::install_trace_dump_signal(SIGUSR1);
+        telemetry::set_trace_thread_name("aggregator");
+        std::cout << "[Config] Tracing to " << trace_file << " (SIGUSR1 writes a snapshot)\n";
+    }
+
+    // ========== DDS INITIALIZATION ==========
+    telemetry::DdsHealth dds_health;
+    std::vector<std::unique_ptr<Input>> inputs;
+    for (dds_domainid_t domain : domains) {
+        auto input = std::make_unique<Input>();
+        input->domain = domain;
+        input->label = telemetry::domain_label(domain);
+        if (!input->dds.open(qos_profile, domain)) {
+            return 1;
+        }
+        input->dds.set_partitions(partitions);
+        input->reader = input->dds.create_reader();
+        if (input->reader < 0) {
+            std::cerr << "[ERROR] Failed to create DDS reader in " << input->label << "\n";
+            return 1;
+        }
+        dds_health.watch_reader(input->reader, "aggregator.dds.in" + std::to_string(inputs.size()));
+        std::cout << "[DDS] Subscribed to '" << telemetry::TELEMETRY_TOPIC << "' in " << input->label << " ("
+                  << telemetry::partition_label(partitions) << ")\n";
+        inputs.push_back(std::move(input));
+    }
+
+    telemetry::DdsSession upstream_dds;
+    if (!upstream_dds.open(qos_profile, upstream_domain)) {
+        return 1;
+    }
+    upstream_dds.set_partitions(upstream_partitions);
+    dds_entity_t writer = upstream_dds.create_writer();
+    if (writer < 0) {
+        std::cerr << "[ERROR] Failed to create upstream DDS writer\n";
+        return 1;
+    }
+    dds_health.watch_writer(writer, "aggregator.dds.out");
+    std::cout << "[DDS] Publishing " << (mode == OutputMode::Raw ? "merged raw stream" : "rollups")
+              << " in " << telemetry::domain_label(upstream_domain) << ", "
+              << telemetry::partition_label(upstream_partitions) << " ("
+              << telemetry::qos_profile_name(qos_profile) << ")\n";
+    if (mode == OutputMode::Rollup) {
+        std::cout << "[Config] Rollup window: " << window_ms << " ms\n";
+    }
+
+    // ========== CONTROL SOCKET ==========
+    telemetry::ControlServer control;
+    control.add_command("hubs", "Hub sessions: origin, state, messages, gaps, age", control_hubs);
+    if (!control_path.empty() && control.start(control_path)) {
+        std::cout << "[Control] Listening on " << control_path << " (try: echo help | nc -U "
+                  << control_path << ")\n";
+    }
+
+    std::cout << "[Aggregator] Waiting for hubs...\n";
+    telemetry::console().start();
+
+    // ========== MAIN LOOP ==========
+    Upstream upstream(upstream_dds, writer);
+    // Windows close on the sample timestamps; the grace period lets hubs
+    // with slower clocks or deeper queues land in the right window
+    telemetry::WindowAggregator windows(window_ms, window_ms / 2);
+    std::vector<telemetry::WindowSummary> closed;
+    telemetry::RateLimit parse_errors(5, std::chrono::seconds(1));
+
+    void* samples[TAKE_BATCH];
+    dds_sample_info_t infos[TAKE_BATCH];
+    uint64_t last_poll_ms = telemetry::wall_clock_ms();
+    uint64_t last_report_ms = last_poll_ms;
+    uint64_t last_health_poll_ms = last_poll_ms;
+    uint64_t received = 0;
+    uint64_t received_at_report = 0;
+    uint64_t published_at_report = 0;
+
+    while (g_running) {
+        bool took_any = false;
+        for (size_t index = 0; index < inputs.size(); ++index) {
+            Input& input = *inputs[index];
+            samples[0] = nullptr;   // loan the samples from DDS
+            int ret;
+            {
+                TRACE_SCOPE("take");
+                ret = dds_take(input.reader, samples, infos, TAKE_BATCH, TAKE_BATCH);
+            }
+            if (ret <= 0) {
+                continue;
+            }
+            took_any = true;
+            g_metrics.take_batch.record(static_cast<uint64_t>(ret));
+            uint64_t now_ms = telemetry::wall_clock_ms();
+
+            TRACE_SCOPE("relay");
+            auto batch_start = std::chrono::steady_clock::now();
+            for (int i = 0; i < ret; ++i) {
+                const Telemetry_JsonMessage* msg = static_cast<const Telemetry_JsonMessage*>(samples[i]);
+                if (!infos[i].valid_data || msg->payload == nullptr) {
+                    continue;
+                }
+                g_metrics.received.add();
+                received++;
+                g_metrics.bytes.add(strlen(msg->payload));
+
+                SensorData data;
+                uint64_t sequence;
+                telemetry::StageStamps stamps;
+                if (!telemetry::parse_sensor_message(msg->payload, data, sequence, &stamps)) {
+                    g_metrics.parse_failures.add();
+                    telemetry::log_err(parse_errors) << "[ERROR] Unparseable message from " << input.label;
+                    continue;
+                }
+
+                telemetry::HubKey key{static_cast<uint32_t>(index), infos[i].publication_handle};
+                telemetry::HubSessionTable::Verdict verdict;
+                {
+                    std::lock_guard<std::mutex> lock(g_session_mutex);
+                    verdict = g_sessions.record(key, input.label, data.id, sequence, now_ms);
+                }
+                if (verdict == telemetry::HubSessionTable::Verdict::Stale) {
+                    g_metrics.stale.add();
+                    continue;
+                }
+                if (verdict == telemetry::HubSessionTable::Verdict::NewSession) {
+                    telemetry::log_out() << "[Aggregator] New session: " << hub_name(key) << " in " << input.label;
+                }
+
+                if (mode == OutputMode::Raw) {
+                    upstream.publish_raw(data, stamps);
+                } else {
+                    telemetry::WindowSummary window;
+                    if (windows.add(data.id, data.value, static_cast<uint64_t>(data.timestamp), key, window)) {
+                        upstream.publish_rollup(window, window_ms);
+                    }
+                }
+            }
+            dds_return_loan(input.reader, samples, ret);
+            g_metrics.relay_ns.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - batch_start).count() / ret));
+        }
+        if (took_any) {
+            upstream.flush();
+        }
+
+        uint64_t now_ms = telemetry::wall_clock_ms();
+        if (now_ms - last_poll_ms >= 100) {
+            last_poll_ms = now_ms;
+            closed.clear();
+            windows.poll(now_ms, closed);
+            for (const auto& window : closed) {
+                upstream.publish_rollup(window, window_ms);
+            }
+            if (!closed.empty()) {
+                upstream.flush();
+            }
+
+            std::vector<telemetry::HubSession> ended;
+            size_t active;
+            {
+                std::lock_guard<std::mutex> lock(g_session_mutex);
+                ended = g_sessions.expire(now_ms);
+                active = g_sessions.active_count();
+            }
+            for (const auto& session : ended) {
+                telemetry::log_out() << "[Aggregator] Hub session ended: " << describe_session(session, now_ms);
+            }
+            g_metrics.active_hubs.set(static_cast<int64_t>(active));
+        }
+
+        if (now_ms - last_health_poll_ms >= 1000) {
+            dds_health.poll();
+            last_health_poll_ms = now_ms;
+        }
+
+        // Fan-in ratio every 5 s
+        if (now_ms - last_report_ms >= 5000) {
+            uint64_t published = upstream.published();
+            double seconds = (now_ms - last_report_ms) / 1000.0;
+            uint64_t in = received - received_at_report;
+            uint64_t out = published - published_at_report;
+            telemetry::log_out() << "[Aggregator] " << g_sessions.active_count() << " hubs, in "
+                                 << static_cast<uint64_t>(in / seconds) << " msg/s, out "
+                                 << static_cast<uint64_t>(out / seconds) << " msg/s"
+                                 << (out > 0 ? " (" + std::to_string(in / out) + ":1)" : std::string());
+            received_at_report = received;
+            published_at_report = published;
+            last_report_ms = now_ms;
+        }
+
+        if (!trace_file.empty() && telemetry::trace_dump_requested()) {
+            telemetry::write_chrome_trace(trace_file);
+        }
+
+        if (!took_any) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // ========== CLEANUP ==========
+    control.stop();
+    // Partially filled windows go out before the writer does
+    closed.clear();
+    windows.drain(closed);
+    for (const auto& window : closed) {
+        upstream.publish_rollup(window, window_ms);
+    }
+    upstream.flush();
+    telemetry::console().stop();
+
+    std::cout << "[Aggregator] Cleaning up...\n";
+    dds_health.poll();
+    for (auto& input : inputs) {
+        input->dds.close();
+    }
+    upstream_dds.close();
+
+    std::cout << "\n========== Summary ==========\n";
+    uint64_t now_ms = telemetry::wall_clock_ms();
+    std::vector<telemetry::HubSession> sessions = g_sessions.sessions();
+    std::cout << "Hub sessions: " << sessions.size();
+    if (g_sessions.dropped_count() > 0) {
+        std::cout << " (+" << g_sessions.dropped_count() << " dropped after --hub-retention)";
+    }
+    std::cout << "\n";
+    for (const auto& session : sessions) {
+        std::cout << "  " << describe_session(session, now_ms) << "\n";
+    }
+    uint64_t published = upstream.published();
+    std::cout << "Received " << received << ", published " << published << " upstream";
+    if (published > 0) {
+        std::cout << " (" << std::fixed << std::setprecision(1)
+                  << static_cast<double>(received) / static_cast<double>(published) << ":1)";
+    }
+    std::cout << "\n";
+    if (mode == OutputMode::Rollup && windows.late_samples() > 0) {
+        std::cout << "Late samples folded into a later window: " << windows.late_samples() << "\n";
+    }
+    std::cout << "Metrics:\n" << telemetry::format_metrics(telemetry::metrics().snapshot());
+
+    if (!trace_file.empty()) {
+        if (telemetry::write_chrome_trace(trace_file)) {
+            std::cout << "Trace written to " << trace_file << "\n";
+        } else {
+            std::cerr << "[ERROR] Failed to write trace to " << trace_file << "\n";
+        }
+    }
+    std::cout << "[Aggregator] Exited cleanly.\n";
+    return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Entry points of the apps. Each *_process binary calls its own from
+// main() after installing signal handlers; telemetry_all (built with
+// TELEMETRY_EMBEDDED, which leaves those main()s out) runs all three on
+// threads of one process. *_stop() asks a running instance to shut down,
+// as SIGINT does for the standalone process.
+
+int sensor_hub_main(int argc, char** argv);
+void sensor_hub_stop();
+
+int monitor_main(int argc, char** argv);
+void monitor_stop();
+
+int logger_main(int argc, char** argv);
+void logger_stop();
@@ -1,200 +1,787 @@
 #include <iostream>
-#include <fstream>
 #include <atomic>
 #include <csignal>
 #include <chrono>
 #include <thread>
 #include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
 #include <sstream>
+#include <vector>
 
 #include <dds/dds.h>
 #include "telemetry.h"
-#include <nlohmann/json.hpp>
 
 #include "../core/telemetry_types.h"
+#include "../core/log_sink.h"
+#include "../core/log_sinks.h"
+#include "../core/checkpoint.h"
+#include "../core/frame_log.h"
+#include "../core/history.h"
+#include "../core/dds_bootstrap.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "../core/async_console.h"
+#include "../core/message_codec.h"
+#include "../core/config.h"
+#include "../core/dds_health.h"
+#include "../core/perf_counters.h"
+#include "../core/alloc_accounting.h"
+#include "../core/control_socket.h"
+#include "../core/udp_transport.h"
+#include "../core/transport.h"
+#include "components.h"
+
+namespace {
 
 std::atomic<bool> g_running{true};
 std::atomic<uint64_t> g_total_logged{0};
+std::atomic<uint64_t> g_duplicates_skipped{0};
+std::atomic<uint64_t> g_history_requests{0};
+std::atomic<uint64_t> g_history_samples{0};
 
-void signal_handler(int signal) {
-    std::cout << "\n[Logger] Caught signal " << signal << ", shutting down...\n";
-    g_running = false;
+// Metrics recorded by this process; the sink workers add
+// logger.sink.<name>.write_ns and .lag_ms histograms of their own
+struct LoggerMetrics {
+    telemetry::Counter received = telemetry::metrics().counter("logger.messages_received");
+    telemetry::Counter bytes = telemetry::metrics().counter("logger.bytes_received");
+    telemetry::Counter parse_failures = telemetry::metrics().counter("logger.parse_failures");
+    telemetry::Counter duplicates = telemetry::metrics().counter("logger.duplicates_skipped");
+    telemetry::Counter logged = telemetry::metrics().counter("logger.messages_logged");
+    telemetry::Histogram latency_ms = telemetry::metrics().histogram("logger.latency_ms");
+    telemetry::Histogram parse_ns = telemetry::metrics().histogram("logger.parse_ns");
+};
+LoggerMetrics g_metrics;
+
+// Per-sink settings collected from the command line
+struct SinkOptions {
+    bool enabled = false;
+    OverflowPolicy policy = OverflowPolicy::Block;
+};
+
+void print_usage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
+    std::cout << "Options:\n";
+    std::cout << "  --output <file>          Output CSV file, appended to on restart (default: telemetry_log.csv)\n";
+    std::cout << "  --checkpoint <file>      Per-sensor high-water mark file (default: <output>.ckpt)\n";
+    std::cout << "  --fresh                  Discard previous output: CSV, checkpoint, binary segments,\n";
+    std::cout << "                           rollup and compressed log\n";
+    std::cout << "  --sinks <list>           Comma-separated sinks: csv,binary,rollup,socket,compressed (default: csv)\n";
+    std::cout << "  --binary-prefix <path>   Binary segment file prefix (default: telemetry_segment)\n";
+    std::cout << "  --segment-records <n>    Records per binary segment (default: 100000)\n";
+    std::cout << "  --rollup-output <file>   Rollup CSV file (default: telemetry_rollup.csv)\n";
+    std::cout << "  --rollup-window <ms>     Rollup window length (default: 1000)\n";
+    std::cout << "  --compressed-output <f>  Block-compressed log, seekable via <f>.idx (default: telemetry_log.mtz)\n";
+    std::cout << "  --frame-kb <n>           Raw bytes per compressed frame in KB (default: 128)\n";
+    std::cout << "  --frame-age <sec>        Seal a partial frame after this long (default: 60)\n";
+    std::cout << "  --socket-path <path>     Unix socket for the live stream (default: /tmp/telemetry_logger.sock)\n";
+    std::cout << "  --queue-capacity <n>     Per-sink queue capacity (default: 4096)\n";
+    std::cout << "  --sink-policy <sink>=<p> Overflow policy per sink: block, drop-newest, drop-oldest\n";
+    std::cout << "                           (default: block, socket uses drop-oldest)\n";
+    std::cout << "  --config <file>          Shared config file (JSON); only the DDS settings are used here\n";
+    std::cout << "  --qos <profile>          DDS QoS profile (default: default, overrides the config file)\n";
+    std::cout << telemetry::qos_profile_help();
+    std::cout << "  --domain <id>            DDS domain to subscribe in (0-232, overrides the config file)\n";
+    std::cout << "  --partition <p>          DDS partition or pattern to log, e.g. 'site-a/*'; repeatable\n";
+    std::cout << "                           (overrides the config file; history stays domain-wide)\n";
+    std::cout << "  --topic-mode <m>         shared (default) or per-type: log lab_telemetry/<type> for every\n";
+    std::cout << "                           configured sensor type (overrides the config file)\n";
+    std::cout << "  --topics <list>          Per-type topics to log, e.g. temperature,pressure (implies per-type)\n";
+    std::cout << "  --transport <t>          dds (default), udp (the hub's batched UDP frames) or inproc\n";
+    std::cout << "                           (telemetry_all only); no history service without DDS\n";
+    std::cout << "  --udp-listen <a>         UDP address to listen on, [host:]port (default: 0.0.0.0:17402)\n";
+    std::cout << "  --history-batch <n>      Samples per history reply batch (default: 500)\n";
+    std::cout << "  --no-history             Do not answer history requests\n";
+    std::cout << "  --trace <file>           Record a Chrome trace to <file>, written at exit and on SIGUSR1\n";
+    std::cout << "  --perf                   Count cycles/instructions/cache and branch misses per message\n";
+    std::cout << "  --control <path>         Control socket for live state dumps (default: /tmp/telemetry_logger.ctl)\n";
+    std::cout << "  --no-control             Do not serve a control socket\n";
+    std::cout << "  --help                   Show this help message\n";
+    std::cout << "\nExample:\n";
+    std::cout << "  " << prog_name << " --sinks csv,rollup,socket --sink-policy rollup=drop-newest\n";
 }
 
-std::string get_timestamp_string() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()
-    ) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    return ss.str();
+// Sends one history reply batch and waits for every matched reader to
+// acknowledge it, so a slow requester paces the stream instead of being flooded.
+bool send_history_batch(dds_entity_t reply_writer, const telemetry::HistoryBatch& batch) {
+    std::string payload = telemetry::encode_history_batch(batch);
+
+    Telemetry_JsonMessage reply;
+    reply.payload = dds_string_dup(payload.c_str());
+    int ret = dds_write(reply_writer, &reply);
+    dds_string_free(reply.payload);
+
+    if (ret != DDS_RETCODE_OK) {
+        static telemetry::RateLimit send_errors(5, std::chrono::seconds(1));
+        telemetry::log_err(send_errors) << "[ERROR] Failed to send history batch (code: " << ret << ")";
+        return false;
+    }
+    return dds_wait_for_acks(reply_writer, DDS_SECS(5)) == DDS_RETCODE_OK;
 }
 
-int main(int argc, char** argv) {
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
+// Answers history requests from late-joining subscribers, off the ingest path
+void history_service_func(dds_entity_t request_reader, dds_entity_t reply_writer,
+                          telemetry::HistorySource source, size_t batch_size) {
+    Telemetry_JsonMessage msg;
+    void* samples[1];
+    samples[0] = &msg;
+    dds_sample_info_t infos[1];
+    telemetry::set_trace_thread_name("history");
+
+    while (g_running) {
+        memset(&msg, 0, sizeof(msg));
+        int ret = dds_take(request_reader, samples, infos, 1, 1);
+        if (ret <= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+
+        telemetry::HistoryRequest request;
+        bool valid = infos[0].valid_data && msg.payload != NULL &&
+                     telemetry::parse_history_request(msg.payload, request);
+        dds_return_loan(request_reader, samples, ret);
+        if (!valid) {
+            continue;
+        }
+
+        g_history_requests++;
+        telemetry::log_out() << "[History] Request " << request.request_id << ": "
+                             << request.from_ts << ".." << request.to_ts;
+
+        TRACE_SCOPE("history_request");
+        telemetry::HistoryBatch batch;
+        batch.request_id = request.request_id;
+        bool connected = true;
+        uint64_t bad_frames = 0;
+        uint64_t sent = telemetry::scan_history(source, request, batch_size,
+            [&](const std::vector<telemetry::LogRecord>& records) {
+                batch.samples = records;
+                connected = send_history_batch(reply_writer, batch) && g_running;
+                batch.batch++;
+                return connected;
+            }, &bad_frames);
+
+        if (connected) {
+            batch.samples.clear();
+            batch.final = true;
+            send_history_batch(reply_writer, batch);
+        }
+        g_history_samples += sent;
+        telemetry::log_out() << "[History] Request " << request.request_id << ": sent " << sent
+                             << " samples in " << batch.batch << " batches"
+                             << (connected ? "" : " (requester stopped acknowledging)");
+        if (bad_frames > 0) {
+            telemetry::log_err() << "[ERROR] History request " << request.request_id << ": skipped "
+                                 << bad_frames << " unreadable frames in " << source.compressed_path;
+        }
+    }
+}
+
+void write_sink_stats(std::ostream& out, const std::vector<telemetry::SinkStats>& stats) {
+    for (const auto& s : stats) {
+        out << "  [" << std::setw(10) << std::left << s.name << std::right << "]"
+                  << " written: " << s.written
+                  << " | dropped: " << s.dropped
+                  << " | queue: " << s.queue_depth << "/" << s.queue_capacity
+                  << " | lag: " << s.last_lag_ms << "ms (max " << s.max_lag_ms << "ms)\n";
+    }
+}
+
+// Also refreshes the logger.sink.<name>.queue_depth gauges
+void print_sink_stats(std::ostream& out, const std::vector<telemetry::SinkStats>& stats) {
+    for (const auto& s : stats) {
+        telemetry::metrics().gauge("logger.sink." + s.name + ".queue_depth")
+            .set(static_cast<int64_t>(s.queue_depth));
+    }
+    write_sink_stats(out, stats);
+}
 
+std::string control_counts(const std::string&) {
+    std::ostringstream out;
+    out << "logged: " << g_total_logged.load() << "\n"
+        << "duplicates skipped: " << g_duplicates_skipped.load() << "\n"
+        << "history requests: " << g_history_requests.load()
+        << " (" << g_history_samples.load() << " samples)\n"
+        << "console lines dropped: " << telemetry::console().dropped_lines() << "\n";
+    return out.str();
+}
+
+} // namespace
+
+// ========== ENTRY POINTS ==========
+
+void logger_stop() {
+    g_running = false;
+}
+
+int logger_main(int argc, char** argv) {
     // Parse command line arguments
     std::string output_file = "telemetry_log.csv";
+    std::string checkpoint_file;
+    bool fresh_start = false;
+    std::string binary_prefix = "telemetry_segment";
+    uint64_t segment_records = 100000;
+    std::string rollup_file = "telemetry_rollup.csv";
+    uint64_t rollup_window_ms = 1000;
+    std::string socket_path = "/tmp/telemetry_logger.sock";
+    std::string compressed_file = "telemetry_log.mtz";
+    size_t frame_kb = 128;
+    uint64_t frame_age_sec = 60;
+    size_t queue_capacity = 4096;
+    bool history_enabled = true;
+    std::string trace_file;
+    bool perf_enabled = false;
+    telemetry::QosProfile qos_profile = telemetry::QosProfile::Default;
+    bool qos_from_cli = false;
+    dds_domainid_t domain = DDS_DOMAIN_DEFAULT;
+    bool domain_from_cli = false;
+    std::vector<std::string> partitions;
+    bool per_type_topics = false;
+    bool topic_mode_from_cli = false;
+    std::vector<std::string> topic_types;   // --topics; empty = every configured type
+    telemetry::Transport transport = telemetry::Transport::Dds;
+    std::string udp_listen = std::to_string(telemetry::UDP_LOGGER_PORT);
+    std::string config_file;
+    std::string control_path = "/tmp/telemetry_logger.ctl";
+    size_t history_batch = 500;
+
+    std::map<std::string, SinkOptions> sinks = {
+        {"csv",    {true,  OverflowPolicy::Block}},
+        {"binary", {false, OverflowPolicy::Block}},
+        {"rollup", {false, OverflowPolicy::Block}},
+        {"socket", {false, OverflowPolicy::DropOldest}},
+        {"compressed", {false, OverflowPolicy::Block}}
+    };
     
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         if (arg == "--output" && i + 1 < argc) {
             output_file = argv[++i];
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_file = argv[++i];
+        } else if (arg == "--fresh") {
+            fresh_start = true;
+        } else if (arg == "--sinks" && i + 1 < argc) {
+            for (auto& pair : sinks) {
+                pair.second.enabled = false;
+            }
+            std::stringstream list(argv[++i]);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                auto it = sinks.find(name);
+                if (it == sinks.end()) {
+                    std::cerr << "[ERROR] Unknown sink: " << name << "\n";
+                    return 1;
+                }
+                it->second.enabled = true;
+            }
+        } else if (arg == "--binary-prefix" && i + 1 < argc) {
+            binary_prefix = argv[++i];
+        } else if (arg == "--segment-records" && i + 1 < argc) {
+            segment_records = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--rollup-output" && i + 1 < argc) {
+            rollup_file = argv[++i];
+        } else if (arg == "--rollup-window" && i + 1 < argc) {
+            rollup_window_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--compressed-output" && i + 1 < argc) {
+            compressed_file = argv[++i];
+        } else if (arg == "--frame-kb" && i + 1 < argc) {
+            frame_kb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--frame-age" && i + 1 < argc) {
+            frame_age_sec = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--socket-path" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--queue-capacity" && i + 1 < argc) {
+            queue_capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--sink-policy" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            auto it = sinks.find(spec.substr(0, eq));
+            if (eq == std::string::npos || it == sinks.end() ||
+                !telemetry::parse_overflow_policy(spec.substr(eq + 1), it->second.policy)) {
+                std::cerr << "[ERROR] Invalid sink policy: " << spec << "\n";
+                return 1;
+            }
+        } else if (arg == "--history-batch" && i + 1 < argc) {
+            history_batch = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--qos" && i + 1 < argc) {
+            if (!telemetry::parse_qos_profile(argv[++i], qos_profile)) {
+                std::cerr << "[ERROR] Unknown QoS profile: " << argv[i] << "\n";
+                return 1;
+            }
+            qos_from_cli = true;
+        } else if (arg == "--domain" && i + 1 < argc) {
+            if (!telemetry::parse_domain_id(argv[++i], domain)) {
+                std::cerr << "[ERROR] Invalid domain id: " << argv[i] << " (expected 0-"
+                          << telemetry::MAX_DOMAIN_ID << ")\n";
+                return 1;
+            }
+            domain_from_cli = true;
+        } else if (arg == "--partition" && i + 1 < argc) {
+            partitions.push_back(argv[++i]);
+        } else if (arg == "--topic-mode" && i + 1 < argc) {
+            if (!telemetry::parse_topic_mode(argv[++i], per_type_topics)) {
+                std::cerr << "[ERROR] Unknown topic mode: " << argv[i] << "\n";
+                return 1;
+            }
+            topic_mode_from_cli = true;
+        } else if (arg == "--topics" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string type;
+            while (std::getline(list, type, ',')) {
+                if (!telemetry::is_valid_sensor_type(type)) {
+                    std::cerr << "[ERROR] Invalid topic type: '" << type << "'\n";
+                    return 1;
+                }
+                topic_types.push_back(type);
+            }
+            per_type_topics = true;
+            topic_mode_from_cli = true;
+        } else if (arg == "--transport" && i + 1 < argc) {
+            if (!telemetry::parse_transport(argv[++i], transport)) {
+                std::cerr << "[ERROR] Unknown transport: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--udp-listen" && i + 1 < argc) {
+            udp_listen = argv[++i];
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg == "--perf") {
+            perf_enabled = true;
+        } else if (arg == "--control" && i + 1 < argc) {
+            control_path = argv[++i];
+        } else if (arg == "--no-control") {
+            control_path.clear();
+        } else if (arg == "--no-history") {
+            history_enabled = false;
         } else if (arg == "--help") {
-            std::cout << "Usage: " << argv[0] << " [OPTIONS]\n";
-            std::cout << "Options:\n";
-            std::cout << "  --output <file>  Output CSV file (default: telemetry_log.csv)\n";
-            std::cout << "  --help           Show this help message\n";
+            print_usage(argv[0]);
             return 0;
         }
     }
 
     std::cout << "[Logger] Starting...\n";
-    std::cout << "[Logger] Output file: " << output_file << "\n";
 
-    // Open CSV file for writing
-    std::ofstream csv_file(output_file);
-    if (!csv_file.is_open()) {
-        std::cerr << "[ERROR] Failed to open output file: " << output_file << "\n";
+    // The logger only takes its DDS settings from the shared config file
+    if (!config_file.empty()) {
+        std::string error;
+        if (!telemetry::config_store().reload(config_file, error)) {
+            std::cerr << "[ERROR] Failed to load config: " << error << "\n";
+            return 1;
+        }
+        std::cout << "[Config] Loaded " << config_file << "\n";
+    }
+    if (!qos_from_cli) {
+        qos_profile = telemetry::config_store().current().qos_profile;
+    }
+    if (!domain_from_cli) {
+        domain = telemetry::config_store().current().domain;
+    }
+    if (partitions.empty()) {
+        partitions = telemetry::config_store().current().partitions;
+    }
+    if (!topic_mode_from_cli) {
+        per_type_topics = telemetry::config_store().current().per_type_topics;
+    }
+    if (per_type_topics && topic_types.empty()) {
+        topic_types = telemetry::config_store().current().sensor_types();
+    }
+
+    if (!trace_file.empty()) {
+        telemetry::enable_tracing();
+        telemetry::install_trace_dump_signal(SIGUSR1);
+        telemetry::set_trace_thread_name("ingest");
+        std::cout << "[Config] Tracing to " << trace_file << " (SIGUSR1 writes a snapshot)\n";
+    }
+
+    // ========== RESTART STATE ==========
+    if (checkpoint_file.empty()) {
+        checkpoint_file = output_file + ".ckpt";
+    }
+    if (fresh_start) {
+        std::remove(output_file.c_str());
+        std::remove(checkpoint_file.c_str());
+        std::remove(compressed_file.c_str());
+        std::remove((compressed_file + ".idx").c_str());
+        std::remove(rollup_file.c_str());
+        telemetry::remove_binary_segments(binary_prefix);
+        std::cout << "[Logger] Fresh start: previous output discarded\n";
+    }
+
+    // Samples at or below these marks are already in the CSV file. Without
+    // the CSV sink there is nothing to resume against: every sample is logged.
+    telemetry::SequenceCheckpoint resume_marks(checkpoint_file);
+    if (sinks["csv"].enabled) {
+        telemetry::recover_csv_marks(output_file, resume_marks);
+    }
+    if (!resume_marks.empty()) {
+        std::cout << "[Logger] Resuming from checkpoint " << checkpoint_file << ":\n";
+        for (const auto& pair : resume_marks.marks()) {
+            std::cout << "  Sensor " << pair.first << ": last persisted seq "
+                      << pair.second.sequence << "\n";
+        }
+    }
+
+    // ========== SINK SETUP ==========
+    telemetry::FanOutLogger fanout;
+    for (const auto& pair : sinks) {
+        const std::string& name = pair.first;
+        if (!pair.second.enabled) continue;
+
+        std::unique_ptr<telemetry::LogSink> sink;
+        if (name == "csv") {
+            sink = std::make_unique<telemetry::CsvSink>(output_file, checkpoint_file);
+            std::cout << "[Logger] CSV sink: " << output_file;
+        } else if (name == "binary") {
+            sink = std::make_unique<telemetry::BinarySegmentSink>(binary_prefix, segment_records);
+            std::cout << "[Logger] Binary sink: " << binary_prefix << ".NNNN.bin";
+        } else if (name == "rollup") {
+            sink = std::make_unique<telemetry::RollupSink>(rollup_file, rollup_window_ms);
+            std::cout << "[Logger] Rollup sink: " << rollup_file << " (" << rollup_window_ms << "ms windows)";
+        } else if (name == "socket") {
+            sink = std::make_unique<telemetry::SocketStreamSink>(socket_path);
+            std::cout << "[Logger] Socket sink: " << socket_path;
+        } else if (name == "compressed") {
+            sink = std::make_unique<telemetry::CompressedFrameSink>(
+                compressed_file, frame_kb * 1024, frame_age_sec * 1000,
+                sinks["csv"].enabled ? output_file : "");
+            std::cout << "[Logger] Compressed sink: " << compressed_file << " (" << frame_kb << "KB frames)";
+        }
+        std::cout << " [" << telemetry::overflow_policy_name(pair.second.policy) << "]\n";
+        fanout.add_sink(std::move(sink), queue_capacity, pair.second.policy);
+    }
+
+    if (fanout.sink_count() == 0) {
+        std::cerr << "[ERROR] No sinks enabled\n";
+        return 1;
+    }
+    if (!fanout.start()) {
         return 1;
     }
 
-    // Write CSV header
-    csv_file << "timestamp,sensor_id,value,sequence,received_at\n";
-    csv_file.flush();
-    std::cout << "[Logger] CSV header written\n";
+    if (transport != telemetry::Transport::Dds && per_type_topics) {
+        std::cerr << "[ERROR] Per-type topics need the DDS transport\n";
+        fanout.stop();
+        return 1;
+    }
 
     // ========== DDS INITIALIZATION ==========
-    dds_entity_t participant = dds_create_participant(DDS_DOMAIN_DEFAULT, NULL, NULL);
-    if (participant < 0) {
-        std::cerr << "[ERROR] Failed to create DDS participant\n";
-        csv_file.close();
+    // Skipped with --transport udp/inproc, and with it the history service
+    telemetry::DdsSession dds;
+    if (transport != telemetry::Transport::Dds) {
+        history_enabled = false;
+    } else if (!dds.open(qos_profile, domain)) {
+        fanout.stop();
         return 1;
     }
-    std::cout << "[DDS] Participant created\n";
-
-    dds_entity_t topic = dds_create_topic(
-        participant,
-        &Telemetry_JsonMessage_desc,
-        "lab_telemetry",
-        NULL,
-        NULL
-    );
-    if (topic < 0) {
-        std::cerr << "[ERROR] Failed to create DDS topic\n";
-        dds_delete(participant);
-        csv_file.close();
-        return 1;
+    dds.set_partitions(partitions);
+
+    if (telemetry::config_store().current().deadline_ms > 0) {
+        dds.set_deadline(DDS_MSECS(static_cast<int64_t>(telemetry::config_store().current().deadline_ms)));
     }
-    std::cout << "[DDS] Topic created\n";
+    // Middleware-side loss (history overflow, resource limits) and matched
+    // writers, polled into logger.dds.* metrics (logger.dds.<type>.* per topic)
+    telemetry::DdsHealth dds_health;
 
-    // QoS for reliable delivery with larger history
-    dds_qos_t *qos = dds_create_qos();
-    dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_SECS(10));
-    dds_qset_history(qos, DDS_HISTORY_KEEP_LAST, 100);
+    // One reader on the shared topic, or one per selected type with that
+    // type's profile. In-process, the logger keeps its DDS-reliable
+    // semantics: a full queue holds up the hub rather than drop samples.
+    std::unique_ptr<telemetry::TelemetrySubscriber> subscriber;
+    telemetry::ReaderSet readers;
+    telemetry::UdpReceiver udp;
+    if (transport == telemetry::Transport::Udp) {
+        sockaddr_in address{};
+        if (!telemetry::parse_udp_address(udp_listen, "0.0.0.0", address) || !udp.open(address, "logger.udp")) {
+            std::cerr << "[ERROR] Cannot listen for UDP on " << udp_listen << "\n";
+            fanout.stop();
+            return 1;
+        }
+        std::cout << "[UDP] Listening on " << telemetry::format_udp_address(address) << "\n";
+        subscriber = std::make_unique<telemetry::UdpSubscriber>(udp);
+    } else if (transport == telemetry::Transport::InProcess) {
+        subscriber = std::make_unique<telemetry::InProcessSubscriber>(
+            telemetry::inprocess_bus(), "logger", OverflowPolicy::Block);
+        std::cout << "[InProc] Subscribed (block)\n";
+    } else if (!per_type_topics) {
+        dds_entity_t reader = dds.create_reader();
+        if (reader < 0) {
+            std::cerr << "[ERROR] Failed to create DDS reader\n";
+            fanout.stop();
+            return 1;
+        }
+        readers.add(reader);
+        dds_health.watch_reader(reader, "logger.dds");
+        std::cout << "[DDS] Subscribed to 'lab_telemetry' (" << telemetry::partition_label(partitions) << ")\n";
+    } else {
+        for (const auto& type : topic_types) {
+            telemetry::QosProfile profile = telemetry::config_store().current().topic_profile(type, qos_profile);
+            dds_entity_t topic = dds.sensor_topic(type);
+            dds_entity_t reader = topic > 0 ? dds.create_reader(topic, profile) : topic;
+            if (reader < 0) {
+                std::cerr << "[ERROR] Failed to create DDS reader for '" << telemetry::sensor_topic_name(type) << "'\n";
+                fanout.stop();
+                return 1;
+            }
+            readers.add(reader);
+            dds_health.watch_reader(reader, "logger.dds." + type);
+            std::cout << "[DDS] Subscribed to '" << telemetry::sensor_topic_name(type) << "' ("
+                      << telemetry::qos_profile_name(profile) << ", " << telemetry::partition_label(partitions) << ")\n";
+        }
+    }
+
+    if (!subscriber) {
+        subscriber = std::make_unique<telemetry::DdsSubscriber>(readers);
+    }
 
-    dds_entity_t reader = dds_create_reader(participant, topic, qos, NULL);
-    dds_delete_qos(qos);
+    // ========== HISTORY SERVICE ==========
+    dds_entity_t request_topic = 0;
+    dds_entity_t reply_topic = 0;
+    dds_entity_t request_reader = 0;
+    dds_entity_t reply_writer = 0;
+    std::thread history_thread;
 
-    if (reader < 0) {
-        std::cerr << "[ERROR] Failed to create DDS reader\n";
-        dds_delete(topic);
-        dds_delete(participant);
-        csv_file.close();
-        return 1;
+    telemetry::HistorySource history_source;
+    if (sinks["csv"].enabled) history_source.csv_path = output_file;
+    if (sinks["compressed"].enabled) history_source.compressed_path = compressed_file;
+
+    if (history_enabled && (history_source.csv_path.size() || history_source.compressed_path.size())) {
+        request_topic = dds.create_topic(telemetry::HISTORY_REQUEST_TOPIC);
+        reply_topic = dds.create_topic(telemetry::HISTORY_REPLY_TOPIC);
+
+        dds_qos_t *request_qos = dds_create_qos();
+        dds_qset_reliability(request_qos, DDS_RELIABILITY_RELIABLE, DDS_SECS(10));
+        dds_qset_history(request_qos, DDS_HISTORY_KEEP_LAST, 16);
+        request_reader = dds_create_reader(dds.participant(), request_topic, request_qos, NULL);
+        dds_delete_qos(request_qos);
+
+        // KEEP_ALL with a small cap: writes block instead of overwriting unacked batches
+        dds_qos_t *reply_qos = dds_create_qos();
+        dds_qset_reliability(reply_qos, DDS_RELIABILITY_RELIABLE, DDS_SECS(10));
+        dds_qset_history(reply_qos, DDS_HISTORY_KEEP_ALL, 0);
+        dds_qset_resource_limits(reply_qos, 16, DDS_LENGTH_UNLIMITED, DDS_LENGTH_UNLIMITED);
+        reply_writer = dds_create_writer(dds.participant(), reply_topic, reply_qos, NULL);
+        dds_delete_qos(reply_qos);
+
+        if (request_topic < 0 || reply_topic < 0 || request_reader < 0 || reply_writer < 0) {
+            std::cerr << "[ERROR] Failed to create history service entities, continuing without\n";
+        } else {
+            history_thread = std::thread(history_service_func, request_reader, reply_writer,
+                                         history_source, history_batch);
+            std::cout << "[DDS] History service on '" << telemetry::HISTORY_REQUEST_TOPIC << "'\n";
+        }
     }
-    
-    std::cout << "[DDS] Subscribed to 'lab_telemetry'\n";
+
+    // ========== CONTROL SOCKET ==========
+    // Served from its own thread; sink stats are atomics plus a short lock
+    // per queue, so ingest and the sinks keep running during a dump
+    telemetry::ControlServer control;
+    control.add_command("queues", "Per-sink queue depth, drops and lag", [&fanout](const std::string&) {
+        std::ostringstream out;
+        write_sink_stats(out, fanout.stats());
+        return out.str();
+    });
+    control.add_command("counts", "Messages logged, duplicates skipped, history requests served", control_counts);
+    if (!control_path.empty() && control.start(control_path)) {
+        std::cout << "[Control] Listening on " << control_path << " (try: echo help | nc -U "
+                  << control_path << ")\n";
+    }
+
     std::cout << "[Logger] Listening for messages (Ctrl+C to stop)...\n\n";
 
+    // Console output from here on goes through the console thread
+    telemetry::console().start();
+    telemetry::RateLimit ingest_errors(5, std::chrono::seconds(1));
+
     // ========== MAIN LOOP ==========
-    Telemetry_JsonMessage msg;
-    void* samples[1];
-    samples[0] = &msg;
-    dds_sample_info_t infos[1];
+    telemetry::ReceivedMessage received;
     
-    auto last_flush = std::chrono::steady_clock::now();
-    constexpr int FLUSH_INTERVAL_MS = 1000; // Flush every second
+    auto last_stats = std::chrono::steady_clock::now();
+    auto last_health_poll = last_stats;
+    constexpr int STATS_INTERVAL_MS = 10000; // Sink lag report every 10 seconds
+
+    // Hardware counters per ingested message (--perf), on this thread only;
+    // sink threads are not counted
+    std::unique_ptr<telemetry::PerfRegion> perf_ingest;
+    if (perf_enabled) {
+        perf_ingest = std::make_unique<telemetry::PerfRegion>("parse+fanout");
+    }
+    // Heap allocations per ingested message (-DTELEMETRY_ALLOC_ACCOUNTING=ON builds)
+    std::unique_ptr<telemetry::AllocRegion> alloc_ingest;
+    if (telemetry::alloc_accounting_enabled()) {
+        alloc_ingest = std::make_unique<telemetry::AllocRegion>("parse+fanout");
+    }
     
     while(g_running) {
-        memset(&msg, 0, sizeof(msg));
-        
-        int ret = dds_take(reader, samples, infos, 1, 1);
+        bool got;
+        {
+            TRACE_SCOPE("take");
+            got = subscriber->take(received);
+        }
         
-        if (ret > 0 && infos[0].valid_data) {
-            if (msg.payload == NULL) {
-                std::cerr << "[ERROR] Received NULL payload\n";
+        if (got) {
+            if (!received.decoded && received.payload == NULL) {
+                telemetry::log_err(ingest_errors) << "[ERROR] Received NULL payload";
                 continue;
             }
+            telemetry::PerfScope perf_scope(perf_ingest.get());
+            telemetry::AllocScope alloc_scope(alloc_ingest.get());
             
-            try {
-                nlohmann::json j = nlohmann::json::parse(msg.payload);
-                
-                int sensor_id = j["id"];
-                double value = j["value"];
-                uint64_t timestamp = j["timestamp"];
-                uint64_t sequence = j["sequence"];
+            g_metrics.received.add();
+            telemetry::LogRecord record;
+            // In-process samples arrive decoded
+            bool parsed = received.decoded;
+            if (parsed) {
+                record.data = received.sample.data;
+                record.sequence = received.sample.sequence;
+            } else {
+                TRACE_SCOPE("parse");
+                g_metrics.bytes.add(received.len);
+                auto parse_start = std::chrono::steady_clock::now();
+                parsed = telemetry::parse_sensor_message(received.payload, record.data, record.sequence);
+                if (parsed) {
+                    g_metrics.parse_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - parse_start).count());
+                }
+            }
+            if (parsed) {
+                record.received_ms = telemetry::wall_clock_ms();
+                g_metrics.latency_ms.record(record.received_ms > static_cast<uint64_t>(record.data.timestamp)
+                                                ? record.received_ms - record.data.timestamp : 0);
                 
-                std::string received_at = get_timestamp_string();
+                // Skip what a previous run already persisted
+                if (resume_marks.covers(record.data.id, record.sequence, record.data.timestamp)) {
+                    g_duplicates_skipped++;
+                    g_metrics.duplicates.add();
+                    continue;
+                }
                 
-                // Write to CSV: timestamp,sensor_id,value,sequence,received_at
-                csv_file << timestamp << ","
-                         << sensor_id << ","
-                         << std::fixed << std::setprecision(2) << value << ","
-                         << sequence << ","
-                         << received_at << "\n";
+                // Hand off to every sink; formatting and I/O happen on the sink threads
+                {
+                    TRACE_SCOPE("publish");
+                    fanout.publish(record);
+                }
                 
                 g_total_logged++;
+                g_metrics.logged.add();
                 
                 // Print progress every 25 messages
                 if (g_total_logged % 25 == 0) {
-                    std::cout << "[Logger] Logged " << g_total_logged 
-                              << " messages (Sensor " << sensor_id 
-                              << ", seq: " << sequence << ")\n";
+                    telemetry::log_out() << "[Logger] Logged " << g_total_logged.load()
+                                         << " messages (Sensor " << record.data.id
+                                         << ", seq: " << record.sequence << ")";
                 }
                 
-            } catch (const std::exception& e) {
-                std::cerr << "[ERROR] Failed to parse message: " << e.what() << "\n";
+            } else {
+                g_metrics.parse_failures.add();
+                telemetry::log_err(ingest_errors) << "[ERROR] Failed to parse message: " << received.payload;
             }
-            
-            dds_return_loan(reader, samples, ret);
         }
         
-        // Periodic flush to ensure data is written to disk
+        // Periodic per-sink lag report
         auto now = std::chrono::steady_clock::now();
         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - last_flush
+            now - last_stats
         ).count();
         
-        if (elapsed > FLUSH_INTERVAL_MS) {
-            csv_file.flush();
-            last_flush = now;
+        if (now - last_health_poll >= std::chrono::seconds(1)) {
+            dds_health.poll();
+            last_health_poll = now;
+        }
+
+        if (elapsed > STATS_INTERVAL_MS) {
+            TRACE_SCOPE("stats");
+            std::ostringstream report;
+            report << "[Logger] Sink status:\n";
+            print_sink_stats(report, fanout.stats());
+            telemetry::DdsHealthCounts health = dds_health.totals();
+            if (health.sample_lost > 0 || health.sample_rejected > 0) {
+                report << "[Logger] DDS reader lost " << health.sample_lost
+                       << " and rejected " << health.sample_rejected << " samples so far\n";
+            }
+            telemetry::console().write(telemetry::ConsoleStream::Out, report.str());
+            last_stats = now;
+        }
+        
+        if (!trace_file.empty() && telemetry::trace_dump_requested()) {
+            telemetry::write_chrome_trace(trace_file);
+            telemetry::log_out() << "[Trace] Snapshot written to " << trace_file;
         }
         
-        // Small sleep to avoid busy-waiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // Small sleep to avoid busy-waiting; only when idle, so bursts drain
+        // at full speed
+        if (!got) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
     }
 
     // ========== CLEANUP ==========
-    std::cout << "\n[Logger] Cleaning up...\n";
+    control.stop();
+    telemetry::log_out() << "\n[Logger] Cleaning up...";
     
-    // Final flush
-    csv_file.flush();
-    csv_file.close();
+    if (history_thread.joinable()) {
+        history_thread.join();
+    }
+
+    // Drain, flush and close every sink
+    fanout.stop();
+
+    telemetry::console().stop();
     
-    dds_delete(reader);
-    dds_delete(topic);
-    dds_delete(participant);
+    dds_health.poll();
+    subscriber.reset();   // returns its last loan, or leaves the in-process bus
+    dds.close();
 
     std::cout << "\n========== Summary ==========\n";
     std::cout << "Total messages logged: " << g_total_logged.load() << "\n";
-    std::cout << "Output file: " << output_file << "\n";
+    std::cout << "Duplicates skipped: " << g_duplicates_skipped.load() << "\n";
+    telemetry::DdsHealthCounts health = dds_health.totals();
+    std::cout << "Lost inside DDS: " << health.sample_lost << " (rejected: " << health.sample_rejected
+              << ", deadline missed: " << health.requested_deadline_missed << ")\n";
+    if (transport == telemetry::Transport::Udp) {
+        const telemetry::UdpReceiverStats& stats = udp.stats();
+        std::cout << "UDP: " << stats.records << " messages in " << stats.datagrams << " frames; frames lost: "
+                  << stats.frames_lost << ", reordered: " << stats.frames_reordered
+                  << ", malformed: " << stats.malformed << "\n";
+    }
+    if (telemetry::console().dropped_lines() > 0) {
+        std::cout << "Console lines dropped: " << telemetry::console().dropped_lines() << "\n";
+    }
+    std::cout << "History requests served: " << g_history_requests.load()
+              << " (" << g_history_samples.load() << " samples)\n";
+    std::cout << "Sinks:\n";
+    print_sink_stats(std::cout, fanout.stats());
+    if (perf_ingest) {
+        std::cout << "Perf: " << perf_ingest->summary() << "\n";
+    }
+    if (alloc_ingest) {
+        std::cout << "Allocations: " << alloc_ingest->summary() << "\n";
+    }
+    std::cout << "Metrics:\n" << telemetry::format_metrics(telemetry::metrics().snapshot());
+
+    if (!trace_file.empty()) {
+        if (telemetry::write_chrome_trace(trace_file)) {
+            std::cout << "Trace written to " << trace_file << "\n";
+        } else {
+            std::cerr << "[ERROR] Failed to write trace to " << trace_file << "\n";
+        }
+    }
     std::cout << "[Logger] Exited cleanly.\n";
     
     return 0;
-}
\ No newline at end of file
+}
+#ifndef TELEMETRY_EMBEDDED
+void signal_handler(int signal) {
+    std::cout << "\n[Logger] Caught signal " << signal << ", shutting down...\n";
+    logger_stop();
+}
+
+int main(int argc, char** argv) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    return logger_main(argc, argv);
+}
+#endif
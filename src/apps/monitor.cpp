@@ -1,95 +1,199 @@
 #include <iostream>
+#include <algorithm>
 #include <atomic>
 #include <csignal>
 #include <chrono>
 #include <thread>
 #include <map>
+#include <memory>
 #include <iomanip>
 #include <mutex>
 #include <cstring>
-#include <set>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
 
 #include <dds/dds.h>
 #include "telemetry.h"
-#include <nlohmann/json.hpp>
 
 #include "../core/telemetry_types.h"
+#include "../core/history.h"
+#include "../core/dds_bootstrap.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "../core/async_console.h"
+#include "../core/message_codec.h"
+#include "../core/config.h"
+#include "../core/dds_health.h"
+#include "../core/executor.h"
+#include "../core/perf_counters.h"
+#include "../core/alloc_accounting.h"
+#include "../core/control_socket.h"
+#include "../core/udp_transport.h"
+#include "../core/transport.h"
+#include "../core/sensor_state.h"
+#include "components.h"
+
+namespace {
 
 std::atomic<bool> g_running{true};
 
-// Sensor metadata
-struct SensorMetadata {
-    std::string name;
-    std::string unit;
+// Metrics recorded by this process (printed in the final summary)
+struct MonitorMetrics {
+    telemetry::Counter received = telemetry::metrics().counter("monitor.messages_received");
+    telemetry::Counter bytes = telemetry::metrics().counter("monitor.bytes_received");
+    telemetry::Counter parse_failures = telemetry::metrics().counter("monitor.parse_failures");
+    telemetry::Counter duplicates = telemetry::metrics().counter("monitor.duplicates");
+    telemetry::Counter history_samples = telemetry::metrics().counter("monitor.history_samples");
+    telemetry::Histogram latency_ms = telemetry::metrics().histogram("monitor.latency_ms");
+    telemetry::Histogram parse_ns = telemetry::metrics().histogram("monitor.parse_ns");
+
+    // Per-stage breakdown from messages carrying hub stamps (hub --stamps), µs
+    telemetry::Histogram stage_enqueue = telemetry::metrics().histogram("monitor.stage.sample_to_enqueue_us");
+    telemetry::Histogram stage_queue = telemetry::metrics().histogram("monitor.stage.hub_queue_us");
+    telemetry::Histogram stage_encode = telemetry::metrics().histogram("monitor.stage.encode_us");
+    telemetry::Histogram stage_dds = telemetry::metrics().histogram("monitor.stage.dds_and_poll_us");
+    telemetry::Histogram stage_process = telemetry::metrics().histogram("monitor.stage.process_us");
+    telemetry::Histogram stage_total = telemetry::metrics().histogram("monitor.stage.end_to_end_us");
 };
+MonitorMetrics g_metrics;
 
-const std::map<int, SensorMetadata> SENSOR_CONFIG = {
-    {0, {"Temperature", "°C"}},
-    {1, {"Pressure", "hPa"}},
-    {2, {"Humidity", "%"}}
+// Stage names as shown on the dashboard, in pipeline order
+const std::pair<const char*, const char*> STAGE_HISTOGRAMS[] = {
+    {"enqueue", "monitor.stage.sample_to_enqueue_us"},
+    {"hub queue", "monitor.stage.hub_queue_us"},
+    {"encode", "monitor.stage.encode_us"},
+    {"dds+poll", "monitor.stage.dds_and_poll_us"},
+    {"process", "monitor.stage.process_us"},
+    {"total", "monitor.stage.end_to_end_us"},
 };
 
+// DDS-side loss on the telemetry reader, so sequence gaps can be attributed
+// (polled from the main loop, read by the dashboard)
+telemetry::DdsHealth g_dds_health;
+
+
 // Per-sensor tracking
-struct SensorState {
-    uint64_t expected_seq = 0;
-    uint64_t message_count = 0;
-    uint64_t dropped_count = 0;
-    
-    double current_value = 0.0;
-    double min_value = 1e9;
-    double max_value = -1e9;
-    double sum_value = 0.0;
-    
-    uint64_t last_timestamp = 0;
-    uint64_t last_received_ms = 0;
-    bool initialized = false;
-    
-    std::set<uint64_t> seen_sequences;
-};
+using telemetry::SensorState;
 
 std::map<int, SensorState> g_sensors;
 std::mutex g_sensor_mutex;
 
 // Rate limiting
 uint64_t g_last_print_ms = 0;
-const uint64_t REFRESH_INTERVAL_MS = 200; // Update every 200ms
 bool g_first_print = true;
 
-void signal_handler(int signal) {
-    std::cout << "\n[Monitor] Caught signal " << signal << ", shutting down...\n";
-    g_running = false;
-}
-
 uint64_t get_current_time_ms() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now().time_since_epoch()
     ).count();
 }
 
+// Applies one sample to the per-sensor state. Returns false for a duplicate.
+bool ingest_sample(int sensor_id, double value, uint64_t timestamp, uint64_t sequence) {
+    TRACE_SCOPE("stats");
+    uint64_t now_ms = get_current_time_ms();
+
+    std::lock_guard<std::mutex> lock(g_sensor_mutex);
+    return g_sensors[sensor_id].ingest(value, timestamp, sequence, now_ms);
+}
+
+// Records the hub's stamps plus this process's taken/processed stamps.
+// Stamps from another host can be skewed; negative spans count as 0.
+void record_stage_latency(const telemetry::StageStamps& s, uint64_t taken_us, uint64_t processed_us) {
+    auto span = [](uint64_t from, uint64_t to) -> uint64_t { return to > from ? to - from : 0; };
+    g_metrics.stage_enqueue.record(span(s.sampled_us, s.enqueued_us));
+    g_metrics.stage_queue.record(span(s.enqueued_us, s.dequeued_us));
+    g_metrics.stage_encode.record(span(s.dequeued_us, s.written_us));
+    g_metrics.stage_dds.record(span(s.written_us, taken_us));
+    g_metrics.stage_process.record(span(taken_us, processed_us));
+    g_metrics.stage_total.record(span(s.sampled_us, processed_us));
+}
+
+// Sensor names and units come from the live config (telemetry::config_store())
 std::string get_sensor_name(int id) {
-    auto it = SENSOR_CONFIG.find(id);
-    if (it != SENSOR_CONFIG.end()) {
-        return it->second.name;
+    const telemetry::SensorConfig* sensor = telemetry::config_store().current().find_sensor(id);
+    if (sensor != nullptr) {
+        return sensor->name;
     }
     return "Unknown";
 }
 
 std::string get_sensor_unit(int id) {
-    auto it = SENSOR_CONFIG.find(id);
-    if (it != SENSOR_CONFIG.end()) {
-        return it->second.unit;
+    const telemetry::SensorConfig* sensor = telemetry::config_store().current().find_sensor(id);
+    if (sensor != nullptr) {
+        return sensor->unit;
     }
     return "";
 }
 
-void move_cursor_home() {
+// ========== CONTROL COMMANDS ==========
+// Run on the control socket thread. The sensor table is copied under its
+// mutex and formatted afterwards, so ingest waits at most for the copy.
+
+std::string control_sensors(const std::string&) {
+    std::map<int, SensorState> copy;
+    {
+        std::lock_guard<std::mutex> lock(g_sensor_mutex);
+        for (const auto& [id, state] : g_sensors) {
+            SensorState& entry = copy[id];
+            entry.expected_seq = state.expected_seq;
+            entry.message_count = state.message_count;
+            entry.dropped_count = state.dropped_count;
+            entry.current_value = state.current_value;
+            entry.min_value = state.min_value;
+            entry.max_value = state.max_value;
+            entry.last_received_ms = state.last_received_ms;
+        }
+    }
+    uint64_t now_ms = get_current_time_ms();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    for (const auto& [id, state] : copy) {
+        out << "  sensor " << id << " " << get_sensor_name(id)
+            << "  value " << state.current_value << " " << get_sensor_unit(id)
+            << "  min " << state.min_value << "  max " << state.max_value
+            << "  messages " << state.message_count << "  dropped " << state.dropped_count
+            << "  next seq " << state.expected_seq
+            << "  age " << (state.message_count > 0 ? now_ms - state.last_received_ms : 0) << " ms\n";
+    }
+    if (copy.empty()) {
+        out << "no sensors seen yet\n";
+    }
+    return out.str();
+}
+
+// Set by the "refresh" control command until the next config reload; 0 =
+// use the config's value. Kept out of the config so a command can't race a
+// SIGHUP reload or leave another retired config behind on every call.
+std::atomic<uint64_t> g_refresh_override_ms{0};
+
+uint64_t refresh_interval_ms() {
+    uint64_t override_ms = g_refresh_override_ms.load(std::memory_order_relaxed);
+    return override_ms > 0 ? override_ms : telemetry::config_store().current().monitor_refresh_ms;
+}
+
+// Overrides the interval; a SIGHUP reload goes back to the file's value.
+std::string control_refresh(const std::string& args) {
+    if (!args.empty()) {
+        long ms = std::atol(args.c_str());
+        if (ms <= 0) {
+            return "usage: refresh [ms]\n";
+        }
+        g_refresh_override_ms = static_cast<uint64_t>(ms);
+    }
+    return "refresh " + std::to_string(refresh_interval_ms()) + " ms\n";
+}
+
+void move_cursor_home(std::ostream& out = std::cout) {
     // Move cursor to home position without clearing
-    std::cout << "\033[H";
+    out << "\033[H";
 }
 
-void clear_screen_once() {
+void clear_screen_once(std::ostream& out = std::cout) {
     // Clear screen only on first print
-    std::cout << "\033[2J\033[H";
+    out << "\033[2J\033[H";
 }
 
 void hide_cursor() {
@@ -101,6 +205,7 @@ void show_cursor() {
 }
 
 void print_dashboard() {
+    TRACE_SCOPE("render");
     std::lock_guard<std::mutex> lock(g_sensor_mutex);
     
     bool has_data = false;
@@ -115,17 +220,20 @@ void print_dashboard() {
         return;
     }
     
+    // Rendered off-screen; the console thread does the (possibly slow) terminal write
+    std::ostringstream out;
+
     // Only clear screen on first print, then just move cursor home
     if (g_first_print) {
-        clear_screen_once();
+        clear_screen_once(out);
         g_first_print = false;
     } else {
-        move_cursor_home();
+        move_cursor_home(out);
     }
 
-    std::cout << "╔══════════════════════════════════════════════════════════════════════════════╗\n";
-    std::cout << "║                      LIVE TELEMETRY DASHBOARD                                ║\n";
-    std::cout << "╚══════════════════════════════════════════════════════════════════════════════╝\n\n";
+    out << "╔══════════════════════════════════════════════════════════════════════════════╗\n";
+    out << "║                      LIVE TELEMETRY DASHBOARD                                ║\n";
+    out << "╚══════════════════════════════════════════════════════════════════════════════╝\n\n";
     
     for (const auto& pair : g_sensors) {
         int id = pair.first;
@@ -137,171 +245,555 @@ void print_dashboard() {
         std::string name = get_sensor_name(id);
         std::string unit = get_sensor_unit(id);
         
-        std::cout << "┌─ Sensor " << id << ": " << std::setw(11) << std::left << name << " ─────────────────────────────────────────────────────┐\n";
-        std::cout << "│ Current: " << std::fixed << std::setprecision(2) 
+        out << "┌─ Sensor " << id << ": " << std::setw(11) << std::left << name << " ─────────────────────────────────────────────────────┐\n";
+        out << "│ Current: " << std::fixed << std::setprecision(2) 
                   << std::setw(8) << std::right << state.current_value << " " 
                   << std::setw(4) << std::left << unit;
-        std::cout << " │ Min: " << std::setw(8) << state.min_value
+        out << " │ Min: " << std::setw(8) << state.min_value
                   << " │ Max: " << std::setw(8) << state.max_value
                   << " │ Avg: " << std::setw(8) << avg << " │\n";
-        std::cout << "│ Messages: " << std::setw(5) << state.message_count;
+        out << "│ Messages: " << std::setw(5) << state.message_count;
         
         if (state.dropped_count > 0) {
-            std::cout << " │ ⚠ DROPPED: " << std::setw(5) << state.dropped_count << " ";
+            out << " │ ⚠ DROPPED: " << std::setw(5) << state.dropped_count << " ";
         } else {
-            std::cout << " │ ✓ No drops      ";
+            out << " │ ✓ No drops      ";
         }
-        std::cout << "                                         │\n";
-        std::cout << "└───────────────────────────────────────────────────────────────────────────┘\n";
+        out << "                                         │\n";
+        out << "└───────────────────────────────────────────────────────────────────────────┘\n";
     }
     
-    std::cout << "\n";
-    std::cout << "Last Update: " << std::fixed << std::setprecision(3) 
+    telemetry::DdsHealthCounts health = g_dds_health.totals();
+    out << "\nDDS reader: lost " << health.sample_lost << " │ rejected " << health.sample_rejected
+        << " │ deadline missed " << health.requested_deadline_missed
+        << " │ writers matched " << health.matched << "          \n";
+    // Latency breakdown, once stamped messages have arrived
+    telemetry::MetricsSnapshot snapshot = telemetry::metrics().snapshot();
+    auto total = snapshot.histograms.find("monitor.stage.end_to_end_us");
+    if (total != snapshot.histograms.end() && total->second.count > 0) {
+        out << "Stage p50/p99 (µs):";
+        for (const auto& stage : STAGE_HISTOGRAMS) {
+            const telemetry::HistogramSnapshot& h = snapshot.histograms[stage.second];
+            out << " " << stage.first << " " << h.percentile(50) << "/" << h.percentile(99);
+        }
+        out << "          \n";
+    }
+    out << "Last Update: " << std::fixed << std::setprecision(3) 
               << get_current_time_ms() / 1000.0 << "s | Press Ctrl+C to stop";
     
     // Add extra lines to clear any leftover content from previous prints
-    std::cout << "\n\n\n\n";
+    out << "\n\n\n\n";
 
-    std::cout << std::flush;
+    telemetry::console().replace_frame(out.str());
 }
 
-int main() {
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
+// Asks the logger for the last `seconds` of data and ingests the replies
+// before live processing starts. Returns the number of samples received.
+uint64_t fetch_history(telemetry::DdsSession& dds, int seconds) {
+    dds_entity_t participant = dds.participant();
+    dds_entity_t request_topic = dds.create_topic(telemetry::HISTORY_REQUEST_TOPIC);
+    dds_entity_t reply_topic = dds.create_topic(telemetry::HISTORY_REPLY_TOPIC);
+    if (request_topic < 0 || reply_topic < 0) {
+        std::cerr << "[ERROR] Failed to create history topics\n";
+        return 0;
+    }
+
+    dds_qos_t *qos = dds_create_qos();
+    dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_SECS(10));
+    dds_qset_history(qos, DDS_HISTORY_KEEP_ALL, 0);
+    dds_entity_t request_writer = dds_create_writer(participant, request_topic, qos, NULL);
+    dds_entity_t reply_reader = dds_create_reader(participant, reply_topic, qos, NULL);
+    dds_delete_qos(qos);
+
+    // Wait until the logger's endpoints are matched, or the request goes nowhere
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    dds_publication_matched_status_t pub_status{};
+    dds_subscription_matched_status_t sub_status{};
+    while (g_running && std::chrono::steady_clock::now() < deadline) {
+        dds_get_publication_matched_status(request_writer, &pub_status);
+        dds_get_subscription_matched_status(reply_reader, &sub_status);
+        if (pub_status.current_count > 0 && sub_status.current_count > 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    uint64_t received = 0;
+    if (pub_status.current_count == 0 || sub_status.current_count == 0) {
+        std::cout << "[History] No logger answering history requests\n";
+    } else {
+        uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+
+        telemetry::HistoryRequest request;
+        request.request_id = "monitor-" + std::to_string(getpid()) + "-" + std::to_string(now);
+        request.from_ts = static_cast<long>(now) - seconds * 1000L;
+        request.to_ts = static_cast<long>(now);
+
+        std::string payload = telemetry::encode_history_request(request);
+        Telemetry_JsonMessage msg;
+        msg.payload = dds_string_dup(payload.c_str());
+        dds_write(request_writer, &msg);
+        dds_string_free(msg.payload);
+        std::cout << "[History] Requested last " << seconds << "s\n";
+
+        // Stream batches until the final one; give up if the logger goes quiet
+        void* samples[1];
+        samples[0] = &msg;
+        dds_sample_info_t infos[1];
+        auto last_batch = std::chrono::steady_clock::now();
+        bool done = false;
+
+        while (g_running && !done &&
+               std::chrono::steady_clock::now() - last_batch < std::chrono::seconds(5)) {
+            memset(&msg, 0, sizeof(msg));
+            int ret = dds_take(reply_reader, samples, infos, 1, 1);
+            if (ret <= 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+
+            telemetry::HistoryBatch batch;
+            if (infos[0].valid_data && msg.payload != NULL &&
+                telemetry::parse_history_batch(msg.payload, batch) &&
+                batch.request_id == request.request_id) {
+                for (const auto& r : batch.samples) {
+                    ingest_sample(r.data.id, r.data.value, r.data.timestamp, r.sequence);
+                }
+                received += batch.samples.size();
+                g_metrics.history_samples.add(batch.samples.size());
+                done = batch.final;
+                last_batch = std::chrono::steady_clock::now();
+            }
+            dds_return_loan(reply_reader, samples, ret);
+        }
+        std::cout << "[History] Received " << received << " samples"
+                  << (done ? "" : " (incomplete)") << "\n";
+    }
+
+    dds_delete(reply_reader);
+    dds_delete(request_writer);
+    dds_delete(reply_topic);
+    dds_delete(request_topic);
+    return received;
+}
+
+// ========== PIPELINE ==========
+// The main loop as coroutines on one executor, driven by the monitor's own
+// thread (so --perf/--alloc regions, which count per thread, stay valid):
+// ingest (take -> parse -> stats) wakes on the DDS read condition, render
+// and housekeeping on timers. Nothing sleeps a fixed 10 ms between polls.
+
+// How long an idle ingest waits for the reader before checking g_running
+constexpr auto INGEST_IDLE_WAIT = std::chrono::milliseconds(100);
+// UDP and in-process subscribers have no read condition: poll at this rate
+constexpr auto INGEST_POLL_INTERVAL = std::chrono::milliseconds(10);
+// Messages handled per burst before giving the other stages a turn
+constexpr int INGEST_BURST = 256;
+constexpr auto HOUSEKEEPING_INTERVAL = std::chrono::milliseconds(100);
+// Longest render sleep, so shutdown and refresh changes are noticed
+constexpr uint64_t RENDER_MAX_WAIT_MS = 100;
+
+struct Pipeline {
+    telemetry::Executor& executor;
+    telemetry::TelemetrySubscriber& subscriber;
+    telemetry::DdsReadWaiter* dds_waiter;   // null off DDS
+    std::vector<dds_entity_t> readers;
+    telemetry::PerfRegion* perf_ingest;
+    telemetry::AllocRegion* alloc_ingest;
+    std::string trace_file;
+    std::string config_file;
+    bool data_updated = false;   // one executor thread, so no atomic
+};
+
+// Parses (unless in-process) and applies one message. Returns whether the
+// dashboard has something new.
+bool ingest_message(telemetry::ReceivedMessage& received, Pipeline& pipeline) {
+    uint64_t taken_us = telemetry::wall_clock_us();
+    telemetry::PerfScope perf_scope(pipeline.perf_ingest);
+    telemetry::AllocScope alloc_scope(pipeline.alloc_ingest);
+
+    g_metrics.received.add();
+    auto parse_start = std::chrono::steady_clock::now();
+    SensorData& sample = received.sample.data;
+    uint64_t& sequence = received.sample.sequence;
+    telemetry::StageStamps& stamps = received.sample.stamps;
+    // In-process samples arrive decoded
+    bool parsed = received.decoded;
+    if (!parsed) {
+        TRACE_SCOPE("parse");
+        g_metrics.bytes.add(received.len);
+        parsed = telemetry::parse_sensor_message(received.payload, sample, sequence, &stamps);
+        if (parsed) {
+            g_metrics.parse_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - parse_start).count());
+        }
+    }
+    if (!parsed) {
+        // Silently skip parse errors during live display
+        g_metrics.parse_failures.add();
+        return false;
+    }
+    uint64_t timestamp = static_cast<uint64_t>(sample.timestamp);
+    uint64_t now_ms = telemetry::wall_clock_ms();
+    g_metrics.latency_ms.record(now_ms > timestamp ? now_ms - timestamp : 0);
+
+    bool updated = ingest_sample(sample.id, sample.value, timestamp, sequence);
+    if (!updated) {
+        g_metrics.duplicates.add();
+    }
+    if (stamps.present) {
+        record_stage_latency(stamps, taken_us, telemetry::wall_clock_us());
+    }
+    return updated;
+}
+
+telemetry::Task<> ingest_stage(Pipeline& pipeline) {
+    telemetry::ReceivedMessage received;
+    int burst = 0;
+    while (g_running) {
+        bool got;
+        {
+            TRACE_SCOPE("take");
+            got = pipeline.subscriber.take(received);
+        }
+        if (!got) {
+            burst = 0;
+            if (pipeline.dds_waiter != nullptr) {
+                co_await pipeline.dds_waiter->readable(pipeline.readers, INGEST_IDLE_WAIT);
+            } else {
+                co_await pipeline.executor.sleep_for(INGEST_POLL_INTERVAL);
+            }
+            continue;
+        }
+        if (received.decoded || received.payload != NULL) {
+            pipeline.data_updated |= ingest_message(received, pipeline);
+        }
+        if (++burst == INGEST_BURST) {
+            burst = 0;
+            co_await pipeline.executor.schedule();
+        }
+    }
+}
+
+// Draws a frame when there is new data and the refresh interval has passed
+telemetry::Task<> render_stage(Pipeline& pipeline) {
+    while (g_running) {
+        uint64_t now_ms = get_current_time_ms();
+        uint64_t due_ms = g_last_print_ms + refresh_interval_ms();
+        if (pipeline.data_updated && now_ms >= due_ms) {
+            print_dashboard();
+            g_last_print_ms = now_ms;
+            pipeline.data_updated = false;
+            continue;
+        }
+        uint64_t wait_ms = now_ms < due_ms ? std::min(due_ms - now_ms, RENDER_MAX_WAIT_MS) : RENDER_MAX_WAIT_MS;
+        co_await pipeline.executor.sleep_for(std::chrono::milliseconds(wait_ms));
+    }
+}
+
+// DDS health, trace snapshots and config reloads
+telemetry::Task<> housekeeping_stage(Pipeline& pipeline) {
+    uint64_t last_health_poll_ms = 0;
+    while (g_running) {
+        uint64_t now_ms = get_current_time_ms();
+        if (now_ms - last_health_poll_ms >= 1000) {
+            g_dds_health.poll();
+            last_health_poll_ms = now_ms;
+        }
+        if (!pipeline.trace_file.empty() && telemetry::trace_dump_requested()) {
+            telemetry::write_chrome_trace(pipeline.trace_file);
+        }
+        // Names, units and refresh rate are read per frame, so a reload
+        // shows up on the next dashboard refresh
+        if (!pipeline.config_file.empty() && telemetry::config_reload_requested()) {
+            std::string error;
+            if (telemetry::config_store().reload(pipeline.config_file, error)) {
+                g_refresh_override_ms = 0;
+            } else {
+                telemetry::log_err() << "[ERROR] Config reload failed, keeping current config: " << error;
+            }
+            pipeline.data_updated = true;
+        }
+        co_await pipeline.executor.sleep_for(HOUSEKEEPING_INTERVAL);
+    }
+}
+
+void print_usage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
+    std::cout << "Options:\n";
+    std::cout << "  --history <sec>  Warm up with the last <sec> seconds from the logger\n";
+    std::cout << "  --config <file>  Sensor/QoS config file (JSON); SIGHUP reloads it\n";
+    std::cout << "  --qos <profile>  DDS QoS profile (default: default, overrides the config file)\n";
+    std::cout << telemetry::qos_profile_help();
+    std::cout << "  --domain <id>    DDS domain to subscribe in (0-232, overrides the config file)\n";
+    std::cout << "  --partition <p>  DDS partition or pattern to subscribe to, e.g. 'site-a/*'; repeatable\n";
+    std::cout << "                   (overrides the config file)\n";
+    std::cout << "  --topic-mode <m> shared (default) or per-type: read lab_telemetry/<type> for every\n";
+    std::cout << "                   configured sensor type (overrides the config file)\n";
+    std::cout << "  --topics <list>  Per-type topics to read, e.g. temperature,humidity (implies per-type)\n";
+    std::cout << "  --transport <t>  dds (default), udp (the hub's batched UDP frames) or inproc\n";
+    std::cout << "                   (components of telemetry_all only)\n";
+    std::cout << "  --udp-listen <a> UDP address to listen on, [host:]port (default: 0.0.0.0:17401)\n";
+    std::cout << "  --trace <file>   Record a Chrome trace to <file>, written at exit and on SIGUSR1\n";
+    std::cout << "  --perf           Count cycles/instructions/cache and branch misses per received message\n";
+    std::cout << "  --control <path> Control socket for live state dumps (default: /tmp/telemetry_monitor.ctl)\n";
+    std::cout << "  --no-control     Do not serve a control socket\n";
+    std::cout << "  --help           Show this help message\n";
+}
+
+} // namespace
+
+// ========== ENTRY POINTS ==========
+
+void monitor_stop() {
+    g_running = false;
+}
+
+int monitor_main(int argc, char** argv) {
+    int history_sec = 0;
+    telemetry::QosProfile qos_profile = telemetry::QosProfile::Default;
+    bool qos_from_cli = false;
+    dds_domainid_t domain = DDS_DOMAIN_DEFAULT;
+    bool domain_from_cli = false;
+    std::vector<std::string> partitions;
+    bool per_type_topics = false;
+    bool topic_mode_from_cli = false;
+    std::vector<std::string> topic_types;   // --topics; empty = every configured type
+    telemetry::Transport transport = telemetry::Transport::Dds;
+    std::string udp_listen = std::to_string(telemetry::UDP_MONITOR_PORT);
+    std::string trace_file;
+    std::string config_file;
+    bool perf_enabled = false;
+    std::string control_path = "/tmp/telemetry_monitor.ctl";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--history" && i + 1 < argc) {
+            history_sec = std::atoi(argv[++i]);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if (arg == "--perf") {
+            perf_enabled = true;
+        } else if (arg == "--control" && i + 1 < argc) {
+            control_path = argv[++i];
+        } else if (arg == "--no-control") {
+            control_path.clear();
+        } else if (arg == "--qos" && i + 1 < argc) {
+            if (!telemetry::parse_qos_profile(argv[++i], qos_profile)) {
+                std::cerr << "[ERROR] Unknown QoS profile: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+            qos_from_cli = true;
+        } else if (arg == "--domain" && i + 1 < argc) {
+            if (!telemetry::parse_domain_id(argv[++i], domain)) {
+                std::cerr << "[ERROR] Invalid domain id: " << argv[i] << " (expected 0-"
+                          << telemetry::MAX_DOMAIN_ID << ")\n";
+                return 1;
+            }
+            domain_from_cli = true;
+        } else if (arg == "--partition" && i + 1 < argc) {
+            partitions.push_back(argv[++i]);
+        } else if (arg == "--topic-mode" && i + 1 < argc) {
+            if (!telemetry::parse_topic_mode(argv[++i], per_type_topics)) {
+                std::cerr << "[ERROR] Unknown topic mode: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+            topic_mode_from_cli = true;
+        } else if (arg == "--topics" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string type;
+            while (std::getline(list, type, ',')) {
+                if (!telemetry::is_valid_sensor_type(type)) {
+                    std::cerr << "[ERROR] Invalid topic type: '" << type << "'\n";
+                    return 1;
+                }
+                topic_types.push_back(type);
+            }
+            per_type_topics = true;
+            topic_mode_from_cli = true;
+        } else if (arg == "--transport" && i + 1 < argc) {
+            if (!telemetry::parse_transport(argv[++i], transport)) {
+                std::cerr << "[ERROR] Unknown transport: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--udp-listen" && i + 1 < argc) {
+            udp_listen = argv[++i];
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "[ERROR] Unknown option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
 
     std::cout << "[Monitor] Starting...\n";
 
-    // ========== DDS INITIALIZATION ==========
-    dds_entity_t participant = dds_create_participant(DDS_DOMAIN_DEFAULT, NULL, NULL);
-    if (participant < 0) {
-        std::cerr << "[ERROR] Failed to create DDS participant\n";
+    if (!config_file.empty()) {
+        std::string error;
+        if (!telemetry::config_store().reload(config_file, error)) {
+            std::cerr << "[ERROR] Failed to load config: " << error << "\n";
+            return 1;
+        }
+        telemetry::install_config_reload_signal(SIGHUP);
+        std::cout << "[Config] Loaded " << config_file << " (SIGHUP reloads it)\n";
+    }
+    if (!qos_from_cli) {
+        qos_profile = telemetry::config_store().current().qos_profile;
+    }
+    if (!domain_from_cli) {
+        domain = telemetry::config_store().current().domain;
+    }
+    if (partitions.empty()) {
+        partitions = telemetry::config_store().current().partitions;
+    }
+    if (!topic_mode_from_cli) {
+        per_type_topics = telemetry::config_store().current().per_type_topics;
+    }
+    if (per_type_topics && topic_types.empty()) {
+        topic_types = telemetry::config_store().current().sensor_types();
+    }
+
+    if (!trace_file.empty()) {
+        telemetry::enable_tracing();
+        telemetry::install_trace_dump_signal(SIGUSR1);
+        telemetry::set_trace_thread_name("monitor");
+        std::cout << "[Config] Tracing to " << trace_file << " (SIGUSR1 writes a snapshot)\n";
+    }
+
+    if (transport != telemetry::Transport::Dds && (per_type_topics || history_sec > 0)) {
+        std::cerr << "[ERROR] " << (history_sec > 0 ? "--history" : "Per-type topics")
+                  << " needs the DDS transport\n";
         return 1;
     }
-    std::cout << "[DDS] Participant created\n";
-
-    dds_entity_t topic = dds_create_topic(
-        participant,
-        &Telemetry_JsonMessage_desc,
-        "lab_telemetry",
-        NULL,
-        NULL
-    );
-    if (topic < 0) {
-        std::cerr << "[ERROR] Failed to create DDS topic\n";
-        dds_delete(participant);
+
+    // ========== DDS INITIALIZATION ==========
+    // Skipped with --transport udp/inproc
+    telemetry::DdsSession dds;
+    if (transport == telemetry::Transport::Dds && !dds.open(qos_profile, domain)) {
         return 1;
     }
-    std::cout << "[DDS] Topic created\n";
+    dds.set_partitions(partitions);
 
-    dds_qos_t *qos = dds_create_qos();
-    dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_SECS(10));
-    dds_qset_history(qos, DDS_HISTORY_KEEP_LAST, 100);
+    if (telemetry::config_store().current().deadline_ms > 0) {
+        dds.set_deadline(DDS_MSECS(static_cast<int64_t>(telemetry::config_store().current().deadline_ms)));
+    }
+    // One reader on the shared topic, or one per selected type with that
+    // type's profile; topics not selected are never matched or delivered.
+    // In-process, the dashboard drops the oldest samples rather than hold
+    // up the hub.
+    std::unique_ptr<telemetry::TelemetrySubscriber> subscriber;
+    telemetry::ReaderSet readers;
+    telemetry::UdpReceiver udp;
+    if (transport == telemetry::Transport::Udp) {
+        sockaddr_in address{};
+        if (!telemetry::parse_udp_address(udp_listen, "0.0.0.0", address)) {
+            std::cerr << "[ERROR] Invalid UDP listen address: " << udp_listen << "\n";
+            return 1;
+        }
+        if (!udp.open(address, "monitor.udp")) {
+            return 1;
+        }
+        std::cout << "[UDP] Listening on " << telemetry::format_udp_address(address) << "\n";
+        subscriber = std::make_unique<telemetry::UdpSubscriber>(udp);
+    } else if (transport == telemetry::Transport::InProcess) {
+        subscriber = std::make_unique<telemetry::InProcessSubscriber>(
+            telemetry::inprocess_bus(), "monitor", OverflowPolicy::DropOldest);
+        std::cout << "[InProc] Subscribed (drop-oldest)\n";
+    } else if (!per_type_topics) {
+        dds_entity_t reader = dds.create_reader();
+        if (reader < 0) {
+            std::cerr << "[ERROR] Failed to create DDS reader\n";
+            return 1;
+        }
+        readers.add(reader);
+        g_dds_health.watch_reader(reader, "monitor.dds");
+        std::cout << "[DDS] Subscribed to 'lab_telemetry' (" << telemetry::partition_label(partitions) << ")\n";
+    } else {
+        for (const auto& type : topic_types) {
+            telemetry::QosProfile profile = telemetry::config_store().current().topic_profile(type, qos_profile);
+            dds_entity_t topic = dds.sensor_topic(type);
+            dds_entity_t reader = topic > 0 ? dds.create_reader(topic, profile) : topic;
+            if (reader < 0) {
+                std::cerr << "[ERROR] Failed to create DDS reader for '" << telemetry::sensor_topic_name(type) << "'\n";
+                return 1;
+            }
+            readers.add(reader);
+            g_dds_health.watch_reader(reader, "monitor.dds." + type);
+            std::cout << "[DDS] Subscribed to '" << telemetry::sensor_topic_name(type) << "' ("
+                      << telemetry::qos_profile_name(profile) << ", " << telemetry::partition_label(partitions) << ")\n";
+        }
+    }
+    if (!subscriber) {
+        subscriber = std::make_unique<telemetry::DdsSubscriber>(readers);
+    }
 
-    dds_entity_t reader = dds_create_reader(participant, topic, qos, NULL);
-    dds_delete_qos(qos);
+    bool data_updated = false;
+    if (history_sec > 0) {
+        data_updated = fetch_history(dds, history_sec) > 0;
+    }
 
-    if (reader < 0) {
-        std::cerr << "[ERROR] Failed to create DDS reader\n";
-        dds_delete(topic);
-        dds_delete(participant);
-        return 1;
+    // ========== CONTROL SOCKET ==========
+    telemetry::ControlServer control;
+    control.add_command("sensors", "Per-sensor value, range, counts and age", control_sensors);
+    control.add_command("refresh", "refresh [ms]: show or set the dashboard refresh interval", control_refresh);
+    if (!control_path.empty() && control.start(control_path)) {
+        std::cout << "[Control] Listening on " << control_path << " (try: echo help | nc -U "
+                  << control_path << ")\n";
     }
-    
-    std::cout << "[DDS] Subscribed to 'lab_telemetry'\n";
+
     std::cout << "[Monitor] Waiting for data...\n\n";
     std::this_thread::sleep_for(std::chrono::seconds(1));
     
     // Hide cursor for cleaner display
     hide_cursor();
+    std::cout << std::flush;
+
+    // Dashboard frames go through the console thread from here on
+    telemetry::console().start();
     
     // ========== MAIN LOOP ==========
-    Telemetry_JsonMessage msg;
-    void* samples[1];
-    samples[0] = &msg;
-    dds_sample_info_t infos[1];
-    
-    bool data_updated = false;
-    
-    while(g_running) {
-        memset(&msg, 0, sizeof(msg));
-        
-        int ret = dds_take(reader, samples, infos, 1, 1);
-        
-        if (ret > 0 && infos[0].valid_data) {
-            if (msg.payload == NULL) {
-                dds_return_loan(reader, samples, ret);
-                continue;
-            }
-            
-            try {
-                nlohmann::json j = nlohmann::json::parse(msg.payload);
-                int sensor_id = j["id"];
-                double value = j["value"];
-                uint64_t timestamp = j["timestamp"];
-                uint64_t sequence = j["sequence"];
-                
-                uint64_t now_ms = get_current_time_ms();
-
-                {
-                    std::lock_guard<std::mutex> lock(g_sensor_mutex);
-                    SensorState& state = g_sensors[sensor_id];
-                    
-                    if (state.seen_sequences.count(sequence) > 0) {
-                        dds_return_loan(reader, samples, ret);
-                        continue;
-                    }
-                    
-                    state.seen_sequences.insert(sequence);
-                    
-                    if (!state.initialized) {
-                        state.expected_seq = sequence;
-                        state.initialized = true;
-                    } else {
-                        if (sequence != state.expected_seq) {
-                            uint64_t dropped = sequence - state.expected_seq;
-                            state.dropped_count += dropped;
-                        }
-                    }
-                    
-                    state.expected_seq = sequence + 1;
-                    state.message_count++;
-                    state.current_value = value;
-                    state.last_timestamp = timestamp;
-                    state.last_received_ms = now_ms;
-                    
-                    if (value < state.min_value) state.min_value = value;
-                    if (value > state.max_value) state.max_value = value;
-                    state.sum_value += value;
-                    
-                    data_updated = true;
-                }
-                
-            } catch (const std::exception& e) {
-                // Silently skip parse errors during live display
-            }
-            
-            dds_return_loan(reader, samples, ret);
-        }
-        
-        // Rate-limited printing
-        uint64_t now_ms = get_current_time_ms();
-        if (data_updated && (now_ms - g_last_print_ms) >= REFRESH_INTERVAL_MS) {
-            print_dashboard();
-            g_last_print_ms = now_ms;
-            data_updated = false;
+    // Hardware counters per received message (--perf), on this thread
+    std::unique_ptr<telemetry::PerfRegion> perf_ingest;
+    if (perf_enabled) {
+        perf_ingest = std::make_unique<telemetry::PerfRegion>("parse+ingest");
+    }
+    // Heap allocations per received message (-DTELEMETRY_ALLOC_ACCOUNTING=ON builds)
+    std::unique_ptr<telemetry::AllocRegion> alloc_ingest;
+    if (telemetry::alloc_accounting_enabled()) {
+        alloc_ingest = std::make_unique<telemetry::AllocRegion>("parse+ingest");
+    }
+
+    {
+        telemetry::Executor executor(0, "monitor");
+        std::unique_ptr<telemetry::DdsReadWaiter> dds_waiter;
+        if (transport == telemetry::Transport::Dds) {
+            dds_waiter = std::make_unique<telemetry::DdsReadWaiter>(executor, dds.participant());
         }
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        Pipeline pipeline{executor, *subscriber, dds_waiter && dds_waiter->ok() ? dds_waiter.get() : nullptr,
+                          readers.readers(), perf_ingest.get(), alloc_ingest.get(), trace_file, config_file};
+        pipeline.data_updated = data_updated;
+        executor.spawn(ingest_stage(pipeline));
+        executor.spawn(render_stage(pipeline));
+        executor.spawn(housekeeping_stage(pipeline));
+        executor.run();   // until monitor_stop()
     }
 
     // ========== CLEANUP ==========
+    control.stop();
+    telemetry::console().stop();
     show_cursor(); // Restore cursor
     clear_screen_once();
     
     std::cout << "[Monitor] Cleaning up...\n";
-    dds_delete(reader);
-    dds_delete(topic);
-    dds_delete(participant);
+    g_dds_health.poll();
+    subscriber.reset();   // returns its last loan, or leaves the in-process bus
+    dds.close();
 
     std::cout << "\n╔══════════════════════════════════════════════════════════════════════════════╗\n";
     std::cout << "║                           FINAL SUMMARY                                      ║\n";
@@ -327,6 +819,46 @@ int main() {
         }
     }
 
+    // Sequence gaps include samples DDS dropped on this reader; the rest were
+    // lost before reaching it (hub side or on the wire)
+    telemetry::DdsHealthCounts health = g_dds_health.totals();
+    std::cout << "Lost inside DDS (this reader): " << health.sample_lost
+              << " (rejected: " << health.sample_rejected
+              << ", deadline missed: " << health.requested_deadline_missed << ")\n\n";
+    if (transport == telemetry::Transport::Udp) {
+        const telemetry::UdpReceiverStats& stats = udp.stats();
+        std::cout << "UDP: " << stats.records << " messages in " << stats.datagrams << " frames ("
+                  << stats.syscalls << " receive calls); frames lost: " << stats.frames_lost
+                  << ", reordered: " << stats.frames_reordered << ", malformed: " << stats.malformed << "\n\n";
+    }
+
+    if (perf_ingest) {
+        std::cout << "Perf: " << perf_ingest->summary() << "\n\n";
+    }
+    if (alloc_ingest) {
+        std::cout << "Allocations: " << alloc_ingest->summary() << "\n\n";
+    }
+    std::cout << "Metrics:\n" << telemetry::format_metrics(telemetry::metrics().snapshot()) << "\n";
+
+    if (!trace_file.empty()) {
+        if (telemetry::write_chrome_trace(trace_file)) {
+            std::cout << "Trace written to " << trace_file << "\n";
+        } else {
+            std::cerr << "[ERROR] Failed to write trace to " << trace_file << "\n";
+        }
+    }
     std::cout << "[Monitor] Exited cleanly.\n";
     return 0;
-}
\ No newline at end of file
+}
+#ifndef TELEMETRY_EMBEDDED
+void signal_handler(int signal) {
+    std::cout << "\n[Monitor] Caught signal " << signal << ", shutting down...\n";
+    monitor_stop();
+}
+
+int main(int argc, char** argv) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    return monitor_main(argc, argv);
+}
+#endif
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include <thread>
 #include <vector>
 #include <atomic>
@@ -8,38 +9,82 @@
 #include <cstdlib>
 #include <csignal>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <sstream>
 
 // DDS headers
 #include <dds/dds.h>
 #include "telemetry.h"
 
-// Include nlohmann json library
-#include <nlohmann/json.hpp>
-
 // Include our core files
 #include "../core/telemetry_types.h"
-#include "../core/thread_safe_queue.h"
+#include "../core/bounded_queue.h"
+#include "../core/dds_bootstrap.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "../core/async_console.h"
+#include "../core/buffer_pool.h"
+#include "../core/message_codec.h"
+#include "../core/config.h"
+#include "../core/dds_health.h"
+#include "../core/perf_counters.h"
+#include "../core/alloc_accounting.h"
+#include "../core/control_socket.h"
+#include "../core/udp_transport.h"
+#include "../core/transport.h"
+#include "components.h"
+
+namespace {
 
 // Global flag for threads to check
 std::atomic<bool> g_running{true};
 std::atomic<uint64_t> g_message_count{0};
 
-// The shared queue (Thread-safe!)
-ThreadSafeQueue<SensorData> g_data_queue;
+// The shared queue (Thread-safe!). Sensor threads fill in data and stamps,
+// the publisher the sequence. A ring allocated up front, so neither side
+// touches the heap per sample; if the publisher falls this far behind, the
+// sensor threads wait for it rather than grow the queue.
+constexpr size_t DATA_QUEUE_CAPACITY = 8192;
+BoundedQueue<telemetry::TelemetrySample> g_data_queue(DATA_QUEUE_CAPACITY, OverflowPolicy::Block);
+
+// Carry per-stage stamps in each payload (--stamps)
+bool g_send_stamps = false;
 
 // Global delay configuration
 int g_artificial_delay_ms = 0;
 
+// Longest the publish loop waits on an empty queue before it checks for
+// reloads, health, trace dumps and --duration again
+constexpr auto HOUSEKEEPING_INTERVAL = std::chrono::milliseconds(100);
+
+// Metrics recorded by this process (printed in the summary)
+struct HubMetrics {
+    telemetry::Counter samples = telemetry::metrics().counter("hub.samples_generated");
+    telemetry::Counter published = telemetry::metrics().counter("hub.messages_published");
+    telemetry::Counter bytes = telemetry::metrics().counter("hub.bytes_published");
+    telemetry::Counter errors = telemetry::metrics().counter("hub.publish_errors");
+    telemetry::Gauge queue_depth = telemetry::metrics().gauge("hub.queue_depth");
+    telemetry::Histogram queue_ms = telemetry::metrics().histogram("hub.queue_wait_ms");
+    telemetry::Histogram encode_ns = telemetry::metrics().histogram("hub.encode_ns");
+    telemetry::Histogram write_ns = telemetry::metrics().histogram("hub.write_ns");
+};
+HubMetrics g_metrics;
+
 // PER-SENSOR sequence tracking
 std::map<int, uint64_t> g_sensor_sequences;
 std::mutex g_sequence_mutex;
 
-// Signal handler for graceful shutdown
-void signal_handler(int signal) {
-    std::cout << "\n[Sensor Hub] Caught signal " << signal << ", shutting down...\n";
-    g_running = false;
-    g_data_queue.stop();
+// Sleeps for `duration`, waking early on shutdown
+void sleep_while_running(std::chrono::microseconds duration) {
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    while (g_running) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) break;
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            deadline - now, std::chrono::milliseconds(100)));
+    }
 }
 
 // Sensor thread function - each sensor generates different data
@@ -48,67 +93,169 @@ void sensor_thread_func(int id) {
     std::random_device rd;
     std::mt19937 gen(rd());
     
-    // Different sensors simulate different physical quantities
+    // Range, name and rate come from the config; re-read whenever a reload
+    // bumps the version (a lock-free load, so it's checked every sample)
     std::uniform_real_distribution<> dis;
     std::string sensor_type;
-    
-    switch(id) {
-        case 0:  // Temperature sensor (°C)
-            dis = std::uniform_real_distribution<>(20.0, 30.0);
-            sensor_type = "Temperature";
-            break;
-        case 1:  // Pressure sensor (hPa) 
-            dis = std::uniform_real_distribution<>(1000.0, 1020.0);
-            sensor_type = "Pressure";
-            break;
-        case 2:  // Humidity sensor (%)
-            dis = std::uniform_real_distribution<>(40.0, 60.0);
-            sensor_type = "Humidity";
-            break;
-        default:
-            dis = std::uniform_real_distribution<>(0.0, 100.0);
-            sensor_type = "Generic";
-    }
+    std::chrono::microseconds interval{0};
+    telemetry::SensorConfig applied;
+    uint64_t config_version = 0;
+    bool active = false;
 
-    std::cout << "[Thread] Sensor " << id << " (" << sensor_type << ") started\n";
+    telemetry::set_trace_thread_name("sensor-" + std::to_string(id));
 
     while(g_running) {
-        SensorData data;
-        data.id = id;
-        //generate the fake values
-        data.value = dis(gen);  // Random value within sensor's range
-        //generate the timstamp
-        data.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()
-        ).count();
-
-        g_data_queue.push(data);
-
-        // Sleep 500ms (2 Hz per sensor = 6 messages/sec total)
-        int sleep_time = 500 + g_artificial_delay_ms;
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
+        uint64_t version = telemetry::config_store().version();
+        if (version != config_version) {
+            const telemetry::SensorConfig* sensor = telemetry::config_store().current().find_sensor(id);
+            bool changed = sensor != nullptr &&
+                (!active || sensor->name != applied.name || sensor->rate_hz != applied.rate_hz ||
+                 sensor->min_value != applied.min_value || sensor->max_value != applied.max_value);
+            if (changed) {
+                applied = *sensor;
+                dis = std::uniform_real_distribution<>(sensor->min_value, sensor->max_value);
+                sensor_type = sensor->name;
+                interval = std::chrono::microseconds(static_cast<int64_t>(1e6 / sensor->rate_hz));
+                if (config_version == 0) {
+                    std::cout << "[Thread] Sensor " << id << " (" << sensor_type << ") started\n";
+                } else {
+                    telemetry::log_out() << "[Thread] Sensor " << id << " (" << sensor_type
+                                         << ") now " << sensor->rate_hz << " Hz in ["
+                                         << sensor->min_value << ", " << sensor->max_value << "]";
+                }
+            } else if (sensor == nullptr && active) {
+                telemetry::log_out() << "[Thread] Sensor " << id << " (" << sensor_type
+                                     << ") removed from config, pausing";
+            }
+            active = sensor != nullptr;
+            config_version = version;
+        }
+        if (!active) {
+            sleep_while_running(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        telemetry::TelemetrySample sample;
+        SensorData& data = sample.data;
+        {
+            TRACE_SCOPE("sample");
+            data.id = id;
+            //generate the fake values
+            data.value = dis(gen);  // Random value within sensor's range
+            //generate the timstamp
+            data.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()
+            ).count();
+        }
+        if (g_send_stamps) {
+            sample.stamps.present = true;
+            sample.stamps.sampled_us = telemetry::wall_clock_us();
+        }
+
+        {
+            TRACE_SCOPE("enqueue");
+            if (g_send_stamps) {
+                sample.stamps.enqueued_us = telemetry::wall_clock_us();
+            }
+            g_data_queue.push(sample);
+        }
+        g_metrics.samples.add();
+
+        // Default config: 2 Hz per sensor = 6 messages/sec total
+        sleep_while_running(interval + std::chrono::milliseconds(g_artificial_delay_ms));
     }
     
     std::cout << "[Thread] Sensor " << id << " (" << sensor_type << ") stopped\n";
 }
 
+// ========== CONTROL COMMANDS ==========
+// Run on the control socket thread; they only read atomics and take the
+// sequence mutex for a copy, so publishing carries on meanwhile.
+
+std::string control_queues(const std::string&) {
+    std::ostringstream out;
+    out << "publish queue: " << g_data_queue.size() << "/" << g_data_queue.capacity() << " samples\n"
+        << "console lines dropped: " << telemetry::console().dropped_lines() << "\n";
+    return out.str();
+}
+
+std::string control_sensors(const std::string&) {
+    std::map<int, uint64_t> sequences;
+    {
+        std::lock_guard<std::mutex> lock(g_sequence_mutex);
+        sequences = g_sensor_sequences;
+    }
+    std::ostringstream out;
+    const telemetry::TelemetryConfig& config = telemetry::config_store().current();
+    for (const auto& [id, next_sequence] : sequences) {
+        out << "  sensor " << id;
+        if (const telemetry::SensorConfig* sensor = config.find_sensor(id)) {
+            out << " " << sensor->name << " " << sensor->rate_hz << " Hz ["
+                << sensor->min_value << ", " << sensor->max_value << "] " << sensor->unit;
+        } else {
+            out << " (removed from config, paused)";
+        }
+        out << "  published " << next_sequence << "\n";
+    }
+    out << "total published: " << g_message_count.load() << "\n";
+    return out.str();
+}
+
 void print_usage(const char* prog_name) {
     std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
     std::cout << "Options:\n";
     std::cout << "  --delay <ms>     Add artificial delay to sensor threads (for testing race conditions)\n";
     std::cout << "  --duration <sec> Run duration in seconds (default: infinite, use Ctrl+C to stop)\n";
+    std::cout << "  --config <file>  Sensor/QoS config file (JSON); SIGHUP reloads it\n";
+    std::cout << "  --qos <profile>  DDS QoS profile (default: default, overrides the config file)\n";
+    std::cout << telemetry::qos_profile_help();
+    std::cout << "  --domain <id>    DDS domain to publish in (0-232, overrides the config file)\n";
+    std::cout << "  --partition <p>  DDS partition to publish into, e.g. site-a/line-1; repeatable\n";
+    std::cout << "                   (overrides the config file; wildcards are for subscribers)\n";
+    std::cout << "  --topic-mode <m> shared (one topic, default) or per-type (lab_telemetry/<type> per\n";
+    std::cout << "                   sensor type, QoS from the config's topic_qos); overrides the config file\n";
+    std::cout << "  --transport <t>  dds (default), udp (batched frames, no retransmission) or inproc\n";
+    std::cout << "                   (components of telemetry_all only)\n";
+    std::cout << "  --udp-target <a> UDP destination host:port, repeatable\n";
+    std::cout << "                   (default: 127.0.0.1:17401 and 127.0.0.1:17402, the monitor and logger)\n";
+    std::cout << "  --udp-datagram <bytes>  UDP frame size (default: 1472, max 9216)\n";
+    std::cout << "  --no-gso         Send UDP batches with sendmmsg even where UDP_SEGMENT works\n";
+    std::cout << "  --trace <file>   Record a Chrome trace to <file>, written at exit and on SIGUSR1\n";
+    std::cout << "  --stamps         Carry per-stage latency stamps in each message (see monitor)\n";
+    std::cout << "  --perf           Count cycles/instructions/cache and branch misses per published message\n";
+    std::cout << "  --control <path> Control socket for live state dumps (default: /tmp/telemetry_hub.ctl)\n";
+    std::cout << "  --no-control     Do not serve a control socket\n";
     std::cout << "  --help           Show this help message\n";
     std::cout << "\nExample:\n";
     std::cout << "  " << prog_name << " --delay 50 --duration 60\n";
     std::cout << "  " << prog_name << "  # Runs indefinitely until Ctrl+C\n";
 }
 
-int main(int argc, char** argv) {
+} // namespace
+
+// ========== ENTRY POINTS ==========
+
+void sensor_hub_stop() {
+    g_running = false;
+    g_data_queue.stop();
+}
+
+int sensor_hub_main(int argc, char** argv) {
     int run_duration_sec = -1;  // -1 = infinite by default
-    
-    // Setup signal handlers
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
+    telemetry::QosProfile qos_profile = telemetry::QosProfile::Default;
+    bool qos_from_cli = false;
+    dds_domainid_t domain = DDS_DOMAIN_DEFAULT;
+    bool domain_from_cli = false;
+    std::vector<std::string> partitions;
+    bool per_type_topics = false;
+    bool topic_mode_from_cli = false;
+    telemetry::Transport transport = telemetry::Transport::Dds;
+    std::vector<std::string> udp_targets;
+    telemetry::UdpSenderOptions udp_options;
+    std::string trace_file;
+    std::string config_file;
+    bool perf_enabled = false;
+    std::string control_path = "/tmp/telemetry_hub.ctl";
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -123,6 +270,53 @@ int main(int argc, char** argv) {
         } else if (arg == "--duration" && i + 1 < argc) {
             run_duration_sec = std::atoi(argv[++i]);
             std::cout << "[Config] Run duration: " << run_duration_sec << " seconds\n";
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if (arg == "--stamps") {
+            g_send_stamps = true;
+        } else if (arg == "--perf") {
+            perf_enabled = true;
+        } else if (arg == "--control" && i + 1 < argc) {
+            control_path = argv[++i];
+        } else if (arg == "--no-control") {
+            control_path.clear();
+        } else if (arg == "--qos" && i + 1 < argc) {
+            if (!telemetry::parse_qos_profile(argv[++i], qos_profile)) {
+                std::cerr << "[ERROR] Unknown QoS profile: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+            qos_from_cli = true;
+        } else if (arg == "--domain" && i + 1 < argc) {
+            if (!telemetry::parse_domain_id(argv[++i], domain)) {
+                std::cerr << "[ERROR] Invalid domain id: " << argv[i] << " (expected 0-"
+                          << telemetry::MAX_DOMAIN_ID << ")\n";
+                return 1;
+            }
+            domain_from_cli = true;
+        } else if (arg == "--partition" && i + 1 < argc) {
+            partitions.push_back(argv[++i]);
+        } else if (arg == "--topic-mode" && i + 1 < argc) {
+            if (!telemetry::parse_topic_mode(argv[++i], per_type_topics)) {
+                std::cerr << "[ERROR] Unknown topic mode: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+            topic_mode_from_cli = true;
+        } else if (arg == "--transport" && i + 1 < argc) {
+            if (!telemetry::parse_transport(argv[++i], transport)) {
+                std::cerr << "[ERROR] Unknown transport: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--udp-target" && i + 1 < argc) {
+            udp_targets.push_back(argv[++i]);
+        } else if (arg == "--udp-datagram" && i + 1 < argc) {
+            udp_options.max_datagram = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-gso") {
+            udp_options.gso = false;
         } else {
             std::cerr << "[ERROR] Unknown option: " << arg << "\n";
             print_usage(argv[0]);
@@ -131,122 +325,281 @@ int main(int argc, char** argv) {
     }
 
     std::cout << "[Sensor Hub] Starting...\n";
+
+    if (!config_file.empty()) {
+        std::string error;
+        if (!telemetry::config_store().reload(config_file, error)) {
+            std::cerr << "[ERROR] Failed to load config: " << error << "\n";
+            return 1;
+        }
+        telemetry::install_config_reload_signal(SIGHUP);
+        std::cout << "[Config] Loaded " << config_file << " (SIGHUP reloads it)\n";
+    }
+    if (!qos_from_cli) {
+        qos_profile = telemetry::config_store().current().qos_profile;
+    }
+    if (!domain_from_cli) {
+        domain = telemetry::config_store().current().domain;
+    }
+    if (partitions.empty()) {
+        partitions = telemetry::config_store().current().partitions;
+    }
+    if (!topic_mode_from_cli) {
+        per_type_topics = telemetry::config_store().current().per_type_topics;
+    }
+    for (const auto& name : partitions) {
+        if (name.empty() || telemetry::is_partition_pattern(name)) {
+            std::cerr << "[ERROR] Hub partition must be a literal name, not '" << name << "'\n";
+            return 1;
+        }
+    }
+
+    if (!trace_file.empty()) {
+        telemetry::enable_tracing();
+        telemetry::install_trace_dump_signal(SIGUSR1);
+        std::cout << "[Config] Tracing to " << trace_file << " (SIGUSR1 writes a snapshot)\n";
+    }
+    if (g_send_stamps) {
+        std::cout << "[Config] Stage stamps enabled\n";
+    }
+    if (perf_enabled) {
+        std::cout << "[Config] Perf counters enabled for the publish loop\n";
+    }
     
     if (run_duration_sec == -1) {
         std::cout << "[Config] Running indefinitely (press Ctrl+C to stop)\n";
     }
 
-    // ========== DDS INITIALIZATION ==========
-    dds_entity_t participant = dds_create_participant(DDS_DOMAIN_DEFAULT, NULL, NULL);
-    if (participant < 0) {
-        std::cerr << "[ERROR] Failed to create DDS participant\n";
+    if (transport != telemetry::Transport::Dds && per_type_topics) {
+        std::cerr << "[ERROR] Per-type topics need the DDS transport\n";
         return 1;
     }
-    std::cout << "[DDS] Participant created\n";
-
-    dds_entity_t topic = dds_create_topic(
-        participant,
-        &Telemetry_JsonMessage_desc,
-        "lab_telemetry",
-        NULL,
-        NULL
-    );
-    if (topic < 0) {
-        std::cerr << "[ERROR] Failed to create DDS topic\n";
-        dds_delete(participant);
+
+    // ========== DDS INITIALIZATION ==========
+    // Skipped with --transport udp/inproc: no participant, no discovery
+    telemetry::DdsSession dds;
+    if (transport == telemetry::Transport::Dds && !dds.open(qos_profile, domain)) {
         return 1;
     }
-    std::cout << "[DDS] Topic 'lab_telemetry' created\n";
+    dds.set_partitions(partitions);
 
-    // Set QoS for reliable delivery with larger history
-    dds_qos_t *qos = dds_create_qos();
-    dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_SECS(10));
-    dds_qset_history(qos, DDS_HISTORY_KEEP_LAST, 100);
-
-    dds_entity_t writer = dds_create_writer(participant, topic, qos, NULL);
-    dds_delete_qos(qos);
-    
-    if (writer < 0) {
-        std::cerr << "[ERROR] Failed to create DDS writer\n";
-        dds_delete(topic);
-        dds_delete(participant);
-        return 1;
+    if (telemetry::config_store().current().deadline_ms > 0) {
+        dds.set_deadline(DDS_MSECS(static_cast<int64_t>(telemetry::config_store().current().deadline_ms)));
     }
-    std::cout << "[DDS] Writer created with reliable QoS\n";
 
-    // Initialize per-sensor sequences
-    for(int i = 0; i < 3; ++i) {
-        g_sensor_sequences[i] = 0;
+    // Matched readers and offered-deadline misses, polled into hub.dds.* metrics
+    // (hub.dds.<type>.* per topic in per-type mode)
+    telemetry::DdsHealth dds_health;
+    auto last_health_poll = std::chrono::steady_clock::now();
+
+    // DDS: one writer on the shared topic, or one per sensor type with that
+    // type's profile. UDP: frames to fixed targets. In-process: samples go
+    // straight into the monitor's and logger's queues, unencoded.
+    std::unique_ptr<telemetry::TelemetryPublisher> publisher;
+    telemetry::UdpSender udp;
+    if (transport == telemetry::Transport::Udp) {
+        if (udp_targets.empty()) {
+            udp_targets = {"127.0.0.1:" + std::to_string(telemetry::UDP_MONITOR_PORT),
+                           "127.0.0.1:" + std::to_string(telemetry::UDP_LOGGER_PORT)};
+        }
+        std::vector<sockaddr_in> targets;
+        for (const auto& text : udp_targets) {
+            sockaddr_in addr{};
+            if (!telemetry::parse_udp_address(text, "127.0.0.1", addr)) {
+                std::cerr << "[ERROR] Invalid UDP target: " << text << "\n";
+                return 1;
+            }
+            targets.push_back(addr);
+        }
+        if (!udp.open(targets, udp_options, "hub.udp")) {
+            return 1;
+        }
+        std::cout << "[UDP] Sending frames to";
+        for (const auto& addr : targets) {
+            std::cout << " " << telemetry::format_udp_address(addr);
+        }
+        std::cout << " (" << (udp.gso_active() ? "GSO" : "sendmmsg") << ")\n";
+        publisher = std::make_unique<telemetry::UdpPublisher>(udp);
+    } else if (transport == telemetry::Transport::InProcess) {
+        std::cout << "[InProc] Publishing to " << telemetry::inprocess_bus().subscribers()
+                  << " in-process subscribers\n";
+        publisher = std::make_unique<telemetry::InProcessPublisher>(telemetry::inprocess_bus());
+    } else {
+        auto dds_publisher = std::make_unique<telemetry::DdsPublisher>(dds, dds_health, "hub.dds");
+        if (!dds_publisher->open(per_type_topics)) {
+            return 1;
+        }
+        publisher = std::move(dds_publisher);
     }
 
     // ========== START SENSOR THREADS ==========
-    std::cout << "[Sensor Hub] Starting 3 sensor threads...\n";
+    // One thread per configured sensor; a reload that adds sensors starts more
     std::vector<std::thread> sensors;
-    for(int i = 0; i < 3; ++i) {
-        sensors.emplace_back(sensor_thread_func, i);
-    }
+    std::set<int> started_sensors;
+    auto start_new_sensors = [&]() {
+        for (const auto& sensor : telemetry::config_store().current().sensors) {
+            if (started_sensors.insert(sensor.id).second) {
+                {
+                    std::lock_guard<std::mutex> lock(g_sequence_mutex);
+                    g_sensor_sequences[sensor.id];   // Sequences start at 0
+                }
+                sensors.emplace_back(sensor_thread_func, sensor.id);
+            }
+        }
+    };
+    std::cout << "[Sensor Hub] Starting " << telemetry::config_store().current().sensors.size()
+              << " sensor threads...\n";
+    start_new_sensors();
 
     // Small delay to let threads start
     std::this_thread::sleep_for(std::chrono::milliseconds(200));
 
+    // ========== CONTROL SOCKET ==========
+    telemetry::ControlServer control;
+    control.add_command("queues", "Publish queue depth and dropped console lines", control_queues);
+    control.add_command("sensors", "Configured sensors and messages published per sensor", control_sensors);
+    if (!control_path.empty() && control.start(control_path)) {
+        std::cout << "[Control] Listening on " << control_path << " (try: echo help | nc -U "
+                  << control_path << ")\n";
+    }
+
     // ========== MAIN LOOP (Publisher) ==========
-    SensorData incoming_data;
+    telemetry::TelemetrySample queued;
+    SensorData& incoming_data = queued.data;
     auto start_time = std::chrono::steady_clock::now();
 
     std::cout << "[Main] Publishing data...\n";
 
+    // Console output from the publish loop goes through the console thread
+    telemetry::console().start();
+    telemetry::RateLimit publish_errors(5, std::chrono::seconds(1));
+    telemetry::set_trace_thread_name("publisher");
+    // Payload memory for the message being published; released in bulk once
+    // dds_write has serialized it
+    telemetry::Arena payload_arena;
+    // Hardware counters per published message (--perf), on this thread
+    std::unique_ptr<telemetry::PerfRegion> perf_publish;
+    if (perf_enabled) {
+        perf_publish = std::make_unique<telemetry::PerfRegion>("publish");
+    }
+    // Heap allocations per published message (-DTELEMETRY_ALLOC_ACCOUNTING=ON builds)
+    std::unique_ptr<telemetry::AllocRegion> alloc_publish;
+    if (telemetry::alloc_accounting_enabled()) {
+        alloc_publish = std::make_unique<telemetry::AllocRegion>("publish");
+    }
+
     while(g_running) {
-        if(g_data_queue.pop(incoming_data)) {
+        bool got_data;
+        {
+            TRACE_SCOPE("dequeue");
+            got_data = g_data_queue.pop_for(queued, HOUSEKEEPING_INTERVAL);
+        }
+        if(got_data) {
+            telemetry::PerfScope perf_scope(perf_publish.get());
+            telemetry::AllocScope alloc_scope(alloc_publish.get());
+            auto dequeued = std::chrono::steady_clock::now();
+            if (queued.stamps.present) {
+                queued.stamps.dequeued_us = telemetry::wall_clock_us();
+            }
+            long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()
+            ).count();
+            g_metrics.queue_ms.record(now_ms > incoming_data.timestamp ? now_ms - incoming_data.timestamp : 0);
+            g_metrics.queue_depth.set(static_cast<int64_t>(g_data_queue.size()));
+
             // Get and increment the per-sensor sequence
-            uint64_t sequence;
+            uint64_t& sequence = queued.sequence;
             {
                 std::lock_guard<std::mutex> lock(g_sequence_mutex);
                 sequence = g_sensor_sequences[incoming_data.id]++;
             }
             
-            // Create JSON payload with PER-SENSOR sequence number
-            nlohmann::json j;
-            j["id"] = incoming_data.id;
-            j["value"] = incoming_data.value;
-            j["timestamp"] = incoming_data.timestamp;
-            j["sequence"] = sequence;
-
-
-            //serilization : COnert the in-memory json object 'j' into a string 
-            std::string json_str = j.dump();//<<--cool this is serialization step Mr.
-
-            // Create DDS message
-            Telemetry_JsonMessage msg;
-            msg.payload = dds_string_dup(json_str.c_str());
+            // In-process delivery skips encoding altogether
+            char* payload = nullptr;
+            size_t payload_len = 0;
+            if (queued.stamps.present) {
+                queued.stamps.written_us = telemetry::wall_clock_us();   // restamped below
+            }
+            if (publisher->wants_payload()) {
+                TRACE_SCOPE("encode");
+                // Create JSON payload with PER-SENSOR sequence number
+                payload = payload_arena.allocate_chars(telemetry::MAX_SENSOR_MESSAGE);
+                payload_len = telemetry::encode_sensor_message(
+                    payload, telemetry::MAX_SENSOR_MESSAGE, incoming_data, sequence, &queued.stamps);
+            }
+            // "written" is taken once the payload is ready, so the monitor's
+            // encode stage covers encoding and dds_and_poll starts at the write
+            if (queued.stamps.present) {
+                uint64_t written_us = telemetry::wall_clock_us();
+                if (payload == nullptr || telemetry::restamp_written(payload, payload_len, written_us)) {
+                    queued.stamps.written_us = written_us;
+                }
+            }
+            auto encoded = std::chrono::steady_clock::now();
+            g_metrics.encode_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                encoded - dequeued).count());
 
-            // Publish via DDS-
-            int ret = dds_write(writer, &msg);
+            // Publish via DDS, append to the current UDP frame, or queue in-process
+            int ret;
+            {
+                TRACE_SCOPE("write");
+                ret = publisher->publish(queued, payload, payload_len);
+            }
+            g_metrics.write_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - encoded).count());
             if (ret == DDS_RETCODE_OK) {
                 g_message_count++;
+                g_metrics.published.add();
+                g_metrics.bytes.add(payload_len);
                 
                 // Print every 25th message to reduce spam
                 if (g_message_count % 25 == 0) {
-                    std::cout << "[DDS] Published #" << g_message_count 
-                              << " (Sensor " << incoming_data.id 
-                              << ", seq: " << sequence << ")\n";
+                    telemetry::log_out() << "[DDS] Published #" << g_message_count.load()
+                                         << " (Sensor " << incoming_data.id
+                                         << ", seq: " << sequence << ")";
                 }
             } else {
-                std::cerr << "[ERROR] Failed to publish message (code: " << ret << ")\n";
+                g_metrics.errors.add();
+                telemetry::log_err(publish_errors) << "[ERROR] Failed to publish message (code: " << ret << ")";
             }
 
-            // Free DDS allocated string
-            dds_string_free(msg.payload);
-        } else {
-            // Queue is empty, brief sleep
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            payload_arena.reset();
+
+            // With writer batching, send the partial batch once we have caught up
+            if (g_data_queue.size() == 0) {
+                TRACE_SCOPE("flush");
+                publisher->flush();
+            }
+        }
+
+        if (!trace_file.empty() && telemetry::trace_dump_requested()) {
+            telemetry::write_chrome_trace(trace_file);
+            telemetry::log_out() << "[Trace] Snapshot written to " << trace_file;
+        }
+
+        if (std::chrono::steady_clock::now() - last_health_poll >= std::chrono::seconds(1)) {
+            dds_health.poll();
+            last_health_poll = std::chrono::steady_clock::now();
+        }
+
+        if (!config_file.empty() && telemetry::config_reload_requested()) {
+            std::string error;
+            if (telemetry::config_store().reload(config_file, error)) {
+                telemetry::log_out() << "[Config] Reloaded " << config_file << " ("
+                                     << telemetry::config_store().current().sensors.size()
+                                     << " sensors; QoS changes need a restart)";
+                start_new_sensors();
+            } else {
+                telemetry::log_err() << "[ERROR] Config reload failed, keeping current config: " << error;
+            }
         }
 
         // Check timeout (if duration was specified)
         if (run_duration_sec > 0) {
             auto elapsed = std::chrono::steady_clock::now() - start_time;
             if (elapsed > std::chrono::seconds(run_duration_sec)) {
-                std::cout << "[Main] Timeout reached (" << run_duration_sec 
-                          << " seconds), shutting down...\n";
+                telemetry::log_out() << "[Main] Timeout reached (" << run_duration_sec
+                                     << " seconds), shutting down...";
                 g_running = false;
                 g_data_queue.stop();
             }
@@ -254,25 +607,65 @@ int main(int argc, char** argv) {
     }
 
     // ========== CLEANUP ==========
+    control.stop();
+    telemetry::console().stop();
     std::cout << "[Main] Stopping sensor threads...\n";
     for(auto& t : sensors) {
         if(t.joinable()) t.join();
     }
 
     std::cout << "[DDS] Cleaning up...\n";
-    dds_delete(writer);
-    dds_delete(topic);
-    dds_delete(participant);
+    dds_health.poll();
+    dds.close();
+    if (transport == telemetry::Transport::Udp) {
+        udp.close();
+        const telemetry::UdpSenderStats& stats = udp.stats();
+        std::cout << "[UDP] " << stats.records << " messages in " << stats.frames << " frames, "
+                  << stats.syscalls << " send calls, " << stats.send_errors << " datagrams failed\n";
+    }
 
     std::cout << "\n========== Summary ==========\n";
     std::cout << "Total messages published: " << g_message_count.load() << "\n";
+    if (telemetry::console().dropped_lines() > 0) {
+        std::cout << "Console lines dropped: " << telemetry::console().dropped_lines() << "\n";
+    }
     
     // Print final sequences per sensor
     std::cout << "Final sequences per sensor:\n";
     for (const auto& pair : g_sensor_sequences) {
         std::cout << "  Sensor " << pair.first << ": " << pair.second << " messages\n";
     }
+
+    if (perf_publish) {
+        std::cout << "Perf: " << perf_publish->summary() << "\n";
+    }
+    if (alloc_publish) {
+        std::cout << "Allocations: " << alloc_publish->summary() << "\n";
+    }
+    std::cout << "Metrics:\n" << telemetry::format_metrics(telemetry::metrics().snapshot());
+
+    if (!trace_file.empty()) {
+        if (telemetry::write_chrome_trace(trace_file)) {
+            std::cout << "Trace written to " << trace_file << "\n";
+        } else {
+            std::cerr << "[ERROR] Failed to write trace to " << trace_file << "\n";
+        }
+    }
     
     std::cout << "[Sensor Hub] Exited cleanly.\n";
     return 0;
-}
\ No newline at end of file
+}
+#ifndef TELEMETRY_EMBEDDED
+// Signal handler for graceful shutdown
+void signal_handler(int signal) {
+    std::cout << "\n[Sensor Hub] Caught signal " << signal << ", shutting down...\n";
+    sensor_hub_stop();
+}
+
+int main(int argc, char** argv) {
+    // Setup signal handlers
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    return sensor_hub_main(argc, argv);
+}
+#endif
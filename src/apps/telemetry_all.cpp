@@ -0,0 +1,213 @@
+// Hub, monitor and logger as threads of one process (edge boxes), connected
+// by the in-process transport: samples go from the hub's publish loop into
+// the consumers' queues as structs, with no DDS participant, encoding or
+// parsing in between.
+//
+//   ./telemetry_all [--config <file>] [--duration <sec>] [--no-monitor] [--no-logger]
+//                   [--hub "<options>"] [--monitor "<options>"] [--logger "<options>"]
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/async_console.h"
+#include "../core/config.h"
+#include "../core/transport.h"
+#include "components.h"
+
+std::atomic<bool> g_stop_requested{false};
+
+void signal_handler(int) {
+    g_stop_requested = true;
+}
+
+// One app running on its own thread
+struct Component {
+    const char* name;
+    int (*entry)(int, char**);
+    void (*stop)();
+    std::vector<std::string> args;   // args[0] is the program name
+    std::thread thread;
+    std::atomic<bool> done{false};
+    int exit_code = 0;
+};
+
+void run_component(Component& component) {
+    std::vector<char*> argv;
+    for (auto& arg : component.args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    component.exit_code = component.entry(static_cast<int>(component.args.size()), argv.data());
+    component.done = true;
+}
+
+// "--delay 5 --stamps" -> "--delay", "5", "--stamps"
+void append_options(std::vector<std::string>& args, const std::string& text) {
+    std::istringstream words(text);
+    std::string word;
+    while (words >> word) {
+        args.push_back(word);
+    }
+}
+
+bool any_done(const std::vector<std::unique_ptr<Component>>& components) {
+    for (const auto& component : components) {
+        if (component->done) return true;
+    }
+    return false;
+}
+
+void print_usage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
+    std::cout << "Runs the sensor hub, monitor and logger in one process over in-memory queues.\n";
+    std::cout << "Options:\n";
+    std::cout << "  --config <file>       Sensor/QoS config file, shared by all three (SIGHUP reloads it)\n";
+    std::cout << "  --duration <sec>      Stop after this long (default: until Ctrl+C)\n";
+    std::cout << "  --no-monitor          Run without the dashboard\n";
+    std::cout << "  --no-logger           Run without the logger\n";
+    std::cout << "  --verbose             Keep the hub's and logger's progress lines under the dashboard\n";
+    std::cout << "  --hub \"<options>\"     Extra sensor_hub_process options, e.g. \"--stamps --delay 5\"\n";
+    std::cout << "  --monitor \"<options>\" Extra monitor_process options\n";
+    std::cout << "  --logger \"<options>\"  Extra logger_process options, e.g. \"--sinks csv,rollup\"\n";
+    std::cout << "  --help                Show this help message\n";
+    std::cout << "\nExample:\n";
+    std::cout << "  " << prog_name << " --config config/telemetry.json --duration 60 --no-monitor\n";
+}
+
+int main(int argc, char** argv) {
+    std::string config_file;
+    std::string duration;
+    bool with_monitor = true;
+    bool with_logger = true;
+    bool verbose = false;
+    std::string hub_options, monitor_options, logger_options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration = argv[++i];
+        } else if (arg == "--no-monitor") {
+            with_monitor = false;
+        } else if (arg == "--no-logger") {
+            with_logger = false;
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--hub" && i + 1 < argc) {
+            hub_options = argv[++i];
+        } else if (arg == "--monitor" && i + 1 < argc) {
+            monitor_options = argv[++i];
+        } else if (arg == "--logger" && i + 1 < argc) {
+            logger_options = argv[++i];
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "[ERROR] Unknown option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    // The config store is process-wide: load it once here, so the consumers
+    // see it before the hub starts. Only the hub gets --config, which makes
+    // it the one component acting on SIGHUP.
+    if (!config_file.empty()) {
+        std::string error;
+        if (!telemetry::config_store().reload(config_file, error)) {
+            std::cerr << "[ERROR] Failed to load config: " << error << "\n";
+            return 1;
+        }
+    }
+    // Progress lines would scroll the dashboard away
+    if (with_monitor && !verbose) {
+        telemetry::set_log_level(telemetry::LogLevel::Error);
+    }
+
+    // ========== COMPONENTS ==========
+    // Consumers first, so they are subscribed before the first sample
+    std::vector<std::unique_ptr<Component>> consumers;
+    auto add = [](std::vector<std::unique_ptr<Component>>& list, const char* name, int (*entry)(int, char**),
+                  void (*stop)(), const std::string& options) -> Component& {
+        auto component = std::make_unique<Component>();
+        component->name = name;
+        component->entry = entry;
+        component->stop = stop;
+        component->args = {std::string("telemetry_all/") + name, "--transport", "inproc"};
+        append_options(component->args, options);
+        list.push_back(std::move(component));
+        return *list.back();
+    };
+    if (with_logger) {
+        add(consumers, "logger", logger_main, logger_stop, logger_options);
+    }
+    if (with_monitor) {
+        add(consumers, "monitor", monitor_main, monitor_stop, monitor_options);
+    }
+    std::vector<std::unique_ptr<Component>> hubs;
+    Component& hub = add(hubs, "hub", sensor_hub_main, sensor_hub_stop, "");
+    if (!config_file.empty()) {
+        hub.args.insert(hub.args.end(), {"--config", config_file});
+    }
+    if (!duration.empty()) {
+        hub.args.insert(hub.args.end(), {"--duration", duration});
+    }
+    append_options(hub.args, hub_options);
+
+    for (auto& consumer : consumers) {
+        consumer->thread = std::thread(run_component, std::ref(*consumer));
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (telemetry::inprocess_bus().subscribers() < consumers.size() && !any_done(consumers) &&
+           !g_stop_requested && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    bool consumers_ready = telemetry::inprocess_bus().subscribers() == consumers.size();
+    if (consumers_ready && !g_stop_requested) {
+        hub.thread = std::thread(run_component, std::ref(hub));
+        telemetry::log_out() << "[All] " << consumers.size() + 1 << " components up in "
+                             << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    std::chrono::steady_clock::now() - start_time).count() << " ms";
+    } else if (!consumers_ready) {
+        std::cerr << "[ERROR] A component failed to start\n";
+    }
+
+    // ========== RUN ==========
+    // Until Ctrl+C, or until any component exits (the hub's --duration, or an error)
+    while (hub.thread.joinable() && !g_stop_requested && !hub.done && !any_done(consumers)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    // ========== SHUTDOWN ==========
+    // Hub first, then give the consumers a moment to drain what it queued
+    hub.stop();
+    if (hub.thread.joinable()) {
+        hub.thread.join();
+    }
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (telemetry::inprocess_bus().pending() > 0 && !any_done(consumers) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    int exit_code = consumers_ready ? hub.exit_code : 1;
+    for (auto& consumer : consumers) {
+        consumer->stop();
+        consumer->thread.join();
+        if (exit_code == 0) {
+            exit_code = consumer->exit_code;
+        }
+    }
+    std::cout << "[All] Exited" << (exit_code == 0 ? " cleanly" : " with errors") << ".\n";
+    return exit_code;
+}
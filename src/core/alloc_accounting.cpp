@@ -0,0 +1,70 @@
+#include "alloc_accounting.h"
+#include <atomic>
+#include <cstdio>
+
+namespace telemetry {
+
+namespace {
+
+// Constant-initialised and trivially destructible, so operator new can
+// touch it at any point in a thread's life (including static init and
+// thread exit) without a TLS guard.
+thread_local AllocCounts t_counts;
+
+std::atomic<bool> g_enabled{false};
+
+} // namespace
+
+namespace detail {
+
+void note_allocation(size_t bytes) noexcept {
+    t_counts.allocations++;
+    t_counts.bytes += bytes;
+}
+
+void note_deallocation() noexcept {
+    t_counts.deallocations++;
+}
+
+void mark_alloc_accounting_enabled() noexcept {
+    g_enabled.store(true, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+AllocCounts thread_alloc_counts() {
+    return t_counts;
+}
+
+bool alloc_accounting_enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+// ========== AllocRegion ==========
+
+void AllocRegion::end() {
+    AllocCounts now = thread_alloc_counts();
+    totals_.allocations += now.allocations - start_.allocations;
+    totals_.deallocations += now.deallocations - start_.deallocations;
+    totals_.bytes += now.bytes - start_.bytes;
+    ++iterations_;
+}
+
+std::string AllocRegion::summary() const {
+    if (!alloc_accounting_enabled()) {
+        return name_ + ": allocation accounting not built in (-DTELEMETRY_ALLOC_ACCOUNTING=ON)";
+    }
+    if (iterations_ == 0) {
+        return name_ + ": no iterations";
+    }
+    double n = static_cast<double>(iterations_);
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%s: %.2f allocations (%.0f bytes) per iteration (%llu iterations)",
+                  name_.c_str(), static_cast<double>(totals_.allocations) / n,
+                  static_cast<double>(totals_.bytes) / n,
+                  static_cast<unsigned long long>(iterations_));
+    return line;
+}
+
+} // namespace telemetry
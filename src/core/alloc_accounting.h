@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace telemetry {
+
+// Heap activity of one thread. Only moves when the counting operator
+// new/delete (alloc_hooks.cpp, the telemetry_alloc_hooks object library)
+// is linked into the binary: always for test_alloc_accounting, and for the
+// apps with -DTELEMETRY_ALLOC_ACCOUNTING=ON.
+struct AllocCounts {
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes = 0;          // requested bytes, not counting allocator overhead
+};
+
+// Totals for the calling thread since it started (a thread-local read).
+AllocCounts thread_alloc_counts();
+
+// True when the counting hooks are linked in; without them every count
+// stays 0 and "zero allocations" would prove nothing.
+bool alloc_accounting_enabled();
+
+// Accumulates the calling thread's allocations over repeated executions of
+// a region, like PerfRegion does for hardware counters:
+//
+//   telemetry::AllocRegion publish("publish");
+//   { telemetry::AllocScope scope(publish); ... }
+//   std::cout << publish.summary();   // allocations per iteration
+class AllocRegion {
+public:
+    explicit AllocRegion(std::string name) : name_(std::move(name)) {}
+
+    void begin() { start_ = thread_alloc_counts(); }
+    void end();
+
+    uint64_t iterations() const { return iterations_; }
+    const AllocCounts& totals() const { return totals_; }
+
+    // "<name>: 0.00 allocations (0 bytes) per iteration (N iterations)", or
+    // a note that accounting is not compiled in.
+    std::string summary() const;
+
+private:
+    std::string name_;
+    AllocCounts start_;
+    AllocCounts totals_;
+    uint64_t iterations_ = 0;
+};
+
+// Brackets one iteration of a region; a null region makes it a no-op.
+class AllocScope {
+public:
+    explicit AllocScope(AllocRegion* region) : region_(region) {
+        if (region_ != nullptr) region_->begin();
+    }
+    explicit AllocScope(AllocRegion& region) : AllocScope(&region) {}
+    ~AllocScope() {
+        if (region_ != nullptr) region_->end();
+    }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    AllocRegion* region_;
+};
+
+namespace detail {
+// Called by the counting operator new/delete; must not allocate.
+void note_allocation(size_t bytes) noexcept;
+void note_deallocation() noexcept;
+void mark_alloc_accounting_enabled() noexcept;
+} // namespace detail
+
+} // namespace telemetry
@@ -0,0 +1,99 @@
+// Counting replacements for the global operator new/delete. Deliberately
+// not part of telemetry_core: a static library member defining operator new
+// would be pulled into every binary. Link the telemetry_alloc_hooks object
+// library to opt in (see TELEMETRY_ALLOC_ACCOUNTING).
+#include <cstdlib>
+#include <new>
+
+#include "alloc_accounting.h"
+
+namespace {
+
+struct EnableAccounting {
+    EnableAccounting() { telemetry::detail::mark_alloc_accounting_enabled(); }
+} g_enable_accounting;
+
+void* counted_alloc(size_t size) {
+    telemetry::detail::note_allocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* counted_aligned_alloc(size_t size, std::align_val_t align) {
+    telemetry::detail::note_allocation(size);
+    void* p = nullptr;
+    size_t alignment = static_cast<size_t>(align);
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    if (posix_memalign(&p, alignment, size == 0 ? 1 : size) != 0) {
+        return nullptr;
+    }
+    return p;
+}
+
+void counted_free(void* p) noexcept {
+    if (p != nullptr) {
+        telemetry::detail::note_deallocation();
+        std::free(p);
+    }
+}
+
+} // namespace
+
+// Kept out of line so GCC doesn't pair the inlined malloc/free against
+// new/delete (-Wmismatched-new-delete).
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    if (void* p = counted_alloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](size_t size) {
+    if (void* p = counted_alloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+__attribute__((noinline)) void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t align) {
+    if (void* p = counted_aligned_alloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](size_t size, std::align_val_t align) {
+    if (void* p = counted_aligned_alloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t align,
+                                             const std::nothrow_t&) noexcept {
+    return counted_aligned_alloc(size, align);
+}
+
+__attribute__((noinline)) void* operator new[](size_t size, std::align_val_t align,
+                                               const std::nothrow_t&) noexcept {
+    return counted_aligned_alloc(size, align);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete[](void* p) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, std::align_val_t) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t, std::align_val_t) noexcept { counted_free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    counted_free(p);
+}
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    counted_free(p);
+}
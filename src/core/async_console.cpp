@@ -0,0 +1,296 @@
+#include "async_console.h"
+#include <algorithm>
+#include <cstring>
+
+#include "trace.h"
+
+namespace telemetry {
+
+namespace {
+constexpr auto IDLE_WAIT = std::chrono::milliseconds(2);
+
+uint64_t round_up_pow2(size_t n) {
+    uint64_t capacity = 2;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+uint64_t steady_ms() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+} // namespace
+
+// ========== AsyncConsole ==========
+
+AsyncConsole::AsyncConsole(size_t capacity, FILE* out, FILE* err)
+    : slots_(new Slot[round_up_pow2(capacity)]),
+      mask_(round_up_pow2(capacity) - 1),
+      out_(out),
+      err_(err),
+      dropped_metric_(metrics().counter("console.lines_dropped")) {
+    for (uint64_t i = 0; i <= mask_; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AsyncConsole::~AsyncConsole() {
+    stop();
+}
+
+void AsyncConsole::start() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    if (users_++ > 0) {
+        return;
+    }
+    stopped_ = false;
+    running_ = true;
+    thread_ = std::thread(&AsyncConsole::run, this);
+}
+
+void AsyncConsole::stop() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    if (users_ > 1) {
+        users_--;
+        return;
+    }
+    users_ = 0;
+    // Later writes go straight out. A writer that checked stopped_ before
+    // this store is counted in writers_ (both seq_cst, so either it sees
+    // the flag or we see it), and its line is in the ring once it leaves.
+    stopped_.store(true);
+    while (writers_.load() != 0) {
+        std::this_thread::yield();
+    }
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    drain();
+}
+
+bool AsyncConsole::write(ConsoleStream stream, const char* text, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    writers_.fetch_add(1);
+    if (stopped_.load()) {
+        writers_.fetch_sub(1, std::memory_order_release);
+        write_direct(stream, text, len);
+        return true;
+    }
+    bool queued = push(stream, text, len);
+    writers_.fetch_sub(1, std::memory_order_release);
+    if (!queued) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        dropped_metric_.add();
+    }
+    return queued;
+}
+
+void AsyncConsole::write_direct(ConsoleStream stream, const char* text, size_t len) {
+    // Held by stop() until its final drain is out
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    FILE* f = file(stream);
+    std::fwrite(text, 1, len, f);
+    std::fflush(f);
+}
+
+// Bounded multi-producer ring: each slot's sequence says whose turn it is
+// (producer claiming position p waits for p, the drain thread for p + 1).
+// A line longer than SLOT_TEXT claims consecutive slots with one CAS.
+bool AsyncConsole::push(ConsoleStream stream, const char* text, size_t len) {
+    uint64_t count = (len + SLOT_TEXT - 1) / SLOT_TEXT;
+    if (count > mask_ + 1) {
+        return false;   // would never fit
+    }
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        // The drain thread frees slots in order, so if the line's last slot
+        // is free for this lap, so are the ones before it
+        uint64_t last = pos + count - 1;
+        uint64_t seq = slots_[last & mask_].sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(last);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;   // full
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+        Slot& slot = slots_[(pos + i) & mask_];
+        size_t chunk = std::min(len - i * SLOT_TEXT, SLOT_TEXT);
+        slot.stream = stream;
+        slot.length = static_cast<uint16_t>(chunk);
+        std::memcpy(slot.text, text + i * SLOT_TEXT, chunk);
+    }
+    // First slot last: the drain thread takes the whole line in one pass
+    for (uint64_t i = count; i-- > 0;) {
+        slots_[(pos + i) & mask_].sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+void AsyncConsole::replace_frame(std::string frame) {
+    writers_.fetch_add(1);
+    if (stopped_.load()) {
+        writers_.fetch_sub(1, std::memory_order_release);
+        write_direct(ConsoleStream::Out, frame.data(), frame.size());
+        return;
+    }
+    std::string* old = frame_.exchange(new std::string(std::move(frame)), std::memory_order_acq_rel);
+    writers_.fetch_sub(1, std::memory_order_release);
+    if (old != nullptr) {
+        replaced_frames_.fetch_add(1, std::memory_order_relaxed);
+        delete old;
+    }
+}
+
+bool AsyncConsole::drain() {
+    std::string out;
+    std::string err;
+    while (true) {
+        Slot& slot = slots_[head_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            break;
+        }
+        (slot.stream == ConsoleStream::Err ? err : out).append(slot.text, slot.length);
+        slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+    }
+
+    std::unique_ptr<std::string> frame(frame_.exchange(nullptr, std::memory_order_acq_rel));
+    if (frame) {
+        out += *frame;
+    }
+
+    if (!err.empty()) {
+        std::fwrite(err.data(), 1, err.size(), err_);
+        std::fflush(err_);
+    }
+    if (!out.empty()) {
+        std::fwrite(out.data(), 1, out.size(), out_);
+        std::fflush(out_);
+    }
+    return !out.empty() || !err.empty();
+}
+
+void AsyncConsole::run() {
+    set_trace_thread_name("console");
+    while (running_.load(std::memory_order_relaxed)) {
+        if (!drain()) {
+            std::this_thread::sleep_for(IDLE_WAIT);
+        }
+    }
+}
+
+AsyncConsole& console() {
+    static AsyncConsole instance;
+    return instance;
+}
+
+// ========== Log level ==========
+
+namespace detail {
+std::atomic<uint8_t> g_log_level{static_cast<uint8_t>(LogLevel::Info)};
+} // namespace detail
+
+void set_log_level(LogLevel level) {
+    detail::g_log_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+const char* log_level_name(LogLevel level) {
+    return level == LogLevel::Error ? "error" : "info";
+}
+
+bool parse_log_level(const std::string& text, LogLevel& level) {
+    if (text == "error") {
+        level = LogLevel::Error;
+    } else if (text == "info") {
+        level = LogLevel::Info;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ========== RateLimit ==========
+
+bool RateLimit::allow(uint64_t& suppressed) {
+    uint64_t now = steady_ms();
+    uint64_t start = window_start_ms_.load(std::memory_order_relaxed);
+    if (now - start >= interval_ms_ &&
+        window_start_ms_.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        count_.store(0, std::memory_order_relaxed);
+    }
+
+    if (count_.fetch_add(1, std::memory_order_relaxed) < burst_) {
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// ========== ConsoleLine ==========
+
+ConsoleLine::~ConsoleLine() {
+    if (!active_) {
+        return;
+    }
+    if (suppressed_ > 0) {
+        *this << " (" << suppressed_ << " similar suppressed)";
+    }
+    if (length_ == sizeof(buffer_)) {
+        --length_;
+    }
+    buffer_[length_++] = '\n';
+    (target_ != nullptr ? *target_ : console()).write(stream_, buffer_, length_);
+}
+
+ConsoleLine& ConsoleLine::append(const char* text, size_t len) {
+    if (!active_) return *this;
+    size_t n = std::min(len, sizeof(buffer_) - length_);
+    std::memcpy(buffer_ + length_, text, n);
+    length_ += n;
+    return *this;
+}
+
+ConsoleLine& ConsoleLine::operator<<(const char* text) {
+    if (!active_) return *this;
+    return append(text, std::strlen(text));
+}
+
+ConsoleLine& ConsoleLine::operator<<(double value) {
+    if (!active_) return *this;
+    char tmp[32];
+    int n = std::snprintf(tmp, sizeof(tmp), "%g", value);
+    return append(tmp, n > 0 ? static_cast<size_t>(n) : 0);
+}
+
+ConsoleLine& ConsoleLine::append_signed(long long value) {
+    if (value < 0) {
+        append("-", 1);
+        return append_unsigned(0ULL - static_cast<unsigned long long>(value));
+    }
+    return append_unsigned(static_cast<unsigned long long>(value));
+}
+
+ConsoleLine& ConsoleLine::append_unsigned(unsigned long long value) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[sizeof(tmp) - 1 - n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return append(tmp + sizeof(tmp) - n, n);
+}
+
+} // namespace telemetry
@@ -0,0 +1,186 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "metrics.h"
+
+namespace telemetry {
+
+enum class ConsoleStream : uint8_t { Out, Err };
+
+// Console output for hot loops. Producers copy a formatted line into a
+// lock-free ring and return; a background thread does the blocking
+// fwrite()s. When the ring is full the line is dropped and counted, so a
+// slow or stalled terminal never holds up data processing.
+//
+// Lines written before start() are queued; lines written after stop() go
+// straight to the stream (once stop() has drained the ring), so late
+// shutdown messages are not lost.
+class AsyncConsole {
+public:
+    static constexpr size_t SLOT_TEXT = 240;   // longer writes take consecutive slots
+
+    explicit AsyncConsole(size_t capacity = 1024, FILE* out = stdout, FILE* err = stderr);
+    ~AsyncConsole();
+
+    AsyncConsole(const AsyncConsole&) = delete;
+    AsyncConsole& operator=(const AsyncConsole&) = delete;
+
+    // start()/stop() pairs nest (telemetry_all runs three apps on one
+    // console); the outermost stop() drains everything queued and joins
+    // the drain thread. stop() without start() just drains.
+    void start();
+    void stop();
+
+    // Never blocks. A write is queued whole or dropped whole (ring full, or
+    // longer than the entire ring), so it never interleaves with other
+    // producers' output. Returns false if it was dropped.
+    bool write(ConsoleStream stream, const char* text, size_t len);
+    bool write(ConsoleStream stream, const std::string& text) {
+        return write(stream, text.data(), text.size());
+    }
+
+    // Full-screen output such as the monitor dashboard: only the newest
+    // frame is kept, so a slow terminal skips frames instead of queueing them.
+    void replace_frame(std::string frame);
+
+    uint64_t dropped_lines() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t replaced_frames() const { return replaced_frames_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence{0};
+        ConsoleStream stream = ConsoleStream::Out;
+        uint16_t length = 0;
+        char text[SLOT_TEXT];
+    };
+
+    bool push(ConsoleStream stream, const char* text, size_t len);
+    // After stop(): straight to the stream, ordered after the final drain
+    void write_direct(ConsoleStream stream, const char* text, size_t len);
+    // Writes out what is queued. Returns false if there was nothing.
+    bool drain();
+    void run();
+    FILE* file(ConsoleStream stream) const { return stream == ConsoleStream::Err ? err_ : out_; }
+
+    std::unique_ptr<Slot[]> slots_;
+    const uint64_t mask_;
+    alignas(64) std::atomic<uint64_t> tail_{0};   // producers
+    alignas(64) uint64_t head_ = 0;               // drain thread only
+    std::atomic<std::string*> frame_{nullptr};
+
+    FILE* out_;
+    FILE* err_;
+    std::thread thread_;
+    std::mutex lifecycle_mutex_;   // start/stop
+    int users_ = 0;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopped_{false};
+    // write()/replace_frame() calls that saw stopped_ unset and may still
+    // be queueing; stop() waits for them before its final drain
+    std::atomic<uint32_t> writers_{0};
+
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> replaced_frames_{0};
+    Counter dropped_metric_;
+};
+
+// Process-wide console the apps log through.
+AsyncConsole& console();
+
+// Which lines log_out() lets through: Error keeps only log_err() output,
+// Info (the default) adds progress lines. Changeable at runtime (the
+// control socket's "loglevel" command).
+enum class LogLevel : uint8_t { Error, Info };
+
+namespace detail {
+extern std::atomic<uint8_t> g_log_level;
+} // namespace detail
+
+inline LogLevel log_level() {
+    return static_cast<LogLevel>(detail::g_log_level.load(std::memory_order_relaxed));
+}
+void set_log_level(LogLevel level);
+const char* log_level_name(LogLevel level);
+// Accepts "error" and "info".
+bool parse_log_level(const std::string& text, LogLevel& level);
+
+// Lets at most `burst` messages through per `interval`; the rest are counted
+// and reported on the next message that gets through.
+class RateLimit {
+public:
+    RateLimit(uint32_t burst, std::chrono::milliseconds interval)
+        : burst_(burst), interval_ms_(static_cast<uint64_t>(interval.count())) {}
+
+    // `suppressed` receives how many messages were refused since the last
+    // one allowed.
+    bool allow(uint64_t& suppressed);
+
+private:
+    const uint32_t burst_;
+    const uint64_t interval_ms_;
+    std::atomic<uint64_t> window_start_ms_{0};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+// One console line, formatted into a fixed buffer and handed to console()
+// when it goes out of scope; the trailing newline is added automatically.
+// Text beyond the buffer is truncated.
+//
+//   telemetry::log_out() << "[DDS] Published #" << count;
+//   static telemetry::RateLimit limit(5, std::chrono::seconds(1));
+//   telemetry::log_err(limit) << "[ERROR] Failed to parse message: " << e.what();
+class ConsoleLine {
+public:
+    // `target` defaults to console()
+    ConsoleLine(ConsoleStream stream, bool active = true, uint64_t suppressed = 0,
+                AsyncConsole* target = nullptr)
+        : stream_(stream), active_(active), suppressed_(suppressed), target_(target) {}
+    ~ConsoleLine();
+
+    ConsoleLine(const ConsoleLine&) = delete;
+    ConsoleLine& operator=(const ConsoleLine&) = delete;
+
+    ConsoleLine& operator<<(const char* text);
+    ConsoleLine& operator<<(const std::string& text) { return append(text.data(), text.size()); }
+    ConsoleLine& operator<<(char c) { return append(&c, 1); }
+    ConsoleLine& operator<<(double value);
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    ConsoleLine& operator<<(T value) {
+        if (!active_) return *this;
+        return std::is_signed<T>::value ? append_signed(static_cast<long long>(value))
+                                        : append_unsigned(static_cast<unsigned long long>(value));
+    }
+
+private:
+    ConsoleLine& append(const char* text, size_t len);
+    ConsoleLine& append_signed(long long value);
+    ConsoleLine& append_unsigned(unsigned long long value);
+
+    ConsoleStream stream_;
+    bool active_;
+    uint64_t suppressed_;
+    AsyncConsole* target_;
+    size_t length_ = 0;
+    char buffer_[AsyncConsole::SLOT_TEXT];
+};
+
+inline ConsoleLine log_out() { return ConsoleLine(ConsoleStream::Out, log_level() >= LogLevel::Info); }
+inline ConsoleLine log_err() { return ConsoleLine(ConsoleStream::Err); }
+
+inline ConsoleLine log_err(RateLimit& limit) {
+    uint64_t suppressed = 0;
+    bool active = limit.allow(suppressed);
+    return ConsoleLine(ConsoleStream::Err, active, suppressed);
+}
+
+} // namespace telemetry
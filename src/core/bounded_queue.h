@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+// What a full queue does with a new item.
+enum class OverflowPolicy {
+    Block,       // producer waits for space (lossless, applies backpressure)
+    DropNewest,  // new item is discarded
+    DropOldest   // oldest queued item is evicted to make room
+};
+
+// Capacity-limited variant of ThreadSafeQueue. The overflow behaviour is
+// chosen per queue so one slow consumer never stalls an unrelated producer.
+// Items live in a ring allocated up front, so push/pop never touch the heap
+// (a deque allocates and frees a chunk every few hundred bytes of traffic).
+template <typename T>
+class BoundedQueue {
+private:
+    std::vector<T> ring_;
+    size_t head_ = 0;    // index of the oldest item
+    size_t count_ = 0;
+    const size_t capacity_;
+    const OverflowPolicy policy_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::atomic<bool> stopped_{false};
+
+public:
+    BoundedQueue(size_t capacity, OverflowPolicy policy)
+        : ring_(capacity == 0 ? 1 : capacity), capacity_(capacity == 0 ? 1 : capacity), policy_(policy) {}
+
+    // Pushes according to the overflow policy.
+    // Returns false if an item (new or evicted) was dropped or the queue is stopped.
+    bool push(const T& value) {
+        bool dropped = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stopped_) {
+                return false;
+            }
+            if (count_ >= capacity_) {
+                switch (policy_) {
+                    case OverflowPolicy::Block:
+                        not_full_.wait(lock, [this] {
+                            return count_ < capacity_ || stopped_;
+                        });
+                        if (stopped_) {
+                            return false;
+                        }
+                        break;
+                    case OverflowPolicy::DropNewest:
+                        return false;
+                    case OverflowPolicy::DropOldest:
+                        head_ = (head_ + 1) % capacity_;
+                        count_--;
+                        dropped = true;
+                        break;
+                }
+            }
+            ring_[(head_ + count_) % capacity_] = value;
+            count_++;
+        }
+        not_empty_.notify_one();
+        return !dropped;
+    }
+
+    // Waits up to `timeout` for data. Returns false on timeout or when stopped and drained.
+    template <typename Rep, typename Period>
+    bool pop_for(T& value, std::chrono::duration<Rep, Period> timeout) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!not_empty_.wait_for(lock, timeout, [this] {
+                    return count_ > 0 || stopped_;
+                })) {
+                return false;
+            }
+            if (count_ == 0) {
+                return false; // stopped and drained
+            }
+            value = ring_[head_];
+            head_ = (head_ + 1) % capacity_;
+            count_--;
+        }
+        not_full_.notify_one();
+        return true;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    size_t capacity() const { return capacity_; }
+    OverflowPolicy policy() const { return policy_; }
+    bool stopped() const { return stopped_; }
+
+    // Wakes producers and consumers; consumers still drain what is queued.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+};
@@ -0,0 +1,130 @@
+#include "buffer_pool.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace telemetry {
+
+// ========== BufferPool ==========
+
+BufferPool::~BufferPool() {
+    for (auto& list : free_) {
+        for (char* buffer : list) {
+            delete[] buffer;
+        }
+    }
+}
+
+size_t BufferPool::class_index(size_t size) {
+    size_t index = 0;
+    size_t capacity = MIN_CLASS_SIZE;
+    while (capacity < size) {
+        capacity <<= 1;
+        ++index;
+    }
+    return index;
+}
+
+size_t BufferPool::class_size(size_t size) {
+    if (size > MAX_CLASS_SIZE) {
+        return size;
+    }
+    return MIN_CLASS_SIZE << class_index(size);
+}
+
+char* BufferPool::acquire(size_t size, size_t& capacity) {
+    capacity = class_size(size);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.acquired;
+        ++stats_.outstanding;
+        if (capacity <= MAX_CLASS_SIZE) {
+            auto& list = free_[class_index(capacity)];
+            if (!list.empty()) {
+                char* buffer = list.back();
+                list.pop_back();
+                return buffer;
+            }
+        }
+        ++stats_.heap_allocations;
+    }
+    return new char[capacity];
+}
+
+void BufferPool::release(char* buffer, size_t capacity) {
+    if (buffer == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --stats_.outstanding;
+        if (capacity <= MAX_CLASS_SIZE) {
+            // Free lists only grow while buffers are outstanding, so in steady
+            // state push_back stays within the vector's existing capacity
+            free_[class_index(capacity)].push_back(buffer);
+            return;
+        }
+    }
+    delete[] buffer;
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+BufferPool& buffer_pool() {
+    static BufferPool instance;
+    return instance;
+}
+
+// ========== Arena ==========
+
+Arena::Arena(size_t block_size, BufferPool& pool)
+    : pool_(pool), block_size_(BufferPool::class_size(block_size)) {}
+
+Arena::~Arena() {
+    for (const Block& block : blocks_) {
+        pool_.release(block.data, block.capacity);
+    }
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    while (current_ < blocks_.size()) {
+        Block& block = blocks_[current_];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+        uintptr_t aligned = (base + offset_ + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+        size_t end = static_cast<size_t>(aligned - base) + size;
+        if (end <= block.capacity) {
+            offset_ = end;
+            return reinterpret_cast<void*>(aligned);
+        }
+        if (current_ + 1 == blocks_.size()) {
+            break;
+        }
+        ++current_;
+        offset_ = 0;
+    }
+
+    // Oversized requests get a block of their own
+    size_t capacity = 0;
+    char* data = pool_.acquire(std::max(block_size_, size + align), capacity);
+    blocks_.push_back({data, capacity});
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return allocate(size, align);
+}
+
+void Arena::reset() {
+    current_ = 0;
+    offset_ = 0;
+}
+
+size_t Arena::bytes_used() const {
+    size_t used = offset_;
+    for (size_t i = 0; i < current_ && i < blocks_.size(); ++i) {
+        used += blocks_[i].capacity;
+    }
+    return used;
+}
+
+} // namespace telemetry
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace telemetry {
+
+// Recycles message-sized buffers by power-of-two size class (64 B .. 64 KB).
+// Once the free lists have warmed up, acquire()/release() never reach
+// malloc. Requests above the largest class go straight to the heap.
+class BufferPool {
+public:
+    static constexpr size_t MIN_CLASS_SIZE = 64;
+    static constexpr size_t NUM_CLASSES = 11;   // 64 << 10 = 64 KB
+    static constexpr size_t MAX_CLASS_SIZE = MIN_CLASS_SIZE << (NUM_CLASSES - 1);
+
+    struct Stats {
+        uint64_t acquired = 0;
+        uint64_t heap_allocations = 0;   // acquisitions the free lists couldn't serve
+        uint64_t outstanding = 0;
+    };
+
+    BufferPool() = default;
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Returns a buffer of at least `size` bytes; `capacity` receives its
+    // actual size, which must be passed back to release().
+    char* acquire(size_t size, size_t& capacity);
+    void release(char* buffer, size_t capacity);
+
+    Stats stats() const;
+
+    static size_t class_size(size_t size);
+
+private:
+    static size_t class_index(size_t size);
+
+    mutable std::mutex mutex_;
+    std::array<std::vector<char*>, NUM_CLASSES> free_;
+    Stats stats_;
+};
+
+// Process-wide pool shared by the codecs and arenas.
+BufferPool& buffer_pool();
+
+// Bump allocator for everything one message or batch needs. Memory comes
+// from the pool in blocks and is handed back in bulk by reset() (keeps the
+// blocks for the next batch) or on destruction. Not thread-safe: one arena
+// per processing loop.
+class Arena {
+public:
+    explicit Arena(size_t block_size = 4096, BufferPool& pool = buffer_pool());
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+    char* allocate_chars(size_t size) { return static_cast<char*>(allocate(size, 1)); }
+
+    // Invalidates everything allocated so far; blocks are kept for reuse.
+    void reset();
+
+    size_t bytes_used() const;
+    size_t blocks() const { return blocks_.size(); }
+
+private:
+    struct Block {
+        char* data;
+        size_t capacity;
+    };
+
+    BufferPool& pool_;
+    const size_t block_size_;
+    std::vector<Block> blocks_;
+    size_t current_ = 0;    // index into blocks_
+    size_t offset_ = 0;     // bytes used in blocks_[current_]
+};
+
+} // namespace telemetry
@@ -0,0 +1,103 @@
+#include "checkpoint.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace telemetry {
+
+namespace {
+const char* HEADER = "# MiniTelemetry checkpoint v1";
+}
+
+SequenceCheckpoint::SequenceCheckpoint(std::string path) : path_(std::move(path)) {}
+
+bool SequenceCheckpoint::load() {
+    clear();
+
+    std::ifstream in(path_);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || line != HEADER) {
+        return false;
+    }
+
+    // "offset <bytes>", then one "sensor_id sequence timestamp" line per
+    // sensor. Older checkpoints have no offset line (offset 0).
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        if (line.rfind("offset ", 0) == 0) {
+            std::string key;
+            fields >> key >> data_offset_;
+            continue;
+        }
+        int sensor_id;
+        SensorMark mark;
+        if (fields >> sensor_id >> mark.sequence >> mark.timestamp) {
+            marks_[sensor_id] = mark;
+        }
+    }
+    return true;
+}
+
+bool SequenceCheckpoint::save() const {
+    const std::string tmp_path = path_ + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << HEADER << "\n";
+        out << "offset " << data_offset_ << "\n";
+        for (const auto& pair : marks_) {
+            out << pair.first << " " << pair.second.sequence << " "
+                << pair.second.timestamp << "\n";
+        }
+        out.flush();
+        if (!out.good()) {
+            return false;
+        }
+    }
+    if (!sync_path(tmp_path) || std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        return false;
+    }
+    // Make the rename itself durable
+    size_t slash = path_.find_last_of('/');
+    return sync_path(slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash));
+}
+
+void SequenceCheckpoint::clear() {
+    marks_.clear();
+    data_offset_ = 0;
+}
+
+bool SequenceCheckpoint::covers(int sensor_id, uint64_t sequence, long timestamp) const {
+    auto it = marks_.find(sensor_id);
+    if (it == marks_.end()) {
+        return false;
+    }
+    return sequence <= it->second.sequence && timestamp <= it->second.timestamp;
+}
+
+void SequenceCheckpoint::advance(int sensor_id, uint64_t sequence, long timestamp) {
+    SensorMark& mark = marks_[sensor_id];
+    mark.sequence = sequence;
+    mark.timestamp = timestamp;
+}
+
+bool sync_path(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+} // namespace telemetry
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace telemetry {
+
+// Per-sensor high-water mark of what has been persisted.
+struct SensorMark {
+    uint64_t sequence = 0;
+    long timestamp = 0;     // Sample timestamp of that sequence
+};
+
+// Small on-disk record of the last persisted sequence per sensor, so a
+// restarted logger can append to its output and skip samples it already
+// wrote without rescanning the file.
+//
+// A sample counts as already persisted only if both its sequence and its
+// timestamp are at or below the mark. A restarted hub starts again at
+// sequence 0 with newer timestamps, so its data is never mistaken for
+// duplicates.
+//
+// The checkpoint also records how many bytes of the data file the marks
+// cover, so rows written after the last save can be found again on restart
+// (recover_csv_marks).
+class SequenceCheckpoint {
+public:
+    explicit SequenceCheckpoint(std::string path);
+
+    // Reads the checkpoint. Returns false (leaving it empty) if the file is
+    // missing or unreadable.
+    bool load();
+    // Atomically and durably replaces the file: write "<path>.tmp", fsync
+    // it, rename it over the old file, then fsync the directory.
+    bool save() const;
+
+    bool covers(int sensor_id, uint64_t sequence, long timestamp) const;
+    void advance(int sensor_id, uint64_t sequence, long timestamp);
+
+    // Size of the data file when the marks were saved
+    uint64_t data_offset() const { return data_offset_; }
+    void set_data_offset(uint64_t offset) { data_offset_ = offset; }
+    void clear();
+
+    const std::map<int, SensorMark>& marks() const { return marks_; }
+    const std::string& path() const { return path_; }
+    bool empty() const { return marks_.empty(); }
+
+private:
+    std::string path_;
+    std::map<int, SensorMark> marks_;
+    uint64_t data_offset_ = 0;
+};
+
+// fsync()s a file or directory by path. Works for files another stream has
+// open, since fsync covers the file, not the descriptor.
+bool sync_path(const std::string& path);
+
+} // namespace telemetry
@@ -0,0 +1,233 @@
+#include "config.h"
+#include <csignal>
+#include <fstream>
+#include <set>
+#include <nlohmann/json.hpp>
+
+namespace telemetry {
+
+namespace {
+std::atomic<bool> g_reload_requested{false};
+
+void handle_reload_signal(int) {
+    g_reload_requested = true;
+}
+
+bool parse_sensor(const nlohmann::json& j, SensorConfig& sensor, std::string& error) {
+    sensor.id = j.at("id").get<int>();
+    sensor.name = j.value("name", sensor.name);
+    sensor.unit = j.value("unit", sensor.unit);
+    sensor.min_value = j.value("min", sensor.min_value);
+    sensor.max_value = j.value("max", sensor.max_value);
+    sensor.rate_hz = j.value("rate_hz", sensor.rate_hz);
+    sensor.type = j.value("type", sensor.type);
+
+    std::string where = "sensor " + std::to_string(sensor.id);
+    if (sensor.id < 0) {
+        error = where + ": id must not be negative";
+        return false;
+    }
+    if (!(sensor.min_value < sensor.max_value)) {
+        error = where + ": min must be below max";
+        return false;
+    }
+    if (!(sensor.rate_hz > 0.0 && sensor.rate_hz <= 1000.0)) {
+        error = where + ": rate_hz must be in (0, 1000]";
+        return false;
+    }
+    if (!is_valid_sensor_type(sensor.topic_type())) {
+        error = where + ": type '" + sensor.topic_type() + "' must be lower-case letters, digits and '_'";
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+std::string SensorConfig::topic_type() const {
+    if (!type.empty()) {
+        return type;
+    }
+    std::string derived;
+    for (char c : name) {
+        if (c >= 'A' && c <= 'Z') {
+            derived += static_cast<char>(c - 'A' + 'a');
+        } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            derived += c;
+        } else if (!derived.empty() && derived.back() != '_') {
+            derived += '_';
+        }
+    }
+    while (!derived.empty() && derived.back() == '_') {
+        derived.pop_back();
+    }
+    return derived;
+}
+
+std::vector<std::string> TelemetryConfig::sensor_types() const {
+    std::set<std::string> types;
+    for (const auto& sensor : sensors) {
+        types.insert(sensor.topic_type());
+    }
+    return std::vector<std::string>(types.begin(), types.end());
+}
+
+QosProfile TelemetryConfig::topic_profile(const std::string& type, QosProfile fallback) const {
+    auto it = topic_qos.find(type);
+    return it != topic_qos.end() ? it->second : fallback;
+}
+
+const SensorConfig* TelemetryConfig::find_sensor(int id) const {
+    for (const auto& sensor : sensors) {
+        if (sensor.id == id) {
+            return &sensor;
+        }
+    }
+    return nullptr;
+}
+
+bool parse_topic_mode(const std::string& name, bool& per_type_topics) {
+    if (name == "shared" || name == "per-type") {
+        per_type_topics = name == "per-type";
+        return true;
+    }
+    return false;
+}
+
+TelemetryConfig default_config() {
+    TelemetryConfig config;
+    config.sensors = {
+        {0, "Temperature", "°C", 20.0, 30.0, 2.0, ""},
+        {1, "Pressure", "hPa", 1000.0, 1020.0, 2.0, ""},
+        {2, "Humidity", "%", 40.0, 60.0, 2.0, ""},
+    };
+    return config;
+}
+
+bool load_config(const std::string& path, TelemetryConfig& config, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    TelemetryConfig loaded = default_config();
+    try {
+        nlohmann::json j = nlohmann::json::parse(in);
+
+        if (j.contains("qos_profile") &&
+            !parse_qos_profile(j["qos_profile"].get<std::string>(), loaded.qos_profile)) {
+            error = "unknown qos_profile " + j["qos_profile"].get<std::string>();
+            return false;
+        }
+
+        loaded.deadline_ms = j.value("deadline_ms", loaded.deadline_ms);
+
+        if (j.contains("domain")) {
+            int64_t domain = j["domain"].get<int64_t>();
+            if (domain < 0 || domain > MAX_DOMAIN_ID) {
+                error = "domain must be in [0, " + std::to_string(MAX_DOMAIN_ID) + "]";
+                return false;
+            }
+            loaded.domain = static_cast<dds_domainid_t>(domain);
+        }
+
+        if (j.contains("partitions")) {
+            loaded.partitions = j["partitions"].get<std::vector<std::string>>();
+            for (const auto& name : loaded.partitions) {
+                if (name.empty()) {
+                    error = "partitions must not contain empty names";
+                    return false;
+                }
+            }
+        }
+
+        if (j.contains("topic_mode")) {
+            std::string mode = j["topic_mode"].get<std::string>();
+            if (!parse_topic_mode(mode, loaded.per_type_topics)) {
+                error = "topic_mode must be \"shared\" or \"per-type\", not " + mode;
+                return false;
+            }
+        }
+
+        if (j.contains("topic_qos")) {
+            for (const auto& [type, name] : j["topic_qos"].items()) {
+                QosProfile profile;
+                if (!parse_qos_profile(name.get<std::string>(), profile)) {
+                    error = "unknown qos_profile " + name.get<std::string>() + " for topic type " + type;
+                    return false;
+                }
+                loaded.topic_qos[type] = profile;
+            }
+        }
+
+        if (j.contains("monitor")) {
+            loaded.monitor_refresh_ms = j["monitor"].value("refresh_ms", loaded.monitor_refresh_ms);
+            if (loaded.monitor_refresh_ms == 0) {
+                error = "monitor.refresh_ms must be positive";
+                return false;
+            }
+        }
+
+        if (j.contains("sensors")) {
+            loaded.sensors.clear();
+            std::set<int> ids;
+            for (const auto& entry : j.at("sensors")) {
+                SensorConfig sensor;
+                if (!parse_sensor(entry, sensor, error)) {
+                    return false;
+                }
+                if (!ids.insert(sensor.id).second) {
+                    error = "duplicate sensor id " + std::to_string(sensor.id);
+                    return false;
+                }
+                loaded.sensors.push_back(std::move(sensor));
+            }
+        }
+    } catch (const std::exception& e) {
+        error = path + ": " + e.what();
+        return false;
+    }
+
+    config = std::move(loaded);
+    return true;
+}
+
+// ========== ConfigStore ==========
+
+ConfigStore::ConfigStore(TelemetryConfig initial) {
+    configs_.push_back(std::make_unique<const TelemetryConfig>(std::move(initial)));
+    current_.store(configs_.back().get(), std::memory_order_release);
+}
+
+ConfigStore::~ConfigStore() = default;
+
+void ConfigStore::publish(TelemetryConfig config) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    configs_.push_back(std::make_unique<const TelemetryConfig>(std::move(config)));
+    current_.store(configs_.back().get(), std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool ConfigStore::reload(const std::string& path, std::string& error) {
+    TelemetryConfig config;
+    if (!load_config(path, config, error)) {
+        return false;
+    }
+    publish(std::move(config));
+    return true;
+}
+
+ConfigStore& config_store() {
+    static ConfigStore instance;
+    return instance;
+}
+
+void install_config_reload_signal(int signo) {
+    std::signal(signo, handle_reload_signal);
+}
+
+bool config_reload_requested() {
+    return g_reload_requested.exchange(false);
+}
+
+} // namespace telemetry
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dds_bootstrap.h"
+
+namespace telemetry {
+
+// One simulated sensor: what the hub generates and how the monitor labels it.
+struct SensorConfig {
+    int id = 0;
+    std::string name = "Generic";
+    std::string unit;
+    double min_value = 0.0;
+    double max_value = 100.0;
+    double rate_hz = 2.0;
+    std::string type;          // per-type topic; empty = derived from the name
+
+    // `type`, or the name lower-cased with other characters as '_'
+    // ("Relative Humidity" -> "relative_humidity")
+    std::string topic_type() const;
+};
+
+// Everything the three processes used to compile in. Built once by
+// load_config() and never modified afterwards; a reload builds a new one.
+struct TelemetryConfig {
+    std::vector<SensorConfig> sensors;
+    QosProfile qos_profile = QosProfile::Default;   // startup only
+    uint64_t deadline_ms = 0;                       // DDS deadline QoS, 0 = none; startup only
+    uint64_t monitor_refresh_ms = 200;
+    dds_domainid_t domain = DDS_DOMAIN_DEFAULT;     // startup only
+    std::vector<std::string> partitions;            // telemetry topic partitions; startup only
+    bool per_type_topics = false;                   // one topic per sensor type; startup only
+    std::map<std::string, QosProfile> topic_qos;    // per-type profile overrides; startup only
+
+    // nullptr if `id` is not configured
+    const SensorConfig* find_sensor(int id) const;
+
+    // Distinct topic types of the configured sensors, sorted
+    std::vector<std::string> sensor_types() const;
+    // The topic_qos entry for `type`, else `fallback` (the process's profile)
+    QosProfile topic_profile(const std::string& type, QosProfile fallback) const;
+};
+
+// "shared" (everything on TELEMETRY_TOPIC) or "per-type" (sensor_topic_name
+// per sensor type), for "topic_mode" and --topic-mode.
+bool parse_topic_mode(const std::string& name, bool& per_type_topics);
+
+// The original three sensors (temperature, pressure, humidity at 2 Hz).
+TelemetryConfig default_config();
+
+// Reads a JSON config file:
+//
+//   {
+//     "qos_profile": "default",
+//     "deadline_ms": 0,
+//     "domain": 0,
+//     "partitions": ["site-a/line-1"],
+//     "topic_mode": "shared",               // or "per-type"
+//     "topic_qos": { "vibration": "low-latency" },
+//     "monitor": { "refresh_ms": 200 },
+//     "sensors": [
+//       { "id": 0, "name": "Temperature", "unit": "°C", "min": 20, "max": 30, "rate_hz": 2,
+//         "type": "temperature" }
+//     ]
+//   }
+//
+// Missing sections keep the defaults. "partitions" is what a hub publishes
+// into and what the monitor and logger subscribe to (patterns allowed). On failure `error` says why and
+// `config` is left untouched.
+bool load_config(const std::string& path, TelemetryConfig& config, std::string& error);
+
+// RCU-style holder for the live config. Readers do a single acquire load
+// and never lock; publish() swaps in a new immutable config. Replaced
+// configs are retired rather than freed, because a reader may still hold
+// the old pointer and there is no grace-period tracking - reloads are
+// operator-initiated and a config is a few hundred bytes.
+class ConfigStore {
+public:
+    explicit ConfigStore(TelemetryConfig initial = default_config());
+    ~ConfigStore();
+
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    // Valid for the store's lifetime.
+    const TelemetryConfig& current() const {
+        return *current_.load(std::memory_order_acquire);
+    }
+
+    // Bumped by every publish(); cheap to poll for "has anything changed".
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    void publish(TelemetryConfig config);
+
+    // load_config() + publish(). The live config is kept on failure.
+    bool reload(const std::string& path, std::string& error);
+
+private:
+    std::atomic<const TelemetryConfig*> current_;
+    std::atomic<uint64_t> version_{1};
+    std::mutex writer_mutex_;   // publishers only
+    std::vector<std::unique_ptr<const TelemetryConfig>> configs_;
+};
+
+// Process-wide store the apps read from.
+ConfigStore& config_store();
+
+// Makes `signo` request a config reload (the apps use SIGHUP). The handler
+// only sets a flag; the apps poll config_reload_requested() from their main loops.
+void install_config_reload_signal(int signo);
+bool config_reload_requested();
+
+} // namespace telemetry
@@ -0,0 +1,281 @@
+#include "control_socket.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "async_console.h"
+#include "metrics.h"
+#include "trace.h"
+
+namespace telemetry {
+
+namespace {
+
+constexpr int POLL_MS = 200;                // how quickly stop() is noticed
+constexpr int CLIENT_IDLE_MS = 30000;
+constexpr size_t MAX_LINE = 4096;
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Blocking send of the whole reply; the socket has a send timeout, so a
+// client that stops reading costs at most that long.
+bool send_all(int fd, const std::string& text) {
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// "0-3,6" style CPU list
+std::string format_cpu_set(const cpu_set_t& set) {
+    std::string out;
+    int start = -1;
+    for (int cpu = 0; cpu <= CPU_SETSIZE; ++cpu) {
+        bool in = cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+        if (in && start < 0) {
+            start = cpu;
+        } else if (!in && start >= 0) {
+            if (!out.empty()) out += ',';
+            out += std::to_string(start);
+            if (cpu - 1 > start) out += '-' + std::to_string(cpu - 1);
+            start = -1;
+        }
+    }
+    return out.empty() ? "-" : out;
+}
+
+} // namespace
+
+// ========== Thread placement ==========
+
+std::string describe_threads() {
+    std::ostringstream out;
+    DIR* dir = ::opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return "threads: /proc/self/task unavailable\n";
+    }
+    while (dirent* entry = ::readdir(dir)) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        std::string task = std::string("/proc/self/task/") + entry->d_name;
+        std::string name;
+        std::ifstream comm(task + "/comm");
+        std::getline(comm, name);
+
+        // Field 39 of stat is the CPU the thread last ran on; count fields
+        // after the ")" that closes the (possibly space-containing) name
+        int last_cpu = -1;
+        std::ifstream stat_file(task + "/stat");
+        std::string stat((std::istreambuf_iterator<char>(stat_file)), std::istreambuf_iterator<char>());
+        size_t close_paren = stat.rfind(')');
+        if (close_paren != std::string::npos) {
+            std::istringstream fields(stat.substr(close_paren + 1));
+            std::string field;
+            for (int index = 3; fields >> field; ++index) {
+                if (index == 39) {
+                    last_cpu = std::atoi(field.c_str());
+                    break;
+                }
+            }
+        }
+
+        cpu_set_t affinity;
+        CPU_ZERO(&affinity);
+        pid_t tid = static_cast<pid_t>(std::atoi(entry->d_name));
+        bool have_affinity = ::sched_getaffinity(tid, sizeof(affinity), &affinity) == 0;
+
+        out << "  " << entry->d_name << "  " << name
+            << std::string(name.size() < 16 ? 16 - name.size() : 1, ' ')
+            << "cpu " << last_cpu
+            << "  affinity " << (have_affinity ? format_cpu_set(affinity) : "?") << "\n";
+    }
+    ::closedir(dir);
+    return out.str();
+}
+
+// ========== ControlServer ==========
+
+ControlServer::ControlServer() {
+    add_command("help", "List commands", [this](const std::string&) {
+        std::ostringstream out;
+        for (const auto& [name, command] : commands_) {
+            out << "  " << name << std::string(name.size() < 12 ? 12 - name.size() : 1, ' ')
+                << command.help << "\n";
+        }
+        return out.str();
+    });
+    add_command("metrics", "Snapshot of every counter, gauge and histogram", [](const std::string&) {
+        return format_metrics(metrics().snapshot());
+    });
+    add_command("threads", "Threads with last CPU and affinity", [](const std::string&) {
+        return describe_threads();
+    });
+    add_command("trace", "trace <file>: write the trace rings as Chrome trace JSON", [](const std::string& args) {
+        if (!tracing_enabled()) {
+            return std::string("tracing is off (start the process with --trace)\n");
+        }
+        if (args.empty()) {
+            return std::string("usage: trace <file>\n");
+        }
+        return write_chrome_trace(args) ? "trace written to " + args + "\n"
+                                        : "failed to write " + args + "\n";
+    });
+    add_command("loglevel", "loglevel [error|info]: show or set console verbosity", [](const std::string& args) {
+        if (!args.empty()) {
+            LogLevel level;
+            if (!parse_log_level(args, level)) {
+                return "unknown log level: " + args + " (error, info)\n";
+            }
+            set_log_level(level);
+        }
+        return std::string("loglevel ") + log_level_name(log_level()) + "\n";
+    });
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+void ControlServer::add_command(const std::string& name, const std::string& help, Handler handler) {
+    commands_[name] = Command{help, std::move(handler)};
+}
+
+bool ControlServer::start(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[ERROR] Control socket path too long: " << path << "\n";
+        return false;
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(path.c_str());
+
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 4) < 0) {
+        std::cerr << "[ERROR] Failed to bind control socket " << path << ": " << std::strerror(errno) << "\n";
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    path_ = path;
+    running_ = true;
+    thread_ = std::thread(&ControlServer::run, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        ::unlink(path_.c_str());
+    }
+}
+
+std::string ControlServer::execute(const std::string& line) const {
+    std::string text = trim(line);
+    if (text.empty()) {
+        return "";
+    }
+    size_t space = text.find_first_of(" \t");
+    std::string name = text.substr(0, space);
+    std::string args = space == std::string::npos ? "" : trim(text.substr(space));
+
+    auto it = commands_.find(name);
+    if (it == commands_.end()) {
+        return "unknown command: " + name + " (try help)\n";
+    }
+    std::string reply = it->second.handler(args);
+    if (reply.empty() || reply.back() != '\n') {
+        reply += '\n';
+    }
+    return reply;
+}
+
+void ControlServer::run() {
+    set_trace_thread_name("control");
+    while (running_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, POLL_MS) <= 0) {
+            continue;
+        }
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        timeval send_timeout{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+        serve(fd);
+        ::close(fd);
+    }
+}
+
+void ControlServer::serve(int fd) {
+    std::string pending;
+    char buf[1024];
+    int idle_ms = 0;
+    while (running_ && idle_ms < CLIENT_IDLE_MS) {
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, POLL_MS);
+        if (ready == 0) {
+            idle_ms += POLL_MS;
+            continue;
+        }
+        ssize_t n = ready > 0 ? ::recv(fd, buf, sizeof(buf), 0) : -1;
+        if (n <= 0) {
+            break;   // client closed (a final unterminated line is still run below)
+        }
+        idle_ms = 0;
+        pending.append(buf, static_cast<size_t>(n));
+
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (!send_all(fd, execute(line))) {
+                return;
+            }
+        }
+        if (pending.size() > MAX_LINE) {
+            send_all(fd, "line too long\n");
+            return;
+        }
+    }
+    if (!pending.empty()) {
+        send_all(fd, execute(pending));
+    }
+}
+
+} // namespace telemetry
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace telemetry {
+
+// Line-oriented introspection server on a Unix-domain socket. Each line a
+// client sends is one command ("name [args]"); the reply is text ending in
+// a newline. Commands run on the server's own thread, so handlers must only
+// touch state that is safe to read concurrently (metrics snapshots, atomics,
+// short mutex-guarded copies) - ingest never waits for a client.
+//
+//   echo metrics | nc -U /tmp/telemetry_hub.ctl
+//   nc -U /tmp/telemetry_monitor.ctl     # interactive: help, threads, ...
+//
+// Built in: help, metrics, threads, trace <file>, loglevel [error|info].
+// Clients are served one at a time; a client idle for 30 s is dropped.
+class ControlServer {
+public:
+    // `args` is the rest of the line after the command name, trimmed.
+    using Handler = std::function<std::string(const std::string& args)>;
+
+    ControlServer();
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // Registers (or replaces) a command. Call before start().
+    void add_command(const std::string& name, const std::string& help, Handler handler);
+
+    // Binds `path` (replacing a stale socket file) and starts the server thread.
+    bool start(const std::string& path);
+    // Stops the thread, closes the socket and removes the file.
+    void stop();
+
+    bool running() const { return running_.load(std::memory_order_relaxed); }
+    const std::string& path() const { return path_; }
+
+    // Runs one command line and returns its reply, as a client would see it.
+    std::string execute(const std::string& line) const;
+
+private:
+    struct Command {
+        std::string help;
+        Handler handler;
+    };
+
+    void run();
+    void serve(int fd);
+
+    std::map<std::string, Command> commands_;
+    std::string path_;
+    int listen_fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+// One line per thread of this process: tid, name (see set_trace_thread_name),
+// the CPU it last ran on and its affinity mask.
+std::string describe_threads();
+
+} // namespace telemetry
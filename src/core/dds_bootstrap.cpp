@@ -0,0 +1,288 @@
+#include "dds_bootstrap.h"
+#include <fnmatch.h>
+#include <iostream>
+
+#include "telemetry.h"
+
+namespace telemetry {
+
+QosSettings qos_settings(QosProfile profile) {
+    QosSettings s;
+    switch (profile) {
+        case QosProfile::Default:
+            break;
+        case QosProfile::LowLatency:
+            s.reliability = DDS_RELIABILITY_BEST_EFFORT;
+            s.max_blocking_time = 0;
+            s.history_depth = 8;
+            break;
+        case QosProfile::HighThroughput:
+            s.max_blocking_time = DDS_SECS(1);
+            s.history = DDS_HISTORY_KEEP_ALL;
+            s.history_depth = 0;
+            s.max_samples = 4096;
+            s.writer_batching = true;
+            break;
+        case QosProfile::LosslessLogging:
+            s.max_blocking_time = DDS_SECS(60);
+            s.history = DDS_HISTORY_KEEP_ALL;
+            s.history_depth = 0;
+            s.max_samples = 65536;
+            s.writer_batching = true;
+            break;
+    }
+    return s;
+}
+
+const char* qos_profile_name(QosProfile profile) {
+    switch (profile) {
+        case QosProfile::Default:         return "default";
+        case QosProfile::LowLatency:      return "low-latency";
+        case QosProfile::HighThroughput:  return "high-throughput";
+        case QosProfile::LosslessLogging: return "lossless-logging";
+    }
+    return "unknown";
+}
+
+bool parse_qos_profile(const std::string& name, QosProfile& profile) {
+    for (QosProfile p : {QosProfile::Default, QosProfile::LowLatency,
+                         QosProfile::HighThroughput, QosProfile::LosslessLogging}) {
+        if (name == qos_profile_name(p)) {
+            profile = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string qos_profile_help() {
+    return "                   default          RELIABLE, KEEP_LAST(100)\n"
+           "                   low-latency      BEST_EFFORT, KEEP_LAST(8)\n"
+           "                   high-throughput  RELIABLE, KEEP_ALL (4096 samples), batched writes\n"
+           "                   lossless-logging RELIABLE, KEEP_ALL (65536 samples), 60s blocking, batched writes\n";
+}
+
+dds_qos_t* create_qos(QosProfile profile) {
+    QosSettings s = qos_settings(profile);
+
+    dds_qos_t* qos = dds_create_qos();
+    dds_qset_reliability(qos, s.reliability, s.max_blocking_time);
+    dds_qset_history(qos, s.history, s.history_depth);
+    if (s.history == DDS_HISTORY_KEEP_ALL) {
+        dds_qset_resource_limits(qos, s.max_samples, DDS_LENGTH_UNLIMITED, s.max_samples);
+    }
+    return qos;
+}
+
+std::string sensor_topic_name(const std::string& type) {
+    return std::string(TELEMETRY_TOPIC) + "/" + type;
+}
+
+bool is_valid_sensor_type(const std::string& type) {
+    if (type.empty()) {
+        return false;
+    }
+    for (char c : type) {
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_domain_id(const std::string& text, dds_domainid_t& domain) {
+    if (text.empty() || text.size() > 3 || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long value = std::stoul(text);
+    if (value > MAX_DOMAIN_ID) {
+        return false;
+    }
+    domain = static_cast<dds_domainid_t>(value);
+    return true;
+}
+
+std::string domain_label(dds_domainid_t domain) {
+    return domain == DDS_DOMAIN_DEFAULT ? "default domain" : "domain " + std::to_string(domain);
+}
+
+bool is_partition_pattern(const std::string& name) {
+    return name.find_first_of("*?") != std::string::npos;
+}
+
+std::string partition_label(const std::vector<std::string>& partitions) {
+    if (partitions.empty()) {
+        return "default partition";
+    }
+    std::string label = partitions.size() == 1 ? "partition " : "partitions ";
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        label += (i > 0 ? ", " : "") + partitions[i];
+    }
+    return label;
+}
+
+bool partitions_match(const std::vector<std::string>& reader_partitions,
+                      const std::vector<std::string>& writer_partitions) {
+    static const std::vector<std::string> default_partition{""};
+    const auto& readers = reader_partitions.empty() ? default_partition : reader_partitions;
+    const auto& writers = writer_partitions.empty() ? default_partition : writer_partitions;
+    for (const auto& pattern : readers) {
+        for (const auto& name : writers) {
+            if (fnmatch(pattern.c_str(), name.c_str(), 0) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// ========== DdsSession ==========
+
+DdsSession::~DdsSession() {
+    close();
+}
+
+bool DdsSession::open(QosProfile profile, dds_domainid_t domain, const char* topic_name) {
+    profile_ = profile;
+    domain_ = domain;
+
+    participant_ = dds_create_participant(domain, NULL, NULL);
+    if (participant_ < 0) {
+        std::cerr << "[ERROR] Failed to create DDS participant\n";
+        participant_ = 0;
+        return false;
+    }
+    std::cout << "[DDS] Participant created (" << domain_label(domain) << ")\n";
+
+    topic_ = create_topic(topic_name);
+    if (topic_ < 0) {
+        std::cerr << "[ERROR] Failed to create DDS topic\n";
+        close();
+        return false;
+    }
+    std::cout << "[DDS] Topic '" << topic_name << "' created (QoS profile: "
+              << qos_profile_name(profile_) << ")\n";
+    return true;
+}
+
+void DdsSession::close() {
+    if (participant_ > 0) {
+        dds_delete(participant_);
+    }
+    participant_ = 0;
+    topic_ = 0;
+    publisher_ = 0;
+    subscriber_ = 0;
+    sensor_topics_.clear();
+}
+
+dds_entity_t DdsSession::create_topic(const char* name) {
+    return dds_create_topic(participant_, &Telemetry_JsonMessage_desc, name, NULL, NULL);
+}
+
+dds_entity_t DdsSession::create_writer() {
+    return create_writer(topic_, profile_);
+}
+
+dds_entity_t DdsSession::create_reader() {
+    return create_reader(topic_, profile_);
+}
+
+dds_entity_t DdsSession::create_writer(dds_entity_t topic, QosProfile profile) {
+    // Batching is a process-wide switch in Cyclone
+    if (qos_settings(profile).writer_batching) {
+        dds_write_set_batch(true);
+        batching_ = true;
+    }
+    dds_qos_t* qos = create_qos(profile);
+    if (deadline_ != DDS_INFINITY) {
+        dds_qset_deadline(qos, deadline_);
+    }
+    dds_entity_t writer = dds_create_writer(writer_parent(), topic, qos, NULL);
+    dds_delete_qos(qos);
+    return writer;
+}
+
+dds_entity_t DdsSession::create_reader(dds_entity_t topic, QosProfile profile) {
+    dds_qos_t* qos = create_qos(profile);
+    if (deadline_ != DDS_INFINITY) {
+        dds_qset_deadline(qos, deadline_);
+    }
+    dds_entity_t reader = dds_create_reader(reader_parent(), topic, qos, NULL);
+    dds_delete_qos(qos);
+    return reader;
+}
+
+dds_entity_t DdsSession::sensor_topic(const std::string& type) {
+    auto it = sensor_topics_.find(type);
+    if (it != sensor_topics_.end()) {
+        return it->second;
+    }
+    dds_entity_t topic = create_topic(sensor_topic_name(type).c_str());
+    if (topic > 0) {
+        sensor_topics_.emplace(type, topic);
+    }
+    return topic;
+}
+
+namespace {
+
+dds_qos_t* partition_qos(const std::vector<std::string>& partitions) {
+    std::vector<const char*> names;
+    for (const auto& name : partitions) {
+        names.push_back(name.c_str());
+    }
+    dds_qos_t* qos = dds_create_qos();
+    dds_qset_partition(qos, static_cast<uint32_t>(names.size()), names.data());
+    return qos;
+}
+
+} // namespace
+
+dds_entity_t DdsSession::writer_parent() {
+    if (partitions_.empty()) {
+        return participant_;
+    }
+    if (publisher_ <= 0) {
+        dds_qos_t* qos = partition_qos(partitions_);
+        publisher_ = dds_create_publisher(participant_, qos, NULL);
+        dds_delete_qos(qos);
+    }
+    return publisher_;
+}
+
+dds_entity_t DdsSession::reader_parent() {
+    if (partitions_.empty()) {
+        return participant_;
+    }
+    if (subscriber_ <= 0) {
+        dds_qos_t* qos = partition_qos(partitions_);
+        subscriber_ = dds_create_subscriber(participant_, qos, NULL);
+        dds_delete_qos(qos);
+    }
+    return subscriber_;
+}
+
+void DdsSession::flush(dds_entity_t writer) const {
+    if (batching_) {
+        dds_write_flush(writer);
+    }
+}
+
+// ========== ReaderSet ==========
+
+dds_return_t ReaderSet::take(void** samples, dds_sample_info_t* infos, size_t bufsz, uint32_t maxs,
+                             dds_entity_t& taken_from) {
+    for (size_t i = 0; i < readers_.size(); ++i) {
+        size_t index = (next_ + i) % readers_.size();
+        dds_return_t ret = dds_take(readers_[index], samples, infos, bufsz, maxs);
+        if (ret != 0) {
+            taken_from = readers_[index];
+            next_ = (index + 1) % readers_.size();
+            return ret;
+        }
+    }
+    return 0;
+}
+
+} // namespace telemetry
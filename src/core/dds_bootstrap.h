@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <dds/dds.h>
+
+namespace telemetry {
+
+constexpr const char* TELEMETRY_TOPIC = "lab_telemetry";
+
+// Per-type topics, e.g. "lab_telemetry/temperature". A type is lower-case
+// letters, digits and underscores, so the name stays a valid DDS topic name.
+std::string sensor_topic_name(const std::string& type);
+bool is_valid_sensor_type(const std::string& type);
+
+// Named QoS envelopes shared by every process, selected with --qos.
+enum class QosProfile {
+    Default,          // RELIABLE, KEEP_LAST(100) - the original settings
+    LowLatency,       // BEST_EFFORT, shallow KEEP_LAST, no batching
+    HighThroughput,   // RELIABLE, KEEP_ALL with resource limits, writer batching
+    LosslessLogging   // RELIABLE, deep KEEP_ALL, long blocking, writer batching
+};
+
+// What a profile turns into.
+struct QosSettings {
+    dds_reliability_kind_t reliability = DDS_RELIABILITY_RELIABLE;
+    dds_duration_t max_blocking_time = DDS_SECS(10);
+    dds_history_kind_t history = DDS_HISTORY_KEEP_LAST;
+    int32_t history_depth = 100;
+    int32_t max_samples = DDS_LENGTH_UNLIMITED;   // resource limits (KEEP_ALL only)
+    bool writer_batching = false;
+};
+
+QosSettings qos_settings(QosProfile profile);
+const char* qos_profile_name(QosProfile profile);
+// Accepts "default", "low-latency", "high-throughput" and "lossless-logging".
+bool parse_qos_profile(const std::string& name, QosProfile& profile);
+// One line per profile, for --help output.
+std::string qos_profile_help();
+
+// Caller owns the result (dds_delete_qos).
+dds_qos_t* create_qos(QosProfile profile);
+
+// DDSI maps domain ids to UDP ports; ids above 232 overflow the port range.
+constexpr dds_domainid_t MAX_DOMAIN_ID = 232;
+
+// Accepts a decimal id in [0, MAX_DOMAIN_ID].
+bool parse_domain_id(const std::string& text, dds_domainid_t& domain);
+// "domain 3", or "default domain" for DDS_DOMAIN_DEFAULT.
+std::string domain_label(dds_domainid_t domain);
+
+// Partition names may use the DDS wildcards * and ?, which only make sense
+// on the subscribing side: "site-a/*" matches a writer in "site-a/line-2".
+bool is_partition_pattern(const std::string& name);
+// "partitions a, b", or "default partition" for an empty list.
+std::string partition_label(const std::vector<std::string>& partitions);
+// Whether a reader in `reader_partitions` (patterns allowed) would match a
+// writer in `writer_partitions`; an empty list is the default partition.
+bool partitions_match(const std::vector<std::string>& reader_partitions,
+                      const std::vector<std::string>& writer_partitions);
+
+// Participant plus the telemetry topic, and the reader/writer creation that
+// used to be copied into every app. Deleting the participant on close()
+// deletes every entity created through it.
+class DdsSession {
+public:
+    DdsSession() = default;
+    ~DdsSession();
+
+    DdsSession(const DdsSession&) = delete;
+    DdsSession& operator=(const DdsSession&) = delete;
+
+    // Creates the participant and the telemetry topic. Prints progress and
+    // errors in the apps' "[DDS]" style.
+    bool open(QosProfile profile, dds_domainid_t domain = DDS_DOMAIN_DEFAULT,
+              const char* topic_name = TELEMETRY_TOPIC);
+    void close();
+
+    // Deadline QoS for endpoints created afterwards (default: none). A reader
+    // only matches writers offering at least as tight a deadline, so every
+    // process must use the same value.
+    void set_deadline(dds_duration_t deadline) { deadline_ = deadline; }
+
+    // Partitions for the telemetry endpoints created afterwards (default:
+    // none, i.e. the default partition). They go on a publisher/subscriber
+    // created on first use, since that is where DDS matches partitions; a
+    // writer and a reader match when any of their names match. Readers may
+    // pass patterns (is_partition_pattern), writers need literal names.
+    void set_partitions(std::vector<std::string> partitions) { partitions_ = std::move(partitions); }
+    const std::vector<std::string>& partitions() const { return partitions_; }
+
+    // Telemetry topic endpoints with the session's profile
+    dds_entity_t create_writer();
+    dds_entity_t create_reader();
+
+    // Endpoints on any JsonMessage topic of this participant with their own
+    // profile; deadline and partitions as above
+    dds_entity_t create_writer(dds_entity_t topic, QosProfile profile);
+    dds_entity_t create_reader(dds_entity_t topic, QosProfile profile);
+
+    // The per-type topic for `type` (sensor_topic_name), created on first use.
+    dds_entity_t sensor_topic(const std::string& type);
+
+    // Additional JsonMessage topic on the same participant
+    dds_entity_t create_topic(const char* name);
+
+    // Pushes out a partially filled batch (no-op unless a writer was
+    // created with a batching profile).
+    void flush(dds_entity_t writer) const;
+
+    dds_entity_t participant() const { return participant_; }
+    dds_entity_t topic() const { return topic_; }
+    QosProfile profile() const { return profile_; }
+    dds_domainid_t domain() const { return domain_; }
+
+private:
+    // Parent for new endpoints: the participant without partitions,
+    // otherwise a partitioned publisher/subscriber (created once)
+    dds_entity_t writer_parent();
+    dds_entity_t reader_parent();
+
+    dds_entity_t participant_ = 0;
+    dds_entity_t topic_ = 0;
+    dds_entity_t publisher_ = 0;
+    dds_entity_t subscriber_ = 0;
+    QosProfile profile_ = QosProfile::Default;
+    dds_domainid_t domain_ = DDS_DOMAIN_DEFAULT;
+    dds_duration_t deadline_ = DDS_INFINITY;
+    std::vector<std::string> partitions_;
+    std::map<std::string, dds_entity_t> sensor_topics_;
+    bool batching_ = false;
+};
+
+// Several telemetry readers (one per per-type topic) drained by a loop
+// written for one. take() starts after the reader that last had data, so a
+// busy topic cannot starve the others.
+class ReaderSet {
+public:
+    void add(dds_entity_t reader) { readers_.push_back(reader); }
+    const std::vector<dds_entity_t>& readers() const { return readers_; }
+    bool empty() const { return readers_.empty(); }
+
+    // dds_take() on the first reader with data. `taken_from` is that reader,
+    // for dds_return_loan; returns 0 when none has data.
+    dds_return_t take(void** samples, dds_sample_info_t* infos, size_t bufsz, uint32_t maxs,
+                      dds_entity_t& taken_from);
+
+private:
+    std::vector<dds_entity_t> readers_;
+    size_t next_ = 0;
+};
+
+} // namespace telemetry
@@ -0,0 +1,91 @@
+#include "dds_health.h"
+
+namespace telemetry {
+
+namespace {
+// Enabled so status conditions and listeners can trigger on them too.
+// DATA_AVAILABLE stays on so read conditions and waitsets keep working.
+constexpr uint32_t READER_STATUS_MASK = DDS_SAMPLE_LOST_STATUS | DDS_SAMPLE_REJECTED_STATUS |
+                                        DDS_REQUESTED_DEADLINE_MISSED_STATUS |
+                                        DDS_SUBSCRIPTION_MATCHED_STATUS | DDS_DATA_AVAILABLE_STATUS;
+constexpr uint32_t WRITER_STATUS_MASK = DDS_OFFERED_DEADLINE_MISSED_STATUS |
+                                        DDS_PUBLICATION_MATCHED_STATUS;
+
+// Status totals only grow; the metric gets the increase since the last poll
+void advance(uint64_t& seen, uint32_t total, Counter& counter) {
+    if (total > seen) {
+        counter.add(total - seen);
+        seen = total;
+    }
+}
+} // namespace
+
+void DdsHealth::watch_reader(dds_entity_t reader, const std::string& prefix) {
+    if (reader <= 0) {
+        return;
+    }
+    dds_set_status_mask(reader, READER_STATUS_MASK);
+    watched_.push_back({reader, true, {},
+                        metrics().counter(prefix + ".sample_lost"),
+                        metrics().counter(prefix + ".sample_rejected"),
+                        metrics().counter(prefix + ".requested_deadline_missed"),
+                        metrics().gauge(prefix + ".matched_publications")});
+}
+
+void DdsHealth::watch_writer(dds_entity_t writer, const std::string& prefix) {
+    if (writer <= 0) {
+        return;
+    }
+    dds_set_status_mask(writer, WRITER_STATUS_MASK);
+    watched_.push_back({writer, false, {}, Counter(), Counter(),
+                        metrics().counter(prefix + ".offered_deadline_missed"),
+                        metrics().gauge(prefix + ".matched_subscriptions")});
+}
+
+void DdsHealth::poll() {
+    for (Watched& w : watched_) {
+        if (w.is_reader) {
+            dds_sample_lost_status_t lost{};
+            if (dds_get_sample_lost_status(w.entity, &lost) == DDS_RETCODE_OK) {
+                advance(w.counts.sample_lost, lost.total_count, w.lost);
+            }
+            dds_sample_rejected_status_t rejected{};
+            if (dds_get_sample_rejected_status(w.entity, &rejected) == DDS_RETCODE_OK) {
+                advance(w.counts.sample_rejected, rejected.total_count, w.rejected);
+            }
+            dds_requested_deadline_missed_status_t deadline{};
+            if (dds_get_requested_deadline_missed_status(w.entity, &deadline) == DDS_RETCODE_OK) {
+                advance(w.counts.requested_deadline_missed, deadline.total_count, w.deadline_missed);
+            }
+            dds_subscription_matched_status_t matched{};
+            if (dds_get_subscription_matched_status(w.entity, &matched) == DDS_RETCODE_OK) {
+                w.counts.matched = matched.current_count;
+                w.matched.set(matched.current_count);
+            }
+        } else {
+            dds_offered_deadline_missed_status_t deadline{};
+            if (dds_get_offered_deadline_missed_status(w.entity, &deadline) == DDS_RETCODE_OK) {
+                advance(w.counts.offered_deadline_missed, deadline.total_count, w.deadline_missed);
+            }
+            dds_publication_matched_status_t matched{};
+            if (dds_get_publication_matched_status(w.entity, &matched) == DDS_RETCODE_OK) {
+                w.counts.matched = matched.current_count;
+                w.matched.set(matched.current_count);
+            }
+        }
+    }
+}
+
+DdsHealthCounts DdsHealth::totals() const {
+    DdsHealthCounts sum;
+    for (const Watched& w : watched_) {
+        sum.sample_lost += w.counts.sample_lost;
+        sum.sample_rejected += w.counts.sample_rejected;
+        sum.requested_deadline_missed += w.counts.requested_deadline_missed;
+        sum.offered_deadline_missed += w.counts.offered_deadline_missed;
+        sum.matched += w.counts.matched;
+    }
+    return sum;
+}
+
+} // namespace telemetry
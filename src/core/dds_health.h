@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <dds/dds.h>
+
+#include "metrics.h"
+
+namespace telemetry {
+
+// Cumulative DDS communication status counts for the watched entities.
+struct DdsHealthCounts {
+    uint64_t sample_lost = 0;                 // readers: dropped inside the middleware
+    uint64_t sample_rejected = 0;             // readers: refused by resource limits
+    uint64_t requested_deadline_missed = 0;   // readers
+    uint64_t offered_deadline_missed = 0;     // writers
+    uint32_t matched = 0;                     // current matched writers/readers
+};
+
+// Enables the sample-lost, sample-rejected, deadline-missed and matched
+// statuses on readers and writers and polls them into metrics, so losses
+// inside DDS (e.g. a KEEP_LAST history overflowing) can be told apart from
+// samples the hub never sent. For each watched entity with metric prefix P:
+//
+//   P.sample_lost, P.sample_rejected,          (readers)
+//   P.requested_deadline_missed, P.matched_publications
+//   P.offered_deadline_missed, P.matched_subscriptions   (writers)
+//
+// poll() is cheap (a few status reads per entity) and meant to be called
+// from a main loop about once a second. Not thread-safe.
+class DdsHealth {
+public:
+    DdsHealth() = default;
+
+    DdsHealth(const DdsHealth&) = delete;
+    DdsHealth& operator=(const DdsHealth&) = delete;
+
+    void watch_reader(dds_entity_t reader, const std::string& prefix);
+    void watch_writer(dds_entity_t writer, const std::string& prefix);
+
+    void poll();
+
+    // Sums over everything watched, as of the last poll().
+    DdsHealthCounts totals() const;
+
+private:
+    struct Watched {
+        dds_entity_t entity;
+        bool is_reader;
+        DdsHealthCounts counts;
+        Counter lost;
+        Counter rejected;
+        Counter deadline_missed;
+        Gauge matched;
+    };
+
+    std::vector<Watched> watched_;
+};
+
+} // namespace telemetry
@@ -0,0 +1,269 @@
+#include "executor.h"
+#include <algorithm>
+#include <iostream>
+
+#include "trace.h"
+
+namespace telemetry {
+
+namespace {
+
+// Owner of a spawned task: starts when the executor first resumes it and
+// frees itself when the task is done.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Longest single dds_waitset_wait, so a wait with a far deadline still
+// notices shutdown in bounded time even if a trigger were lost
+constexpr int64_t MAX_WAITSET_WAIT_MS = 1000;
+
+} // namespace
+
+// ========== Executor ==========
+
+Executor::Executor(size_t threads, std::string name) {
+    for (size_t i = 0; i < threads; ++i) {
+        std::string label = name + "-" + std::to_string(i);
+        workers_.emplace_back([this, label] {
+            set_trace_thread_name(label);
+            work([this] { return stopping_; });
+        });
+    }
+}
+
+Executor::~Executor() {
+    run();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void Executor::spawn(Task<> task) {
+    active_++;
+    auto owner = [](Executor& executor, Task<> task) -> Detached {
+        try {
+            co_await task;
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Executor task failed: " << e.what() << "\n";
+        } catch (...) {
+            std::cerr << "[ERROR] Executor task failed\n";
+        }
+        executor.task_finished();
+    };
+    post(owner(*this, std::move(task)).handle);
+}
+
+void Executor::run() {
+    work([this] { return active_.load() == 0; });
+}
+
+void Executor::post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(handle);
+    }
+    wake_.notify_one();
+}
+
+void Executor::add_timer(Clock::time_point deadline, std::coroutine_handle<> handle) {
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        earliest = timers_.empty() || deadline < timers_.top().deadline;
+        timers_.push({deadline, next_order_++, handle});
+    }
+    // A sleeping worker may be waiting for a later deadline
+    if (earliest) {
+        wake_.notify_one();
+    }
+}
+
+void Executor::task_finished() {
+    if (active_.fetch_sub(1) == 1) {
+        // run() callers wait for this under the lock
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_.notify_all();
+    }
+}
+
+template <typename Done>
+void Executor::work(Done done) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        auto now = Clock::now();
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            ready_.push_back(timers_.top().handle);
+            timers_.pop();
+        }
+        if (!ready_.empty()) {
+            std::coroutine_handle<> handle = ready_.front();
+            ready_.pop_front();
+            // Leave the rest to an idle worker, if there is one
+            if (!ready_.empty()) {
+                wake_.notify_one();
+            }
+            lock.unlock();
+            handle.resume();
+            lock.lock();
+            continue;
+        }
+        if (done()) {
+            return;
+        }
+        if (timers_.empty()) {
+            wake_.wait(lock);
+        } else {
+            wake_.wait_until(lock, timers_.top().deadline);
+        }
+    }
+}
+
+// ========== DdsReadWaiter ==========
+
+DdsReadWaiter::DdsReadWaiter(Executor& executor, dds_entity_t participant) : executor_(executor) {
+    waitset_ = dds_create_waitset(participant);
+    if (waitset_ < 0) {
+        std::cerr << "[ERROR] Failed to create DDS waitset: " << dds_strretcode(waitset_) << "\n";
+        return;
+    }
+    // Attached to itself, so dds_waitset_set_trigger() wakes run() to pick
+    // up new waits; its attach argument (0) marks that wake-up
+    dds_waitset_attach(waitset_, waitset_, 0);
+    thread_ = std::thread(&DdsReadWaiter::run, this);
+}
+
+DdsReadWaiter::~DdsReadWaiter() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    dds_waitset_set_trigger(waitset_, true);
+    thread_.join();
+    for (const auto& [reader, entry] : conditions_) {
+        dds_delete(entry.condition);   // already gone if the reader was deleted first
+    }
+    dds_delete(waitset_);
+}
+
+bool DdsReadWaiter::ReadableAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    // Once queued, run() may resume the coroutine on another executor thread
+    // and destroy this awaiter before we return: touch no members after unlock
+    dds_entity_t waitset = waiter_.waitset_;
+    {
+        std::lock_guard<std::mutex> lock(waiter_.mutex_);
+        if (waiter_.stopping_ || !waiter_.ok()) {
+            return false;
+        }
+        waiter_.pending_.push_back(this);
+    }
+    dds_waitset_set_trigger(waitset, true);
+    return true;
+}
+
+void DdsReadWaiter::attach(ReadableAwaiter* wait) {
+    for (dds_entity_t reader : wait->readers_) {
+        auto it = conditions_.find(reader);
+        if (it == conditions_.end()) {
+            dds_entity_t condition = dds_create_readcondition(reader, DDS_ANY_STATE);
+            if (condition < 0) {
+                continue;
+            }
+            it = conditions_.emplace(reader, ReaderCondition{condition, 0}).first;
+        }
+        // The reader handle is the attach argument: run() matches it to waits
+        if (it->second.waits == 0 &&
+            dds_waitset_attach(waitset_, it->second.condition, static_cast<dds_attach_t>(reader)) < 0) {
+            // Deleted with its reader; a later wait on a new reader recreates it
+            dds_delete(it->second.condition);
+            conditions_.erase(it);
+            continue;
+        }
+        it->second.waits++;
+        wait->attached_.push_back(reader);
+    }
+}
+
+void DdsReadWaiter::resolve(ReadableAwaiter* wait) {
+    for (dds_entity_t reader : wait->attached_) {
+        ReaderCondition& entry = conditions_.at(reader);
+        if (--entry.waits == 0) {
+            dds_waitset_detach(waitset_, entry.condition);
+        }
+    }
+    wait->attached_.clear();
+    executor_.post(wait->handle_);
+}
+
+void DdsReadWaiter::run() {
+    set_trace_thread_name("dds-wait");
+    std::vector<ReadableAwaiter*> active;
+    std::vector<dds_attach_t> triggered(64);
+    bool stopping = false;
+    while (!stopping || !active.empty()) {
+        // Clear the trigger before collecting, so a wait queued after the
+        // swap sets it again and the next dds_waitset_wait returns at once
+        dds_waitset_set_trigger(waitset_, false);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (ReadableAwaiter* wait : pending_) {
+                attach(wait);
+                active.push_back(wait);
+            }
+            pending_.clear();
+            stopping = stopping_;
+        }
+
+        if (!stopping && !active.empty()) {
+            auto deadline = active.front()->deadline_;
+            for (ReadableAwaiter* wait : active) {
+                deadline = std::min(deadline, wait->deadline_);
+            }
+            int64_t timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - Executor::Clock::now()).count() + 1;
+            timeout_ms = std::clamp<int64_t>(timeout_ms, 0, MAX_WAITSET_WAIT_MS);
+            dds_return_t n = dds_waitset_wait(waitset_, triggered.data(), triggered.size(), DDS_MSECS(timeout_ms));
+            auto end = triggered.begin() + std::clamp<dds_return_t>(n, 0, static_cast<dds_return_t>(triggered.size()));
+            for (ReadableAwaiter* wait : active) {
+                for (dds_entity_t reader : wait->attached_) {
+                    if (std::find(triggered.begin(), end, static_cast<dds_attach_t>(reader)) != end) {
+                        wait->readable_ = true;
+                    }
+                }
+            }
+        } else if (!stopping) {
+            dds_waitset_wait(waitset_, triggered.data(), triggered.size(), DDS_MSECS(MAX_WAITSET_WAIT_MS));
+        }
+
+        // Resolved waits are readable, timed out, or cut short by shutdown
+        auto now = Executor::Clock::now();
+        auto still_waiting = std::stable_partition(active.begin(), active.end(), [&](ReadableAwaiter* wait) {
+            return !wait->readable_ && !stopping && wait->deadline_ > now;
+        });
+        std::vector<ReadableAwaiter*> resolved(still_waiting, active.end());
+        active.erase(still_waiting, active.end());
+        for (ReadableAwaiter* wait : resolved) {
+            resolve(wait);
+        }
+    }
+}
+
+} // namespace telemetry
@@ -0,0 +1,385 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dds/dds.h>
+
+namespace telemetry {
+
+class Executor;
+
+// ========== TASK ==========
+
+// A coroutine returning T. Tasks start suspended and run when awaited, or
+// when handed to Executor::spawn(); an exception thrown inside is rethrown
+// from co_await.
+//
+//   telemetry::Task<int> parse_next(telemetry::AsyncQueue<std::string>& lines);
+//   telemetry::Task<> pipeline(...) { int v = co_await parse_next(lines); ... }
+template <typename T = void>
+class [[nodiscard]] Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Resume whoever awaited us, straight from here
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> done) noexcept {
+            std::coroutine_handle<> next = done.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void take() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+// ========== EXECUTOR ==========
+
+// Runs coroutines on a few threads instead of one thread per blocking loop.
+// A coroutine suspended on a timer, a queue pop or a DDS read condition
+// holds no thread; whichever executor thread is free resumes it once it is
+// ready:
+//
+//   telemetry::Executor executor(0, "monitor");   // run() drives it
+//   executor.spawn(ingest(...));                  // take -> parse -> stats
+//   executor.spawn(render(...));                  // timer -> dashboard
+//   executor.run();                               // until both return
+//
+// A resumed coroutine may land on any executor thread, so stages that keep
+// per-thread state (PerfRegion, AllocRegion) want a single-threaded
+// executor. Spawned tasks have to finish on their own, typically by checking
+// a stop flag after each await: nothing cancels them.
+class Executor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // `threads` workers named "<name>-<i>". With 0, tasks only run on a
+    // thread inside run().
+    explicit Executor(size_t threads = 1, std::string name = "exec");
+    // Waits (running tasks on the calling thread) for every spawned task,
+    // then joins the workers.
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    size_t threads() const { return workers_.size(); }
+
+    // Starts `task` on an executor thread. Exceptions escaping it are
+    // printed to stderr.
+    void spawn(Task<> task);
+
+    // Runs tasks on the calling thread too, until every spawned task has
+    // finished.
+    void run();
+
+    // Tasks spawned and not yet finished
+    size_t active() const { return active_.load(); }
+
+    // Queues a suspended coroutine to be resumed on an executor thread. For
+    // awaitables; tasks use the awaiters below.
+    void post(std::coroutine_handle<> handle);
+
+    // co_await executor.schedule(): continue on an executor thread (behind
+    // whatever is already queued, so it also works as a yield).
+    struct ScheduleAwaiter {
+        Executor& executor;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { executor.post(handle); }
+        void await_resume() const noexcept {}
+    };
+    ScheduleAwaiter schedule() { return {*this}; }
+
+    // co_await executor.sleep_until(t) / sleep_for(d): resume on an executor
+    // thread once the deadline has passed.
+    struct SleepAwaiter {
+        Executor& executor;
+        Clock::time_point deadline;
+        bool await_ready() const noexcept { return deadline <= Clock::now(); }
+        void await_suspend(std::coroutine_handle<> handle) { executor.add_timer(deadline, handle); }
+        void await_resume() const noexcept {}
+    };
+    SleepAwaiter sleep_until(Clock::time_point deadline) { return {*this, deadline}; }
+    template <typename Rep, typename Period>
+    SleepAwaiter sleep_for(std::chrono::duration<Rep, Period> delay) {
+        return {*this, Clock::now() + std::chrono::duration_cast<Clock::duration>(delay)};
+    }
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t order;   // FIFO among equal deadlines
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : order > other.order;
+        }
+    };
+
+    void add_timer(Clock::time_point deadline, std::coroutine_handle<> handle);
+    void task_finished();
+    // Resumes ready coroutines until `done` holds (checked under mutex_)
+    template <typename Done>
+    void work(Done done);
+
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t next_order_ = 0;
+    std::atomic<size_t> active_{0};
+    bool stopping_ = false;
+};
+
+// ========== ASYNC QUEUE ==========
+
+// Bounded FIFO between coroutines (or from a plain thread into one):
+// push() never blocks, co_await pop() suspends the consumer until an item
+// or close() arrives. The push side handles a full queue itself, e.g. by
+// counting a drop or by co_await executor.schedule() and retrying.
+template <typename T>
+class AsyncQueue {
+public:
+    AsyncQueue(Executor& executor, size_t capacity) : executor_(executor), capacity_(capacity) {}
+
+    AsyncQueue(const AsyncQueue&) = delete;
+    AsyncQueue& operator=(const AsyncQueue&) = delete;
+
+    // False when the queue is full or closed. A waiting consumer gets the
+    // item directly and is resumed on the executor.
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_) return false;
+        if (!waiters_.empty()) {
+            PopAwaiter* waiter = waiters_.front();
+            waiters_.pop_front();
+            waiter->value_.emplace(std::move(item));
+            std::coroutine_handle<> handle = waiter->handle_;
+            lock.unlock();
+            executor_.post(handle);
+            return true;
+        }
+        if (items_.size() >= capacity_) return false;
+        items_.push_back(std::move(item));
+        return true;
+    }
+
+    // Consumers drain what is queued, then their pops return nullopt.
+    void close() {
+        std::deque<PopAwaiter*> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            waiters.swap(waiters_);
+        }
+        for (PopAwaiter* waiter : waiters) {
+            executor_.post(waiter->handle_);
+        }
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    // co_await queue.pop(): the next item, or nullopt once closed and empty
+    class PopAwaiter {
+    public:
+        explicit PopAwaiter(AsyncQueue& queue) : queue_(queue) {}
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::lock_guard<std::mutex> lock(queue_.mutex_);
+            if (!queue_.items_.empty()) {
+                value_.emplace(std::move(queue_.items_.front()));
+                queue_.items_.pop_front();
+                return false;
+            }
+            if (queue_.closed_) return false;
+            handle_ = handle;
+            queue_.waiters_.push_back(this);
+            return true;
+        }
+        std::optional<T> await_resume() { return std::move(value_); }
+
+    private:
+        friend class AsyncQueue;
+        AsyncQueue& queue_;
+        std::optional<T> value_;
+        std::coroutine_handle<> handle_;
+    };
+    PopAwaiter pop() { return PopAwaiter(*this); }
+
+private:
+    Executor& executor_;
+    size_t capacity_;
+    mutable std::mutex mutex_;
+    std::deque<T> items_;
+    std::deque<PopAwaiter*> waiters_;
+    bool closed_ = false;
+};
+
+// ========== DDS READ CONDITIONS ==========
+
+// Suspends coroutines until a DDS reader has samples, using one thread
+// blocked in dds_waitset_wait for all of them instead of a take-and-sleep
+// loop per reader:
+//
+//   telemetry::DdsReadWaiter waiter(executor, dds.participant());
+//   while (running) {
+//       if (!co_await waiter.readable(readers.readers(), 100ms)) continue;
+//       while (subscriber.take(message)) { ... }
+//   }
+//
+// Each reader gets one read condition on its first wait, kept until the
+// waiter is destroyed; it is attached to the waitset only while a wait on
+// that reader is pending. Destroy the waiter before the readers' participant.
+class DdsReadWaiter {
+public:
+    DdsReadWaiter(Executor& executor, dds_entity_t participant);
+    // Resumes pending waits with false, then joins the waitset thread
+    ~DdsReadWaiter();
+
+    DdsReadWaiter(const DdsReadWaiter&) = delete;
+    DdsReadWaiter& operator=(const DdsReadWaiter&) = delete;
+
+    bool ok() const { return waitset_ > 0; }
+
+    // co_await readable(readers, timeout): true once any of `readers` holds
+    // a sample (possibly already before the call), false on timeout or
+    // shutdown.
+    class ReadableAwaiter {
+    public:
+        ReadableAwaiter(DdsReadWaiter& waiter, std::vector<dds_entity_t> readers,
+                        std::chrono::milliseconds timeout)
+            : waiter_(waiter), readers_(std::move(readers)), deadline_(Executor::Clock::now() + timeout) {}
+        bool await_ready() const noexcept { return readers_.empty(); }
+        bool await_suspend(std::coroutine_handle<> handle);
+        bool await_resume() const noexcept { return readable_; }
+
+    private:
+        friend class DdsReadWaiter;
+        DdsReadWaiter& waiter_;
+        std::vector<dds_entity_t> readers_;
+        Executor::Clock::time_point deadline_;
+        std::coroutine_handle<> handle_;
+        std::vector<dds_entity_t> attached_;   // readers whose condition this wait holds
+        bool readable_ = false;
+    };
+    ReadableAwaiter readable(std::vector<dds_entity_t> readers, std::chrono::milliseconds timeout) {
+        return ReadableAwaiter(*this, std::move(readers), timeout);
+    }
+
+private:
+    void run();
+    void attach(ReadableAwaiter* wait);
+    void resolve(ReadableAwaiter* wait);
+
+    struct ReaderCondition {
+        dds_entity_t condition;
+        size_t waits;   // pending waits on the reader; attached while > 0
+    };
+
+    Executor& executor_;
+    dds_entity_t waitset_ = 0;
+    std::mutex mutex_;
+    std::vector<ReadableAwaiter*> pending_;   // not yet attached by run()
+    bool stopping_ = false;
+    std::map<dds_entity_t, ReaderCondition> conditions_;   // by reader; run() thread only
+    std::thread thread_;
+};
+
+} // namespace telemetry
@@ -0,0 +1,124 @@
+#include "fan_in.h"
+
+namespace telemetry {
+
+// ========== HubSessionTable ==========
+
+HubSessionTable::Verdict HubSessionTable::record(const HubKey& key, const std::string& origin, int sensor_id,
+                                                 uint64_t sequence, uint64_t now_ms) {
+    Verdict verdict = Verdict::Accepted;
+    auto it = sessions_.find(key);
+    if (it == sessions_.end()) {
+        it = sessions_.emplace(key, HubSession{}).first;
+        it->second.key = key;
+        it->second.origin = origin;
+        it->second.first_seen_ms = now_ms;
+        active_++;
+        verdict = Verdict::NewSession;
+    } else if (!it->second.active) {
+        it->second.active = true;
+        active_++;
+    }
+
+    HubSession& session = it->second;
+    session.last_seen_ms = now_ms;
+    auto next = session.next_sequence.find(sensor_id);
+    if (next == session.next_sequence.end()) {
+        session.next_sequence.emplace(sensor_id, sequence + 1);
+    } else if (sequence < next->second) {
+        session.stale++;
+        return Verdict::Stale;
+    } else {
+        session.gaps += sequence - next->second;
+        next->second = sequence + 1;
+    }
+    session.messages++;
+    return verdict;
+}
+
+std::vector<HubSession> HubSessionTable::expire(uint64_t now_ms) {
+    std::vector<HubSession> expired;
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        HubSession& session = it->second;
+        if (session.active && now_ms > session.last_seen_ms + idle_timeout_ms_) {
+            session.active = false;
+            active_--;
+            expired.push_back(session);
+        }
+        if (!session.active && now_ms > session.last_seen_ms + retention_ms_) {
+            it = sessions_.erase(it);
+            dropped_++;
+        } else {
+            ++it;
+        }
+    }
+    return expired;
+}
+
+std::vector<HubSession> HubSessionTable::sessions() const {
+    std::vector<HubSession> out;
+    out.reserve(sessions_.size());
+    for (const auto& [key, session] : sessions_) {
+        out.push_back(session);
+    }
+    return out;
+}
+
+// ========== WindowAggregator ==========
+
+WindowAggregator::WindowAggregator(uint64_t window_ms, uint64_t grace_ms)
+    : window_ms_(window_ms > 0 ? window_ms : 1), grace_ms_(grace_ms) {}
+
+bool WindowAggregator::add(int sensor_id, double value, uint64_t timestamp_ms, const HubKey& source,
+                           WindowSummary& closed) {
+    uint64_t start = timestamp_ms - timestamp_ms % window_ms_;
+    Open& open = open_[sensor_id];
+    bool emitted = false;
+    if (open.summary.count > 0) {
+        if (start > open.summary.start_ms) {
+            closed = close(open);
+            emitted = true;
+        } else if (start < open.summary.start_ms) {
+            late_++;
+        }
+    }
+    WindowSummary& summary = open.summary;
+    if (summary.count == 0) {
+        summary.sensor_id = sensor_id;
+        summary.start_ms = start;
+        summary.min = value;
+        summary.max = value;
+    }
+    summary.count++;
+    summary.sum += value;
+    if (value < summary.min) summary.min = value;
+    if (value > summary.max) summary.max = value;
+    open.sources.insert(source);
+    return emitted;
+}
+
+void WindowAggregator::poll(uint64_t now_ms, std::vector<WindowSummary>& out) {
+    for (auto& [id, open] : open_) {
+        if (open.summary.count > 0 && open.summary.start_ms + window_ms_ + grace_ms_ <= now_ms) {
+            out.push_back(close(open));
+        }
+    }
+}
+
+void WindowAggregator::drain(std::vector<WindowSummary>& out) {
+    for (auto& [id, open] : open_) {
+        if (open.summary.count > 0) {
+            out.push_back(close(open));
+        }
+    }
+}
+
+WindowSummary WindowAggregator::close(Open& open) {
+    WindowSummary summary = open.summary;
+    summary.sources = static_cast<uint32_t>(open.sources.size());
+    open.summary = WindowSummary{};
+    open.sources.clear();
+    return summary;
+}
+
+} // namespace telemetry
@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace telemetry {
+
+// Where a hub's samples come from: the aggregator's input index (one per
+// subscribed domain) and the DDS publication handle of the hub's writer.
+// A restarted hub gets a new writer, hence a new key and a new session.
+struct HubKey {
+    uint32_t input = 0;
+    uint64_t writer = 0;
+
+    bool operator<(const HubKey& other) const {
+        return input != other.input ? input < other.input : writer < other.writer;
+    }
+};
+
+struct HubSession {
+    HubKey key;
+    std::string origin;        // e.g. "domain 3", for display
+    uint64_t first_seen_ms = 0;
+    uint64_t last_seen_ms = 0;
+    uint64_t messages = 0;
+    uint64_t gaps = 0;         // samples missing from this hub's sequences
+    uint64_t stale = 0;        // repeated or out-of-order sequences, dropped
+    bool active = true;        // false once idle past the table's timeout
+    std::map<int, uint64_t> next_sequence;   // per sensor
+};
+
+// Per-hub session tracking for a process merging many hubs' streams. Hub
+// sequences are per sensor and per hub, so gaps are only meaningful per
+// session; merged output is renumbered downstream of this table.
+// Every hub restart is a new key, so inactive sessions are dropped once
+// idle for `retention_ms`; a sample from a dropped key starts a new session.
+// Single-threaded (the aggregator's ingest loop); copy out with sessions().
+class HubSessionTable {
+public:
+    enum class Verdict { NewSession, Accepted, Stale };
+
+    explicit HubSessionTable(uint64_t idle_timeout_ms = 5000, uint64_t retention_ms = 600000)
+        : idle_timeout_ms_(idle_timeout_ms), retention_ms_(std::max(retention_ms, idle_timeout_ms)) {}
+
+    // Applies one sample. A sequence below the next expected one for that
+    // hub and sensor is Stale and should not be forwarded.
+    Verdict record(const HubKey& key, const std::string& origin, int sensor_id, uint64_t sequence,
+                   uint64_t now_ms);
+
+    // Marks sessions idle for longer than the timeout inactive and returns
+    // them (for logging). A later sample from the same key reactivates it.
+    // Also drops inactive sessions idle for longer than the retention.
+    std::vector<HubSession> expire(uint64_t now_ms);
+
+    std::vector<HubSession> sessions() const;
+    size_t active_count() const { return active_; }
+    size_t total_count() const { return sessions_.size(); }
+    // Sessions dropped after the retention period, over the table's lifetime
+    uint64_t dropped_count() const { return dropped_; }
+
+private:
+    uint64_t idle_timeout_ms_;
+    uint64_t retention_ms_;
+    std::map<HubKey, HubSession> sessions_;
+    size_t active_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+// One downsampled window for a sensor id, merged across hubs.
+struct WindowSummary {
+    int sensor_id = 0;
+    uint64_t start_ms = 0;     // window covers [start_ms, start_ms + window)
+    uint64_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double sum = 0.0;
+    uint32_t sources = 0;      // distinct hubs in the window
+
+    double mean() const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+};
+
+// Fixed windows aligned to multiples of `window_ms` on the sample
+// timestamp, as the logger's rollup sink does, one open window per sensor
+// id. A sample for a later window closes the open one; poll() closes
+// windows whose end is more than `grace_ms` behind the wall clock, so
+// sensors that go quiet still emit. Samples older than the open window
+// (late hubs, skewed clocks) are folded into it and counted as late.
+class WindowAggregator {
+public:
+    explicit WindowAggregator(uint64_t window_ms, uint64_t grace_ms = 0);
+
+    // Returns true and fills `closed` when the sample closed a window.
+    bool add(int sensor_id, double value, uint64_t timestamp_ms, const HubKey& source, WindowSummary& closed);
+
+    // Appends windows ending at or before now_ms - grace_ms to `out`.
+    void poll(uint64_t now_ms, std::vector<WindowSummary>& out);
+    // Appends every open window (shutdown).
+    void drain(std::vector<WindowSummary>& out);
+
+    uint64_t window_ms() const { return window_ms_; }
+    uint64_t late_samples() const { return late_; }
+
+private:
+    struct Open {
+        WindowSummary summary;
+        std::set<HubKey> sources;
+    };
+
+    static WindowSummary close(Open& open);
+
+    uint64_t window_ms_;
+    uint64_t grace_ms_;
+    std::map<int, Open> open_;
+    uint64_t late_ = 0;
+};
+
+} // namespace telemetry
@@ -0,0 +1,305 @@
+#include "frame_log.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include "log_sinks.h"
+#include "lz_codec.h"
+
+namespace telemetry {
+
+namespace {
+
+const unsigned char FRAME_MAGIC[4] = {'M', 'T', 'F', 'R'};
+
+void put_le(unsigned char* out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+uint64_t get_le(const unsigned char* in, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) {
+        v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return v;
+}
+
+// The complete frame starting at `offset`, read from its header
+bool frame_at(std::ifstream& data, uint64_t file_size, uint64_t offset, FrameInfo& frame) {
+    unsigned char header[FRAME_HEADER_SIZE];
+    if (offset + FRAME_HEADER_SIZE > file_size) {
+        return false;
+    }
+    data.clear();
+    data.seekg(static_cast<std::streamoff>(offset));
+    if (!data.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        !decode_frame_header(header, frame) ||
+        offset + FRAME_HEADER_SIZE + frame.comp_size > file_size) {
+        return false;   // torn tail
+    }
+    frame.offset = offset;
+    return true;
+}
+
+// Loads the frames of `path` (open as `data`, if it exists): first from the
+// index, as long as its lines are complete, contiguous and match the frame
+// headers, then by scanning the data file past the last good entry (a crash
+// between frame and index write, a torn index line, or no index at all).
+// Returns the end of the last complete frame. `clean` is false if the
+// index or the data file need repair.
+uint64_t load_frames(std::ifstream& data, const std::string& path,
+                     std::vector<FrameInfo>& frames, bool& clean) {
+    uint64_t file_size = 0;
+    if (data.is_open()) {
+        data.seekg(0, std::ios::end);
+        file_size = static_cast<uint64_t>(data.tellg());
+    }
+
+    frames.clear();
+    clean = true;
+    uint64_t end = 0;
+    std::ifstream index(path + ".idx", std::ios::binary);
+    std::string line;
+    while (std::getline(index, line)) {
+        std::istringstream fields(line);
+        FrameInfo listed;
+        FrameInfo actual;
+        if (index.eof() ||   // no newline: torn
+            !(fields >> listed.offset >> listed.raw_size >> listed.comp_size >> listed.records
+                     >> listed.min_ts >> listed.max_ts) ||
+            (!(fields >> listed.csv_end) && !fields.eof()) ||
+            listed.offset != end || !frame_at(data, file_size, end, actual) ||
+            actual.raw_size != listed.raw_size || actual.comp_size != listed.comp_size ||
+            actual.records != listed.records) {
+            clean = false;
+            break;
+        }
+        actual.csv_end = listed.csv_end;
+        frames.push_back(actual);
+        end += FRAME_HEADER_SIZE + actual.comp_size;
+    }
+
+    // Pick up frames the index does not know about
+    FrameInfo frame;
+    while (frame_at(data, file_size, end, frame)) {
+        frames.push_back(frame);
+        end += FRAME_HEADER_SIZE + frame.comp_size;
+        clean = false;
+    }
+    if (end < file_size) {
+        clean = false;
+    }
+    data.clear();
+    return end;
+}
+
+void write_index_line(std::ostream& out, const FrameInfo& frame) {
+    out << frame.offset << " " << frame.raw_size << " " << frame.comp_size << " "
+        << frame.records << " " << frame.min_ts << " " << frame.max_ts << " " << frame.csv_end << "\n";
+}
+
+} // namespace
+
+void encode_frame_header(const FrameInfo& frame, unsigned char* out) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = FRAME_MAGIC[i];
+    }
+    put_le(out + 4, frame.raw_size, 4);
+    put_le(out + 8, frame.comp_size, 4);
+    put_le(out + 12, frame.records, 4);
+    put_le(out + 16, static_cast<uint64_t>(frame.min_ts), 8);
+    put_le(out + 24, static_cast<uint64_t>(frame.max_ts), 8);
+}
+
+bool decode_frame_header(const unsigned char* in, FrameInfo& frame) {
+    for (int i = 0; i < 4; ++i) {
+        if (in[i] != FRAME_MAGIC[i]) {
+            return false;
+        }
+    }
+    frame.raw_size = static_cast<uint32_t>(get_le(in + 4, 4));
+    frame.comp_size = static_cast<uint32_t>(get_le(in + 8, 4));
+    frame.records = static_cast<uint32_t>(get_le(in + 12, 4));
+    frame.min_ts = static_cast<long>(get_le(in + 16, 8));
+    frame.max_ts = static_cast<long>(get_le(in + 24, 8));
+    return true;
+}
+
+// ========== CompressedFrameSink ==========
+
+CompressedFrameSink::CompressedFrameSink(std::string path, size_t frame_bytes, uint64_t max_frame_age_ms,
+                                         std::string csv_path)
+    : path_(std::move(path)),
+      frame_bytes_(frame_bytes == 0 ? 1 : frame_bytes),
+      max_frame_age_ms_(max_frame_age_ms),
+      csv_path_(std::move(csv_path)) {}
+
+bool CompressedFrameSink::open() {
+    // New frames go after the last complete frame a previous run left
+    // behind. A crash can leave a torn frame, a torn index line, or frames
+    // missing from the index: cut the data file back to complete frames and
+    // rewrite the index to match before appending.
+    std::vector<FrameInfo> frames;
+    bool clean = true;
+    {
+        std::ifstream existing(path_, std::ios::binary);
+        offset_ = load_frames(existing, path_, frames, clean);
+    }
+    if (!clean) {
+        std::error_code ec;
+        if (std::filesystem::exists(path_, ec)) {
+            std::filesystem::resize_file(path_, offset_, ec);
+        }
+        const std::string index_path = path_ + ".idx";
+        const std::string tmp_path = index_path + ".tmp";
+        {
+            std::ofstream index(tmp_path, std::ios::trunc);
+            for (const auto& frame : frames) {
+                write_index_line(index, frame);
+            }
+            index.flush();
+            if (!index.good()) {
+                ec = std::make_error_code(std::errc::io_error);
+            }
+        }
+        if (ec || std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+            std::cerr << "[ERROR] Failed to repair " << path_ << (ec ? ": " + ec.message() : "") << "\n";
+            return false;
+        }
+        std::cerr << "[Logger] " << path_ << ": repaired after an unclean shutdown ("
+                  << frames.size() << " complete frames kept)\n";
+    }
+
+    data_.open(path_, std::ios::binary | std::ios::app);
+    if (!data_.is_open()) {
+        return false;
+    }
+    index_.open(path_ + ".idx", std::ios::app);
+    if (!index_.is_open()) {
+        return false;
+    }
+    if (!csv_path_.empty()) {
+        csv_offset_ = csv_resume_offset(csv_path_);
+    }
+
+    raw_.reserve(frame_bytes_ + 256);
+    return true;
+}
+
+void CompressedFrameSink::write(const LogRecord& record) {
+    if (raw_.empty()) {
+        current_ = FrameInfo{};
+        current_.min_ts = record.data.timestamp;
+        current_.max_ts = record.data.timestamp;
+        frame_started_ = std::chrono::steady_clock::now();
+    }
+
+    format_csv_row(record, raw_);
+    current_.records++;
+    if (record.data.timestamp < current_.min_ts) current_.min_ts = record.data.timestamp;
+    if (record.data.timestamp > current_.max_ts) current_.max_ts = record.data.timestamp;
+
+    if (raw_.size() >= frame_bytes_) {
+        seal_frame();
+    }
+}
+
+void CompressedFrameSink::seal_frame() {
+    if (raw_.empty()) {
+        return;
+    }
+
+    compressed_.clear();
+    lz::compress(reinterpret_cast<const uint8_t*>(raw_.data()), raw_.size(), compressed_);
+
+    current_.offset = offset_;
+    current_.raw_size = static_cast<uint32_t>(raw_.size());
+    current_.comp_size = static_cast<uint32_t>(compressed_.size());
+    if (!csv_path_.empty()) {
+        csv_offset_ += raw_.size();
+        current_.csv_end = csv_offset_;
+    }
+
+    unsigned char header[FRAME_HEADER_SIZE];
+    encode_frame_header(current_, header);
+    data_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    data_.write(reinterpret_cast<const char*>(compressed_.data()),
+                static_cast<std::streamsize>(compressed_.size()));
+    data_.flush();
+
+    // Index entry only after the frame itself is out
+    write_index_line(index_, current_);
+    index_.flush();
+
+    offset_ += FRAME_HEADER_SIZE + compressed_.size();
+    frames_written_++;
+    raw_bytes_ += raw_.size();
+    stored_bytes_ += FRAME_HEADER_SIZE + compressed_.size();
+    raw_.clear();
+}
+
+void CompressedFrameSink::flush() {
+    if (!raw_.empty()) {
+        auto age = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - frame_started_
+        ).count();
+        if (static_cast<uint64_t>(age) >= max_frame_age_ms_) {
+            seal_frame();
+        }
+    }
+}
+
+void CompressedFrameSink::close() {
+    seal_frame();
+    data_.close();
+    index_.close();
+
+    if (frames_written_ > 0) {
+        std::cout << "[Logger] Compressed sink: " << frames_written_ << " frames, "
+                  << raw_bytes_ << " -> " << stored_bytes_ << " bytes ("
+                  << static_cast<double>(raw_bytes_) / stored_bytes_ << "x)\n";
+    }
+}
+
+// ========== FrameReader ==========
+
+FrameReader::FrameReader(std::string path) : path_(std::move(path)) {}
+
+bool FrameReader::open() {
+    data_.open(path_, std::ios::binary);
+    if (!data_.is_open()) {
+        return false;
+    }
+    bool clean;
+    load_frames(data_, path_, frames_, clean);
+    return true;
+}
+
+std::vector<FrameInfo> FrameReader::frames_overlapping(long from_ts, long to_ts) const {
+    std::vector<FrameInfo> result;
+    for (const auto& f : frames_) {
+        if (f.max_ts >= from_ts && f.min_ts <= to_ts) {
+            result.push_back(f);
+        }
+    }
+    return result;
+}
+
+bool FrameReader::read_frame(const FrameInfo& frame, std::string& rows) {
+    compressed_.resize(frame.comp_size);
+    data_.clear();
+    data_.seekg(static_cast<std::streamoff>(frame.offset + FRAME_HEADER_SIZE));
+    if (!data_.read(reinterpret_cast<char*>(compressed_.data()), frame.comp_size)) {
+        return false;
+    }
+    if (!lz::decompress(compressed_.data(), compressed_.size(), frame.raw_size, raw_)) {
+        return false;
+    }
+    rows.assign(reinterpret_cast<const char*>(raw_.data()), raw_.size());
+    return true;
+}
+
+} // namespace telemetry
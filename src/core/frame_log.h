@@ -0,0 +1,104 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "log_sink.h"
+
+namespace telemetry {
+
+// Location and time span of one compressed frame.
+//
+// On disk a frame is a 32-byte header ("MTFR", raw_size, comp_size,
+// records as u32, min_ts and max_ts as i64, all little-endian) followed by
+// comp_size bytes of LZ-compressed CSV rows. "<path>.idx" holds one text
+// line per frame: "offset raw_size comp_size records min_ts max_ts csv_end".
+// csv_end is where the frame's last row ends in the CSV log written
+// alongside, so history reads can seek straight to what is not yet sealed;
+// 0 (or a missing field, in older indexes) means unknown.
+struct FrameInfo {
+    uint64_t offset = 0;
+    uint32_t raw_size = 0;
+    uint32_t comp_size = 0;
+    uint32_t records = 0;
+    long min_ts = 0;
+    long max_ts = 0;
+    uint64_t csv_end = 0;
+};
+
+constexpr size_t FRAME_HEADER_SIZE = 32;
+
+// Writes CSV rows into independently compressed frames of about
+// `frame_bytes` raw bytes each. A partial frame is sealed by flush() once it
+// is older than `max_frame_age_ms`, and always on close(). open() appends to
+// an existing log after cutting a torn last frame and rebuilding the index
+// if it is torn or misses frames.
+//
+// With `csv_path`, the sink assumes the CSV sink logs the same records in
+// the same order (both see every record) and tracks where each frame ends
+// in that file. The rows are byte-identical, so this is where the CSV will
+// continue on open (csv_resume_offset) plus the raw bytes sealed since.
+class CompressedFrameSink : public LogSink {
+public:
+    CompressedFrameSink(std::string path, size_t frame_bytes, uint64_t max_frame_age_ms,
+                        std::string csv_path = "");
+
+    const char* name() const override { return "compressed"; }
+    bool open() override;
+    void write(const LogRecord& record) override;
+    void flush() override;
+    void close() override;
+
+private:
+    void seal_frame();
+
+    std::string path_;
+    size_t frame_bytes_;
+    uint64_t max_frame_age_ms_;
+    std::string csv_path_;
+    uint64_t csv_offset_ = 0;
+
+    std::ofstream data_;
+    std::ofstream index_;
+    uint64_t offset_ = 0;
+
+    std::string raw_;
+    std::vector<uint8_t> compressed_;
+    FrameInfo current_;
+    std::chrono::steady_clock::time_point frame_started_;
+
+    uint64_t frames_written_ = 0;
+    uint64_t raw_bytes_ = 0;
+    uint64_t stored_bytes_ = 0;
+};
+
+// Random access to a compressed log: finds frames by time and decodes only those.
+class FrameReader {
+public:
+    explicit FrameReader(std::string path);
+
+    // Loads the index up to its first torn or mismatched line, then scans
+    // any frames past that (a crash between frame and index write, or a
+    // missing index). Returns false if the data file cannot be opened.
+    bool open();
+
+    const std::vector<FrameInfo>& frames() const { return frames_; }
+    // Frames whose [min_ts, max_ts] intersects [from_ts, to_ts].
+    std::vector<FrameInfo> frames_overlapping(long from_ts, long to_ts) const;
+    // Decompresses one frame into its CSV rows.
+    bool read_frame(const FrameInfo& frame, std::string& rows);
+
+private:
+    std::string path_;
+    std::ifstream data_;
+    std::vector<FrameInfo> frames_;
+    std::vector<uint8_t> compressed_;
+    std::vector<uint8_t> raw_;
+};
+
+void encode_frame_header(const FrameInfo& frame, unsigned char* out);
+bool decode_frame_header(const unsigned char* in, FrameInfo& frame);
+
+} // namespace telemetry
@@ -0,0 +1,245 @@
+#include "history.h"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+
+#include "frame_log.h"
+#include "log_sinks.h"
+
+namespace telemetry {
+
+std::string encode_history_request(const HistoryRequest& request) {
+    nlohmann::json j;
+    j["request_id"] = request.request_id;
+    j["sensors"] = request.sensors;
+    j["from"] = request.from_ts;
+    j["to"] = request.to_ts;
+    j["max_samples"] = request.max_samples;
+    return j.dump();
+}
+
+bool parse_history_request(const char* payload, HistoryRequest& request) {
+    try {
+        nlohmann::json j = nlohmann::json::parse(payload);
+        request.request_id = j.at("request_id").get<std::string>();
+        request.sensors = j.value("sensors", std::set<int>{});
+        request.from_ts = j.at("from").get<long>();
+        request.to_ts = j.at("to").get<long>();
+        request.max_samples = j.value("max_samples", uint64_t{0});
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+std::string encode_history_batch(const HistoryBatch& batch) {
+    nlohmann::json samples = nlohmann::json::array();
+    for (const auto& r : batch.samples) {
+        samples.push_back({r.data.id, r.data.value, r.data.timestamp, r.sequence});
+    }
+
+    nlohmann::json j;
+    j["request_id"] = batch.request_id;
+    j["batch"] = batch.batch;
+    j["final"] = batch.final;
+    j["samples"] = std::move(samples);
+    return j.dump();
+}
+
+bool parse_history_batch(const char* payload, HistoryBatch& batch) {
+    try {
+        nlohmann::json j = nlohmann::json::parse(payload);
+        batch.request_id = j.at("request_id").get<std::string>();
+        batch.batch = j.at("batch").get<uint32_t>();
+        batch.final = j.at("final").get<bool>();
+        batch.samples.clear();
+        for (const auto& s : j.at("samples")) {
+            LogRecord r;
+            r.data.id = s.at(0).get<int>();
+            r.data.value = s.at(1).get<double>();
+            r.data.timestamp = s.at(2).get<long>();
+            r.sequence = s.at(3).get<uint64_t>();
+            batch.samples.push_back(r);
+        }
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool history_matches(const HistoryRequest& request, const LogRecord& record) {
+    if (record.data.timestamp < request.from_ts || record.data.timestamp > request.to_ts) {
+        return false;
+    }
+    return request.sensors.empty() || request.sensors.count(record.data.id) > 0;
+}
+
+namespace {
+
+// Collects matches and hands them out one batch at a time
+class BatchEmitter {
+public:
+    BatchEmitter(const HistoryRequest& request, size_t batch_size,
+                 const std::function<bool(const std::vector<LogRecord>&)>& emit)
+        : request_(request), batch_size_(batch_size == 0 ? 1 : batch_size), emit_(emit) {
+        pending_.reserve(batch_size_);
+    }
+
+    // Fallback when CSV rows can't be matched to frames by position:
+    // records at or before this timestamp were already served from frames
+    void skip_until(long ts) { skip_until_ = ts; }
+
+    // Returns false once the scan should stop
+    bool add(const LogRecord& record) {
+        if (record.data.timestamp <= skip_until_ || !history_matches(request_, record)) {
+            return true;
+        }
+        pending_.push_back(record);
+        ++total_;
+        if (pending_.size() >= batch_size_ && !drain()) {
+            return false;
+        }
+        return request_.max_samples == 0 || total_ < request_.max_samples;
+    }
+
+    bool drain() {
+        if (pending_.empty()) {
+            return true;
+        }
+        bool more = emit_(pending_);
+        pending_.clear();
+        return more;
+    }
+
+    uint64_t total() const { return total_; }
+
+private:
+    const HistoryRequest& request_;
+    size_t batch_size_;
+    const std::function<bool(const std::vector<LogRecord>&)>& emit_;
+    std::vector<LogRecord> pending_;
+    uint64_t total_ = 0;
+    long skip_until_ = std::numeric_limits<long>::min();
+};
+
+// Feeds each line of `rows` to the emitter
+bool scan_rows(const std::string& rows, BatchEmitter& emitter) {
+    size_t pos = 0;
+    std::string line;
+    while (pos < rows.size()) {
+        size_t nl = rows.find('\n', pos);
+        if (nl == std::string::npos) {
+            nl = rows.size();
+        }
+        line.assign(rows, pos, nl - pos);
+        pos = nl + 1;
+
+        LogRecord record;
+        if (parse_csv_row(line, record) && !emitter.add(record)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The newest sealed row that can still be read, as CSV text, and where it
+// ends in the CSV log
+bool last_sealed_row(FrameReader& reader, std::string& last, uint64_t& csv_end) {
+    const auto& frames = reader.frames();
+    std::string rows;
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+        if (reader.read_frame(*it, rows) && rows.size() > 1 && rows.back() == '\n') {
+            size_t start = rows.rfind('\n', rows.size() - 2);
+            start = start == std::string::npos ? 0 : start + 1;
+            last.assign(rows, start, std::string::npos);
+            csv_end = it->csv_end;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Where the CSV continues past the sealed frames: `csv_end`, provided the
+// row ending there is `last` (0 means the index doesn't know)
+bool find_csv_tail(std::ifstream& in, const std::string& last, uint64_t csv_end) {
+    if (csv_end < last.size()) {
+        return false;
+    }
+    std::string row(last.size(), '\0');
+    in.seekg(static_cast<std::streamoff>(csv_end - last.size()));
+    if (!in.read(&row[0], static_cast<std::streamsize>(row.size())) || row != last) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+uint64_t scan_history(const HistorySource& source,
+                      const HistoryRequest& request,
+                      size_t batch_size,
+                      const std::function<bool(const std::vector<LogRecord>&)>& emit,
+                      uint64_t* bad_frames) {
+    BatchEmitter emitter(request, batch_size, emit);
+    bool stopped = false;   // the emitter asked to stop
+    uint64_t unreadable = 0;
+    std::string last_sealed;
+    uint64_t csv_end = 0;
+    bool have_sealed = false;
+    long sealed_until = std::numeric_limits<long>::min();
+
+    if (!source.compressed_path.empty()) {
+        FrameReader reader(source.compressed_path);
+        if (reader.open() && !reader.frames().empty()) {
+            std::string rows;
+            for (const auto& frame : reader.frames_overlapping(request.from_ts, request.to_ts)) {
+                if (!reader.read_frame(frame, rows)) {
+                    unreadable++;
+                    continue;
+                }
+                if (!scan_rows(rows, emitter)) {
+                    stopped = true;
+                    break;
+                }
+            }
+
+            // The CSV only has to fill in the rows after the last sealed one
+            have_sealed = last_sealed_row(reader, last_sealed, csv_end);
+            for (const auto& frame : reader.frames()) {
+                sealed_until = std::max(sealed_until, frame.max_ts);
+            }
+        }
+    }
+
+    if (!stopped && !source.csv_path.empty()) {
+        std::ifstream in(source.csv_path, std::ios::binary);
+        uint64_t tail = 0;
+        if (have_sealed) {
+            if (find_csv_tail(in, last_sealed, csv_end)) {
+                tail = csv_end;
+            } else {
+                // The files don't line up: scan it all, skipping by time
+                emitter.skip_until(sealed_until);
+            }
+        }
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(tail));
+        std::string line;
+        while (std::getline(in, line)) {
+            LogRecord record;
+            // The header row simply fails to parse
+            if (parse_csv_row(line, record) && !emitter.add(record)) {
+                break;
+            }
+        }
+    }
+
+    emitter.drain();
+    if (bad_frames) {
+        *bad_frames = unreadable;
+    }
+    return emitter.total();
+}
+
+} // namespace telemetry
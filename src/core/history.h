@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "log_sink.h"
+
+namespace telemetry {
+
+// Topic names of the logger's history request/reply pair. Both carry
+// Telemetry_JsonMessage payloads.
+constexpr const char* HISTORY_REQUEST_TOPIC = "lab_telemetry_history_request";
+constexpr const char* HISTORY_REPLY_TOPIC = "lab_telemetry_history_reply";
+
+// "Give me sensors S between from_ts and to_ts" (sample timestamps, ms).
+struct HistoryRequest {
+    std::string request_id;
+    std::set<int> sensors;          // empty = all sensors
+    long from_ts = 0;
+    long to_ts = 0;
+    uint64_t max_samples = 0;       // 0 = no limit
+};
+
+// One reply message. The last batch of a request has `final` set, even
+// when it carries no samples.
+struct HistoryBatch {
+    std::string request_id;
+    uint32_t batch = 0;
+    bool final = false;
+    std::vector<LogRecord> samples;
+};
+
+std::string encode_history_request(const HistoryRequest& request);
+bool parse_history_request(const char* payload, HistoryRequest& request);
+
+// Samples are encoded as compact [id, value, timestamp, sequence] arrays.
+std::string encode_history_batch(const HistoryBatch& batch);
+bool parse_history_batch(const char* payload, HistoryBatch& batch);
+
+bool history_matches(const HistoryRequest& request, const LogRecord& record);
+
+// Files the logger can answer from. Sealed compressed frames are used
+// first because the frame index lets the scan skip everything outside the
+// requested range; the CSV log then supplies only the rows after the last
+// sealed one. The index records where that row ends in the CSV
+// (FrameInfo::csv_end), so the scan seeks there after checking the row
+// matches. If the two files don't line up (one sink started later or shed
+// records) or the offset is unknown, the whole CSV is read and supplies the
+// rows newer than the newest sealed timestamp.
+struct HistorySource {
+    std::string csv_path;
+    std::string compressed_path;
+};
+
+// Streams matching records to `emit` in batches of at most `batch_size`.
+// `emit` returns false to abort (e.g. the requester went away). A frame
+// that fails to read or decode is skipped and counted in `bad_frames`.
+// Returns the number of records emitted.
+uint64_t scan_history(const HistorySource& source,
+                      const HistoryRequest& request,
+                      size_t batch_size,
+                      const std::function<bool(const std::vector<LogRecord>&)>& emit,
+                      uint64_t* bad_frames = nullptr);
+
+} // namespace telemetry
@@ -0,0 +1,656 @@
+#include "kernels.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace telemetry {
+
+namespace {
+
+constexpr double POS_INF = std::numeric_limits<double>::infinity();
+constexpr double NEG_INF = -std::numeric_limits<double>::infinity();
+
+// Bucket arithmetic shared by every variant. The SIMD versions compute the
+// same (v - lo) * scale with the same rounding, then hand the increments to
+// this code, so their histograms are bit-identical to the scalar one.
+bool histogram_scale(double lo, double hi, size_t bucket_count, double& scale) {
+    if (bucket_count == 0 || !(hi > lo)) {
+        return false;
+    }
+    scale = static_cast<double>(bucket_count) / (hi - lo);
+    return std::isfinite(scale);
+}
+
+inline void bump_bucket(size_t index, uint64_t* buckets, size_t bucket_count) {
+    // Values just below hi can round up to bucket_count
+    buckets[index < bucket_count ? index : bucket_count - 1]++;
+}
+
+inline void histogram_one(double v, double lo, double hi, double scale, uint64_t* buckets,
+                          size_t bucket_count) {
+    if (v >= lo && v < hi) {
+        bump_bucket(static_cast<size_t>((v - lo) * scale), buckets, bucket_count);
+    }
+}
+
+// ========== SCALAR ==========
+
+double min_scalar(const double* values, size_t n) {
+    double m = POS_INF;
+    for (size_t i = 0; i < n; ++i) {
+        m = values[i] < m ? values[i] : m;
+    }
+    return m;
+}
+
+double max_scalar(const double* values, size_t n) {
+    double m = NEG_INF;
+    for (size_t i = 0; i < n; ++i) {
+        m = values[i] > m ? values[i] : m;
+    }
+    return m;
+}
+
+double sum_scalar(const double* values, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        s += values[i];
+    }
+    return s;
+}
+
+double sum_squares_scalar(const double* values, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        s += values[i] * values[i];
+    }
+    return s;
+}
+
+size_t count_in_range_scalar(const double* values, size_t n, double lo, double hi) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += (values[i] >= lo && values[i] <= hi) ? 1 : 0;
+    }
+    return count;
+}
+
+void histogram_scalar(const double* values, size_t n, double lo, double hi, uint64_t* buckets,
+                      size_t bucket_count) {
+    double scale;
+    if (!histogram_scale(lo, hi, bucket_count, scale)) {
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        histogram_one(values[i], lo, hi, scale, buckets, bucket_count);
+    }
+}
+
+const Kernels SCALAR_KERNELS = {
+    Isa::Scalar,
+    min_scalar,
+    max_scalar,
+    sum_scalar,
+    sum_squares_scalar,
+    count_in_range_scalar,
+    histogram_scalar,
+};
+
+#if defined(__x86_64__)
+
+// The SIMD variants cvtt the bucket index to int32
+constexpr size_t MAX_SIMD_BUCKETS = static_cast<size_t>(std::numeric_limits<int32_t>::max());
+
+// ========== SSE2 ==========
+// Baseline on x86-64, so no target attribute. Two lanes per register, four
+// registers per iteration to hide add/min latency.
+
+double min_sse2(const double* values, size_t n) {
+    __m128d a = _mm_set1_pd(POS_INF), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a = _mm_min_pd(a, _mm_loadu_pd(values + i));
+        b = _mm_min_pd(b, _mm_loadu_pd(values + i + 2));
+        c = _mm_min_pd(c, _mm_loadu_pd(values + i + 4));
+        d = _mm_min_pd(d, _mm_loadu_pd(values + i + 6));
+    }
+    a = _mm_min_pd(_mm_min_pd(a, b), _mm_min_pd(c, d));
+    double lanes[2];
+    _mm_storeu_pd(lanes, a);
+    double m = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+    for (; i < n; ++i) {
+        m = values[i] < m ? values[i] : m;
+    }
+    return m;
+}
+
+double max_sse2(const double* values, size_t n) {
+    __m128d a = _mm_set1_pd(NEG_INF), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a = _mm_max_pd(a, _mm_loadu_pd(values + i));
+        b = _mm_max_pd(b, _mm_loadu_pd(values + i + 2));
+        c = _mm_max_pd(c, _mm_loadu_pd(values + i + 4));
+        d = _mm_max_pd(d, _mm_loadu_pd(values + i + 6));
+    }
+    a = _mm_max_pd(_mm_max_pd(a, b), _mm_max_pd(c, d));
+    double lanes[2];
+    _mm_storeu_pd(lanes, a);
+    double m = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    for (; i < n; ++i) {
+        m = values[i] > m ? values[i] : m;
+    }
+    return m;
+}
+
+double sum_sse2(const double* values, size_t n) {
+    __m128d a = _mm_setzero_pd(), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a = _mm_add_pd(a, _mm_loadu_pd(values + i));
+        b = _mm_add_pd(b, _mm_loadu_pd(values + i + 2));
+        c = _mm_add_pd(c, _mm_loadu_pd(values + i + 4));
+        d = _mm_add_pd(d, _mm_loadu_pd(values + i + 6));
+    }
+    a = _mm_add_pd(_mm_add_pd(a, b), _mm_add_pd(c, d));
+    double lanes[2];
+    _mm_storeu_pd(lanes, a);
+    double s = lanes[0] + lanes[1];
+    for (; i < n; ++i) {
+        s += values[i];
+    }
+    return s;
+}
+
+double sum_squares_sse2(const double* values, size_t n) {
+    __m128d a = _mm_setzero_pd(), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128d va = _mm_loadu_pd(values + i);
+        __m128d vb = _mm_loadu_pd(values + i + 2);
+        __m128d vc = _mm_loadu_pd(values + i + 4);
+        __m128d vd = _mm_loadu_pd(values + i + 6);
+        a = _mm_add_pd(a, _mm_mul_pd(va, va));
+        b = _mm_add_pd(b, _mm_mul_pd(vb, vb));
+        c = _mm_add_pd(c, _mm_mul_pd(vc, vc));
+        d = _mm_add_pd(d, _mm_mul_pd(vd, vd));
+    }
+    a = _mm_add_pd(_mm_add_pd(a, b), _mm_add_pd(c, d));
+    double lanes[2];
+    _mm_storeu_pd(lanes, a);
+    double s = lanes[0] + lanes[1];
+    for (; i < n; ++i) {
+        s += values[i] * values[i];
+    }
+    return s;
+}
+
+size_t count_in_range_sse2(const double* values, size_t n, double lo, double hi) {
+    const __m128d vlo = _mm_set1_pd(lo);
+    const __m128d vhi = _mm_set1_pd(hi);
+    // A true compare is all ones, i.e. -1 as an integer lane
+    __m128i a = _mm_setzero_si128(), b = a;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128d va = _mm_loadu_pd(values + i);
+        __m128d vb = _mm_loadu_pd(values + i + 2);
+        __m128d ma = _mm_and_pd(_mm_cmpge_pd(va, vlo), _mm_cmple_pd(va, vhi));
+        __m128d mb = _mm_and_pd(_mm_cmpge_pd(vb, vlo), _mm_cmple_pd(vb, vhi));
+        a = _mm_sub_epi64(a, _mm_castpd_si128(ma));
+        b = _mm_sub_epi64(b, _mm_castpd_si128(mb));
+    }
+    a = _mm_add_epi64(a, b);
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), a);
+    size_t count = static_cast<size_t>(lanes[0] + lanes[1]);
+    for (; i < n; ++i) {
+        count += (values[i] >= lo && values[i] <= hi) ? 1 : 0;
+    }
+    return count;
+}
+
+void histogram_sse2(const double* values, size_t n, double lo, double hi, uint64_t* buckets,
+                    size_t bucket_count) {
+    double scale;
+    if (!histogram_scale(lo, hi, bucket_count, scale)) {
+        return;
+    }
+    if (bucket_count > MAX_SIMD_BUCKETS) {
+        histogram_scalar(values, n, lo, hi, buckets, bucket_count);
+        return;
+    }
+    const __m128d vlo = _mm_set1_pd(lo);
+    const __m128d vhi = _mm_set1_pd(hi);
+    const __m128d vscale = _mm_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(values + i);
+        int mask = _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(v, vlo), _mm_cmplt_pd(v, vhi)));
+        if (mask == 0) {
+            continue;
+        }
+        int32_t index[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(index),
+                         _mm_cvttpd_epi32(_mm_mul_pd(_mm_sub_pd(v, vlo), vscale)));
+        if (mask & 1) bump_bucket(static_cast<size_t>(index[0]), buckets, bucket_count);
+        if (mask & 2) bump_bucket(static_cast<size_t>(index[1]), buckets, bucket_count);
+    }
+    for (; i < n; ++i) {
+        histogram_one(values[i], lo, hi, scale, buckets, bucket_count);
+    }
+}
+
+const Kernels SSE2_KERNELS = {
+    Isa::SSE2,
+    min_sse2,
+    max_sse2,
+    sum_sse2,
+    sum_squares_sse2,
+    count_in_range_sse2,
+    histogram_sse2,
+};
+
+// ========== AVX2 ==========
+
+#define TELEMETRY_AVX2 __attribute__((target("avx2")))
+
+TELEMETRY_AVX2 double min_avx2(const double* values, size_t n) {
+    __m256d a = _mm256_set1_pd(POS_INF), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a = _mm256_min_pd(a, _mm256_loadu_pd(values + i));
+        b = _mm256_min_pd(b, _mm256_loadu_pd(values + i + 4));
+        c = _mm256_min_pd(c, _mm256_loadu_pd(values + i + 8));
+        d = _mm256_min_pd(d, _mm256_loadu_pd(values + i + 12));
+    }
+    a = _mm256_min_pd(_mm256_min_pd(a, b), _mm256_min_pd(c, d));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, a);
+    double m = POS_INF;
+    for (double lane : lanes) {
+        m = lane < m ? lane : m;
+    }
+    for (; i < n; ++i) {
+        m = values[i] < m ? values[i] : m;
+    }
+    return m;
+}
+
+TELEMETRY_AVX2 double max_avx2(const double* values, size_t n) {
+    __m256d a = _mm256_set1_pd(NEG_INF), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a = _mm256_max_pd(a, _mm256_loadu_pd(values + i));
+        b = _mm256_max_pd(b, _mm256_loadu_pd(values + i + 4));
+        c = _mm256_max_pd(c, _mm256_loadu_pd(values + i + 8));
+        d = _mm256_max_pd(d, _mm256_loadu_pd(values + i + 12));
+    }
+    a = _mm256_max_pd(_mm256_max_pd(a, b), _mm256_max_pd(c, d));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, a);
+    double m = NEG_INF;
+    for (double lane : lanes) {
+        m = lane > m ? lane : m;
+    }
+    for (; i < n; ++i) {
+        m = values[i] > m ? values[i] : m;
+    }
+    return m;
+}
+
+TELEMETRY_AVX2 double sum_avx2(const double* values, size_t n) {
+    __m256d a = _mm256_setzero_pd(), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a = _mm256_add_pd(a, _mm256_loadu_pd(values + i));
+        b = _mm256_add_pd(b, _mm256_loadu_pd(values + i + 4));
+        c = _mm256_add_pd(c, _mm256_loadu_pd(values + i + 8));
+        d = _mm256_add_pd(d, _mm256_loadu_pd(values + i + 12));
+    }
+    a = _mm256_add_pd(_mm256_add_pd(a, b), _mm256_add_pd(c, d));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, a);
+    double s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i) {
+        s += values[i];
+    }
+    return s;
+}
+
+TELEMETRY_AVX2 double sum_squares_avx2(const double* values, size_t n) {
+    __m256d a = _mm256_setzero_pd(), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d va = _mm256_loadu_pd(values + i);
+        __m256d vb = _mm256_loadu_pd(values + i + 4);
+        __m256d vc = _mm256_loadu_pd(values + i + 8);
+        __m256d vd = _mm256_loadu_pd(values + i + 12);
+        a = _mm256_add_pd(a, _mm256_mul_pd(va, va));
+        b = _mm256_add_pd(b, _mm256_mul_pd(vb, vb));
+        c = _mm256_add_pd(c, _mm256_mul_pd(vc, vc));
+        d = _mm256_add_pd(d, _mm256_mul_pd(vd, vd));
+    }
+    a = _mm256_add_pd(_mm256_add_pd(a, b), _mm256_add_pd(c, d));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, a);
+    double s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i) {
+        s += values[i] * values[i];
+    }
+    return s;
+}
+
+TELEMETRY_AVX2 size_t count_in_range_avx2(const double* values, size_t n, double lo, double hi) {
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    __m256i a = _mm256_setzero_si256(), b = a;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d va = _mm256_loadu_pd(values + i);
+        __m256d vb = _mm256_loadu_pd(values + i + 4);
+        __m256d ma = _mm256_and_pd(_mm256_cmp_pd(va, vlo, _CMP_GE_OQ), _mm256_cmp_pd(va, vhi, _CMP_LE_OQ));
+        __m256d mb = _mm256_and_pd(_mm256_cmp_pd(vb, vlo, _CMP_GE_OQ), _mm256_cmp_pd(vb, vhi, _CMP_LE_OQ));
+        a = _mm256_sub_epi64(a, _mm256_castpd_si256(ma));
+        b = _mm256_sub_epi64(b, _mm256_castpd_si256(mb));
+    }
+    a = _mm256_add_epi64(a, b);
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), a);
+    size_t count = static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    for (; i < n; ++i) {
+        count += (values[i] >= lo && values[i] <= hi) ? 1 : 0;
+    }
+    return count;
+}
+
+TELEMETRY_AVX2 void histogram_avx2(const double* values, size_t n, double lo, double hi, uint64_t* buckets,
+                                   size_t bucket_count) {
+    double scale;
+    if (!histogram_scale(lo, hi, bucket_count, scale)) {
+        return;
+    }
+    if (bucket_count > MAX_SIMD_BUCKETS) {
+        histogram_scalar(values, n, lo, hi, buckets, bucket_count);
+        return;
+    }
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    const __m256d vscale = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(values + i);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(
+            _mm256_and_pd(_mm256_cmp_pd(v, vlo, _CMP_GE_OQ), _mm256_cmp_pd(v, vhi, _CMP_LT_OQ))));
+        if (mask == 0) {
+            continue;
+        }
+        int32_t index[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(index),
+                         _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(v, vlo), vscale)));
+        while (mask != 0) {
+            int lane = __builtin_ctz(mask);
+            bump_bucket(static_cast<size_t>(index[lane]), buckets, bucket_count);
+            mask &= mask - 1;
+        }
+    }
+    for (; i < n; ++i) {
+        histogram_one(values[i], lo, hi, scale, buckets, bucket_count);
+    }
+}
+
+const Kernels AVX2_KERNELS = {
+    Isa::AVX2,
+    min_avx2,
+    max_avx2,
+    sum_avx2,
+    sum_squares_avx2,
+    count_in_range_avx2,
+    histogram_avx2,
+};
+
+// ========== AVX-512 ==========
+// Masked loads handle the tail, so there is no scalar remainder loop.
+
+// GCC 12's avx512fintrin.h trips -Wuninitialized on its own
+// _mm512_undefined_* placeholders (fixed in GCC 13)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+#define TELEMETRY_AVX512 __attribute__((target("avx512f")))
+
+TELEMETRY_AVX512 inline __mmask8 tail_mask(size_t remaining) {
+    return static_cast<__mmask8>((1u << remaining) - 1);
+}
+
+TELEMETRY_AVX512 double min_avx512(const double* values, size_t n) {
+    const __m512d inf = _mm512_set1_pd(POS_INF);
+    __m512d a = inf, b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        a = _mm512_min_pd(a, _mm512_loadu_pd(values + i));
+        b = _mm512_min_pd(b, _mm512_loadu_pd(values + i + 8));
+        c = _mm512_min_pd(c, _mm512_loadu_pd(values + i + 16));
+        d = _mm512_min_pd(d, _mm512_loadu_pd(values + i + 24));
+    }
+    for (; i + 8 <= n; i += 8) {
+        a = _mm512_min_pd(a, _mm512_loadu_pd(values + i));
+    }
+    if (i < n) {
+        b = _mm512_min_pd(b, _mm512_mask_loadu_pd(inf, tail_mask(n - i), values + i));
+    }
+    return _mm512_reduce_min_pd(_mm512_min_pd(_mm512_min_pd(a, b), _mm512_min_pd(c, d)));
+}
+
+TELEMETRY_AVX512 double max_avx512(const double* values, size_t n) {
+    const __m512d ninf = _mm512_set1_pd(NEG_INF);
+    __m512d a = ninf, b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        a = _mm512_max_pd(a, _mm512_loadu_pd(values + i));
+        b = _mm512_max_pd(b, _mm512_loadu_pd(values + i + 8));
+        c = _mm512_max_pd(c, _mm512_loadu_pd(values + i + 16));
+        d = _mm512_max_pd(d, _mm512_loadu_pd(values + i + 24));
+    }
+    for (; i + 8 <= n; i += 8) {
+        a = _mm512_max_pd(a, _mm512_loadu_pd(values + i));
+    }
+    if (i < n) {
+        b = _mm512_max_pd(b, _mm512_mask_loadu_pd(ninf, tail_mask(n - i), values + i));
+    }
+    return _mm512_reduce_max_pd(_mm512_max_pd(_mm512_max_pd(a, b), _mm512_max_pd(c, d)));
+}
+
+TELEMETRY_AVX512 double sum_avx512(const double* values, size_t n) {
+    __m512d a = _mm512_setzero_pd(), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        a = _mm512_add_pd(a, _mm512_loadu_pd(values + i));
+        b = _mm512_add_pd(b, _mm512_loadu_pd(values + i + 8));
+        c = _mm512_add_pd(c, _mm512_loadu_pd(values + i + 16));
+        d = _mm512_add_pd(d, _mm512_loadu_pd(values + i + 24));
+    }
+    for (; i + 8 <= n; i += 8) {
+        a = _mm512_add_pd(a, _mm512_loadu_pd(values + i));
+    }
+    if (i < n) {
+        b = _mm512_add_pd(b, _mm512_maskz_loadu_pd(tail_mask(n - i), values + i));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(a, b), _mm512_add_pd(c, d)));
+}
+
+TELEMETRY_AVX512 double sum_squares_avx512(const double* values, size_t n) {
+    __m512d a = _mm512_setzero_pd(), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512d va = _mm512_loadu_pd(values + i);
+        __m512d vb = _mm512_loadu_pd(values + i + 8);
+        __m512d vc = _mm512_loadu_pd(values + i + 16);
+        __m512d vd = _mm512_loadu_pd(values + i + 24);
+        a = _mm512_fmadd_pd(va, va, a);
+        b = _mm512_fmadd_pd(vb, vb, b);
+        c = _mm512_fmadd_pd(vc, vc, c);
+        d = _mm512_fmadd_pd(vd, vd, d);
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(values + i);
+        a = _mm512_fmadd_pd(v, v, a);
+    }
+    if (i < n) {
+        __m512d v = _mm512_maskz_loadu_pd(tail_mask(n - i), values + i);
+        b = _mm512_fmadd_pd(v, v, b);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(a, b), _mm512_add_pd(c, d)));
+}
+
+TELEMETRY_AVX512 size_t count_in_range_avx512(const double* values, size_t n, double lo, double hi) {
+    const __m512d vlo = _mm512_set1_pd(lo);
+    const __m512d vhi = _mm512_set1_pd(hi);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(values + i);
+        __mmask8 mask = _mm512_mask_cmp_pd_mask(_mm512_cmp_pd_mask(v, vlo, _CMP_GE_OQ), v, vhi, _CMP_LE_OQ);
+        count += static_cast<size_t>(__builtin_popcount(mask));
+    }
+    if (i < n) {
+        __mmask8 live = tail_mask(n - i);
+        __m512d v = _mm512_maskz_loadu_pd(live, values + i);
+        __mmask8 mask = _mm512_mask_cmp_pd_mask(_mm512_mask_cmp_pd_mask(live, v, vlo, _CMP_GE_OQ), v, vhi,
+                                                _CMP_LE_OQ);
+        count += static_cast<size_t>(__builtin_popcount(mask));
+    }
+    return count;
+}
+
+TELEMETRY_AVX512 void histogram_avx512(const double* values, size_t n, double lo, double hi, uint64_t* buckets,
+                                       size_t bucket_count) {
+    double scale;
+    if (!histogram_scale(lo, hi, bucket_count, scale)) {
+        return;
+    }
+    if (bucket_count > MAX_SIMD_BUCKETS) {
+        histogram_scalar(values, n, lo, hi, buckets, bucket_count);
+        return;
+    }
+    const __m512d vlo = _mm512_set1_pd(lo);
+    const __m512d vhi = _mm512_set1_pd(hi);
+    const __m512d vscale = _mm512_set1_pd(scale);
+    for (size_t i = 0; i < n; i += 8) {
+        __mmask8 live = n - i >= 8 ? static_cast<__mmask8>(0xFF) : tail_mask(n - i);
+        __m512d v = _mm512_maskz_loadu_pd(live, values + i);
+        unsigned mask = _mm512_mask_cmp_pd_mask(_mm512_mask_cmp_pd_mask(live, v, vlo, _CMP_GE_OQ), v, vhi,
+                                                _CMP_LT_OQ);
+        if (mask == 0) {
+            continue;
+        }
+        int32_t index[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(index),
+                            _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_sub_pd(v, vlo), vscale)));
+        while (mask != 0) {
+            int lane = __builtin_ctz(mask);
+            bump_bucket(static_cast<size_t>(index[lane]), buckets, bucket_count);
+            mask &= mask - 1;
+        }
+    }
+}
+
+const Kernels AVX512_KERNELS = {
+    Isa::AVX512,
+    min_avx512,
+    max_avx512,
+    sum_avx512,
+    sum_squares_avx512,
+    count_in_range_avx512,
+    histogram_avx512,
+};
+
+#pragma GCC diagnostic pop
+
+#endif // __x86_64__
+
+bool cpu_supports(Isa isa) {
+#if defined(__x86_64__)
+    switch (isa) {
+        case Isa::Scalar:
+        case Isa::SSE2:
+            return true;
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Isa::AVX512:
+            return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return isa == Isa::Scalar;
+#endif
+}
+
+Isa best_supported() {
+    for (Isa isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2}) {
+        if (cpu_supports(isa)) {
+            return isa;
+        }
+    }
+    return Isa::Scalar;
+}
+
+} // namespace
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2: return "sse2";
+        case Isa::AVX2: return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+Isa detected_isa() {
+    static const Isa isa = [] {
+        Isa best = best_supported();
+        const char* cap = std::getenv("TELEMETRY_ISA");
+        if (cap == nullptr || *cap == '\0') {
+            return best;
+        }
+        for (Isa candidate : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+            if (std::strcmp(cap, isa_name(candidate)) == 0) {
+                return candidate < best ? candidate : best;
+            }
+        }
+        std::cerr << "[ERROR] Unknown TELEMETRY_ISA '" << cap << "', using " << isa_name(best) << "\n";
+        return best;
+    }();
+    return isa;
+}
+
+const Kernels* kernels_for(Isa isa) {
+    if (!cpu_supports(isa)) {
+        return nullptr;
+    }
+#if defined(__x86_64__)
+    switch (isa) {
+        case Isa::Scalar: return &SCALAR_KERNELS;
+        case Isa::SSE2: return &SSE2_KERNELS;
+        case Isa::AVX2: return &AVX2_KERNELS;
+        case Isa::AVX512: return &AVX512_KERNELS;
+    }
+    return nullptr;
+#else
+    return &SCALAR_KERNELS;
+#endif
+}
+
+const Kernels& kernels() {
+    static const Kernels* selected = kernels_for(detected_isa());
+    return *selected;
+}
+
+} // namespace telemetry
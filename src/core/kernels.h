@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace telemetry {
+
+// Instruction sets the block kernels are built for, in increasing order.
+enum class Isa : uint8_t { Scalar, SSE2, AVX2, AVX512 };
+
+const char* isa_name(Isa isa);
+
+// Best ISA this CPU supports. TELEMETRY_ISA=scalar|sse2|avx2|avx512 in the
+// environment caps it (for A/B runs and for reproducing ISA-specific bugs).
+Isa detected_isa();
+
+// Aggregation kernels over contiguous blocks of samples (window rollups,
+// history scans, benchmark statistics). Every ISA variant returns the same
+// min/max/count/histogram results as the scalar one; sums are accumulated
+// in a different order, so they agree only to rounding.
+//
+// Empty input gives min = +inf, max = -inf and zero sums. NaN never counts
+// as in range; min/max over blocks containing NaN are unspecified.
+struct Kernels {
+    Isa isa;
+    double (*min)(const double* values, size_t n);
+    double (*max)(const double* values, size_t n);
+    double (*sum)(const double* values, size_t n);
+    double (*sum_squares)(const double* values, size_t n);
+    // Values with lo <= v <= hi.
+    size_t (*count_in_range)(const double* values, size_t n, double lo, double hi);
+    // Adds each value in [lo, hi) to one of `bucket_count` equal-width
+    // buckets; values outside are skipped. Counts accumulate, so blocks can
+    // be fed one after another.
+    void (*histogram)(const double* values, size_t n, double lo, double hi, uint64_t* buckets,
+                      size_t bucket_count);
+};
+
+// Kernels for detected_isa(), resolved on first use.
+const Kernels& kernels();
+
+// Kernels for a specific ISA, or nullptr if this build or CPU lacks it.
+const Kernels* kernels_for(Isa isa);
+
+} // namespace telemetry
@@ -0,0 +1,169 @@
+#include "log_sink.h"
+#include <chrono>
+#include <iostream>
+
+#include "trace.h"
+
+namespace telemetry {
+
+namespace {
+constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(1000);
+constexpr auto POP_TIMEOUT = std::chrono::milliseconds(100);
+}
+
+uint64_t wall_clock_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+const char* overflow_policy_name(OverflowPolicy policy) {
+    switch (policy) {
+        case OverflowPolicy::Block:      return "block";
+        case OverflowPolicy::DropNewest: return "drop-newest";
+        case OverflowPolicy::DropOldest: return "drop-oldest";
+    }
+    return "unknown";
+}
+
+bool parse_overflow_policy(const std::string& text, OverflowPolicy& policy) {
+    if (text == "block") {
+        policy = OverflowPolicy::Block;
+    } else if (text == "drop-newest") {
+        policy = OverflowPolicy::DropNewest;
+    } else if (text == "drop-oldest") {
+        policy = OverflowPolicy::DropOldest;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ========== SinkWorker ==========
+
+SinkWorker::SinkWorker(std::unique_ptr<LogSink> sink, size_t capacity, OverflowPolicy policy)
+    : sink_(std::move(sink)), queue_(capacity, policy) {
+    std::string prefix = std::string("logger.sink.") + sink_->name();
+    write_ns_ = metrics().histogram(prefix + ".write_ns");
+    lag_ms_ = metrics().histogram(prefix + ".lag_ms");
+}
+
+SinkWorker::~SinkWorker() {
+    stop();
+}
+
+bool SinkWorker::start() {
+    if (!sink_->open()) {
+        std::cerr << "[ERROR] Failed to open sink '" << sink_->name() << "'\n";
+        return false;
+    }
+    thread_ = std::thread(&SinkWorker::run, this);
+    return true;
+}
+
+void SinkWorker::submit(const LogRecord& record) {
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+    if (!queue_.push(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SinkWorker::stop() {
+    queue_.stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SinkWorker::run() {
+    set_trace_thread_name(std::string("sink:") + sink_->name());
+    auto last_flush = std::chrono::steady_clock::now();
+    LogRecord record;
+
+    while (true) {
+        if (queue_.pop_for(record, POP_TIMEOUT)) {
+            auto write_start = std::chrono::steady_clock::now();
+            {
+                TRACE_SCOPE("sink_write");
+                sink_->write(record);
+            }
+            write_ns_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - write_start).count());
+            written_.fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t now_ms = wall_clock_ms();
+            uint64_t lag = now_ms > record.received_ms ? now_ms - record.received_ms : 0;
+            lag_ms_.record(lag);
+            last_lag_ms_.store(lag, std::memory_order_relaxed);
+            if (lag > max_lag_ms_.load(std::memory_order_relaxed)) {
+                max_lag_ms_.store(lag, std::memory_order_relaxed);
+            }
+        } else if (queue_.stopped() && queue_.size() == 0) {
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_flush >= FLUSH_INTERVAL) {
+            TRACE_SCOPE("sink_flush");
+            sink_->flush();
+            last_flush = now;
+        }
+    }
+
+    sink_->flush();
+    sink_->close();
+}
+
+SinkStats SinkWorker::stats() const {
+    SinkStats s;
+    s.name = sink_->name();
+    s.enqueued = enqueued_.load(std::memory_order_relaxed);
+    s.written = written_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.queue_depth = queue_.size();
+    s.queue_capacity = queue_.capacity();
+    s.last_lag_ms = last_lag_ms_.load(std::memory_order_relaxed);
+    s.max_lag_ms = max_lag_ms_.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ========== FanOutLogger ==========
+
+void FanOutLogger::add_sink(std::unique_ptr<LogSink> sink, size_t capacity, OverflowPolicy policy) {
+    workers_.push_back(std::make_unique<SinkWorker>(std::move(sink), capacity, policy));
+}
+
+bool FanOutLogger::start() {
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        if (!workers_[i]->start()) {
+            for (size_t j = 0; j < i; ++j) {
+                workers_[j]->stop();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void FanOutLogger::publish(const LogRecord& record) {
+    for (auto& worker : workers_) {
+        worker->submit(record);
+    }
+}
+
+void FanOutLogger::stop() {
+    for (auto& worker : workers_) {
+        worker->stop();
+    }
+}
+
+std::vector<SinkStats> FanOutLogger::stats() const {
+    std::vector<SinkStats> result;
+    result.reserve(workers_.size());
+    for (const auto& worker : workers_) {
+        result.push_back(worker->stats());
+    }
+    return result;
+}
+
+} // namespace telemetry
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "telemetry_types.h"
+#include "bounded_queue.h"
+#include "metrics.h"
+
+namespace telemetry {
+
+// One decoded sample as the logger hands it to its sinks.
+struct LogRecord {
+    SensorData data;
+    uint64_t sequence = 0;
+    uint64_t received_ms = 0;   // Wall-clock ms when the logger took the sample
+};
+
+// A destination for log records. Each sink is driven by its own thread,
+// so implementations need no internal locking.
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+
+    virtual const char* name() const = 0;
+
+    // Called once, before the sink thread starts.
+    virtual bool open() = 0;
+    virtual void write(const LogRecord& record) = 0;
+    // Called periodically (about once per second) and before close().
+    virtual void flush() = 0;
+    virtual void close() = 0;
+};
+
+// Point-in-time view of a sink's queue and progress.
+struct SinkStats {
+    std::string name;
+    uint64_t enqueued = 0;
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+    size_t queue_depth = 0;
+    size_t queue_capacity = 0;
+    uint64_t last_lag_ms = 0;   // received_ms -> written, most recent record
+    uint64_t max_lag_ms = 0;
+};
+
+// Owns one sink, its bounded queue and the thread draining it.
+class SinkWorker {
+public:
+    SinkWorker(std::unique_ptr<LogSink> sink, size_t capacity, OverflowPolicy policy);
+    ~SinkWorker();
+
+    SinkWorker(const SinkWorker&) = delete;
+    SinkWorker& operator=(const SinkWorker&) = delete;
+
+    bool start();
+    void submit(const LogRecord& record);
+    // Drains the queue, flushes and closes the sink.
+    void stop();
+
+    SinkStats stats() const;
+
+private:
+    void run();
+
+    std::unique_ptr<LogSink> sink_;
+    BoundedQueue<LogRecord> queue_;
+    std::thread thread_;
+
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> last_lag_ms_{0};
+    std::atomic<uint64_t> max_lag_ms_{0};
+
+    // logger.sink.<name>.write_ns / .lag_ms in the process registry
+    Histogram write_ns_;
+    Histogram lag_ms_;
+};
+
+// Fans one decoded stream out to any number of independent sinks.
+class FanOutLogger {
+public:
+    void add_sink(std::unique_ptr<LogSink> sink, size_t capacity, OverflowPolicy policy);
+
+    // Opens every sink. Returns false (and stops what was started) on failure.
+    bool start();
+    void publish(const LogRecord& record);
+    void stop();
+
+    size_t sink_count() const { return workers_.size(); }
+    std::vector<SinkStats> stats() const;
+
+private:
+    std::vector<std::unique_ptr<SinkWorker>> workers_;
+};
+
+const char* overflow_policy_name(OverflowPolicy policy);
+// Accepts "block", "drop-newest" and "drop-oldest".
+bool parse_overflow_policy(const std::string& text, OverflowPolicy& policy);
+
+// Wall-clock milliseconds since the epoch.
+uint64_t wall_clock_ms();
+
+} // namespace telemetry
@@ -0,0 +1,485 @@
+#include "log_sinks.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "async_console.h"
+
+namespace telemetry {
+
+namespace {
+// Errors raised on the sink threads, at most a few per second
+RateLimit g_sink_errors(5, std::chrono::seconds(1));
+}
+
+std::string format_timestamp_ms(uint64_t wall_ms) {
+    char buf[32];
+    size_t n = format_timestamp_ms(wall_ms, buf, sizeof(buf));
+    return std::string(buf, n);
+}
+
+size_t format_timestamp_ms(uint64_t wall_ms, char* out, size_t capacity) {
+    std::time_t seconds = static_cast<std::time_t>(wall_ms / 1000);
+    std::tm local{};
+    localtime_r(&seconds, &local);
+
+    size_t n = std::strftime(out, capacity, "%Y-%m-%d %H:%M:%S", &local);
+    int ms = std::snprintf(out + n, capacity - n, ".%03u", static_cast<unsigned>(wall_ms % 1000));
+    if (ms > 0) {
+        n += static_cast<size_t>(ms);
+    }
+    return n < capacity ? n : capacity - 1;
+}
+
+void format_csv_row(const LogRecord& record, std::string& out) {
+    char buf[96];
+    int n = std::snprintf(buf, sizeof(buf), "%ld,%d,%.2f,%llu,",
+                          record.data.timestamp,
+                          record.data.id,
+                          record.data.value,
+                          static_cast<unsigned long long>(record.sequence));
+    out.append(buf, n > 0 ? static_cast<size_t>(n) : 0);
+    // Stack buffer rather than the std::string overload: the timestamp is
+    // longer than the SSO buffer, which cost one allocation per row
+    char stamp[32];
+    out.append(stamp, format_timestamp_ms(record.received_ms, stamp, sizeof(stamp)));
+    out += '\n';
+}
+
+bool parse_csv_row(const std::string& line, LogRecord& record) {
+    const char* p = line.c_str();
+    char* end;
+
+    record.data.timestamp = std::strtol(p, &end, 10);
+    if (end == p || *end != ',') return false;
+    p = end + 1;
+
+    record.data.id = static_cast<int>(std::strtol(p, &end, 10));
+    if (end == p || *end != ',') return false;
+    p = end + 1;
+
+    record.data.value = std::strtod(p, &end);
+    if (end == p || *end != ',') return false;
+    p = end + 1;
+
+    record.sequence = std::strtoull(p, &end, 10);
+    if (end == p || *end != ',') return false;   // a torn last line stops here
+
+    record.received_ms = 0;
+    return true;
+}
+
+// ========== CsvSink ==========
+
+namespace {
+
+bool file_is_empty(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return !in.is_open() || in.tellg() <= 0;
+}
+
+uint64_t file_size(const std::string& path) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
+// Length of `path` up to and including its last '\n'
+uint64_t complete_rows_size(const std::string& path, uint64_t size) {
+    std::ifstream in(path, std::ios::binary);
+    char buf[4096];
+    uint64_t end = size;
+    while (in && end > 0) {
+        uint64_t chunk = std::min<uint64_t>(sizeof(buf), end);
+        in.seekg(static_cast<std::streamoff>(end - chunk));
+        if (!in.read(buf, static_cast<std::streamsize>(chunk))) {
+            break;
+        }
+        for (uint64_t i = chunk; i > 0; --i) {
+            if (buf[i - 1] == '\n') {
+                return end - chunk + i;
+            }
+        }
+        end -= chunk;
+    }
+    return 0;
+}
+
+constexpr char CSV_HEADER[] = "timestamp,sensor_id,value,sequence,received_at\n";
+
+} // namespace
+
+uint64_t csv_resume_offset(const std::string& path) {
+    uint64_t complete = complete_rows_size(path, file_size(path));
+    return complete > 0 ? complete : sizeof(CSV_HEADER) - 1;
+}
+
+bool recover_csv_marks(const std::string& csv_path, SequenceCheckpoint& checkpoint) {
+    checkpoint.load();
+    bool consistent = true;
+    uint64_t offset = checkpoint.data_offset();
+    if (offset > file_size(csv_path)) {
+        checkpoint.clear();
+        offset = 0;
+        consistent = false;
+    }
+
+    std::ifstream in(csv_path, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(offset));
+    std::string line;
+    LogRecord record;
+    // Only '\n'-terminated rows count; a torn last row is cut on open
+    while (std::getline(in, line) && !in.eof()) {
+        offset += line.size() + 1;
+        if (parse_csv_row(line, record)) {   // the header does not parse
+            checkpoint.advance(record.data.id, record.sequence, record.data.timestamp);
+        }
+    }
+    checkpoint.set_data_offset(offset);
+    return consistent;
+}
+
+CsvSink::CsvSink(std::string path, std::string checkpoint_path) : path_(std::move(path)) {
+    if (!checkpoint_path.empty()) {
+        checkpoint_ = std::make_unique<SequenceCheckpoint>(std::move(checkpoint_path));
+    }
+}
+
+bool CsvSink::open() {
+    // A crash mid-row leaves a partial last line; drop it so the next row
+    // starts on a line of its own
+    size_ = file_size(path_);
+    uint64_t complete = complete_rows_size(path_, size_);
+    if (complete < size_) {
+        std::error_code ec;
+        std::filesystem::resize_file(path_, complete, ec);
+        if (ec) {
+            std::cerr << "[ERROR] Failed to truncate torn row in " << path_ << ": " << ec.message() << "\n";
+            return false;
+        }
+        std::cerr << "[Logger] " << path_ << ": dropped a torn last row (" << size_ - complete << " bytes)\n";
+        size_ = complete;
+    }
+
+    file_.open(path_, std::ios::app);
+    if (!file_.is_open()) {
+        return false;
+    }
+    if (size_ == 0) {
+        file_ << CSV_HEADER;
+        file_.flush();
+        size_ = sizeof(CSV_HEADER) - 1;
+    }
+    if (checkpoint_ && !recover_csv_marks(path_, *checkpoint_)) {
+        std::cerr << "[Logger] Checkpoint " << checkpoint_->path() << " does not match " << path_
+                  << "; rebuilt it from the file\n";
+    }
+    return true;
+}
+
+void CsvSink::write(const LogRecord& record) {
+    row_.clear();
+    format_csv_row(record, row_);
+    file_.write(row_.data(), static_cast<std::streamsize>(row_.size()));
+    size_ += row_.size();
+    if (checkpoint_) {
+        checkpoint_->advance(record.data.id, record.sequence, record.data.timestamp);
+        checkpoint_dirty_ = true;
+    }
+}
+
+void CsvSink::flush() {
+    file_.flush();
+    // Group commit: the marks only move once the rows they cover are on disk
+    if (checkpoint_ && checkpoint_dirty_ && file_.good()) {
+        if (!sync_path(path_)) {
+            log_err(g_sink_errors) << "[ERROR] Failed to sync " << path_;
+            return;
+        }
+        checkpoint_->set_data_offset(size_);
+        if (checkpoint_->save()) {
+            checkpoint_dirty_ = false;
+        } else {
+            log_err(g_sink_errors) << "[ERROR] Failed to save checkpoint " << checkpoint_->path();
+        }
+    }
+}
+
+void CsvSink::close() {
+    file_.close();
+}
+
+// ========== BinarySegmentSink ==========
+
+namespace {
+
+void put_u64(unsigned char* out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+uint64_t get_u64(const unsigned char* in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return v;
+}
+
+} // namespace
+
+BinarySegmentSink::BinarySegmentSink(std::string prefix, uint64_t records_per_segment)
+    : prefix_(std::move(prefix)),
+      records_per_segment_(records_per_segment == 0 ? 1 : records_per_segment) {}
+
+void BinarySegmentSink::encode_record(const LogRecord& record, unsigned char* out) {
+    uint32_t id = static_cast<uint32_t>(record.data.id);
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<unsigned char>(id >> (8 * i));
+    }
+    uint64_t value_bits;
+    std::memcpy(&value_bits, &record.data.value, sizeof(value_bits));
+    put_u64(out + 4, value_bits);
+    put_u64(out + 12, static_cast<uint64_t>(record.data.timestamp));
+    put_u64(out + 20, record.sequence);
+    put_u64(out + 28, record.received_ms);
+}
+
+void BinarySegmentSink::decode_record(const unsigned char* in, LogRecord& record) {
+    uint32_t id = 0;
+    for (int i = 0; i < 4; ++i) {
+        id |= static_cast<uint32_t>(in[i]) << (8 * i);
+    }
+    record.data.id = static_cast<int>(id);
+    uint64_t value_bits = get_u64(in + 4);
+    std::memcpy(&record.data.value, &value_bits, sizeof(value_bits));
+    record.data.timestamp = static_cast<long>(get_u64(in + 12));
+    record.sequence = get_u64(in + 20);
+    record.received_ms = get_u64(in + 28);
+}
+
+size_t remove_binary_segments(const std::string& prefix) {
+    char suffix[32];
+    size_t removed = 0;
+    while (true) {
+        std::snprintf(suffix, sizeof(suffix), ".%04llu.bin", static_cast<unsigned long long>(removed));
+        if (std::remove((prefix + suffix).c_str()) != 0) {
+            return removed;
+        }
+        ++removed;
+    }
+}
+
+bool BinarySegmentSink::open_segment() {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%04llu.bin",
+                  static_cast<unsigned long long>(segment_index_));
+    file_.open(prefix_ + suffix, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        return false;
+    }
+    file_.write(MAGIC, sizeof(MAGIC));
+    records_in_segment_ = 0;
+    return true;
+}
+
+bool BinarySegmentSink::open() {
+    // Resume after the last segment left by a previous run
+    char suffix[32];
+    while (true) {
+        std::snprintf(suffix, sizeof(suffix), ".%04llu.bin",
+                      static_cast<unsigned long long>(segment_index_));
+        if (!std::ifstream(prefix_ + suffix).is_open()) {
+            break;
+        }
+        ++segment_index_;
+    }
+    return open_segment();
+}
+
+void BinarySegmentSink::write(const LogRecord& record) {
+    if (records_in_segment_ >= records_per_segment_) {
+        file_.close();
+        ++segment_index_;
+        if (!open_segment()) {
+            log_err(g_sink_errors) << "[ERROR] Failed to open binary segment " << segment_index_;
+            return;
+        }
+    }
+    unsigned char buf[RECORD_SIZE];
+    encode_record(record, buf);
+    file_.write(reinterpret_cast<const char*>(buf), sizeof(buf));
+    ++records_in_segment_;
+}
+
+void BinarySegmentSink::flush() {
+    file_.flush();
+}
+
+void BinarySegmentSink::close() {
+    file_.close();
+}
+
+// ========== RollupSink ==========
+
+RollupSink::RollupSink(std::string path, uint64_t window_ms)
+    : path_(std::move(path)), window_ms_(window_ms == 0 ? 1 : window_ms) {}
+
+bool RollupSink::open() {
+    bool write_header = file_is_empty(path_);
+    file_.open(path_, std::ios::app);
+    if (!file_.is_open()) {
+        return false;
+    }
+    if (write_header) {
+        file_ << "window_start,sensor_id,count,min,max,avg\n";
+    }
+    return true;
+}
+
+void RollupSink::emit(int sensor_id, const Window& window) {
+    char buf[160];
+    int n = std::snprintf(buf, sizeof(buf), "%llu,%d,%llu,%.2f,%.2f,%.2f\n",
+                          static_cast<unsigned long long>(window.start),
+                          sensor_id,
+                          static_cast<unsigned long long>(window.count),
+                          window.min,
+                          window.max,
+                          window.sum / window.count);
+    file_.write(buf, n > 0 ? n : 0);
+}
+
+void RollupSink::write(const LogRecord& record) {
+    uint64_t ts = static_cast<uint64_t>(record.data.timestamp);
+    uint64_t start = ts - ts % window_ms_;
+
+    Window& window = windows_[record.data.id];
+    if (start < window.start) {
+        late_dropped_++;   // its window is already written
+        return;
+    }
+    if (window.count > 0 && start > window.start) {
+        emit(record.data.id, window);
+        window = Window{};
+    }
+    if (window.count == 0) {
+        window.start = start;
+        window.min = record.data.value;
+        window.max = record.data.value;
+    }
+    window.count++;
+    window.sum += record.data.value;
+    if (record.data.value < window.min) window.min = record.data.value;
+    if (record.data.value > window.max) window.max = record.data.value;
+}
+
+void RollupSink::flush() {
+    file_.flush();
+}
+
+void RollupSink::close() {
+    // Emit the partially filled windows so a shutdown loses nothing
+    for (const auto& pair : windows_) {
+        if (pair.second.count > 0) {
+            emit(pair.first, pair.second);
+        }
+    }
+    windows_.clear();
+    file_.close();
+    if (late_dropped_ > 0) {
+        std::cerr << "[Logger] " << path_ << ": dropped " << late_dropped_
+                  << " samples older than their sensor's open window\n";
+    }
+}
+
+// ========== SocketStreamSink ==========
+
+SocketStreamSink::SocketStreamSink(std::string path) : path_(std::move(path)) {}
+
+bool SocketStreamSink::open() {
+    sockaddr_un addr{};
+    if (path_.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[ERROR] Socket path too long: " << path_ << "\n";
+        return false;
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(path_.c_str());
+
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 8) < 0) {
+        std::cerr << "[ERROR] Failed to bind " << path_ << ": " << std::strerror(errno) << "\n";
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    ::fcntl(listen_fd_, F_SETFL, ::fcntl(listen_fd_, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+void SocketStreamSink::accept_clients() {
+    while (true) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        clients_.push_back(fd);
+    }
+}
+
+void SocketStreamSink::write(const LogRecord& record) {
+    if (clients_.empty()) {
+        return;
+    }
+    row_.clear();
+    format_csv_row(record, row_);
+
+    for (size_t i = 0; i < clients_.size();) {
+        ssize_t sent = ::send(clients_[i], row_.data(), row_.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent != static_cast<ssize_t>(row_.size())) {
+            // Slow or gone: drop the client instead of blocking the sink
+            ::close(clients_[i]);
+            clients_[i] = clients_.back();
+            clients_.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void SocketStreamSink::flush() {
+    accept_clients();
+}
+
+void SocketStreamSink::close() {
+    for (int fd : clients_) {
+        ::close(fd);
+    }
+    clients_.clear();
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        ::unlink(path_.c_str());
+    }
+}
+
+} // namespace telemetry
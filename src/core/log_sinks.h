@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "log_sink.h"
+#include "checkpoint.h"
+
+namespace telemetry {
+
+// Formats wall-clock ms as "YYYY-MM-DD HH:MM:SS.mmm" in local time.
+std::string format_timestamp_ms(uint64_t wall_ms);
+
+// Same text written into `out` (NUL-terminated) without touching the heap;
+// returns its length. 24 bytes is enough.
+size_t format_timestamp_ms(uint64_t wall_ms, char* out, size_t capacity);
+
+// Appends "timestamp,sensor_id,value,sequence,received_at\n" for one record.
+void format_csv_row(const LogRecord& record, std::string& out);
+
+// Parses the first four fields of a CSV row back into a record.
+// received_at is not parsed; received_ms is left at 0.
+bool parse_csv_row(const std::string& line, LogRecord& record);
+
+// Where a CsvSink opened on `path` continues writing: the end of its last
+// complete row, or just past the header it writes to an empty file.
+uint64_t csv_resume_offset(const std::string& path);
+
+// Loads `checkpoint` and brings it up to date with `csv_path`: rows written
+// after the checkpoint's data offset (the tail a crash left unsaved) advance
+// the marks too, so they are not logged twice. Returns false if the
+// checkpoint does not match the file (e.g. the file is shorter than its
+// offset); the marks are then rebuilt from the whole file.
+bool recover_csv_marks(const std::string& csv_path, SequenceCheckpoint& checkpoint);
+
+// The original logger output: one CSV row per sample. An existing file is
+// appended to, after cutting a torn last row back to its last newline.
+// With a checkpoint path, each flush is a group commit: the rows are flushed
+// and fsync()ed first, then the per-sensor high-water marks are saved.
+class CsvSink : public LogSink {
+public:
+    explicit CsvSink(std::string path, std::string checkpoint_path = "");
+
+    const char* name() const override { return "csv"; }
+    bool open() override;
+    void write(const LogRecord& record) override;
+    void flush() override;
+    void close() override;
+
+private:
+    std::string path_;
+    std::ofstream file_;
+    std::string row_;
+    std::unique_ptr<SequenceCheckpoint> checkpoint_;
+    bool checkpoint_dirty_ = false;
+    uint64_t size_ = 0;   // bytes written to path_, checkpoint data offset
+};
+
+// Removes "<prefix>.0000.bin", "<prefix>.0001.bin", ... up to the first
+// missing one. Returns how many were removed.
+size_t remove_binary_segments(const std::string& prefix);
+
+// Fixed-size little-endian records split into numbered segment files
+// ("<prefix>.0000.bin", "<prefix>.0001.bin", ...). A restart continues
+// with the next unused segment number.
+class BinarySegmentSink : public LogSink {
+public:
+    static constexpr char MAGIC[8] = {'M', 'T', 'S', 'E', 'G', '0', '1', '\0'};
+    static constexpr size_t RECORD_SIZE = 36; // i32 id, f64 value, i64 ts, u64 seq, u64 received
+
+    BinarySegmentSink(std::string prefix, uint64_t records_per_segment);
+
+    const char* name() const override { return "binary"; }
+    bool open() override;
+    void write(const LogRecord& record) override;
+    void flush() override;
+    void close() override;
+
+    static void encode_record(const LogRecord& record, unsigned char* out);
+    static void decode_record(const unsigned char* in, LogRecord& record);
+
+private:
+    bool open_segment();
+
+    std::string prefix_;
+    uint64_t records_per_segment_;
+    uint64_t segment_index_ = 0;
+    uint64_t records_in_segment_ = 0;
+    std::ofstream file_;
+};
+
+// Per-sensor min/max/avg over fixed windows of sample time, one CSV row
+// ("window_start,sensor_id,count,min,max,avg") per closed window.
+// A sample from a later window closes the open one; a late sample from an
+// earlier window (already emitted) is dropped and counted, so each window
+// start appears once per sensor. An existing file is appended to.
+class RollupSink : public LogSink {
+public:
+    RollupSink(std::string path, uint64_t window_ms);
+
+    const char* name() const override { return "rollup"; }
+    bool open() override;
+    void write(const LogRecord& record) override;
+    void flush() override;
+    void close() override;
+
+    uint64_t late_dropped() const { return late_dropped_; }
+
+private:
+    struct Window {
+        uint64_t start = 0;
+        uint64_t count = 0;
+        double min = 0.0;
+        double max = 0.0;
+        double sum = 0.0;
+    };
+
+    void emit(int sensor_id, const Window& window);
+
+    std::string path_;
+    uint64_t window_ms_;
+    std::ofstream file_;
+    std::map<int, Window> windows_;
+    uint64_t late_dropped_ = 0;
+};
+
+// Streams CSV rows to every client connected to a local (Unix-domain) socket.
+// Clients that cannot keep up are disconnected rather than waited on.
+class SocketStreamSink : public LogSink {
+public:
+    explicit SocketStreamSink(std::string path);
+
+    const char* name() const override { return "socket"; }
+    bool open() override;
+    void write(const LogRecord& record) override;
+    void flush() override;
+    void close() override;
+
+    size_t client_count() const { return clients_.size(); }
+
+private:
+    void accept_clients();
+
+    std::string path_;
+    int listen_fd_ = -1;
+    std::vector<int> clients_;
+    std::string row_;
+};
+
+} // namespace telemetry
@@ -0,0 +1,149 @@
+#include "lz_codec.h"
+#include <cstring>
+
+namespace telemetry {
+namespace lz {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 14;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash32(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void put_length(std::vector<uint8_t>& out, size_t extra) {
+    while (extra >= 255) {
+        out.push_back(255);
+        extra -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(extra));
+}
+
+void emit_sequence(std::vector<uint8_t>& out,
+                   const uint8_t* literals, size_t literal_len,
+                   size_t offset, size_t match_len) {
+    size_t match_code = match_len ? match_len - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>(
+        ((literal_len < 15 ? literal_len : 15) << 4) | (match_code < 15 ? match_code : 15));
+    out.push_back(token);
+    if (literal_len >= 15) {
+        put_length(out, literal_len - 15);
+    }
+    out.insert(out.end(), literals, literals + literal_len);
+
+    if (match_len == 0) {
+        return; // final, literal-only sequence
+    }
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (match_code >= 15) {
+        put_length(out, match_code - 15);
+    }
+}
+
+bool get_length(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+    uint8_t b;
+    do {
+        if (ip >= end) {
+            return false;
+        }
+        b = *ip++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+} // namespace
+
+void compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    std::vector<int32_t> table(size_t(1) << HASH_BITS, -1);
+
+    size_t ip = 0;
+    size_t anchor = 0;
+
+    while (ip + MIN_MATCH <= size) {
+        uint32_t seq = read32(src + ip);
+        uint32_t h = hash32(seq);
+        int32_t ref = table[h];
+        table[h] = static_cast<int32_t>(ip);
+
+        if (ref >= 0 && ip - ref <= MAX_OFFSET && read32(src + ref) == seq) {
+            size_t len = MIN_MATCH;
+            while (ip + len < size && src[ref + len] == src[ip + len]) {
+                ++len;
+            }
+            emit_sequence(out, src + anchor, ip - anchor, ip - ref, len);
+            ip += len;
+            anchor = ip;
+        } else {
+            ++ip;
+        }
+    }
+
+    emit_sequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool decompress(const uint8_t* src, size_t size, size_t raw_size, std::vector<uint8_t>& out) {
+    out.resize(raw_size);
+    uint8_t* op = out.data();
+    uint8_t* const oend = op + raw_size;
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + size;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && !get_length(ip, iend, literal_len)) {
+            return false;
+        }
+        if (literal_len > static_cast<size_t>(iend - ip) ||
+            literal_len > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literal_len);
+        ip += literal_len;
+        op += literal_len;
+
+        if (ip == iend) {
+            break; // final sequence carries no match
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+
+        size_t match_len = token & 0x0F;
+        if (match_len == 15 && !get_length(ip, iend, match_len)) {
+            return false;
+        }
+        match_len += MIN_MATCH;
+
+        if (offset == 0 || offset > static_cast<size_t>(op - out.data()) ||
+            match_len > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        // Byte-wise copy: the match may overlap what it is producing
+        const uint8_t* match = op - offset;
+        for (size_t i = 0; i < match_len; ++i) {
+            op[i] = match[i];
+        }
+        op += match_len;
+    }
+
+    return op == oend;
+}
+
+} // namespace lz
+} // namespace telemetry
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace telemetry {
+
+// Small self-contained LZ77 block codec in the LZ4 style: a token byte
+// (literal length / match length nibbles, 15 = extended with 255-runs),
+// the literals, then a 16-bit little-endian back-reference offset.
+// Blocks are independent, so any one can be decoded on its own.
+namespace lz {
+
+// Appends the compressed form of src[0..size) to `out`.
+void compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+// Decodes a block produced by compress(). `raw_size` is the exact size of
+// the original data. Returns false if the block is malformed.
+bool decompress(const uint8_t* src, size_t size, size_t raw_size, std::vector<uint8_t>& out);
+
+} // namespace lz
+} // namespace telemetry
@@ -0,0 +1,320 @@
+#include "message_codec.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace telemetry {
+
+namespace {
+
+// ========== Encoding ==========
+
+class Writer {
+public:
+    Writer(char* out, size_t capacity) : pos_(out), end_(out + capacity) {}
+
+    bool literal(const char* text) {
+        size_t len = std::strlen(text);
+        if (static_cast<size_t>(end_ - pos_) < len) return fail();
+        std::memcpy(pos_, text, len);
+        pos_ += len;
+        return true;
+    }
+
+    template <typename T>
+    bool integer(T value) {
+        auto result = std::to_chars(pos_, end_, value);
+        if (result.ec != std::errc()) return fail();
+        pos_ = result.ptr;
+        return true;
+    }
+
+    // Shortest round-trip form, with ".0" on integral values as nlohmann does
+    bool number(double value) {
+        if (!std::isfinite(value)) {
+            return literal("null");
+        }
+        char* start = pos_;
+        auto result = std::to_chars(pos_, end_, value);
+        if (result.ec != std::errc()) return fail();
+        pos_ = result.ptr;
+        if (std::memchr(start, '.', pos_ - start) == nullptr &&
+            std::memchr(start, 'e', pos_ - start) == nullptr) {
+            return literal(".0");
+        }
+        return true;
+    }
+
+    bool ok() const { return ok_; }
+    char* pos() const { return pos_; }
+
+private:
+    bool fail() {
+        ok_ = false;
+        return false;
+    }
+
+    char* pos_;
+    char* end_;
+    bool ok_ = true;
+};
+
+// ========== Parsing ==========
+
+class Reader {
+public:
+    explicit Reader(const char* text) : pos_(text), end_(text + std::strlen(text)) {}
+
+    void skip_ws() {
+        while (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r') ++pos_;
+    }
+
+    bool consume(char c) {
+        skip_ws();
+        if (*pos_ != c) return false;
+        ++pos_;
+        return true;
+    }
+
+    // Key strings are compared in place; escapes are skipped over, not decoded
+    bool string(const char*& begin, size_t& len) {
+        skip_ws();
+        if (*pos_ != '"') return false;
+        begin = ++pos_;
+        while (*pos_ != '"') {
+            if (*pos_ == '\0') return false;
+            if (*pos_ == '\\') {
+                if (*++pos_ == '\0') return false;
+            }
+            ++pos_;
+        }
+        len = static_cast<size_t>(pos_ - begin);
+        ++pos_;
+        return true;
+    }
+
+    template <typename T>
+    bool integer(T& value) {
+        skip_ws();
+        auto result = std::from_chars(pos_, end_, value);
+        if (result.ec == std::errc() &&
+            *result.ptr != '.' && *result.ptr != 'e' && *result.ptr != 'E') {
+            pos_ = result.ptr;
+            return true;
+        }
+        // Whole numbers written as doubles ("3.0", "1e3") are accepted too
+        double d = 0;
+        if (!number(d) || d != std::floor(d) ||
+            d < static_cast<double>(std::numeric_limits<T>::lowest()) ||
+            d > static_cast<double>(std::numeric_limits<T>::max())) {
+            return false;
+        }
+        value = static_cast<T>(d);
+        return true;
+    }
+
+    bool number(double& value) {
+        skip_ws();
+        if (std::strncmp(pos_, "null", 4) == 0) {
+            value = std::numeric_limits<double>::quiet_NaN();
+            pos_ += 4;
+            return true;
+        }
+        auto result = std::from_chars(pos_, end_, value);
+        if (result.ec != std::errc()) return false;
+        pos_ = result.ptr;
+        return true;
+    }
+
+    // Skips one value of any type, bounded in nesting depth
+    bool skip_value(int depth = 0) {
+        if (depth > 32) return false;
+        skip_ws();
+        const char* begin;
+        size_t len;
+        switch (*pos_) {
+        case '"':
+            return string(begin, len);
+        case '{':
+            ++pos_;
+            if (consume('}')) return true;
+            do {
+                if (!string(begin, len) || !consume(':') || !skip_value(depth + 1)) return false;
+            } while (consume(','));
+            return consume('}');
+        case '[':
+            ++pos_;
+            if (consume(']')) return true;
+            do {
+                if (!skip_value(depth + 1)) return false;
+            } while (consume(','));
+            return consume(']');
+        case 't':
+            return keyword("true");
+        case 'f':
+            return keyword("false");
+        case 'n':
+            return keyword("null");
+        default: {
+            double ignored;
+            return number(ignored);
+        }
+        }
+    }
+
+    bool at_end() {
+        skip_ws();
+        return *pos_ == '\0';
+    }
+
+private:
+    bool keyword(const char* word) {
+        size_t len = std::strlen(word);
+        if (std::strncmp(pos_, word, len) != 0) return false;
+        pos_ += len;
+        return true;
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+bool key_is(const char* begin, size_t len, const char* key) {
+    return std::strlen(key) == len && std::memcmp(begin, key, len) == 0;
+}
+
+} // namespace
+
+size_t encode_sensor_message(char* out, size_t capacity, const SensorData& data, uint64_t sequence,
+                             const StageStamps* stamps) {
+    if (capacity == 0) {
+        return 0;
+    }
+    // Keys in the order nlohmann::json's sorted object map writes them
+    Writer w(out, capacity - 1);
+    w.literal("{\"id\":") && w.integer(data.id) &&
+        w.literal(",\"sequence\":") && w.integer(sequence);
+    if (stamps != nullptr && stamps->present) {
+        w.literal(",\"stamps\":[") && w.integer(stamps->sampled_us) &&
+            w.literal(",") && w.integer(stamps->enqueued_us) &&
+            w.literal(",") && w.integer(stamps->dequeued_us) &&
+            w.literal(",") && w.integer(stamps->written_us) && w.literal("]");
+    }
+    w.literal(",\"timestamp\":") && w.integer(data.timestamp) &&
+        w.literal(",\"value\":") && w.number(data.value) &&
+        w.literal("}");
+    if (!w.ok()) {
+        return 0;
+    }
+    *w.pos() = '\0';
+    return static_cast<size_t>(w.pos() - out);
+}
+
+bool restamp_written(char* message, size_t len, uint64_t written_us) {
+    static constexpr char KEY[] = "\"stamps\":[";
+    if (len == 0) {
+        return false;   // encoding failed; nothing to patch
+    }
+    char* begin = std::strstr(message, KEY);
+    if (begin == nullptr) {
+        return false;
+    }
+    // The written stamp sits between the array's last ',' and its ']'
+    char* close = std::strchr(begin, ']');
+    if (close == nullptr || close > message + len) {
+        return false;
+    }
+    char* digits = close;
+    while (digits > begin && digits[-1] != ',') {
+        --digits;
+    }
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), written_us);
+    size_t width = static_cast<size_t>(result.ptr - text);
+    if (digits == begin || width != static_cast<size_t>(close - digits)) {
+        return false;
+    }
+    std::memcpy(digits, text, width);
+    return true;
+}
+
+size_t encode_rollup_message(char* out, size_t capacity, const SensorData& data, uint64_t sequence,
+                             const RollupFields& rollup) {
+    if (capacity == 0) {
+        return 0;
+    }
+    Writer w(out, capacity - 1);
+    w.literal("{\"count\":") && w.integer(rollup.count) &&
+        w.literal(",\"id\":") && w.integer(data.id) &&
+        w.literal(",\"max\":") && w.number(rollup.max) &&
+        w.literal(",\"min\":") && w.number(rollup.min) &&
+        w.literal(",\"sequence\":") && w.integer(sequence) &&
+        w.literal(",\"sources\":") && w.integer(rollup.sources) &&
+        w.literal(",\"timestamp\":") && w.integer(data.timestamp) &&
+        w.literal(",\"value\":") && w.number(data.value) &&
+        w.literal("}");
+    if (!w.ok()) {
+        return 0;
+    }
+    *w.pos() = '\0';
+    return static_cast<size_t>(w.pos() - out);
+}
+
+bool parse_sensor_message(const char* payload, SensorData& data, uint64_t& sequence,
+                          StageStamps* stamps) {
+    if (stamps != nullptr) {
+        stamps->present = false;
+    }
+    if (payload == nullptr) {
+        return false;
+    }
+    Reader r(payload);
+    if (!r.consume('{')) {
+        return false;
+    }
+
+    enum : unsigned { ID = 1, VALUE = 2, TIMESTAMP = 4, SEQUENCE = 8, ALL = 15 };
+    unsigned seen = 0;
+    if (!r.consume('}')) {
+        do {
+            const char* key;
+            size_t len;
+            if (!r.string(key, len) || !r.consume(':')) {
+                return false;
+            }
+            bool ok;
+            if (key_is(key, len, "id")) {
+                ok = r.integer(data.id);
+                seen |= ID;
+            } else if (key_is(key, len, "value")) {
+                ok = r.number(data.value);
+                seen |= VALUE;
+            } else if (key_is(key, len, "timestamp")) {
+                ok = r.integer(data.timestamp);
+                seen |= TIMESTAMP;
+            } else if (key_is(key, len, "sequence")) {
+                ok = r.integer(sequence);
+                seen |= SEQUENCE;
+            } else if (stamps != nullptr && key_is(key, len, "stamps")) {
+                ok = r.consume('[') &&
+                     r.integer(stamps->sampled_us) && r.consume(',') &&
+                     r.integer(stamps->enqueued_us) && r.consume(',') &&
+                     r.integer(stamps->dequeued_us) && r.consume(',') &&
+                     r.integer(stamps->written_us) && r.consume(']');
+                stamps->present = ok;
+            } else {
+                ok = r.skip_value();
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (r.consume(','));
+        if (!r.consume('}')) {
+            return false;
+        }
+    }
+    return r.at_end() && seen == ALL;
+}
+
+} // namespace telemetry
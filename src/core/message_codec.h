@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "telemetry_types.h"
+
+namespace telemetry {
+
+// Upper bound on an encoded sensor message: four keys with 64-bit values,
+// a shortest-round-trip double and the optional stage stamps. Rollup
+// messages fit as well.
+constexpr size_t MAX_SENSOR_MESSAGE = 256;
+
+// CLOCK_REALTIME in microseconds - the common basis for stage stamps taken
+// in different processes (and, with NTP/PTP-synced clocks, on different hosts).
+inline uint64_t wall_clock_us() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+// Optional per-stage wall-clock stamps (wall_clock_us()) the hub can carry
+// in a message, as "stamps":[sampled,enqueued,dequeued,written].
+struct StageStamps {
+    bool present = false;
+    uint64_t sampled_us = 0;    // value generated by the sensor thread
+    uint64_t enqueued_us = 0;   // pushed onto the hub queue
+    uint64_t dequeued_us = 0;   // popped by the publisher
+    uint64_t written_us = 0;    // encoded and handed to dds_write
+};
+
+// Writes {"id":..,"sequence":..,"timestamp":..,"value":..} into `out`
+// (NUL-terminated) without touching the heap - the same text nlohmann's
+// dump() produces for these fields. With `stamps` (and stamps->present)
+// the "stamps" array is added as well. Returns the length, or 0 if
+// `capacity` is too small.
+size_t encode_sensor_message(char* out, size_t capacity, const SensorData& data, uint64_t sequence,
+                             const StageStamps* stamps = nullptr);
+
+// Overwrites the last ("written") stage stamp of a message produced by
+// encode_sensor_message, so the stamp can be taken after encoding. Only
+// done when `written_us` has as many digits as the stamp it replaces (true
+// of any two wall_clock_us() values a few seconds apart); returns false and
+// leaves the message unchanged otherwise, or if it carries no stamps.
+bool restamp_written(char* message, size_t len, uint64_t written_us);
+
+// Extra fields of a downsampled message (telemetry_aggregator rollups). The
+// message's "value" is the window mean and "timestamp" the window end.
+struct RollupFields {
+    uint64_t count = 0;     // samples in the window
+    double min = 0.0;
+    double max = 0.0;
+    uint32_t sources = 0;   // hubs that contributed
+};
+
+// A sensor message plus "count", "max", "min" and "sources", keys sorted
+// like encode_sensor_message. Readers that only know sensor messages parse
+// it as one and skip the extra keys. Returns the length, or 0 if `capacity`
+// is too small.
+size_t encode_rollup_message(char* out, size_t capacity, const SensorData& data, uint64_t sequence,
+                             const RollupFields& rollup);
+
+// Allocation-free parser for sensor messages. Keys may come in any order
+// and unknown keys (of any JSON type) are skipped, so producers can add
+// fields without breaking older readers. Returns false on malformed input
+// or when id, value, timestamp or sequence is missing. If `stamps` is
+// given, it receives the message's stage stamps (present = false without).
+bool parse_sensor_message(const char* payload, SensorData& data, uint64_t& sequence,
+                          StageStamps* stamps = nullptr);
+
+} // namespace telemetry
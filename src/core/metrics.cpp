@@ -0,0 +1,165 @@
+#include "metrics.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace telemetry {
+
+namespace detail {
+thread_local ThreadSlotCache t_slot_cache;
+} // namespace detail
+
+namespace {
+// Registry ids are never reused, so a thread's cached slots can't be
+// mistaken for those of a later registry at the same address.
+std::atomic<uint64_t> g_next_registry_id{1};
+} // namespace
+
+uint64_t histogram_bucket_lower(size_t bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t sub = bucket % HISTOGRAM_SUB_BUCKETS;
+    return (HISTOGRAM_SUB_BUCKETS + sub) << shift;
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+    if (count == 0 || buckets.empty()) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count) + 0.5);
+    rank = std::max<uint64_t>(1, std::min(rank, count));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(histogram_bucket_lower(i), max);
+        }
+    }
+    return max;
+}
+
+MetricsRegistry::MetricsRegistry() : id_(g_next_registry_id++) {}
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+Counter MetricsRegistry::counter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = counter_names_.find(name);
+    if (it != counter_names_.end()) {
+        return Counter(this, it->second);
+    }
+    if (counter_names_.size() >= MAX_COUNTERS) {
+        throw std::length_error("metrics: too many counters");
+    }
+    uint32_t index = static_cast<uint32_t>(counter_names_.size());
+    counter_names_[name] = index;
+    return Counter(this, index);
+}
+
+Gauge MetricsRegistry::gauge(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& cell = gauges_[name];
+    if (!cell) {
+        cell = std::make_unique<std::atomic<int64_t>>(0);
+    }
+    return Gauge(cell.get());
+}
+
+Histogram MetricsRegistry::histogram(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = histogram_names_.find(name);
+    if (it != histogram_names_.end()) {
+        return Histogram(this, it->second);
+    }
+    if (histogram_names_.size() >= MAX_HISTOGRAMS) {
+        throw std::length_error("metrics: too many histograms");
+    }
+    uint32_t index = static_cast<uint32_t>(histogram_names_.size());
+    histogram_names_[name] = index;
+    return Histogram(this, index);
+}
+
+MetricsRegistry::ThreadSlots& MetricsRegistry::register_thread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThreadSlots*& slots = thread_index_[std::this_thread::get_id()];
+    if (slots == nullptr) {
+        threads_.push_back(std::make_unique<ThreadSlots>());
+        slots = threads_.back().get();
+    }
+    detail::t_slot_cache.registry_id = id_;
+    detail::t_slot_cache.slots = slots;
+    return *slots;
+}
+
+MetricsRegistry::HistogramCells& MetricsRegistry::histogram_cells(ThreadSlots& slots, uint32_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    histogram_cells_.push_back(std::make_unique<HistogramCells>());
+    HistogramCells* cells = histogram_cells_.back().get();
+    slots.histograms[index].store(cells, std::memory_order_release);
+    return *cells;
+}
+
+MetricsSnapshot MetricsRegistry::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MetricsSnapshot snap;
+
+    for (const auto& pair : counter_names_) {
+        uint64_t total = 0;
+        for (const auto& slots : threads_) {
+            total += slots->counters[pair.second].load(std::memory_order_relaxed);
+        }
+        snap.counters[pair.first] = total;
+    }
+
+    for (const auto& pair : gauges_) {
+        snap.gauges[pair.first] = pair.second->load(std::memory_order_relaxed);
+    }
+
+    for (const auto& pair : histogram_names_) {
+        HistogramSnapshot& h = snap.histograms[pair.first];
+        h.buckets.assign(HISTOGRAM_BUCKETS, 0);
+        for (const auto& slots : threads_) {
+            const HistogramCells* cells = slots->histograms[pair.second].load(std::memory_order_acquire);
+            if (cells == nullptr) continue;
+            h.count += cells->count.load(std::memory_order_relaxed);
+            h.sum += cells->sum.load(std::memory_order_relaxed);
+            h.max = std::max(h.max, cells->max.load(std::memory_order_relaxed));
+            for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+                h.buckets[i] += cells->buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return snap;
+}
+
+MetricsRegistry& metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::string format_metrics(const MetricsSnapshot& snapshot, const std::string& indent) {
+    std::ostringstream out;
+    for (const auto& pair : snapshot.counters) {
+        out << indent << pair.first << " " << pair.second << "\n";
+    }
+    for (const auto& pair : snapshot.gauges) {
+        out << indent << pair.first << " " << pair.second << "\n";
+    }
+    for (const auto& pair : snapshot.histograms) {
+        const HistogramSnapshot& h = pair.second;
+        out << indent << pair.first << " count=" << h.count;
+        if (h.count > 0) {
+            out << " mean=" << static_cast<uint64_t>(h.mean())
+                << " p50=" << h.percentile(50)
+                << " p99=" << h.percentile(99)
+                << " max=" << h.max;
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+} // namespace telemetry
@@ -0,0 +1,206 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace telemetry {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Log-linear bucketing: values below 2^SUB_BITS get a bucket each, above
+// that every power of two is split into 2^SUB_BITS equal buckets, so a
+// bucket's width is at most 1/8 of its lower bound.
+constexpr unsigned HISTOGRAM_SUB_BITS = 3;
+constexpr size_t HISTOGRAM_SUB_BUCKETS = size_t{1} << HISTOGRAM_SUB_BITS;
+constexpr size_t HISTOGRAM_BUCKETS = (64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+inline size_t histogram_bucket(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = msb - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS +
+           static_cast<size_t>((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+uint64_t histogram_bucket_lower(size_t bucket);
+
+// Aggregated view of one histogram.
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> buckets;  // HISTOGRAM_BUCKETS entries
+
+    double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+    // Lower bound of the bucket holding the p-th percentile (0 < p <= 100).
+    uint64_t percentile(double p) const;
+};
+
+struct MetricsSnapshot {
+    std::map<std::string, uint64_t> counters;
+    std::map<std::string, int64_t> gauges;
+    std::map<std::string, HistogramSnapshot> histograms;
+};
+
+class MetricsRegistry;
+
+// Metric handles are cheap to copy and stay valid for the registry's
+// lifetime. Recording touches only the calling thread's slots: a relaxed
+// load and store on a cache line no other thread writes.
+class Counter {
+public:
+    Counter() = default;
+    inline void add(uint64_t n = 1) const;
+
+private:
+    friend class MetricsRegistry;
+    Counter(MetricsRegistry* registry, uint32_t index) : registry_(registry), index_(index) {}
+
+    MetricsRegistry* registry_ = nullptr;
+    uint32_t index_ = 0;
+};
+
+class Histogram {
+public:
+    Histogram() = default;
+    inline void record(uint64_t value) const;
+
+private:
+    friend class MetricsRegistry;
+    Histogram(MetricsRegistry* registry, uint32_t index) : registry_(registry), index_(index) {}
+
+    MetricsRegistry* registry_ = nullptr;
+    uint32_t index_ = 0;
+};
+
+// A gauge is a level rather than a sum, so it is a single relaxed atomic
+// that the owning thread overwrites; there is nothing to aggregate.
+class Gauge {
+public:
+    Gauge() = default;
+    void set(int64_t value) const {
+        if (cell_ != nullptr) cell_->store(value, std::memory_order_relaxed);
+    }
+
+private:
+    friend class MetricsRegistry;
+    explicit Gauge(std::atomic<int64_t>* cell) : cell_(cell) {}
+
+    std::atomic<int64_t>* cell_ = nullptr;
+};
+
+// Counters, gauges and histograms with per-thread storage. Registering a
+// metric and a thread's first recording take a lock; everything after that
+// is lock-free and free of shared read-modify-write atomics. snapshot()
+// sums the slots of every thread that ever recorded, including threads
+// that have since exited.
+class MetricsRegistry {
+public:
+    static constexpr size_t MAX_COUNTERS = 256;
+    static constexpr size_t MAX_HISTOGRAMS = 32;
+
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // Registering an existing name returns the same metric. Throws
+    // std::length_error when the fixed slot capacity is exhausted.
+    Counter counter(const std::string& name);
+    Gauge gauge(const std::string& name);
+    Histogram histogram(const std::string& name);
+
+    MetricsSnapshot snapshot() const;
+
+private:
+    friend class Counter;
+    friend class Histogram;
+
+    struct alignas(CACHE_LINE_SIZE) HistogramCells {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+    };
+
+    // One per recording thread. Aligned so two threads never share a line.
+    struct alignas(CACHE_LINE_SIZE) ThreadSlots {
+        std::array<std::atomic<uint64_t>, MAX_COUNTERS> counters{};
+        std::array<std::atomic<HistogramCells*>, MAX_HISTOGRAMS> histograms{};
+    };
+
+    ThreadSlots& local();
+    ThreadSlots& register_thread();
+    HistogramCells& histogram_cells(ThreadSlots& slots, uint32_t index);
+
+    const uint64_t id_;
+    mutable std::mutex mutex_;
+    std::map<std::thread::id, ThreadSlots*> thread_index_;
+    std::map<std::string, uint32_t> counter_names_;
+    std::map<std::string, uint32_t> histogram_names_;
+    std::map<std::string, std::unique_ptr<std::atomic<int64_t>>> gauges_;
+    std::vector<std::unique_ptr<ThreadSlots>> threads_;
+    std::vector<std::unique_ptr<HistogramCells>> histogram_cells_;
+};
+
+// Process-wide registry the apps record into.
+MetricsRegistry& metrics();
+
+// One line per metric, e.g. "  hub.write_ns count=10 mean=812 p50=768 p99=1536 max=2100".
+std::string format_metrics(const MetricsSnapshot& snapshot, const std::string& indent = "  ");
+
+// ========== Inline hot path ==========
+
+namespace detail {
+// Last registry this thread recorded into
+struct ThreadSlotCache {
+    uint64_t registry_id = 0;
+    void* slots = nullptr;
+};
+extern thread_local ThreadSlotCache t_slot_cache;
+
+inline void bump(std::atomic<uint64_t>& cell, uint64_t n) {
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+} // namespace detail
+
+inline MetricsRegistry::ThreadSlots& MetricsRegistry::local() {
+    detail::ThreadSlotCache& cache = detail::t_slot_cache;
+    if (cache.registry_id == id_) {
+        return *static_cast<ThreadSlots*>(cache.slots);
+    }
+    return register_thread();
+}
+
+inline void Counter::add(uint64_t n) const {
+    if (registry_ == nullptr) return;
+    detail::bump(registry_->local().counters[index_], n);
+}
+
+inline void Histogram::record(uint64_t value) const {
+    if (registry_ == nullptr) return;
+    MetricsRegistry::ThreadSlots& slots = registry_->local();
+    MetricsRegistry::HistogramCells* cells =
+        slots.histograms[index_].load(std::memory_order_relaxed);
+    if (cells == nullptr) {
+        cells = &registry_->histogram_cells(slots, index_);
+    }
+    detail::bump(cells->count, 1);
+    detail::bump(cells->sum, value);
+    detail::bump(cells->buckets[histogram_bucket(value)], 1);
+    if (value > cells->max.load(std::memory_order_relaxed)) {
+        cells->max.store(value, std::memory_order_relaxed);
+    }
+}
+
+} // namespace telemetry
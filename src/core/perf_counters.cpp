@@ -0,0 +1,125 @@
+#include "perf_counters.h"
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace telemetry {
+
+namespace {
+
+const uint64_t EVENT_CONFIG[PerfCounters::NUM_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int open_event(uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = group_fd == -1 ? 1 : 0;   // the leader starts the group
+    // User space only: allowed at perf_event_paranoid <= 2 without privileges
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // pid 0 / cpu -1: the calling thread, on whichever CPU it runs
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+uint64_t& field(PerfSample& sample, int event) {
+    switch (event) {
+        case PerfCounters::Cycles:       return sample.cycles;
+        case PerfCounters::Instructions: return sample.instructions;
+        case PerfCounters::CacheMisses:  return sample.cache_misses;
+        default:                         return sample.branch_misses;
+    }
+}
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+    for (int& fd : fds_) {
+        fd = -1;
+    }
+    fds_[Cycles] = open_event(EVENT_CONFIG[Cycles], -1);
+    if (fds_[Cycles] < 0) {
+        fds_[Cycles] = -1;
+        return;
+    }
+    // Members the PMU can't provide are simply left out of the group
+    for (int e = Instructions; e < NUM_EVENTS; ++e) {
+        int fd = open_event(EVENT_CONFIG[e], fds_[Cycles]);
+        fds_[e] = fd >= 0 ? fd : -1;
+    }
+    ioctl(fds_[Cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounters::~PerfCounters() {
+    // Members first, then the leader
+    for (int e = NUM_EVENTS - 1; e >= 0; --e) {
+        if (fds_[e] >= 0) {
+            close(fds_[e]);
+        }
+    }
+}
+
+PerfSample PerfCounters::read() const {
+    PerfSample sample;
+    if (!available()) {
+        return sample;
+    }
+    // PERF_FORMAT_GROUP: { nr, values[nr] } in the order the events were opened
+    uint64_t buffer[1 + NUM_EVENTS] = {};
+    if (::read(fds_[Cycles], buffer, sizeof(buffer)) <= 0) {
+        return sample;
+    }
+    uint64_t index = 0;
+    for (int e = Cycles; e < NUM_EVENTS && index < buffer[0]; ++e) {
+        if (fds_[e] >= 0) {
+            field(sample, e) = buffer[1 + index++];
+        }
+    }
+    return sample;
+}
+
+// ========== PerfRegion ==========
+
+void PerfRegion::end() {
+    PerfSample now = counters_.read();
+    totals_.cycles += now.cycles - start_.cycles;
+    totals_.instructions += now.instructions - start_.instructions;
+    totals_.cache_misses += now.cache_misses - start_.cache_misses;
+    totals_.branch_misses += now.branch_misses - start_.branch_misses;
+    ++iterations_;
+}
+
+std::string PerfRegion::summary() const {
+    if (!available()) {
+        return name_ + ": perf counters unavailable (check kernel.perf_event_paranoid)";
+    }
+    if (iterations_ == 0) {
+        return name_ + ": no iterations";
+    }
+    double n = static_cast<double>(iterations_);
+    double ipc = totals_.cycles > 0
+        ? static_cast<double>(totals_.instructions) / static_cast<double>(totals_.cycles) : 0.0;
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%s: %.0f cycles, %.0f instructions (IPC %.2f), %.2f cache misses, "
+                  "%.2f branch misses per iteration (%llu iterations)",
+                  name_.c_str(), static_cast<double>(totals_.cycles) / n,
+                  static_cast<double>(totals_.instructions) / n, ipc,
+                  static_cast<double>(totals_.cache_misses) / n,
+                  static_cast<double>(totals_.branch_misses) / n,
+                  static_cast<unsigned long long>(iterations_));
+    return line;
+}
+
+} // namespace telemetry
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace telemetry {
+
+// Hardware counter values (user space only). A counter the CPU/kernel
+// doesn't offer stays 0 and is flagged in PerfCounters::has().
+struct PerfSample {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+};
+
+// One perf_event_open group counting cycles, instructions, cache misses
+// and branch misses for the thread that constructed it. When perf events
+// are not permitted (kernel.perf_event_paranoid, containers without
+// CAP_PERFMON, VMs without a PMU) available() is false and read() returns
+// zeros, so callers never need a separate code path.
+class PerfCounters {
+public:
+    enum Event { Cycles, Instructions, CacheMisses, BranchMisses, NUM_EVENTS };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return fds_[Cycles] >= 0; }
+    bool has(Event event) const { return fds_[event] >= 0; }
+
+    // Running totals since construction (one read() syscall).
+    PerfSample read() const;
+
+private:
+    int fds_[NUM_EVENTS];
+};
+
+// Accumulates counts over repeated executions of a region on one thread:
+//
+//   telemetry::PerfRegion publish("publish");
+//   { telemetry::PerfScope scope(publish); ... }
+//   std::cout << publish.summary();   // per-iteration averages
+//
+// Bracketing costs two read() syscalls (~1-2 us), so the apps only do it
+// with --perf.
+class PerfRegion {
+public:
+    explicit PerfRegion(std::string name) : name_(std::move(name)) {}
+
+    void begin() { start_ = counters_.read(); }
+    void end();
+
+    bool available() const { return counters_.available(); }
+    uint64_t iterations() const { return iterations_; }
+    const PerfSample& totals() const { return totals_; }
+
+    // "<name>: 1234 cycles, 2345 instructions (IPC 1.90), 3.1 cache misses,
+    // 0.8 branch misses per iteration (N iterations)", or a note that
+    // counters are unavailable.
+    std::string summary() const;
+
+private:
+    std::string name_;
+    PerfCounters counters_;
+    PerfSample start_;
+    PerfSample totals_;
+    uint64_t iterations_ = 0;
+};
+
+// Brackets one iteration of a region; a null region makes it a no-op.
+class PerfScope {
+public:
+    explicit PerfScope(PerfRegion* region) : region_(region) {
+        if (region_ != nullptr) region_->begin();
+    }
+    explicit PerfScope(PerfRegion& region) : PerfScope(&region) {}
+    ~PerfScope() {
+        if (region_ != nullptr) region_->end();
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    PerfRegion* region_;
+};
+
+} // namespace telemetry
@@ -0,0 +1,64 @@
+#include "sensor_state.h"
+
+namespace telemetry {
+
+// ========== SequenceWindow ==========
+
+bool SequenceWindow::mark(uint64_t sequence) {
+    if (!started_) {
+        started_ = true;
+        next_ = sequence + 1;
+        set(sequence);
+        return true;
+    }
+    if (sequence >= next_) {
+        // Slide forward: slots between the old and new head are unseen
+        uint64_t gap = sequence - next_;
+        if (gap >= WINDOW) {
+            bits_.fill(0);
+        } else {
+            for (uint64_t s = next_; s < sequence; ++s) {
+                clear(s);
+            }
+        }
+        set(sequence);
+        next_ = sequence + 1;
+        return true;
+    }
+    if (next_ - sequence > WINDOW || test(sequence)) {
+        return false;
+    }
+    set(sequence);
+    return true;
+}
+
+// ========== SensorState ==========
+
+bool SensorState::ingest(double value, uint64_t timestamp, uint64_t sequence, uint64_t now_ms) {
+    if (!seen.mark(sequence)) {
+        return false;
+    }
+
+    if (!initialized) {
+        expected_seq = sequence;
+        initialized = true;
+    } else if (sequence > expected_seq) {
+        dropped_count += sequence - expected_seq;
+    }
+
+    if (sequence >= expected_seq) {
+        expected_seq = sequence + 1;
+        current_value = value;
+        last_timestamp = timestamp;
+    }
+    message_count++;
+    last_received_ms = now_ms;
+
+    if (value < min_value) min_value = value;
+    if (value > max_value) max_value = value;
+    sum_value += value;
+
+    return true;
+}
+
+} // namespace telemetry
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace telemetry {
+
+// Which of the last WINDOW sequences below the next expected one have been
+// seen: a fixed bitmap that slides forward as sequences arrive, so duplicate
+// detection costs no allocation and no memory growth however long a sensor
+// runs. Sequences further back than the window can't be told apart from
+// duplicates and are reported as seen.
+class SequenceWindow {
+public:
+    static constexpr uint64_t WINDOW = 1024;
+
+    // Marks `sequence` seen. Returns false if it already was (or is too old).
+    bool mark(uint64_t sequence);
+
+    // One past the highest sequence seen
+    uint64_t next() const { return next_; }
+
+private:
+    static constexpr uint64_t WORD_BITS = 64;
+
+    bool test(uint64_t sequence) const {
+        return (bits_[(sequence % WINDOW) / WORD_BITS] >> (sequence % WORD_BITS)) & 1;
+    }
+    void set(uint64_t sequence) {
+        bits_[(sequence % WINDOW) / WORD_BITS] |= uint64_t{1} << (sequence % WORD_BITS);
+    }
+    void clear(uint64_t sequence) {
+        bits_[(sequence % WINDOW) / WORD_BITS] &= ~(uint64_t{1} << (sequence % WORD_BITS));
+    }
+
+    std::array<uint64_t, WINDOW / WORD_BITS> bits_{};
+    uint64_t next_ = 0;
+    bool started_ = false;
+};
+
+// What the monitor tracks per sensor id: value statistics, message counts
+// and sequence gaps, with duplicates filtered out.
+struct SensorState {
+    uint64_t expected_seq = 0;
+    uint64_t message_count = 0;
+    uint64_t dropped_count = 0;
+
+    double current_value = 0.0;
+    double min_value = 1e9;
+    double max_value = -1e9;
+    double sum_value = 0.0;
+
+    uint64_t last_timestamp = 0;
+    uint64_t last_received_ms = 0;
+    bool initialized = false;
+
+    SequenceWindow seen;
+
+    // Applies one sample. Returns false for a duplicate. Never allocates.
+    bool ingest(double value, uint64_t timestamp, uint64_t sequence, uint64_t now_ms);
+};
+
+} // namespace telemetry
@@ -0,0 +1,275 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+#include "trace.h"
+
+namespace telemetry {
+
+namespace {
+
+// Spins (with yield) before a worker parks on the condition variable, so
+// bursts of short tasks don't pay a futex wake per task.
+constexpr int SPIN_ROUNDS = 64;
+
+thread_local const ThreadPool* t_pool = nullptr;
+thread_local int t_worker = -1;
+
+} // namespace
+
+// ========== ThreadPool ==========
+
+ThreadPool::ThreadPool(size_t threads, std::string name, bool pin_to_cpus) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Every worker exists before any thread starts, since workers steal
+    // from each other from their first iteration
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; ++i) {
+        std::string label = name + "-" + std::to_string(i);
+        workers_[i]->thread = std::thread(&ThreadPool::run, this, i, label);
+        if (pin_to_cpus) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(static_cast<int>(i % cpus), &set);
+            pthread_setaffinity_np(workers_[i]->thread.native_handle(), sizeof(set), &set);
+        }
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void ThreadPool::submit(Task task, int affinity) {
+    TaskNode* node = new TaskNode{std::move(task)};
+    // Counted before it is visible, so a worker never sees it as negative
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+
+    int self = current_worker();
+    if (self >= 0) {
+        workers_[static_cast<size_t>(self)]->deque.push(node);
+    } else {
+        size_t index = affinity >= 0
+            ? static_cast<size_t>(affinity) % workers_.size()
+            : static_cast<size_t>(next_inbox_.fetch_add(1, std::memory_order_relaxed) % workers_.size());
+        Worker& target = *workers_[index];
+        std::lock_guard<std::mutex> lock(target.inbox_mutex);
+        target.inbox.push_back(node);
+    }
+    wake_one();
+}
+
+void ThreadPool::wake_one() {
+    // Pairs with the sleepers_ increment in run(): either the worker sees
+    // queued_ > 0 before parking, or we see it parked and notify
+    if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        wake_.notify_one();
+    }
+}
+
+int ThreadPool::current_worker() const {
+    return t_pool == this ? t_worker : -1;
+}
+
+ThreadPool::TaskNode* ThreadPool::take_inbox(Worker& worker) {
+    std::lock_guard<std::mutex> lock(worker.inbox_mutex);
+    if (worker.inbox.empty()) {
+        return nullptr;
+    }
+    TaskNode* node = worker.inbox.front();
+    worker.inbox.pop_front();
+    return node;
+}
+
+ThreadPool::TaskNode* ThreadPool::find_task(int self, bool& stolen) {
+    TaskNode* node = nullptr;
+    stolen = false;
+    if (self >= 0) {
+        Worker& own = *workers_[static_cast<size_t>(self)];
+        if (!own.deque.pop(node)) {
+            node = take_inbox(own);
+        }
+    }
+    if (node == nullptr) {
+        size_t n = workers_.size();
+        size_t start = self >= 0 ? static_cast<size_t>(self) + 1
+                                 : static_cast<size_t>(next_inbox_.load(std::memory_order_relaxed));
+        for (size_t k = 0; k < n && node == nullptr; ++k) {
+            size_t victim = (start + k) % n;
+            if (static_cast<int>(victim) == self) {
+                continue;
+            }
+            if (!workers_[victim]->deque.steal(node)) {
+                node = take_inbox(*workers_[victim]);
+            }
+        }
+        stolen = node != nullptr;
+    }
+    if (node != nullptr) {
+        queued_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+    return node;
+}
+
+void ThreadPool::execute(TaskNode* node) {
+    try {
+        node->fn();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Thread pool task threw: " << e.what() << "\n";
+    } catch (...) {
+        std::cerr << "[ERROR] Thread pool task threw an unknown exception\n";
+    }
+    delete node;
+}
+
+void ThreadPool::run(size_t index, const std::string& name) {
+    t_pool = this;
+    t_worker = static_cast<int>(index);
+    set_trace_thread_name(name);
+    Worker& self = *workers_[index];
+
+    while (true) {
+        bool stolen = false;
+        TaskNode* node = find_task(static_cast<int>(index), stolen);
+        for (int spin = 0; node == nullptr && spin < SPIN_ROUNDS; ++spin) {
+            std::this_thread::yield();
+            node = find_task(static_cast<int>(index), stolen);
+        }
+        if (node != nullptr) {
+            execute(node);
+            self.executed.fetch_add(1, std::memory_order_relaxed);
+            if (stolen) {
+                self.stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        while (queued_.load(std::memory_order_seq_cst) <= 0 && !stopping_) {
+            wake_.wait(lock);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+        if (stopping_ && queued_.load(std::memory_order_seq_cst) <= 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::run_until(const std::function<bool()>& done) {
+    int self = current_worker();
+    while (!done()) {
+        bool stolen = false;
+        TaskNode* node = find_task(self, stolen);
+        if (node == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+        execute(node);
+        if (self < 0) {
+            helped_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            Worker& worker = *workers_[static_cast<size_t>(self)];
+            worker.executed.fetch_add(1, std::memory_order_relaxed);
+            if (stolen) {
+                worker.stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+    Stats stats;
+    for (const auto& worker : workers_) {
+        stats.executed += worker->executed.load(std::memory_order_relaxed);
+        stats.stolen += worker->stolen.load(std::memory_order_relaxed);
+    }
+    stats.helped = helped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ThreadPool& thread_pool() {
+    static ThreadPool instance;
+    return instance;
+}
+
+// ========== parallel_for ==========
+
+namespace {
+
+struct ForState {
+    ForState(ThreadPool& pool, const std::function<void(size_t, size_t)>& fn, size_t grain)
+        : pool(pool), fn(fn), grain(grain) {}
+
+    ThreadPool& pool;
+    const std::function<void(size_t, size_t)>& fn;
+    size_t grain;
+    std::atomic<size_t> pending{1};   // the root range
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+// Hands the upper half to the pool until the rest fits in one grain, then
+// runs it. Thieves take from the top of a deque, i.e. the biggest halves.
+void run_range(ForState* state, size_t lo, size_t hi) {
+    while (hi - lo > state->grain) {
+        size_t mid = lo + (hi - lo) / 2;
+        state->pending.fetch_add(1, std::memory_order_relaxed);
+        state->pool.submit([state, mid, hi] { run_range(state, mid, hi); });
+        hi = mid;
+    }
+    try {
+        state->fn(lo, hi);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(state->error_mutex);
+        if (!state->error) {
+            state->error = std::current_exception();
+        }
+    }
+    // Last touch of *state: the caller may return as soon as this hits 0
+    state->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+} // namespace
+
+void parallel_for(ThreadPool& pool, size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& fn) {
+    if (begin >= end) {
+        return;
+    }
+    if (grain == 0) {
+        // About 8 chunks per worker: enough slack for stealing to balance
+        grain = std::max<size_t>(1, (end - begin) / (pool.size() * 8));
+    }
+    if (end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+
+    ForState state(pool, fn, grain);
+    run_range(&state, begin, end);
+    pool.run_until([&state] { return state.pending.load(std::memory_order_acquire) == 0; });
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+}
+
+} // namespace telemetry
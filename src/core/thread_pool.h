@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "work_stealing_deque.h"
+
+namespace telemetry {
+
+// Work-stealing executor for batch work: parallel parsing, sharded stats,
+// encoding, compaction, scans. Each worker owns a Chase-Lev deque; tasks
+// submitted from a worker go onto its own deque (LIFO, cache-warm), idle
+// workers steal from the other end. Tasks submitted from outside the pool
+// land in a worker's inbox - the one named by the affinity hint, otherwise
+// round robin - and may still be stolen by an idle worker.
+//
+//   telemetry::parallel_for(telemetry::thread_pool(), 0, rows.size(), 1024,
+//                           [&](size_t lo, size_t hi) { parse(rows, lo, hi); });
+//
+// Not for the per-message hot loops: those stay on their dedicated threads.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    struct Stats {
+        uint64_t executed = 0;   // tasks run by workers
+        uint64_t stolen = 0;     // of those, taken from another worker
+        uint64_t helped = 0;     // tasks run by waiting non-worker threads
+    };
+
+    // `threads` = 0 means std::thread::hardware_concurrency(). Workers are
+    // named "<name>-<i>"; with `pin_to_cpus`, worker i is pinned to CPU i
+    // (modulo the CPU count).
+    explicit ThreadPool(size_t threads = 0, std::string name = "pool", bool pin_to_cpus = false);
+    // Runs whatever is still queued, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    // `affinity` (a worker index, taken modulo size()) is a hint for tasks
+    // submitted from outside the pool; tasks submitted by a worker always
+    // start on that worker's deque.
+    void submit(Task task, int affinity = -1);
+
+    // Runs queued tasks on the calling thread until `done` returns true, so
+    // a thread waiting on pool work (including a worker, for nested
+    // parallelism) helps instead of blocking.
+    void run_until(const std::function<bool()>& done);
+
+    // Index of the calling thread in this pool, or -1.
+    int current_worker() const;
+
+    Stats stats() const;
+
+private:
+    struct TaskNode {
+        Task fn;
+    };
+
+    struct alignas(64) Worker {
+        WorkStealingDeque<TaskNode*> deque;
+        std::mutex inbox_mutex;
+        std::deque<TaskNode*> inbox;
+        std::thread thread;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+    };
+
+    void run(size_t index, const std::string& name);
+    // Own deque, own inbox, then the other workers. `self` is -1 for
+    // non-worker threads. `stolen` reports whether the task came from
+    // another worker.
+    TaskNode* find_task(int self, bool& stolen);
+    TaskNode* take_inbox(Worker& worker);
+    void execute(TaskNode* node);
+    void wake_one();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<int64_t> queued_{0};         // submitted, not yet taken
+    std::atomic<uint64_t> next_inbox_{0};
+    std::atomic<uint64_t> helped_{0};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+};
+
+// Process-wide pool (hardware_concurrency workers, started on first use)
+// for apps and tools that don't need one of their own.
+ThreadPool& thread_pool();
+
+// Calls fn(lo, hi) over disjoint chunks covering [begin, end), each at most
+// `grain` long (0 picks one from the pool size), on the pool and the calling
+// thread. The range is split recursively, so idle workers steal large halves
+// rather than many small chunks. Returns when every chunk has run; the first
+// exception thrown by fn is rethrown here.
+void parallel_for(ThreadPool& pool, size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& fn);
+
+} // namespace telemetry
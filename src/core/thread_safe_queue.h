@@ -3,6 +3,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
 
 template <typename T>
 class ThreadSafeQueue {
@@ -40,6 +41,33 @@ public:
         return true;
     }
 
+    // Waits up to `timeout` for data. Returns false on timeout or when stopped and drained.
+    template <typename Rep, typename Period>
+    bool pop_for(T& value, std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cond_var_.wait_for(lock, timeout, [this] {
+                return !queue_.empty() || stopped_;
+            })) {
+            return false;
+        }
+        if (queue_.empty()) {
+            return false; // stopped and drained
+        }
+        value = queue_.front();
+        queue_.pop();
+        return true;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.empty();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
     // Signals all waiting threads to stop
     void stop() {
         stopped_ = true;
@@ -0,0 +1,245 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace telemetry {
+
+namespace detail {
+std::atomic<bool> g_tracing_enabled{false};
+} // namespace detail
+
+namespace {
+
+// end == 0 marks an instant event
+struct TraceEvent {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> start{0};
+    std::atomic<uint64_t> end{0};
+};
+
+// Single-writer ring: only the owning thread stores events and advances
+// head; the dump thread reads behind it.
+struct ThreadRing {
+    std::unique_ptr<TraceEvent[]> events;
+    uint64_t mask = 0;
+    std::atomic<uint64_t> head{0};
+    uint32_t tid = 0;
+    std::string name;   // guarded by g_mutex
+};
+
+std::mutex g_mutex;
+std::vector<std::unique_ptr<ThreadRing>> g_rings;
+size_t g_ring_capacity = 65536;
+
+// Pairs of (trace clock, steady ns) taken at enable time, for converting
+// ticks to microseconds
+uint64_t g_origin_ticks = 0;
+uint64_t g_origin_ns = 0;
+
+std::atomic<bool> g_dump_requested{false};
+
+thread_local ThreadRing* t_ring = nullptr;
+thread_local std::string t_thread_name;
+
+uint64_t steady_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+ThreadRing& local_ring() {
+    if (t_ring != nullptr) {
+        return *t_ring;
+    }
+    auto ring = std::make_unique<ThreadRing>();
+    ring->tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    ring->name = t_thread_name;
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    size_t capacity = 1;
+    while (capacity < g_ring_capacity) {
+        capacity <<= 1;
+    }
+    ring->events.reset(new TraceEvent[capacity]);
+    ring->mask = capacity - 1;
+    t_ring = ring.get();
+    g_rings.push_back(std::move(ring));
+    return *t_ring;
+}
+
+void record(const char* name, uint64_t start, uint64_t end) {
+    ThreadRing& ring = local_ring();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    TraceEvent& e = ring.events[head & ring.mask];
+    e.name.store(name, std::memory_order_relaxed);
+    e.start.store(start, std::memory_order_relaxed);
+    e.end.store(end, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+struct CopiedEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Copies what the ring still holds, dropping slots the writer may have
+// overwritten while we were reading.
+std::vector<CopiedEvent> copy_ring(const ThreadRing& ring) {
+    uint64_t capacity = ring.mask + 1;
+    uint64_t head = ring.head.load(std::memory_order_acquire);
+    uint64_t first = head > capacity ? head - capacity : 0;
+
+    std::vector<CopiedEvent> events;
+    events.reserve(static_cast<size_t>(head - first));
+    for (uint64_t i = first; i < head; ++i) {
+        const TraceEvent& e = ring.events[i & ring.mask];
+        events.push_back({e.name.load(std::memory_order_relaxed),
+                          e.start.load(std::memory_order_relaxed),
+                          e.end.load(std::memory_order_relaxed)});
+    }
+
+    uint64_t after = ring.head.load(std::memory_order_acquire);
+    uint64_t valid_from = after >= capacity ? after - capacity + 1 : 0;
+    if (valid_from > first) {
+        size_t stale = static_cast<size_t>(std::min(valid_from - first, head - first));
+        events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(stale));
+    }
+    return events;
+}
+
+void handle_dump_signal(int) {
+    g_dump_requested = true;
+}
+
+} // namespace
+
+void enable_tracing(size_t events_per_thread) {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_ring_capacity = events_per_thread == 0 ? 1 : events_per_thread;
+        g_origin_ticks = trace_clock();
+        g_origin_ns = steady_ns();
+    }
+    detail::g_tracing_enabled.store(true, std::memory_order_release);
+}
+
+void disable_tracing() {
+    detail::g_tracing_enabled.store(false, std::memory_order_release);
+}
+
+void set_trace_thread_name(const std::string& name) {
+    // Also the OS thread name (top -H, perf, the control socket's "threads"),
+    // limited to 15 characters. Not for the main thread: its name is the
+    // process name that ps/pidof/killall match on.
+    if (syscall(SYS_gettid) != getpid()) {
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    }
+    t_thread_name = name;
+    if (t_ring != nullptr) {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        t_ring->name = name;
+    }
+}
+
+void trace_complete(const char* name, uint64_t start, uint64_t end) {
+    record(name, start, end == 0 ? 1 : end);
+}
+
+void trace_instant(const char* name) {
+    record(name, trace_clock(), 0);
+}
+
+bool write_chrome_trace(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    // Calibrate ticks per microsecond over the whole recording window, with
+    // a short wait if tracing was only just enabled
+    uint64_t now_ticks = trace_clock();
+    uint64_t now_ns = steady_ns();
+    if (now_ns - g_origin_ns < 10000000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        now_ticks = trace_clock();
+        now_ns = steady_ns();
+    }
+    double ticks_per_us = static_cast<double>(now_ticks - g_origin_ticks) * 1000.0 /
+                          static_cast<double>(now_ns - g_origin_ns);
+    if (ticks_per_us <= 0) {
+        ticks_per_us = 1000.0;
+    }
+    auto to_us = [&](uint64_t ticks) {
+        return (static_cast<double>(ticks) - static_cast<double>(g_origin_ticks)) / ticks_per_us;
+    };
+
+    const long pid = static_cast<long>(getpid());
+    bool first = true;
+    auto separator = [&]() -> std::ostream& {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        return out;
+    };
+
+    out << "{\"traceEvents\":[";
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for (const auto& ring : g_rings) {
+        if (!ring->name.empty()) {
+            separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+                        << ",\"tid\":" << ring->tid << ",\"args\":{\"name\":";
+            write_json_string(out, ring->name);
+            out << "}}";
+        }
+
+        for (const auto& e : copy_ring(*ring)) {
+            if (e.name == nullptr) continue;
+            separator() << "{\"name\":";
+            write_json_string(out, e.name);
+            if (e.end == 0) {
+                out << ",\"ph\":\"i\",\"s\":\"t\",\"ts\":" << to_us(e.start);
+            } else {
+                out << ",\"ph\":\"X\",\"ts\":" << to_us(e.start)
+                    << ",\"dur\":" << static_cast<double>(e.end - e.start) / ticks_per_us;
+            }
+            out << ",\"pid\":" << pid << ",\"tid\":" << ring->tid << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return static_cast<bool>(out);
+}
+
+void install_trace_dump_signal(int signo) {
+    std::signal(signo, handle_dump_signal);
+}
+
+bool trace_dump_requested() {
+    return g_dump_requested.exchange(false);
+}
+
+} // namespace telemetry
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Trace points are compiled in unless the build sets TELEMETRY_TRACING=0
+// (CMake option TELEMETRY_ENABLE_TRACING). Compiled-in trace points cost a
+// relaxed load and a branch until tracing is enabled at runtime.
+#ifndef TELEMETRY_TRACING
+#define TELEMETRY_TRACING 1
+#endif
+
+namespace telemetry {
+
+// Raw trace clock: the TSC on x86, steady_clock nanoseconds elsewhere.
+// Converted to microseconds when the trace is written.
+inline uint64_t trace_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+namespace detail {
+extern std::atomic<bool> g_tracing_enabled;
+} // namespace detail
+
+inline bool tracing_enabled() {
+    return detail::g_tracing_enabled.load(std::memory_order_relaxed);
+}
+
+// Starts recording. Each thread gets a ring of `events_per_thread` events
+// (rounded up to a power of two) on its first event; when it wraps, the
+// oldest events are overwritten.
+void enable_tracing(size_t events_per_thread = 65536);
+void disable_tracing();
+
+// Label for the calling thread in the trace viewer; also set as the OS
+// thread name (first 15 characters) except on the main thread.
+void set_trace_thread_name(const std::string& name);
+
+// `name` must outlive the trace (string literals).
+void trace_complete(const char* name, uint64_t start, uint64_t end);
+void trace_instant(const char* name);
+
+// Writes every thread's ring as Chrome trace-event JSON (loadable in
+// chrome://tracing and Perfetto). Safe to call while threads are recording;
+// events overwritten during the copy are left out.
+bool write_chrome_trace(const std::string& path);
+
+// Makes `signo` request a trace dump (the apps use SIGUSR1). The handler
+// only sets a flag; the apps poll trace_dump_requested() from their main loops.
+void install_trace_dump_signal(int signo);
+bool trace_dump_requested();
+
+// Records one complete ("X") event covering its lifetime.
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : name_(name), start_(tracing_enabled() ? trace_clock() : 0) {}
+    ~TraceScope() {
+        if (start_ != 0) {
+            trace_complete(name_, start_, trace_clock());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+};
+
+} // namespace telemetry
+
+#define TELEMETRY_TRACE_CONCAT_(a, b) a##b
+#define TELEMETRY_TRACE_CONCAT(a, b) TELEMETRY_TRACE_CONCAT_(a, b)
+
+#if TELEMETRY_TRACING
+#define TRACE_SCOPE(name) \
+    ::telemetry::TraceScope TELEMETRY_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_INSTANT(name) \
+    do { if (::telemetry::tracing_enabled()) ::telemetry::trace_instant(name); } while (0)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#endif
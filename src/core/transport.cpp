@@ -0,0 +1,250 @@
+#include "transport.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "async_console.h"
+#include "config.h"
+
+namespace telemetry {
+
+bool parse_transport(const std::string& name, Transport& transport) {
+    if (name == "dds") {
+        transport = Transport::Dds;
+    } else if (name == "udp") {
+        transport = Transport::Udp;
+    } else if (name == "inproc") {
+        transport = Transport::InProcess;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* transport_name(Transport transport) {
+    switch (transport) {
+        case Transport::Dds: return "dds";
+        case Transport::Udp: return "udp";
+        case Transport::InProcess: return "inproc";
+    }
+    return "unknown";
+}
+
+// ========== DdsPublisher ==========
+
+bool DdsPublisher::open(bool per_type_topics) {
+    per_type_ = per_type_topics;
+    if (!per_type_) {
+        writer_ = dds_.create_writer();
+        if (writer_ < 0) {
+            std::cerr << "[ERROR] Failed to create DDS writer\n";
+            return false;
+        }
+        writers_.push_back(writer_);
+        health_.watch_writer(writer_, prefix_);
+        std::cout << "[DDS] Writer created (" << qos_profile_name(dds_.profile()) << ", "
+                  << partition_label(dds_.partitions()) << ")\n";
+        return true;
+    }
+    const TelemetryConfig& config = config_store().current();
+    for (const auto& type : config.sensor_types()) {
+        if (create_type_writer(type) < 0) {
+            std::cerr << "[ERROR] Failed to create DDS writer for '" << sensor_topic_name(type) << "'\n";
+            return false;
+        }
+        std::cout << "[DDS] Writer created on '" << sensor_topic_name(type) << "' ("
+                  << qos_profile_name(config.topic_profile(type, dds_.profile())) << ", "
+                  << partition_label(dds_.partitions()) << ")\n";
+    }
+    return true;
+}
+
+dds_entity_t DdsPublisher::create_type_writer(const std::string& type) {
+    dds_entity_t topic = dds_.sensor_topic(type);
+    QosProfile profile = config_store().current().topic_profile(type, dds_.profile());
+    dds_entity_t created = topic > 0 ? dds_.create_writer(topic, profile) : topic;
+    if (created > 0) {
+        type_writers_[type] = created;
+        writers_.push_back(created);
+        health_.watch_writer(created, prefix_ + "." + type);
+    }
+    return created;
+}
+
+dds_entity_t DdsPublisher::writer_for(int sensor_id) {
+    if (!per_type_) {
+        return writer_;
+    }
+    // A reload may have moved sensors to other types; look them up again
+    uint64_t version = config_store().version();
+    if (version != config_version_) {
+        sensor_writers_.clear();
+        config_version_ = version;
+    }
+    auto cached = sensor_writers_.find(sensor_id);
+    if (cached != sensor_writers_.end()) {
+        return cached->second;
+    }
+    const SensorConfig* sensor = config_store().current().find_sensor(sensor_id);
+    if (sensor == nullptr) {
+        return DDS_RETCODE_BAD_PARAMETER;
+    }
+    std::string type = sensor->topic_type();
+    auto existing = type_writers_.find(type);
+    dds_entity_t found = existing != type_writers_.end() ? existing->second : create_type_writer(type);
+    if (found > 0) {
+        sensor_writers_[sensor_id] = found;
+        if (existing == type_writers_.end()) {
+            log_out() << "[DDS] Writer created on '" << sensor_topic_name(type) << "' ("
+                      << qos_profile_name(config_store().current().topic_profile(type, dds_.profile())) << ")";
+        }
+    }
+    return found;
+}
+
+dds_return_t DdsPublisher::publish(const TelemetrySample& sample, const char* payload, size_t) {
+    dds_entity_t writer = writer_for(sample.data.id);
+    if (writer <= 0) {
+        return writer;
+    }
+    // dds_write copies the payload while serializing, so it can point
+    // straight at the caller's (arena) memory
+    Telemetry_JsonMessage msg;
+    msg.payload = const_cast<char*>(payload);
+    return dds_write(writer, &msg);
+}
+
+void DdsPublisher::flush() {
+    for (dds_entity_t writer : writers_) {
+        dds_.flush(writer);
+    }
+}
+
+// ========== UdpPublisher ==========
+
+dds_return_t UdpPublisher::publish(const TelemetrySample&, const char* payload, size_t len) {
+    return sender_.send(payload, len) ? DDS_RETCODE_OK : DDS_RETCODE_ERROR;
+}
+
+// ========== DdsSubscriber ==========
+
+void DdsSubscriber::release() {
+    if (loaned_from_ > 0) {
+        dds_return_loan(loaned_from_, samples_, 1);
+        loaned_from_ = 0;
+    }
+}
+
+bool DdsSubscriber::take(ReceivedMessage& message) {
+    release();
+    while (true) {
+        std::memset(&msg_, 0, sizeof(msg_));
+        dds_entity_t reader = 0;
+        if (readers_.take(samples_, infos_, 1, 1, reader) <= 0) {
+            return false;
+        }
+        loaned_from_ = reader;
+        if (infos_[0].valid_data) {
+            break;
+        }
+        release();   // dispose/unregister notification, no data
+    }
+    message.decoded = false;
+    message.payload = msg_.payload;
+    message.len = msg_.payload != nullptr ? std::strlen(msg_.payload) : 0;
+    return true;
+}
+
+// ========== UdpSubscriber ==========
+
+bool UdpSubscriber::take(ReceivedMessage& message) {
+    message.decoded = false;
+    return receiver_.take(message.payload, message.len);
+}
+
+// ========== InProcessBus ==========
+
+std::shared_ptr<InProcessBus::Queue> InProcessBus::subscribe(const std::string& name, size_t capacity,
+                                                             OverflowPolicy policy) {
+    auto queue = std::make_shared<Queue>(capacity, policy);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto next = std::make_shared<SubscriptionList>(*subscriptions_);
+    next->push_back({queue, metrics().counter("inproc." + name + ".dropped")});
+    subscriptions_ = std::move(next);
+    return queue;
+}
+
+void InProcessBus::unsubscribe(const std::shared_ptr<Queue>& queue) {
+    queue->stop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto next = std::make_shared<SubscriptionList>();
+    for (const auto& subscription : *subscriptions_) {
+        if (subscription.queue != queue) {
+            next->push_back(subscription);
+        }
+    }
+    subscriptions_ = std::move(next);
+}
+
+void InProcessBus::publish(const TelemetrySample& sample) {
+    std::shared_ptr<const SubscriptionList> current;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current = subscriptions_;
+    }
+    for (const auto& subscription : *current) {
+        if (!subscription.queue->push(sample) && !subscription.queue->stopped()) {
+            subscription.dropped.add();
+        }
+    }
+}
+
+size_t InProcessBus::subscribers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscriptions_->size();
+}
+
+size_t InProcessBus::pending() const {
+    std::shared_ptr<const SubscriptionList> current;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current = subscriptions_;
+    }
+    size_t total = 0;
+    for (const auto& subscription : *current) {
+        total += subscription.queue->size();
+    }
+    return total;
+}
+
+InProcessBus& inprocess_bus() {
+    static InProcessBus bus;
+    return bus;
+}
+
+// ========== InProcessPublisher / InProcessSubscriber ==========
+
+dds_return_t InProcessPublisher::publish(const TelemetrySample& sample, const char*, size_t) {
+    bus_.publish(sample);
+    return DDS_RETCODE_OK;
+}
+
+InProcessSubscriber::InProcessSubscriber(InProcessBus& bus, const std::string& name,
+                                         OverflowPolicy policy, size_t capacity)
+    : bus_(bus), queue_(bus.subscribe(name, capacity, policy)) {}
+
+InProcessSubscriber::~InProcessSubscriber() {
+    bus_.unsubscribe(queue_);
+}
+
+bool InProcessSubscriber::take(ReceivedMessage& message) {
+    if (!queue_->pop_for(message.sample, std::chrono::milliseconds(0))) {
+        return false;
+    }
+    message.decoded = true;
+    message.payload = nullptr;
+    message.len = 0;
+    return true;
+}
+
+} // namespace telemetry
@@ -0,0 +1,216 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <dds/dds.h>
+#include "telemetry.h"
+
+#include "bounded_queue.h"
+#include "dds_bootstrap.h"
+#include "dds_health.h"
+#include "message_codec.h"
+#include "metrics.h"
+#include "telemetry_types.h"
+#include "udp_transport.h"
+
+namespace telemetry {
+
+// How the hub reaches the monitor and logger. DDS and UDP carry encoded
+// messages between processes; InProcess hands decoded samples between
+// components of one process (telemetry_all) through in-memory queues, with
+// no encoding, parsing or middleware in between.
+enum class Transport { Dds, Udp, InProcess };
+
+// Accepts "dds", "udp" and "inproc".
+bool parse_transport(const std::string& name, Transport& transport);
+const char* transport_name(Transport transport);
+
+// One sensor sample with its per-sensor sequence, as the hub publishes it
+struct TelemetrySample {
+    SensorData data{};
+    uint64_t sequence = 0;
+    StageStamps stamps;
+};
+
+// ========== PUBLISHING ==========
+
+class TelemetryPublisher {
+public:
+    virtual ~TelemetryPublisher() = default;
+
+    // False when the transport takes samples as they are, so the caller can
+    // skip encoding.
+    virtual bool wants_payload() const { return true; }
+    // Sends one sample. `payload` is its encode_sensor_message() form, or
+    // null when wants_payload() is false. Returns DDS_RETCODE_OK or an error.
+    virtual dds_return_t publish(const TelemetrySample& sample, const char* payload, size_t len) = 0;
+    // Pushes out anything batched.
+    virtual void flush() {}
+};
+
+// Writes to the session's telemetry topic, or in per-type mode to
+// lab_telemetry/<type> with the type's topic_qos profile. Writers for types
+// that first appear on a config reload are created on first publish, and a
+// reload that moves a sensor to another type moves its samples with it.
+class DdsPublisher : public TelemetryPublisher {
+public:
+    // Writers report to `health` under <prefix> (<prefix>.<type> per type)
+    DdsPublisher(DdsSession& dds, DdsHealth& health, std::string health_prefix)
+        : dds_(dds), health_(health), prefix_(std::move(health_prefix)) {}
+
+    // Creates the startup writers, printing them in the apps' "[DDS]" style.
+    bool open(bool per_type_topics);
+
+    dds_return_t publish(const TelemetrySample& sample, const char* payload, size_t len) override;
+    void flush() override;
+
+private:
+    dds_entity_t create_type_writer(const std::string& type);
+    dds_entity_t writer_for(int sensor_id);
+
+    DdsSession& dds_;
+    DdsHealth& health_;
+    std::string prefix_;
+    bool per_type_ = false;
+    dds_entity_t writer_ = 0;                          // shared mode
+    std::vector<dds_entity_t> writers_;                // every writer, for flushing
+    std::map<std::string, dds_entity_t> type_writers_;
+    std::map<int, dds_entity_t> sensor_writers_;       // by sensor id, for config_version_
+    uint64_t config_version_ = 0;
+};
+
+class UdpPublisher : public TelemetryPublisher {
+public:
+    explicit UdpPublisher(UdpSender& sender) : sender_(sender) {}
+
+    dds_return_t publish(const TelemetrySample& sample, const char* payload, size_t len) override;
+    void flush() override { sender_.flush(); }
+
+private:
+    UdpSender& sender_;
+};
+
+// ========== SUBSCRIBING ==========
+
+// One message from take(). Wire transports leave the encoded message in
+// `payload` (NUL-terminated, valid until the next take()) for the caller to
+// parse into `sample`; in-process delivery fills `sample` and sets decoded.
+struct ReceivedMessage {
+    const char* payload = nullptr;
+    size_t len = 0;
+    bool decoded = false;
+    TelemetrySample sample;
+};
+
+class TelemetrySubscriber {
+public:
+    virtual ~TelemetrySubscriber() = default;
+
+    // Next message without blocking; false when nothing is queued.
+    virtual bool take(ReceivedMessage& message) = 0;
+};
+
+// Takes from a ReaderSet one sample at a time. The sample's loan is
+// returned on the next take(), so delete the subscriber before the session.
+class DdsSubscriber : public TelemetrySubscriber {
+public:
+    explicit DdsSubscriber(ReaderSet readers) : readers_(std::move(readers)) {}
+    ~DdsSubscriber() override { release(); }
+
+    DdsSubscriber(const DdsSubscriber&) = delete;
+    DdsSubscriber& operator=(const DdsSubscriber&) = delete;
+
+    bool take(ReceivedMessage& message) override;
+
+private:
+    void release();
+
+    ReaderSet readers_;
+    Telemetry_JsonMessage msg_{};
+    void* samples_[1] = {&msg_};
+    dds_sample_info_t infos_[1];
+    dds_entity_t loaned_from_ = 0;
+};
+
+class UdpSubscriber : public TelemetrySubscriber {
+public:
+    explicit UdpSubscriber(UdpReceiver& receiver) : receiver_(receiver) {}
+
+    bool take(ReceivedMessage& message) override;
+
+private:
+    UdpReceiver& receiver_;
+};
+
+// ========== IN-PROCESS ==========
+
+// Default depth of a subscriber's queue
+constexpr size_t INPROCESS_QUEUE_CAPACITY = 4096;
+
+// Fan-out between components of one process: publish() copies the sample
+// into every subscriber's bounded queue, whose overflow policy decides
+// between backpressure on the publisher (Block) and dropping. Samples
+// published before a subscriber joins are not replayed to it.
+class InProcessBus {
+public:
+    using Queue = BoundedQueue<TelemetrySample>;
+
+    // Drops on the subscriber's queue are counted in inproc.<name>.dropped.
+    std::shared_ptr<Queue> subscribe(const std::string& name, size_t capacity, OverflowPolicy policy);
+    // Stops the queue, so a publisher blocked on it carries on.
+    void unsubscribe(const std::shared_ptr<Queue>& queue);
+
+    void publish(const TelemetrySample& sample);
+    size_t subscribers() const;
+    // Samples queued across all subscribers, not yet taken
+    size_t pending() const;
+
+private:
+    struct Subscription {
+        std::shared_ptr<Queue> queue;
+        Counter dropped;
+    };
+    using SubscriptionList = std::vector<Subscription>;
+
+    // Replaced, never modified, so publish() pushes without holding the lock
+    mutable std::mutex mutex_;
+    std::shared_ptr<const SubscriptionList> subscriptions_ = std::make_shared<SubscriptionList>();
+};
+
+// Process-wide bus the components of telemetry_all share.
+InProcessBus& inprocess_bus();
+
+class InProcessPublisher : public TelemetryPublisher {
+public:
+    explicit InProcessPublisher(InProcessBus& bus) : bus_(bus) {}
+
+    bool wants_payload() const override { return false; }
+    dds_return_t publish(const TelemetrySample& sample, const char* payload, size_t len) override;
+
+private:
+    InProcessBus& bus_;
+};
+
+// Subscribes on construction and unsubscribes on destruction.
+class InProcessSubscriber : public TelemetrySubscriber {
+public:
+    InProcessSubscriber(InProcessBus& bus, const std::string& name,
+                        OverflowPolicy policy, size_t capacity = INPROCESS_QUEUE_CAPACITY);
+    ~InProcessSubscriber() override;
+
+    InProcessSubscriber(const InProcessSubscriber&) = delete;
+    InProcessSubscriber& operator=(const InProcessSubscriber&) = delete;
+
+    bool take(ReceivedMessage& message) override;
+
+private:
+    InProcessBus& bus_;
+    std::shared_ptr<InProcessBus::Queue> queue_;
+};
+
+} // namespace telemetry
@@ -0,0 +1,460 @@
+#include "udp_transport.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <random>
+#include <unistd.h>
+
+namespace telemetry {
+
+namespace {
+
+// Socket buffers asked for; the kernel caps them at net.core.{w,r}mem_max
+constexpr int SEND_BUFFER_BYTES = 4 << 20;
+constexpr int RECEIVE_BUFFER_BYTES = 8 << 20;
+
+// One GSO send is a single UDP datagram to the stack: at most 64 segments
+// and 64 KiB in total
+constexpr size_t GSO_MAX_SEGMENTS = 64;
+constexpr size_t GSO_MAX_BYTES = 65507;
+
+void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+void put_u64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint16_t get_u16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t get_u32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+uint64_t get_u64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+// Errors that mean "no GSO here" rather than a failed send
+bool gso_unsupported(int error) {
+    return error == EIO || error == EINVAL || error == EOPNOTSUPP || error == ENOPROTOOPT;
+}
+
+} // namespace
+
+// ========== Addresses ==========
+
+bool parse_udp_address(const std::string& text, const char* default_host, sockaddr_in& addr) {
+    size_t colon = text.rfind(':');
+    std::string host = colon == std::string::npos ? "" : text.substr(0, colon);
+    std::string port = colon == std::string::npos ? text : text.substr(colon + 1);
+    if (host.empty()) {
+        host = default_host;
+    }
+    if (port.empty() || port.size() > 5 || port.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long number = std::stoul(port);
+    if (number == 0 || number > 65535) {
+        return false;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (::getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+        return false;
+    }
+    addr = *reinterpret_cast<const sockaddr_in*>(result->ai_addr);
+    addr.sin_port = htons(static_cast<uint16_t>(number));
+    ::freeaddrinfo(result);
+    return true;
+}
+
+std::string format_udp_address(const sockaddr_in& addr) {
+    char host[INET_ADDRSTRLEN] = "?";
+    ::inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+    return std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+// ========== Frames ==========
+
+bool decode_udp_frame(const uint8_t* data, size_t len, UdpFrameHeader& header,
+                      std::vector<std::pair<size_t, size_t>>& records) {
+    records.clear();
+    if (len < UDP_FRAME_HEADER || get_u32(data) != UDP_FRAME_MAGIC) {
+        return false;
+    }
+    header.sender = get_u32(data + 4);
+    header.sequence = get_u64(data + 8);
+    header.records = get_u16(data + 16);
+
+    size_t offset = UDP_FRAME_HEADER;
+    for (uint16_t i = 0; i < header.records; ++i) {
+        if (offset + UDP_RECORD_HEADER > len) {
+            return false;
+        }
+        size_t record_len = get_u16(data + offset);
+        offset += UDP_RECORD_HEADER;
+        if (offset + record_len > len) {
+            return false;
+        }
+        records.emplace_back(offset, record_len);
+        offset += record_len;
+    }
+    return true;
+}
+
+void FrameLossTracker::record(uint32_t sender, uint64_t sequence) {
+    auto it = next_.find(sender);
+    if (it == next_.end()) {
+        next_.emplace(sender, sequence + 1);
+    } else if (sequence < it->second) {
+        reordered_++;
+    } else {
+        lost_ += sequence - it->second;
+        it->second = sequence + 1;
+    }
+}
+
+// ========== UdpSender ==========
+
+UdpSender::~UdpSender() {
+    close();
+}
+
+bool UdpSender::open(const std::vector<sockaddr_in>& targets, const UdpSenderOptions& options,
+                     const std::string& metric_prefix) {
+    if (targets.empty()) {
+        std::cerr << "[ERROR] UDP sender needs at least one target\n";
+        return false;
+    }
+    fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        std::cerr << "[ERROR] Failed to create UDP socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    int sndbuf = SEND_BUFFER_BYTES;
+    ::setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    targets_ = targets;
+    stride_ = std::clamp(options.max_datagram, UDP_FRAME_HEADER + UDP_RECORD_HEADER + 1, UDP_MAX_DATAGRAM);
+    batch_frames_ = std::max<size_t>(1, options.batch_frames);
+    sender_id_ = std::random_device{}();
+    next_sequence_ = 0;
+
+    // With UDP_SEGMENT on the socket, a send longer than stride_ leaves the
+    // stack as stride_-sized datagrams, so a batch of frames laid out at
+    // stride_ offsets goes out in one call per target
+    gso_ = false;
+#ifdef UDP_SEGMENT
+    if (options.gso) {
+        int segment = static_cast<int>(stride_);
+        gso_ = ::setsockopt(fd_, SOL_UDP, UDP_SEGMENT, &segment, sizeof(segment)) == 0;
+    }
+#endif
+
+    frames_.assign(batch_frames_ * stride_, 0);
+    lengths_.clear();
+    lengths_.reserve(batch_frames_);
+    open_len_ = 0;
+    messages_.resize(batch_frames_ * targets_.size());
+    iovecs_.resize(batch_frames_ * targets_.size());
+
+    records_counter_ = metrics().counter(metric_prefix + ".records");
+    frames_counter_ = metrics().counter(metric_prefix + ".frames");
+    syscalls_counter_ = metrics().counter(metric_prefix + ".syscalls");
+    errors_counter_ = metrics().counter(metric_prefix + ".send_errors");
+    return true;
+}
+
+void UdpSender::close() {
+    if (fd_ >= 0) {
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool UdpSender::send(const char* payload, size_t len) {
+    size_t record = UDP_RECORD_HEADER + len;
+    if (UDP_FRAME_HEADER + record > stride_) {
+        stats_.oversized++;
+        errors_counter_.add();
+        return false;
+    }
+    bool ok = true;
+    if (open_len_ > 0 && open_len_ + record > stride_) {
+        seal();
+        if (lengths_.size() == batch_frames_) {
+            ok = send_batch();
+        }
+    }
+    if (open_len_ == 0) {
+        open_len_ = UDP_FRAME_HEADER;
+        open_records_ = 0;
+    }
+    uint8_t* frame = frames_.data() + lengths_.size() * stride_;
+    put_u16(frame + open_len_, static_cast<uint16_t>(len));
+    std::memcpy(frame + open_len_ + UDP_RECORD_HEADER, payload, len);
+    open_len_ += record;
+    open_records_++;
+    stats_.records++;
+    records_counter_.add();
+    return ok;
+}
+
+bool UdpSender::flush() {
+    seal();
+    return lengths_.empty() || send_batch();
+}
+
+void UdpSender::seal() {
+    if (open_len_ == 0) {
+        return;
+    }
+    uint8_t* frame = frames_.data() + lengths_.size() * stride_;
+    put_u32(frame, UDP_FRAME_MAGIC);
+    put_u32(frame + 4, sender_id_);
+    put_u64(frame + 8, next_sequence_++);
+    put_u16(frame + 16, open_records_);
+    put_u16(frame + 18, 0);
+    if (gso_) {
+        // Padding up to the segment size; stale bytes would leak old frames
+        std::memset(frame + open_len_, 0, stride_ - open_len_);
+    }
+    lengths_.push_back(open_len_);
+    open_len_ = 0;
+    stats_.frames++;
+    frames_counter_.add();
+}
+
+bool UdpSender::send_batch() {
+    bool ok = gso_ ? send_gso() : send_mmsg();
+    lengths_.clear();
+    return ok;
+}
+
+bool UdpSender::send_gso() {
+    size_t per_send = std::min({batch_frames_, GSO_MAX_SEGMENTS, GSO_MAX_BYTES / stride_});
+    for (size_t t = 0; t < targets_.size(); ++t) {
+        for (size_t first = 0; first < lengths_.size(); first += per_send) {
+            size_t count = std::min(per_send, lengths_.size() - first);
+            iovec iov{frames_.data() + first * stride_, (count - 1) * stride_ + lengths_[first + count - 1]};
+            msghdr msg{};
+            msg.msg_name = &targets_[t];
+            msg.msg_namelen = sizeof(sockaddr_in);
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            ssize_t sent = ::sendmsg(fd_, &msg, 0);
+            stats_.syscalls++;
+            syscalls_counter_.add();
+            if (sent < 0 && gso_unsupported(errno) && count > 1) {
+                // No segmentation offload on this path: switch to sendmmsg
+                // for the rest of this batch and from now on
+#ifdef UDP_SEGMENT
+                int off = 0;
+                ::setsockopt(fd_, SOL_UDP, UDP_SEGMENT, &off, sizeof(off));
+#endif
+                gso_ = false;
+                return send_mmsg_from(t, first);
+            }
+            if (sent < 0) {
+                stats_.send_errors += count;
+                errors_counter_.add(count);
+                continue;
+            }
+            stats_.datagrams += count;
+        }
+    }
+    return true;
+}
+
+bool UdpSender::send_mmsg() {
+    return send_mmsg_from(0, 0);
+}
+
+bool UdpSender::send_mmsg_from(size_t first_target, size_t first_frame) {
+    size_t count = 0;
+    for (size_t t = first_target; t < targets_.size(); ++t) {
+        for (size_t f = (t == first_target ? first_frame : 0); f < lengths_.size(); ++f) {
+            iovecs_[count] = iovec{frames_.data() + f * stride_, lengths_[f]};
+            msghdr& hdr = messages_[count].msg_hdr;
+            hdr = msghdr{};
+            hdr.msg_name = &targets_[t];
+            hdr.msg_namelen = sizeof(sockaddr_in);
+            hdr.msg_iov = &iovecs_[count];
+            hdr.msg_iovlen = 1;
+            count++;
+        }
+    }
+
+    size_t sent = 0;
+    while (sent < count) {
+        int n = ::sendmmsg(fd_, messages_.data() + sent, static_cast<unsigned>(count - sent), 0);
+        stats_.syscalls++;
+        syscalls_counter_.add();
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Loss-tolerant by design: drop the rest of the batch
+            stats_.send_errors += count - sent;
+            errors_counter_.add(count - sent);
+            stats_.datagrams += sent;
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    stats_.datagrams += sent;
+    return true;
+}
+
+// ========== UdpReceiver ==========
+
+UdpReceiver::~UdpReceiver() {
+    close();
+}
+
+bool UdpReceiver::open(const sockaddr_in& address, const std::string& metric_prefix, size_t batch) {
+    fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        std::cerr << "[ERROR] Failed to create UDP socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int rcvbuf = RECEIVE_BUFFER_BYTES;
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (::bind(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "[ERROR] Failed to bind UDP " << format_udp_address(address) << ": "
+                  << std::strerror(errno) << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    batch_ = std::max<size_t>(1, batch);
+    // One spare byte per slot, so the last record can be NUL-terminated
+    size_t slot = UDP_MAX_DATAGRAM + 1;
+    buffers_.assign(batch_ * slot, 0);
+    messages_.assign(batch_, mmsghdr{});
+    iovecs_.resize(batch_);
+    for (size_t i = 0; i < batch_; ++i) {
+        iovecs_[i] = iovec{buffers_.data() + i * slot, UDP_MAX_DATAGRAM};
+        messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+        messages_[i].msg_hdr.msg_iovlen = 1;
+    }
+    received_ = datagram_ = 0;
+    records_.clear();
+    record_ = 0;
+
+    records_counter_ = metrics().counter(metric_prefix + ".records");
+    lost_counter_ = metrics().counter(metric_prefix + ".frames_lost");
+    malformed_counter_ = metrics().counter(metric_prefix + ".malformed");
+    return true;
+}
+
+void UdpReceiver::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+sockaddr_in UdpReceiver::local_address() const {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    return addr;
+}
+
+bool UdpReceiver::take(const char*& payload, size_t& len) {
+    while (record_ >= records_.size()) {
+        if (!next_datagram() && !(receive_batch() && next_datagram())) {
+            return false;
+        }
+    }
+    payload = reinterpret_cast<const char*>(current_ + records_[record_].first);
+    len = records_[record_].second;
+    record_++;
+    stats_.records++;
+    records_counter_.add();
+    return true;
+}
+
+bool UdpReceiver::wait(int timeout_ms) {
+    if (record_ < records_.size() || datagram_ < received_) {
+        return true;
+    }
+    pollfd pfd{fd_, POLLIN, 0};
+    return ::poll(&pfd, 1, timeout_ms) > 0;
+}
+
+bool UdpReceiver::receive_batch() {
+    if (fd_ < 0) {
+        return false;
+    }
+    int n = ::recvmmsg(fd_, messages_.data(), static_cast<unsigned>(batch_), MSG_DONTWAIT, nullptr);
+    if (n <= 0) {
+        return false;
+    }
+    stats_.syscalls++;
+    received_ = static_cast<size_t>(n);
+    datagram_ = 0;
+    return true;
+}
+
+bool UdpReceiver::next_datagram() {
+    while (datagram_ < received_) {
+        size_t index = datagram_++;
+        uint8_t* data = buffers_.data() + index * (UDP_MAX_DATAGRAM + 1);
+        size_t len = messages_[index].msg_len;
+        stats_.datagrams++;
+
+        UdpFrameHeader header;
+        if ((messages_[index].msg_hdr.msg_flags & MSG_TRUNC) || !decode_udp_frame(data, len, header, records_)) {
+            stats_.malformed++;
+            malformed_counter_.add();
+            records_.clear();
+            continue;
+        }
+        uint64_t lost_before = loss_.lost();
+        loss_.record(header.sender, header.sequence);
+        lost_counter_.add(loss_.lost() - lost_before);
+        stats_.frames_lost = loss_.lost();
+        stats_.frames_reordered = loss_.reordered();
+
+        // Terminate each payload in place: the byte after a record is the
+        // next record's length, already decoded, or the spare byte
+        for (const auto& [offset, record_len] : records_) {
+            data[offset + record_len] = '\0';
+        }
+        current_ = data;
+        record_ = 0;
+        if (!records_.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace telemetry
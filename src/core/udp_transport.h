@@ -0,0 +1,205 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "metrics.h"
+
+namespace telemetry {
+
+// Batched UDP alternative to DDS for high-rate, loss-tolerant streams. The
+// hub packs encoded sensor messages into frames, one frame per datagram,
+// and sends a batch of frames per system call (sendmmsg, or one GSO send
+// where the kernel supports UDP_SEGMENT). Receivers drain up to a batch of
+// datagrams per recvmmsg. There is no retransmission: each frame carries a
+// per-sender sequence number, so the receiver counts lost frames, and the
+// per-sensor sequences inside the messages show gaps downstream.
+//
+// Frame layout, little-endian:
+//
+//   u32 magic | u32 sender id | u64 frame sequence | u16 records | u16 reserved
+//   then per record: u16 length | payload bytes
+//
+// Point-to-point: a hub sends every frame to each of its targets.
+
+constexpr uint32_t UDP_FRAME_MAGIC = 0x314d4c54;   // "TLM1"
+constexpr size_t UDP_FRAME_HEADER = 20;
+constexpr size_t UDP_RECORD_HEADER = 2;
+// Ethernet MTU minus IP and UDP headers: frames are never fragmented
+constexpr size_t UDP_DEFAULT_DATAGRAM = 1472;
+// Largest frame either side handles (jumbo frames, or loopback)
+constexpr size_t UDP_MAX_DATAGRAM = 9216;
+// Where the monitor and logger listen by default, and the hub sends
+constexpr uint16_t UDP_MONITOR_PORT = 17401;
+constexpr uint16_t UDP_LOGGER_PORT = 17402;
+
+// "host:port", ":port" or "port"; a missing host means `default_host`.
+// Hosts go through getaddrinfo (IPv4 only).
+bool parse_udp_address(const std::string& text, const char* default_host, sockaddr_in& addr);
+std::string format_udp_address(const sockaddr_in& addr);
+
+struct UdpFrameHeader {
+    uint32_t sender = 0;
+    uint64_t sequence = 0;
+    uint16_t records = 0;
+};
+
+// Reads a frame's header and record boundaries (offset, length) into
+// `records`. False for anything malformed: wrong magic, short frame, or
+// records running past `len`. Bytes after the last record are ignored
+// (GSO padding).
+bool decode_udp_frame(const uint8_t* data, size_t len, UdpFrameHeader& header,
+                      std::vector<std::pair<size_t, size_t>>& records);
+
+// Frame-sequence bookkeeping per sender. A sequence past the next expected
+// one counts the frames in between as lost; an earlier one (reordering or
+// duplicates) is counted but still delivered, since the per-sensor
+// sequences deduplicate downstream.
+class FrameLossTracker {
+public:
+    void record(uint32_t sender, uint64_t sequence);
+
+    uint64_t lost() const { return lost_; }
+    uint64_t reordered() const { return reordered_; }
+    size_t senders() const { return next_.size(); }
+
+private:
+    std::map<uint32_t, uint64_t> next_;
+    uint64_t lost_ = 0;
+    uint64_t reordered_ = 0;
+};
+
+struct UdpSenderOptions {
+    size_t max_datagram = UDP_DEFAULT_DATAGRAM;   // frame size limit, at most UDP_MAX_DATAGRAM
+    size_t batch_frames = 32;                     // full frames that trigger a send
+    bool gso = true;                              // use UDP_SEGMENT when available
+};
+
+struct UdpSenderStats {
+    uint64_t records = 0;
+    uint64_t frames = 0;
+    uint64_t datagrams = 0;       // frames x targets
+    uint64_t syscalls = 0;
+    uint64_t send_errors = 0;     // datagrams not sent
+    uint64_t oversized = 0;       // records larger than a frame, dropped
+};
+
+// Single-threaded (the hub's publish loop).
+class UdpSender {
+public:
+    UdpSender() = default;
+    ~UdpSender();
+
+    UdpSender(const UdpSender&) = delete;
+    UdpSender& operator=(const UdpSender&) = delete;
+
+    // Metrics go to <prefix>.records/.frames/.syscalls/.send_errors. Prints
+    // errors in the apps' "[ERROR]" style.
+    bool open(const std::vector<sockaddr_in>& targets, const UdpSenderOptions& options,
+              const std::string& metric_prefix);
+    void close();
+
+    // Appends one record to the current frame, sending the batch once
+    // batch_frames frames are full. False if the record was dropped
+    // (oversized) or the send failed.
+    bool send(const char* payload, size_t len);
+    // Sends the partial frame and anything queued.
+    bool flush();
+
+    bool gso_active() const { return gso_; }
+    const UdpSenderStats& stats() const { return stats_; }
+
+private:
+    void seal();
+    bool send_batch();
+    bool send_gso();
+    bool send_mmsg();
+    // Frames from `first_frame` to `first_target`, then all frames to the
+    // targets after it
+    bool send_mmsg_from(size_t first_target, size_t first_frame);
+
+    int fd_ = -1;
+    std::vector<sockaddr_in> targets_;
+    size_t stride_ = UDP_DEFAULT_DATAGRAM;
+    size_t batch_frames_ = 32;
+    bool gso_ = false;
+    uint32_t sender_id_ = 0;
+    uint64_t next_sequence_ = 0;
+
+    std::vector<uint8_t> frames_;       // batch_frames slots of stride_ bytes
+    std::vector<size_t> lengths_;       // sealed frame lengths
+    size_t open_len_ = 0;               // bytes in the frame being filled, 0 = none
+    uint16_t open_records_ = 0;
+
+    std::vector<struct mmsghdr> messages_;
+    std::vector<struct iovec> iovecs_;
+
+    UdpSenderStats stats_;
+    Counter records_counter_;
+    Counter frames_counter_;
+    Counter syscalls_counter_;
+    Counter errors_counter_;
+};
+
+struct UdpReceiverStats {
+    uint64_t datagrams = 0;
+    uint64_t records = 0;
+    uint64_t syscalls = 0;        // recvmmsg calls that returned data
+    uint64_t malformed = 0;       // datagrams dropped (bad frame or truncated)
+    uint64_t frames_lost = 0;
+    uint64_t frames_reordered = 0;
+};
+
+// Single-threaded (the consumer's ingest loop).
+class UdpReceiver {
+public:
+    UdpReceiver() = default;
+    ~UdpReceiver();
+
+    UdpReceiver(const UdpReceiver&) = delete;
+    UdpReceiver& operator=(const UdpReceiver&) = delete;
+
+    // Binds `address` and asks for a large receive buffer; bursts beyond
+    // it are lost. Metrics go to <prefix>.records/.frames_lost/.malformed.
+    bool open(const sockaddr_in& address, const std::string& metric_prefix, size_t batch = 32);
+    void close();
+
+    // Next record, without blocking. The payload is NUL-terminated in the
+    // receiver's buffer and valid until the next take(). False when nothing
+    // is queued.
+    bool take(const char*& payload, size_t& len);
+    // Waits up to timeout_ms for data; true if there is something to take.
+    bool wait(int timeout_ms);
+
+    // The bound address, with the port the kernel picked for port 0
+    sockaddr_in local_address() const;
+    const UdpReceiverStats& stats() const { return stats_; }
+
+private:
+    bool next_datagram();
+    bool receive_batch();
+
+    int fd_ = -1;
+    size_t batch_ = 32;
+    std::vector<uint8_t> buffers_;      // batch_ slots of UDP_MAX_DATAGRAM + 1
+    std::vector<struct mmsghdr> messages_;
+    std::vector<struct iovec> iovecs_;
+    size_t received_ = 0;               // datagrams from the last recvmmsg
+    size_t datagram_ = 0;               // next one to decode
+    std::vector<std::pair<size_t, size_t>> records_;
+    size_t record_ = 0;
+    uint8_t* current_ = nullptr;        // datagram the records point into
+    FrameLossTracker loss_;
+
+    UdpReceiverStats stats_;
+    Counter records_counter_;
+    Counter lost_counter_;
+    Counter malformed_counter_;
+};
+
+} // namespace telemetry
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace telemetry {
+
+// Chase-Lev work-stealing deque (the C11 formulation by Le, Pop, Cohen and
+// Zappa Nardelli). One owner thread pushes and pops at the bottom, LIFO,
+// without contention; any other thread may steal from the top, FIFO, with
+// one CAS. T must be trivially copyable (ThreadPool stores pointers).
+//
+// When full, push() grows the ring. The old array is retired instead of
+// freed, because a thief may still be reading from it - the same trade
+// ConfigStore makes. Arrays only double, so the retired total stays below
+// the live one.
+template <typename T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacity = 256) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        arrays_.push_back(std::make_unique<Array>(rounded));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only.
+    void push(T item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only. Returns false when empty (or the last item was stolen).
+    bool pop(T& item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = a->get(b);
+        if (t == b) {
+            // Last item: race the thieves for it
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread. Returns false when empty or when it lost a race.
+    bool steal(T& item) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        Array* a = array_.load(std::memory_order_acquire);
+        T candidate = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        item = candidate;
+        return true;
+    }
+
+    // Approximate when called concurrently.
+    size_t size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    size_t capacity() const { return array_.load(std::memory_order_relaxed)->capacity; }
+
+private:
+    struct Array {
+        explicit Array(size_t n) : capacity(n), mask(n - 1), slots(new std::atomic<T>[n]) {}
+
+        T get(int64_t i) const { return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T item) { slots[static_cast<size_t>(i) & mask].store(item, std::memory_order_relaxed); }
+
+        const size_t capacity;
+        const size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Array* grow(Array* old, int64_t top, int64_t bottom) {
+        arrays_.push_back(std::make_unique<Array>(old->capacity * 2));
+        Array* bigger = arrays_.back().get();
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        array_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};      // thieves
+    alignas(64) std::atomic<int64_t> bottom_{0};   // owner
+    std::atomic<Array*> array_{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_;   // live + retired, owner only
+};
+
+} // namespace telemetry
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../src/core/alloc_accounting.h"
+#include "../src/core/bounded_queue.h"
+#include "../src/core/buffer_pool.h"
+#include "../src/core/log_sink.h"
+#include "../src/core/log_sinks.h"
+#include "../src/core/message_codec.h"
+#include "../src/core/metrics.h"
+#include "../src/core/sensor_state.h"
+#include "../src/core/transport.h"
+
+using namespace telemetry;
+
+// This binary links telemetry_alloc_hooks, so every operator new below is
+// counted. The hot-path tests run a warm-up pass first (arena blocks,
+// per-thread metric slots, the time zone) and then assert that the
+// steady state performs no allocations at all.
+
+namespace {
+
+constexpr int WARMUP = 100;
+constexpr int MESSAGES = 1000;
+
+SensorData make_sample(int id, double value, long timestamp) {
+    SensorData data;
+    data.id = id;
+    data.value = value;
+    data.timestamp = timestamp;
+    return data;
+}
+
+// Accepts everything and keeps nothing, so only the ingest side is measured.
+class NullSink : public LogSink {
+public:
+    const char* name() const override { return "null"; }
+    bool open() override { return true; }
+    void write(const LogRecord&) override {}
+    void flush() override {}
+    void close() override {}
+};
+
+} // namespace
+
+// ========== Accounting ==========
+
+TEST(AllocAccountingTest, CountsAllocationsOnThisThread) {
+    ASSERT_TRUE(alloc_accounting_enabled());
+
+    AllocCounts before = thread_alloc_counts();
+    auto value = std::make_unique<uint64_t>(42);
+    // Keep the compiler from eliding the new/delete pair
+    asm volatile("" : : "g"(value.get()) : "memory");
+    value.reset();
+    AllocCounts after = thread_alloc_counts();
+
+    EXPECT_EQ(after.allocations - before.allocations, 1u);
+    EXPECT_EQ(after.deallocations - before.deallocations, 1u);
+    EXPECT_EQ(after.bytes - before.bytes, sizeof(uint64_t));
+}
+
+TEST(AllocAccountingTest, OtherThreadsAreNotCounted) {
+    AllocCounts before = thread_alloc_counts();
+    uint64_t worker_allocations = 0;
+    std::thread worker([&] {
+        AllocCounts start = thread_alloc_counts();
+        std::vector<int> values(1000);
+        worker_allocations = thread_alloc_counts().allocations - start.allocations;
+    });
+    worker.join();   // std::thread's own state is allocated on this thread
+    AllocCounts after_join = thread_alloc_counts();
+
+    EXPECT_EQ(worker_allocations, 1u);
+    // The vector's bytes were charged to the worker, not to us
+    EXPECT_LT(after_join.bytes - before.bytes, 1000 * sizeof(int));
+}
+
+TEST(AllocRegionTest, AveragesOverIterations) {
+    AllocRegion region("strings");
+    for (int i = 0; i < 10; ++i) {
+        AllocScope scope(region);
+        std::string text(100, 'x');   // past the SSO buffer
+    }
+    {
+        AllocScope disabled(nullptr);   // not counted
+        std::string text(100, 'x');
+    }
+
+    EXPECT_EQ(region.iterations(), 10u);
+    EXPECT_EQ(region.totals().allocations, 10u);
+    std::string summary = region.summary();
+    EXPECT_EQ(summary.rfind("strings: 1.00 allocations", 0), 0u) << summary;
+    EXPECT_NE(summary.find("(10 iterations)"), std::string::npos) << summary;
+}
+
+// ========== Hot paths ==========
+
+// Sensor hub publish loop: a sensor thread's push into the sample ring, the
+// publisher's pop, encode into the per-message arena with the "written"
+// restamp, the stage histograms, and the arena release.
+TEST(HotPathAllocationTest, HubPublishLoopDoesNotAllocate) {
+    BoundedQueue<TelemetrySample> queue(64, OverflowPolicy::Block);
+    Arena arena;
+    Histogram encode_ns = metrics().histogram("test.alloc.encode_ns");
+    Counter published = metrics().counter("test.alloc.published");
+
+    AllocRegion region("publish");
+    for (int i = 0; i < WARMUP + MESSAGES; ++i) {
+        AllocScope scope(i < WARMUP ? nullptr : &region);
+        TelemetrySample sample;
+        sample.data = make_sample(i % 3, 20.0 + i * 0.01, 1733329200000 + i);
+        sample.stamps.present = true;
+        sample.stamps.sampled_us = sample.stamps.enqueued_us = wall_clock_us();
+        ASSERT_TRUE(queue.push(sample));
+
+        TelemetrySample queued;
+        ASSERT_TRUE(queue.pop_for(queued, std::chrono::milliseconds(0)));
+        queued.sequence = static_cast<uint64_t>(i);
+        queued.stamps.dequeued_us = queued.stamps.written_us = wall_clock_us();
+        char* out = arena.allocate_chars(MAX_SENSOR_MESSAGE);
+        size_t len = encode_sensor_message(out, MAX_SENSOR_MESSAGE, queued.data, queued.sequence, &queued.stamps);
+        ASSERT_GT(len, 0u);
+        ASSERT_TRUE(restamp_written(out, len, wall_clock_us()));
+        encode_ns.record(len);
+        published.add();
+        arena.reset();
+    }
+
+    EXPECT_EQ(region.iterations(), static_cast<uint64_t>(MESSAGES));
+    EXPECT_EQ(region.totals().allocations, 0u) << region.summary();
+}
+
+// Monitor ingest: parse the payload, record the receive metrics and apply
+// it to the sensor's state the way the monitor's ingest_sample() does
+// (lock, look up the sensor, SensorState::ingest). Sequences keep climbing
+// with gaps and duplicates, so duplicate tracking has to stay bounded.
+TEST(HotPathAllocationTest, MonitorIngestDoesNotAllocate) {
+    std::map<int, SensorState> sensors;
+    std::mutex sensor_mutex;
+    Counter received = metrics().counter("test.alloc.received");
+    Counter duplicates = metrics().counter("test.alloc.duplicates");
+    Histogram latency = metrics().histogram("test.alloc.latency_ms");
+
+    AllocRegion region("ingest");
+    uint64_t accepted = 0;
+    for (int i = 0; i < WARMUP + 20 * MESSAGES; ++i) {
+        char payload[MAX_SENSOR_MESSAGE];
+        StageStamps sent;
+        sent.present = true;
+        sent.sampled_us = 1;
+        // Every 10th message repeats the previous sequence; every 7th skips one
+        uint64_t sent_seq = static_cast<uint64_t>(i / 3) + static_cast<uint64_t>(i / 21) - (i % 10 == 9 ? 1 : 0);
+        ASSERT_GT(encode_sensor_message(payload, sizeof(payload),
+                                        make_sample(i % 3, 25.5, 1733329200000 + i), sent_seq, &sent), 0u);
+
+        AllocScope scope(i < WARMUP ? nullptr : &region);
+        SensorData data;
+        uint64_t sequence = 0;
+        StageStamps stamps;
+        ASSERT_TRUE(parse_sensor_message(payload, data, sequence, &stamps));
+        received.add();
+        latency.record(sequence);
+        bool updated;
+        {
+            std::lock_guard<std::mutex> lock(sensor_mutex);
+            updated = sensors[data.id].ingest(data.value, static_cast<uint64_t>(data.timestamp), sequence, 0);
+        }
+        if (updated) {
+            accepted++;
+        } else {
+            duplicates.add();
+        }
+    }
+
+    EXPECT_EQ(region.totals().allocations, 0u) << region.summary();
+    EXPECT_GT(accepted, 0u);
+    EXPECT_EQ(sensors.size(), 3u);
+}
+
+// Logger: CSV formatting into the sink's reused row buffer, and the fan-out
+// hand-off to sink queues on the ingest thread.
+TEST(HotPathAllocationTest, LoggerFormattingAndFanOutDoNotAllocate) {
+    FanOutLogger fanout;
+    fanout.add_sink(std::make_unique<NullSink>(), 64, OverflowPolicy::Block);
+    ASSERT_TRUE(fanout.start());
+
+    LogRecord record;
+    record.data = make_sample(2, 1013.25, 1733329200000);
+    record.received_ms = wall_clock_ms();
+    std::string row;
+
+    AllocRegion region("format+fanout");
+    for (int i = 0; i < WARMUP + MESSAGES; ++i) {
+        AllocScope scope(i < WARMUP ? nullptr : &region);
+        record.sequence = static_cast<uint64_t>(i);
+        row.clear();
+        format_csv_row(record, row);
+        fanout.publish(record);
+    }
+    fanout.stop();
+
+    EXPECT_EQ(region.totals().allocations, 0u) << region.summary();
+    EXPECT_EQ(row.back(), '\n');
+}
+
+// What these tests exist to catch: a DOM JSON library back on the hot path.
+TEST(HotPathAllocationTest, JsonLibraryOnHotPathIsCaught) {
+    AllocRegion region("nlohmann");
+    for (int i = 0; i < 10; ++i) {
+        AllocScope scope(region);
+        nlohmann::json j;
+        j["id"] = 1;
+        j["value"] = 25.5;
+        j["timestamp"] = 1733329200000;
+        j["sequence"] = i;
+        std::string text = j.dump();
+    }
+    EXPECT_GT(region.totals().allocations, region.iterations());
+}
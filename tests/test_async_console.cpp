@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/core/async_console.h"
+
+using namespace telemetry;
+
+namespace {
+
+std::string read_all(FILE* f) {
+    std::fflush(f);
+    std::rewind(f);
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        text.append(buf, n);
+    }
+    return text;
+}
+
+size_t count_lines(const std::string& text) {
+    size_t n = 0;
+    for (char c : text) {
+        if (c == '\n') ++n;
+    }
+    return n;
+}
+
+} // namespace
+
+TEST(AsyncConsoleTest, LinesReachTheirStreams) {
+    FILE* out = std::tmpfile();
+    FILE* err = std::tmpfile();
+    {
+        AsyncConsole console(64, out, err);
+        console.start();
+        ConsoleLine(ConsoleStream::Out, true, 0, &console) << "[DDS] Published #" << 25u << " (Sensor " << -1 << ")";
+        ConsoleLine(ConsoleStream::Err, true, 0, &console) << "[ERROR] value " << 2.5;
+        console.stop();
+    }
+    EXPECT_EQ("[DDS] Published #25 (Sensor -1)\n", read_all(out));
+    EXPECT_EQ("[ERROR] value 2.5\n", read_all(err));
+    std::fclose(out);
+    std::fclose(err);
+}
+
+TEST(AsyncConsoleTest, FullRingDropsInsteadOfBlocking) {
+    FILE* out = std::tmpfile();
+    AsyncConsole console(4, out, out);
+
+    // Not started: nothing drains, so only the ring's capacity fits
+    for (int i = 0; i < 10; ++i) {
+        ConsoleLine(ConsoleStream::Out, true, 0, &console) << "line " << i;
+    }
+    EXPECT_EQ(6u, console.dropped_lines());
+
+    console.start();
+    console.stop();
+    EXPECT_EQ("line 0\nline 1\nline 2\nline 3\n", read_all(out));
+    std::fclose(out);
+}
+
+TEST(AsyncConsoleTest, ConcurrentProducersLoseNothingWhenDraining) {
+    FILE* out = std::tmpfile();
+    {
+        AsyncConsole console(1 << 14, out, out);
+        console.start();
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&console, t] {
+                for (int i = 0; i < 1000; ++i) {
+                    ConsoleLine(ConsoleStream::Out, true, 0, &console) << "producer " << t << " line " << i;
+                }
+            });
+        }
+        for (auto& p : producers) p.join();
+        console.stop();
+        EXPECT_EQ(0u, console.dropped_lines());
+    }
+    EXPECT_EQ(4000u, count_lines(read_all(out)));
+    std::fclose(out);
+}
+
+// telemetry_all: each app starts and stops the shared console on its own thread
+TEST(AsyncConsoleTest, NestedStartStopFromSeveralThreads) {
+    FILE* out = std::tmpfile();
+    {
+        AsyncConsole console(1 << 12, out, out);
+        std::vector<std::thread> apps;
+        for (int t = 0; t < 3; ++t) {
+            apps.emplace_back([&console, t] {
+                console.start();
+                for (int i = 0; i < 100; ++i) {
+                    ConsoleLine(ConsoleStream::Out, true, 0, &console) << "app " << t << " line " << i;
+                }
+                console.stop();
+            });
+        }
+        for (auto& app : apps) app.join();
+        ConsoleLine(ConsoleStream::Out, true, 0, &console) << "after";
+        EXPECT_EQ(0u, console.dropped_lines());
+    }
+    std::string text = read_all(out);
+    EXPECT_EQ(301u, count_lines(text));
+    EXPECT_EQ("after\n", text.substr(text.size() - 6));
+    std::fclose(out);
+}
+
+TEST(AsyncConsoleTest, LongTextIsSplitAndOverlongLinesTruncated) {
+    FILE* out = std::tmpfile();
+    {
+        AsyncConsole console(64, out, out);
+        std::string block(1000, 'x');
+        block += "\n";
+        console.write(ConsoleStream::Out, block);
+        ConsoleLine(ConsoleStream::Out, true, 0, &console) << std::string(1000, 'y');
+        console.stop();
+    }
+    std::string text = read_all(out);
+    EXPECT_EQ(std::string(1000, 'x') + "\n" + std::string(AsyncConsole::SLOT_TEXT - 1, 'y') + "\n", text);
+    std::fclose(out);
+}
+
+// Multi-slot lines are claimed in one step, so they come out whole
+TEST(AsyncConsoleTest, LongLinesFromConcurrentProducersDoNotInterleave) {
+    FILE* out = std::tmpfile();
+    {
+        AsyncConsole console(1 << 12, out, out);
+        console.start();
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&console, t] {
+                std::string line(3 * AsyncConsole::SLOT_TEXT / 2, static_cast<char>('a' + t));
+                line += '\n';
+                for (int i = 0; i < 500; ++i) {
+                    while (!console.write(ConsoleStream::Out, line)) {
+                        std::this_thread::yield();   // full: let the drain thread catch up
+                    }
+                }
+            });
+        }
+        for (auto& p : producers) p.join();
+        console.stop();
+    }
+    std::string text = read_all(out);
+    EXPECT_EQ(2000u, count_lines(text));
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        ASSERT_NE(end, std::string::npos);
+        std::string line = text.substr(begin, end - begin);
+        ASSERT_EQ(line, std::string(3 * AsyncConsole::SLOT_TEXT / 2, line[0]));
+        begin = end + 1;
+    }
+    std::fclose(out);
+}
+
+TEST(AsyncConsoleTest, LineLongerThanTheRingIsDropped) {
+    FILE* out = std::tmpfile();
+    {
+        AsyncConsole console(4, out, out);
+        EXPECT_FALSE(console.write(ConsoleStream::Out, std::string(4 * AsyncConsole::SLOT_TEXT + 1, 'x')));
+        EXPECT_TRUE(console.write(ConsoleStream::Out, std::string(4 * AsyncConsole::SLOT_TEXT - 1, 'y') + "\n"));
+        EXPECT_EQ(1u, console.dropped_lines());
+        console.stop();
+    }
+    EXPECT_EQ(std::string(4 * AsyncConsole::SLOT_TEXT - 1, 'y') + "\n", read_all(out));
+    std::fclose(out);
+}
+
+// Every write that reports success shows up, whether it was queued before
+// stop() or went straight out after it
+TEST(AsyncConsoleTest, WritesRacingStopAreNotLost) {
+    for (int round = 0; round < 20; ++round) {
+        FILE* out = std::tmpfile();
+        std::atomic<size_t> written{0};
+        {
+            AsyncConsole console(1 << 14, out, out);
+            console.start();
+            std::atomic<bool> go{false};
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 4; ++t) {
+                producers.emplace_back([&] {
+                    while (!go) {
+                        std::this_thread::yield();
+                    }
+                    for (int i = 0; i < 500; ++i) {
+                        if (console.write(ConsoleStream::Out, "line\n")) {
+                            written++;
+                        }
+                    }
+                });
+            }
+            go = true;
+            console.stop();
+            for (auto& p : producers) p.join();
+        }
+        EXPECT_EQ(written.load(), count_lines(read_all(out))) << "round " << round;
+        std::fclose(out);
+    }
+}
+
+TEST(AsyncConsoleTest, OnlyNewestFrameIsWritten) {
+    FILE* out = std::tmpfile();
+    {
+        AsyncConsole console(16, out, out);
+        console.replace_frame("frame 1\n");
+        console.replace_frame("frame 2\n");
+        console.replace_frame("frame 3\n");
+        EXPECT_EQ(2u, console.replaced_frames());
+        console.stop();
+    }
+    EXPECT_EQ("frame 3\n", read_all(out));
+    std::fclose(out);
+}
+
+TEST(AsyncConsoleTest, RateLimitReportsSuppressedCount) {
+    RateLimit limit(2, std::chrono::milliseconds(50));
+    uint64_t suppressed = 0;
+    EXPECT_TRUE(limit.allow(suppressed));
+    EXPECT_TRUE(limit.allow(suppressed));
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_FALSE(limit.allow(suppressed));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_TRUE(limit.allow(suppressed));
+    EXPECT_EQ(5u, suppressed);
+}
+
+TEST(AsyncConsoleTest, SuppressedLineIsNotFormatted) {
+    FILE* out = std::tmpfile();
+    {
+        AsyncConsole console(16, out, out);
+        ConsoleLine(ConsoleStream::Err, false, 0, &console) << "hidden";
+        ConsoleLine(ConsoleStream::Err, true, 3, &console) << "shown";
+        console.stop();
+    }
+    EXPECT_EQ("shown (3 similar suppressed)\n", read_all(out));
+    std::fclose(out);
+}
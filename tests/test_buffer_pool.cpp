@@ -0,0 +1,355 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "../src/core/buffer_pool.h"
+#include "../src/core/message_codec.h"
+
+using namespace telemetry;
+
+// Counts every heap allocation in this test binary, so the steady-state
+// tests can assert that the hot path never reaches malloc. Kept out of
+// line so GCC doesn't pair the inlined malloc/free against new/delete.
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+}
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+SensorData make_sample(int id, double value, long timestamp) {
+    SensorData data;
+    data.id = id;
+    data.value = value;
+    data.timestamp = timestamp;
+    return data;
+}
+
+} // namespace
+
+// ========== BufferPool / Arena ==========
+
+TEST(BufferPoolTest, ReleasedBuffersAreReused) {
+    BufferPool pool;
+    size_t capacity = 0;
+    char* a = pool.acquire(100, capacity);
+    EXPECT_EQ(capacity, 128u);
+    pool.release(a, capacity);
+
+    char* b = pool.acquire(70, capacity);
+    EXPECT_EQ(b, a);
+    pool.release(b, capacity);
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.acquired, 2u);
+    EXPECT_EQ(stats.heap_allocations, 1u);
+    EXPECT_EQ(stats.outstanding, 0u);
+}
+
+TEST(BufferPoolTest, OversizedBuffersBypassTheFreeLists) {
+    BufferPool pool;
+    size_t capacity = 0;
+    char* big = pool.acquire(BufferPool::MAX_CLASS_SIZE + 1, capacity);
+    EXPECT_EQ(capacity, BufferPool::MAX_CLASS_SIZE + 1);
+    pool.release(big, capacity);
+    pool.acquire(BufferPool::MAX_CLASS_SIZE + 1, capacity);
+    EXPECT_EQ(pool.stats().heap_allocations, 2u);
+}
+
+TEST(ArenaTest, AllocationsAreAlignedAndDisjoint) {
+    BufferPool pool;
+    Arena arena(256, pool);
+    char* a = arena.allocate_chars(3);
+    auto* b = static_cast<uint64_t*>(arena.allocate(sizeof(uint64_t), alignof(uint64_t)));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(uint64_t), 0u);
+    EXPECT_GE(reinterpret_cast<char*>(b), a + 3);
+
+    // Spills into a second block, and oversized requests still fit
+    arena.allocate(250);
+    EXPECT_EQ(arena.blocks(), 2u);
+    char* huge = arena.allocate_chars(10000);
+    huge[9999] = 'x';
+    EXPECT_EQ(arena.blocks(), 3u);
+}
+
+TEST(ArenaTest, ResetKeepsBlocksForReuse) {
+    BufferPool pool;
+    {
+        Arena arena(256, pool);
+        char* first = arena.allocate_chars(64);
+        arena.allocate_chars(250);
+        arena.reset();
+        EXPECT_EQ(arena.bytes_used(), 0u);
+        EXPECT_EQ(arena.allocate_chars(64), first);
+        EXPECT_EQ(pool.stats().heap_allocations, 2u);
+    }
+    // Destruction hands the blocks back to the pool
+    EXPECT_EQ(pool.stats().outstanding, 0u);
+}
+
+// ========== Sensor message codec ==========
+
+TEST(MessageCodecTest, EncodingMatchesNlohmannDump) {
+    char buf[MAX_SENSOR_MESSAGE];
+    const double values[] = {25.5, 1013.25, 0.1, -3.0, 42.0, 1e-7, 123456.789012};
+    for (double value : values) {
+        SensorData data = make_sample(2, value, 1700000000123L);
+        size_t len = encode_sensor_message(buf, sizeof(buf), data, 987654321ULL);
+        ASSERT_GT(len, 0u);
+
+        nlohmann::json j;
+        j["id"] = data.id;
+        j["value"] = data.value;
+        j["timestamp"] = data.timestamp;
+        j["sequence"] = 987654321ULL;
+        EXPECT_EQ(std::string(buf, len), j.dump());
+    }
+}
+
+TEST(MessageCodecTest, RoundTripsExactly) {
+    char buf[MAX_SENSOR_MESSAGE];
+    SensorData in = make_sample(7, 1013.2500000001, 1700000000999L);
+    ASSERT_GT(encode_sensor_message(buf, sizeof(buf), in, 18446744073709551615ULL), 0u);
+
+    SensorData out{};
+    uint64_t sequence = 0;
+    ASSERT_TRUE(parse_sensor_message(buf, out, sequence));
+    EXPECT_EQ(out.id, 7);
+    EXPECT_EQ(out.value, in.value);
+    EXPECT_EQ(out.timestamp, in.timestamp);
+    EXPECT_EQ(sequence, 18446744073709551615ULL);
+}
+
+TEST(MessageCodecTest, TooSmallBufferFails) {
+    char buf[16];
+    EXPECT_EQ(encode_sensor_message(buf, sizeof(buf), make_sample(1, 2.5, 3), 4), 0u);
+}
+
+TEST(MessageCodecTest, ParserSkipsUnknownKeysAndWhitespace) {
+    const char* payload =
+        " { \"stamps\" : {\"hub\": [1, 2.5e3, \"a\\\"b\"]}, \"value\": 21.75, \"ok\": true,"
+        " \"id\":3, \"note\": null, \"timestamp\": 1000, \"sequence\": 5.0 } ";
+    SensorData data{};
+    uint64_t sequence = 0;
+    ASSERT_TRUE(parse_sensor_message(payload, data, sequence));
+    EXPECT_EQ(data.id, 3);
+    EXPECT_DOUBLE_EQ(data.value, 21.75);
+    EXPECT_EQ(data.timestamp, 1000);
+    EXPECT_EQ(sequence, 5u);
+}
+
+TEST(MessageCodecTest, ParserRejectsMalformedOrIncompleteMessages) {
+    SensorData data{};
+    uint64_t sequence = 0;
+    EXPECT_FALSE(parse_sensor_message(nullptr, data, sequence));
+    EXPECT_FALSE(parse_sensor_message("", data, sequence));
+    EXPECT_FALSE(parse_sensor_message("not json", data, sequence));
+    EXPECT_FALSE(parse_sensor_message("{\"id\":1,\"value\":2,\"timestamp\":3}", data, sequence));
+    EXPECT_FALSE(parse_sensor_message("{\"id\":1,\"value\":2,\"timestamp\":3,\"sequence\":-4}",
+                                      data, sequence));
+    EXPECT_FALSE(parse_sensor_message("{\"id\":1,\"value\":2,\"timestamp\":3,\"sequence\":4",
+                                      data, sequence));
+    EXPECT_FALSE(parse_sensor_message("{\"id\":1,\"value\":2,\"timestamp\":3,\"sequence\":4} x",
+                                      data, sequence));
+}
+
+TEST(MessageCodecTest, NonFiniteValuesEncodeAsNull) {
+    char buf[MAX_SENSOR_MESSAGE];
+    size_t len = encode_sensor_message(buf, sizeof(buf), make_sample(0, NAN, 1), 1);
+    EXPECT_NE(std::string(buf, len).find("\"value\":null"), std::string::npos);
+
+    SensorData data{};
+    uint64_t sequence = 0;
+    ASSERT_TRUE(parse_sensor_message(buf, data, sequence));
+    EXPECT_TRUE(std::isnan(data.value));
+}
+
+TEST(MessageCodecTest, StageStampsRoundTripAndMatchNlohmann) {
+    char buf[MAX_SENSOR_MESSAGE];
+    StageStamps in;
+    in.present = true;
+    in.sampled_us = 1700000000000001ULL;
+    in.enqueued_us = 1700000000000012ULL;
+    in.dequeued_us = 1700000000000345ULL;
+    in.written_us = 1700000000000360ULL;
+    SensorData data = make_sample(1, 1013.25, 1700000000000L);
+    size_t len = encode_sensor_message(buf, sizeof(buf), data, 42, &in);
+    ASSERT_GT(len, 0u);
+
+    nlohmann::json j;
+    j["id"] = data.id;
+    j["value"] = data.value;
+    j["timestamp"] = data.timestamp;
+    j["sequence"] = 42;
+    j["stamps"] = {in.sampled_us, in.enqueued_us, in.dequeued_us, in.written_us};
+    EXPECT_EQ(std::string(buf, len), j.dump());
+
+    SensorData parsed{};
+    uint64_t sequence = 0;
+    StageStamps out;
+    ASSERT_TRUE(parse_sensor_message(buf, parsed, sequence, &out));
+    EXPECT_TRUE(out.present);
+    EXPECT_EQ(out.sampled_us, in.sampled_us);
+    EXPECT_EQ(out.enqueued_us, in.enqueued_us);
+    EXPECT_EQ(out.dequeued_us, in.dequeued_us);
+    EXPECT_EQ(out.written_us, in.written_us);
+
+    // Readers that don't ask for stamps skip them
+    ASSERT_TRUE(parse_sensor_message(buf, parsed, sequence));
+    EXPECT_EQ(sequence, 42u);
+}
+
+TEST(MessageCodecTest, WrittenStampIsPatchedAfterEncoding) {
+    char buf[MAX_SENSOR_MESSAGE];
+    StageStamps stamps;
+    stamps.present = true;
+    stamps.sampled_us = stamps.enqueued_us = stamps.dequeued_us = 1700000000000001ULL;
+    stamps.written_us = 1700000000000002ULL;
+    SensorData data = make_sample(2, 45.5, 1700000000000L);
+    size_t len = encode_sensor_message(buf, sizeof(buf), data, 7, &stamps);
+    ASSERT_GT(len, 0u);
+
+    ASSERT_TRUE(restamp_written(buf, len, 1700000000000999ULL));
+    stamps.written_us = 1700000000000999ULL;
+    char expected[MAX_SENSOR_MESSAGE];
+    ASSERT_EQ(encode_sensor_message(expected, sizeof(expected), data, 7, &stamps), len);
+    EXPECT_STREQ(buf, expected);
+
+    // A different width would shift the rest of the message: left alone
+    EXPECT_FALSE(restamp_written(buf, len, 99));
+    EXPECT_STREQ(buf, expected);
+    len = encode_sensor_message(buf, sizeof(buf), data, 7);
+    EXPECT_FALSE(restamp_written(buf, len, 1700000000000999ULL));
+}
+
+TEST(MessageCodecTest, MessagesWithoutStampsReportNone) {
+    char buf[MAX_SENSOR_MESSAGE];
+    StageStamps absent;   // present = false: nothing encoded
+    size_t len = encode_sensor_message(buf, sizeof(buf), make_sample(0, 1.5, 2), 3, &absent);
+    EXPECT_EQ(std::string(buf, len).find("stamps"), std::string::npos);
+
+    SensorData data{};
+    uint64_t sequence = 0;
+    StageStamps out;
+    out.present = true;
+    ASSERT_TRUE(parse_sensor_message(buf, data, sequence, &out));
+    EXPECT_FALSE(out.present);
+
+    EXPECT_FALSE(parse_sensor_message(
+        "{\"id\":1,\"sequence\":2,\"stamps\":[1,2],\"timestamp\":3,\"value\":4.0}",
+        data, sequence, &out));
+}
+
+TEST(MessageCodecTest, WorstCaseMessageFits) {
+    char buf[MAX_SENSOR_MESSAGE];
+    StageStamps stamps;
+    stamps.present = true;
+    stamps.sampled_us = stamps.enqueued_us = stamps.dequeued_us = stamps.written_us = UINT64_MAX;
+    SensorData data = make_sample(INT32_MIN, -1.2345678901234567e-300, LONG_MIN);
+    EXPECT_GT(encode_sensor_message(buf, sizeof(buf), data, UINT64_MAX, &stamps), 0u);
+}
+
+TEST(MessageCodecTest, RollupMessagesMatchNlohmannAndParseAsSensorMessages) {
+    char buf[MAX_SENSOR_MESSAGE];
+    RollupFields rollup;
+    rollup.count = 250;
+    rollup.min = -3.5;
+    rollup.max = 41.0;
+    rollup.sources = 12;
+    SensorData data = make_sample(2, 18.75, 1700000001000L);
+    size_t len = encode_rollup_message(buf, sizeof(buf), data, 9, rollup);
+    ASSERT_GT(len, 0u);
+
+    nlohmann::json j;
+    j["id"] = data.id;
+    j["value"] = data.value;
+    j["timestamp"] = data.timestamp;
+    j["sequence"] = 9;
+    j["count"] = rollup.count;
+    j["min"] = rollup.min;
+    j["max"] = rollup.max;
+    j["sources"] = rollup.sources;
+    EXPECT_EQ(std::string(buf, len), j.dump());
+
+    SensorData parsed{};
+    uint64_t sequence = 0;
+    ASSERT_TRUE(parse_sensor_message(buf, parsed, sequence));
+    EXPECT_EQ(parsed.id, 2);
+    EXPECT_EQ(parsed.value, 18.75);
+    EXPECT_EQ(sequence, 9u);
+
+    RollupFields worst;
+    worst.count = UINT64_MAX;
+    worst.min = worst.max = -1.2345678901234567e-300;
+    worst.sources = UINT32_MAX;
+    EXPECT_GT(encode_rollup_message(buf, sizeof(buf), make_sample(INT32_MIN, -1.2345678901234567e-300, LONG_MIN),
+                                    UINT64_MAX, worst), 0u);
+}
+
+// ========== Steady state ==========
+
+// The publish/ingest cycle the apps run per message: arena-backed encode,
+// parse, bulk release. Once warm it must not allocate at all.
+TEST(SteadyStateTest, EncodeParseCycleDoesNotAllocate) {
+    BufferPool pool;
+    Arena arena(4096, pool);
+
+    auto cycle = [&](int i) {
+        char* payload = arena.allocate_chars(MAX_SENSOR_MESSAGE);
+        SensorData in = make_sample(i % 3, 20.0 + i * 0.01, 1700000000000L + i);
+        size_t len = encode_sensor_message(payload, MAX_SENSOR_MESSAGE, in, static_cast<uint64_t>(i));
+        SensorData out{};
+        uint64_t sequence = 0;
+        bool ok = len > 0 && parse_sensor_message(payload, out, sequence);
+        arena.reset();
+        return ok && sequence == static_cast<uint64_t>(i);
+    };
+
+    ASSERT_TRUE(cycle(0));   // warm-up: the arena takes its first block
+    uint64_t before = g_allocations.load();
+    bool all_ok = true;
+    for (int i = 1; i <= 10000; ++i) {
+        all_ok = cycle(i) && all_ok;
+    }
+    uint64_t allocations = g_allocations.load() - before;
+
+    EXPECT_TRUE(all_ok);
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(pool.stats().heap_allocations, 1u);
+}
+
+TEST(SteadyStateTest, PoolRecyclingDoesNotAllocate) {
+    BufferPool pool;
+    size_t capacity = 0;
+    char* warm[4];
+    for (char*& b : warm) b = pool.acquire(200, capacity);
+    for (char* b : warm) pool.release(b, capacity);
+
+    uint64_t before = g_allocations.load();
+    for (int i = 0; i < 1000; ++i) {
+        char* a = pool.acquire(200, capacity);
+        char* b = pool.acquire(150, capacity);
+        pool.release(a, capacity);
+        pool.release(b, capacity);
+    }
+    EXPECT_EQ(g_allocations.load() - before, 0u);
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "../src/core/config.h"
+
+using namespace telemetry;
+
+namespace {
+
+void write_file(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::trunc);
+    out << text;
+}
+
+} // namespace
+
+TEST(ConfigTest, DefaultsMatchTheOriginalSensors) {
+    TelemetryConfig config = default_config();
+    ASSERT_EQ(config.sensors.size(), 3u);
+    ASSERT_NE(config.find_sensor(1), nullptr);
+    EXPECT_EQ(config.find_sensor(1)->name, "Pressure");
+    EXPECT_EQ(config.find_sensor(1)->unit, "hPa");
+    EXPECT_DOUBLE_EQ(config.find_sensor(2)->rate_hz, 2.0);
+    EXPECT_EQ(config.find_sensor(3), nullptr);
+    EXPECT_EQ(config.qos_profile, QosProfile::Default);
+}
+
+TEST(ConfigTest, LoadsSensorsQosAndMonitorSettings) {
+    const std::string path = "test_config.json";
+    write_file(path, R"({
+        "qos_profile": "low-latency",
+        "monitor": { "refresh_ms": 500 },
+        "sensors": [
+            { "id": 4, "name": "Vibration", "unit": "g", "min": -2, "max": 2, "rate_hz": 50 },
+            { "id": 7, "name": "Voltage", "min": 11.5, "max": 12.5 }
+        ]
+    })");
+
+    TelemetryConfig config;
+    std::string error;
+    ASSERT_TRUE(load_config(path, config, error)) << error;
+    EXPECT_EQ(config.qos_profile, QosProfile::LowLatency);
+    EXPECT_EQ(config.monitor_refresh_ms, 500u);
+    ASSERT_EQ(config.sensors.size(), 2u);
+    EXPECT_EQ(config.find_sensor(4)->unit, "g");
+    EXPECT_DOUBLE_EQ(config.find_sensor(4)->rate_hz, 50.0);
+    EXPECT_DOUBLE_EQ(config.find_sensor(7)->rate_hz, 2.0);   // default
+    EXPECT_EQ(config.find_sensor(0), nullptr);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigTest, LoadsDomainAndPartitions) {
+    const std::string path = "test_config_sharding.json";
+    write_file(path, R"({"domain": 7, "partitions": ["site-a/line-1", "site-a/line-2"]})");
+
+    TelemetryConfig config;
+    std::string error;
+    ASSERT_TRUE(load_config(path, config, error)) << error;
+    EXPECT_EQ(config.domain, 7u);
+    ASSERT_EQ(config.partitions.size(), 2u);
+    EXPECT_EQ(config.partitions[1], "site-a/line-2");
+    std::remove(path.c_str());
+
+    TelemetryConfig defaults = default_config();
+    EXPECT_EQ(defaults.domain, static_cast<dds_domainid_t>(DDS_DOMAIN_DEFAULT));
+    EXPECT_TRUE(defaults.partitions.empty());
+}
+
+TEST(ConfigTest, SensorTypesComeFromNamesUnlessGiven) {
+    TelemetryConfig config = default_config();
+    EXPECT_EQ(config.sensor_types(), (std::vector<std::string>{"humidity", "pressure", "temperature"}));
+
+    SensorConfig sensor;
+    sensor.name = "Relative Humidity (2)";
+    EXPECT_EQ(sensor.topic_type(), "relative_humidity_2");
+    sensor.type = "rh";
+    EXPECT_EQ(sensor.topic_type(), "rh");
+}
+
+TEST(ConfigTest, LoadsPerTypeTopicsAndTheirProfiles) {
+    const std::string path = "test_config_topics.json";
+    write_file(path, R"({
+        "qos_profile": "default",
+        "topic_mode": "per-type",
+        "topic_qos": { "vibration": "low-latency", "temperature": "lossless-logging" },
+        "sensors": [
+            { "id": 0, "name": "Temperature" },
+            { "id": 1, "name": "Accelerometer X", "type": "vibration", "rate_hz": 200 },
+            { "id": 2, "name": "Accelerometer Y", "type": "vibration", "rate_hz": 200 },
+            { "id": 3, "name": "Voltage" }
+        ]
+    })");
+
+    TelemetryConfig config;
+    std::string error;
+    ASSERT_TRUE(load_config(path, config, error)) << error;
+    EXPECT_TRUE(config.per_type_topics);
+    EXPECT_EQ(config.sensor_types(), (std::vector<std::string>{"temperature", "vibration", "voltage"}));
+    EXPECT_EQ(config.topic_profile("vibration", QosProfile::Default), QosProfile::LowLatency);
+    EXPECT_EQ(config.topic_profile("temperature", QosProfile::Default), QosProfile::LosslessLogging);
+    EXPECT_EQ(config.topic_profile("voltage", QosProfile::HighThroughput), QosProfile::HighThroughput);
+    std::remove(path.c_str());
+
+    bool per_type = true;
+    EXPECT_TRUE(parse_topic_mode("shared", per_type));
+    EXPECT_FALSE(per_type);
+    EXPECT_FALSE(parse_topic_mode("per_type", per_type));
+}
+
+TEST(ConfigTest, InvalidFilesAreRejectedWithAReason) {
+    const std::string path = "test_config_bad.json";
+    const char* bad[] = {
+        R"({"sensors": [{"id": 1}, {"id": 1}]})",
+        R"({"sensors": [{"id": 1, "min": 5, "max": 5}]})",
+        R"({"sensors": [{"id": 1, "rate_hz": 0}]})",
+        R"({"sensors": [{"name": "no id"}]})",
+        R"({"qos_profile": "fastest"})",
+        R"({"monitor": {"refresh_ms": 0}})",
+        R"({"domain": 233})",
+        R"({"domain": -1})",
+        R"({"partitions": ["site-a", ""]})",
+        R"({"partitions": "site-a"})",
+        R"({"topic_mode": "per-sensor"})",
+        R"({"topic_qos": {"temperature": "fastest"}})",
+        R"({"sensors": [{"id": 1, "type": "Temp-C"}]})",
+        R"({"sensors": [{"id": 1, "name": "!!!"}]})",
+        R"({"sensors": )",
+    };
+    for (const char* text : bad) {
+        write_file(path, text);
+        TelemetryConfig config = default_config();
+        std::string error;
+        EXPECT_FALSE(load_config(path, config, error)) << text;
+        EXPECT_FALSE(error.empty()) << text;
+        EXPECT_EQ(config.sensors.size(), 3u) << "config modified on failure: " << text;
+    }
+    std::remove(path.c_str());
+
+    TelemetryConfig config;
+    std::string error;
+    EXPECT_FALSE(load_config("does_not_exist.json", config, error));
+}
+
+TEST(ConfigStoreTest, PublishSwapsConfigAndBumpsVersion) {
+    ConfigStore store;
+    const TelemetryConfig* before = &store.current();
+    uint64_t version = store.version();
+
+    TelemetryConfig next = default_config();
+    next.sensors.push_back({9, "Extra", "", 0.0, 1.0, 10.0, ""});
+    store.publish(next);
+
+    EXPECT_GT(store.version(), version);
+    EXPECT_NE(&store.current(), before);
+    EXPECT_NE(store.current().find_sensor(9), nullptr);
+    // The replaced config stays readable for anyone still holding it
+    EXPECT_EQ(before->find_sensor(9), nullptr);
+    EXPECT_EQ(before->sensors.size(), 3u);
+}
+
+TEST(ConfigStoreTest, FailedReloadKeepsTheLiveConfig) {
+    ConfigStore store;
+    uint64_t version = store.version();
+    std::string error;
+    EXPECT_FALSE(store.reload("does_not_exist.json", error));
+    EXPECT_EQ(store.version(), version);
+    EXPECT_EQ(store.current().sensors.size(), 3u);
+}
+
+TEST(ConfigStoreTest, ReadersSeeConsistentConfigsDuringReloads) {
+    ConfigStore store;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> inconsistent{0};
+
+    // Every published config has sensors whose rate equals the sensor count
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                const TelemetryConfig& config = store.current();
+                for (const auto& sensor : config.sensors) {
+                    if (config.sensors.size() > 3 &&
+                        sensor.rate_hz != static_cast<double>(config.sensors.size())) {
+                        inconsistent++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int i = 4; i < 200; ++i) {
+        TelemetryConfig config;
+        for (int id = 0; id < i; ++id) {
+            config.sensors.push_back({id, "S", "", 0.0, 1.0, static_cast<double>(i), ""});
+        }
+        store.publish(std::move(config));
+    }
+    done = true;
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(inconsistent.load(), 0u);
+    EXPECT_EQ(store.current().sensors.size(), 199u);
+}
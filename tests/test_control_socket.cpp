@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../src/core/async_console.h"
+#include "../src/core/control_socket.h"
+#include "../src/core/metrics.h"
+#include "../src/core/trace.h"
+
+using namespace telemetry;
+
+namespace {
+
+std::string test_socket_path() {
+    return "/tmp/test_control_" + std::to_string(::getpid()) + ".ctl";
+}
+
+// Sends `request`, closes the write side and returns everything the server
+// replied until it closed the connection.
+std::string round_trip(const std::string& path, const std::string& request) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return "<connect failed>";
+    }
+    ::send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    ::shutdown(fd, SHUT_WR);
+
+    std::string reply;
+    char buf[512];
+    ssize_t n;
+    while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0) {
+        reply.append(buf, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return reply;
+}
+
+} // namespace
+
+TEST(ControlServerTest, ExecuteDispatchesCommandsWithArguments) {
+    ControlServer server;
+    server.add_command("echo", "Repeat the arguments", [](const std::string& args) {
+        return "echo:" + args;
+    });
+
+    EXPECT_EQ(server.execute("echo  hello world  \r"), "echo:hello world\n");
+    EXPECT_EQ(server.execute("echo"), "echo:\n");
+    EXPECT_EQ(server.execute("   "), "");
+    EXPECT_EQ(server.execute("nope"), "unknown command: nope (try help)\n");
+
+    std::string help = server.execute("help");
+    EXPECT_NE(help.find("echo"), std::string::npos) << help;
+    EXPECT_NE(help.find("metrics"), std::string::npos) << help;
+}
+
+TEST(ControlServerTest, BuiltinsDumpMetricsAndChangeLogLevel) {
+    ControlServer server;
+    metrics().counter("test.control.requests").add(3);
+
+    std::string dump = server.execute("metrics");
+    EXPECT_NE(dump.find("test.control.requests 3"), std::string::npos) << dump;
+
+    EXPECT_EQ(server.execute("loglevel"), "loglevel info\n");
+    EXPECT_EQ(server.execute("loglevel error"), "loglevel error\n");
+    EXPECT_EQ(log_level(), LogLevel::Error);
+    EXPECT_NE(server.execute("loglevel loud").find("unknown log level"), std::string::npos);
+    EXPECT_EQ(server.execute("loglevel info"), "loglevel info\n");
+    EXPECT_EQ(log_level(), LogLevel::Info);
+
+    if (!tracing_enabled()) {
+        EXPECT_NE(server.execute("trace /tmp/x.json").find("tracing is off"), std::string::npos);
+    }
+}
+
+TEST(ControlServerTest, ThreadsListsNamedThreads) {
+    std::atomic<bool> named{false};
+    std::atomic<bool> done{false};
+    std::thread worker([&] {
+        set_trace_thread_name("ctl-test-worker");
+        named = true;
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    while (!named) {
+        std::this_thread::yield();
+    }
+
+    std::string threads = describe_threads();
+    done = true;
+    worker.join();
+
+    EXPECT_NE(threads.find("ctl-test-worker"), std::string::npos) << threads;
+    EXPECT_NE(threads.find("affinity"), std::string::npos) << threads;
+}
+
+TEST(ControlServerTest, ServesRequestsOverTheSocket) {
+    std::string path = test_socket_path();
+    ControlServer server;
+    server.add_command("ping", "Liveness check", [](const std::string&) { return std::string("pong"); });
+    ASSERT_TRUE(server.start(path));
+    EXPECT_TRUE(server.running());
+
+    // Several commands per connection; the last one needs no newline
+    EXPECT_EQ(round_trip(path, "ping\nping\nping"), "pong\npong\npong\n");
+    EXPECT_EQ(round_trip(path, "bogus\n"), "unknown command: bogus (try help)\n");
+
+    server.stop();
+    EXPECT_NE(::access(path.c_str(), F_OK), 0);   // socket file removed
+}
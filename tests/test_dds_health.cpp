@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "../src/core/dds_bootstrap.h"
+#include "../src/core/dds_health.h"
+
+using namespace telemetry;
+
+TEST(DdsHealthTest, InvalidEntitiesAreIgnored) {
+    DdsHealth health;
+    health.watch_reader(-1, "test.invalid_reader");
+    health.watch_writer(0, "test.invalid_writer");
+    health.poll();
+
+    DdsHealthCounts totals = health.totals();
+    EXPECT_EQ(totals.sample_lost, 0u);
+    EXPECT_EQ(totals.matched, 0u);
+    EXPECT_EQ(metrics().snapshot().counters.count("test.invalid_reader.sample_lost"), 0u);
+}
+
+// In-process writer and reader on one participant: both should see the
+// match, and nothing should be reported lost.
+TEST(DdsHealthTest, ReportsMatchedEndpointsWithoutLoss) {
+    DdsSession dds;
+    ASSERT_TRUE(dds.open(QosProfile::Default, DDS_DOMAIN_DEFAULT, "test_dds_health"));
+    dds_entity_t writer = dds.create_writer();
+    dds_entity_t reader = dds.create_reader();
+    ASSERT_GT(writer, 0);
+    ASSERT_GT(reader, 0);
+
+    DdsHealth health;
+    health.watch_writer(writer, "test.health.writer");
+    health.watch_reader(reader, "test.health.reader");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    do {
+        health.poll();
+        if (health.totals().matched >= 2) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    DdsHealthCounts totals = health.totals();
+    EXPECT_EQ(totals.matched, 2u);   // one matched reader + one matched writer
+    EXPECT_EQ(totals.sample_lost, 0u);
+    EXPECT_EQ(totals.sample_rejected, 0u);
+
+    MetricsSnapshot snap = metrics().snapshot();
+    EXPECT_EQ(snap.gauges["test.health.writer.matched_subscriptions"], 1);
+    EXPECT_EQ(snap.gauges["test.health.reader.matched_publications"], 1);
+    EXPECT_EQ(snap.counters.count("test.health.reader.sample_lost"), 1u);
+    EXPECT_EQ(snap.counters.count("test.health.writer.offered_deadline_missed"), 1u);
+}
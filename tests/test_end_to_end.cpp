@@ -46,7 +46,7 @@ TEST(EndToEndTest, SensorDataPipeline) {
     SensorData data;
     
     int processed = 0;
-    while (queue.pop(data) && processed < 30) {
+    while (processed < 30 && queue.pop(data)) {
         int sensor_id = data.id;
         trackers[sensor_id].process_message(data, sequences[sensor_id]++);
         processed++;
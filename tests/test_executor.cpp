@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "telemetry.h"
+#include "../src/core/dds_bootstrap.h"
+#include "../src/core/executor.h"
+
+using namespace telemetry;
+using namespace std::chrono_literals;
+
+namespace {
+
+Task<int> add_later(Executor& executor, int a, int b) {
+    co_await executor.sleep_for(1ms);
+    co_return a + b;
+}
+
+Task<int> fail() {
+    throw std::runtime_error("parse failed");
+    co_return 0;
+}
+
+} // namespace
+
+TEST(ExecutorTest, AwaitedTasksReturnValuesAndRethrow) {
+    Executor executor(1, "test");
+    int sum = 0;
+    std::string error;
+    executor.spawn([](Executor& executor, int& sum, std::string& error) -> Task<> {
+        sum = co_await add_later(executor, 2, 3);
+        sum += co_await add_later(executor, sum, 10);
+        try {
+            co_await fail();
+        } catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+    }(executor, sum, error));
+    executor.run();
+    EXPECT_EQ(sum, 20);
+    EXPECT_EQ(error, "parse failed");
+    EXPECT_EQ(executor.active(), 0u);
+}
+
+// With no workers, everything runs on the thread inside run()
+TEST(ExecutorTest, TimersFireInDeadlineOrderOnTheRunThread) {
+    Executor executor(0, "test");
+    std::vector<int> fired;
+    std::thread::id caller = std::this_thread::get_id();
+    bool on_caller = true;
+    auto start = Executor::Clock::now();
+    for (int delay_ms : {30, 10, 20}) {
+        executor.spawn([](Executor& executor, int delay_ms, std::vector<int>& fired,
+                          std::thread::id caller, bool& on_caller) -> Task<> {
+            co_await executor.sleep_for(std::chrono::milliseconds(delay_ms));
+            fired.push_back(delay_ms);
+            on_caller = on_caller && std::this_thread::get_id() == caller;
+        }(executor, delay_ms, fired, caller, on_caller));
+    }
+    executor.run();
+    EXPECT_EQ(fired, (std::vector<int>{10, 20, 30}));
+    EXPECT_TRUE(on_caller);
+    EXPECT_GE(Executor::Clock::now() - start, 30ms);
+}
+
+// Sleeping tasks hold no thread: 200 x 20 ms on two workers take about 20 ms
+TEST(ExecutorTest, ManySleepingTasksShareFewThreads) {
+    Executor executor(2, "test");
+    std::atomic<int> done{0};
+    auto start = Executor::Clock::now();
+    for (int i = 0; i < 200; ++i) {
+        executor.spawn([](Executor& executor, std::atomic<int>& done) -> Task<> {
+            co_await executor.sleep_for(20ms);
+            done++;
+        }(executor, done));
+    }
+    executor.run();
+    EXPECT_EQ(done.load(), 200);
+    EXPECT_LT(Executor::Clock::now() - start, 1s);
+}
+
+// A consumer coroutine waits on pop() while a plain thread produces
+TEST(ExecutorTest, AsyncQueuePopWaitsForPushAndClose) {
+    Executor executor(2, "test");
+    AsyncQueue<int> queue(executor, 64);
+    long sum = 0;
+    int popped = 0;
+    executor.spawn([](AsyncQueue<int>& queue, long& sum, int& popped) -> Task<> {
+        while (std::optional<int> value = co_await queue.pop()) {
+            sum += *value;
+            popped++;
+        }
+    }(queue, sum, popped));
+
+    std::thread producer([&] {
+        for (int i = 1; i <= 1000; ++i) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();   // full: the consumer catches up
+            }
+        }
+        queue.close();
+    });
+    producer.join();
+    executor.run();
+    EXPECT_EQ(popped, 1000);
+    EXPECT_EQ(sum, 500500);
+    EXPECT_FALSE(queue.push(1));   // closed
+}
+
+TEST(ExecutorTest, AsyncQueueRejectsPushWhenFull) {
+    Executor executor(0, "test");
+    AsyncQueue<std::string> queue(executor, 2);
+    EXPECT_TRUE(queue.push("a"));
+    EXPECT_TRUE(queue.push("b"));
+    EXPECT_FALSE(queue.push("c"));
+    EXPECT_EQ(queue.size(), 2u);
+    queue.close();
+    std::vector<std::string> drained;
+    executor.spawn([](AsyncQueue<std::string>& queue, std::vector<std::string>& drained) -> Task<> {
+        while (std::optional<std::string> item = co_await queue.pop()) {
+            drained.push_back(*item);
+        }
+    }(queue, drained));
+    executor.run();
+    EXPECT_EQ(drained, (std::vector<std::string>{"a", "b"}));
+}
+
+// Times out on an idle reader, then wakes once a writer delivers
+TEST(ExecutorTest, DdsReadWaiterWakesWhenTheReaderHasData) {
+    DdsSession dds;
+    ASSERT_TRUE(dds.open(QosProfile::Default, DDS_DOMAIN_DEFAULT, "test_executor"));
+    dds_entity_t reader = dds.create_reader();
+    dds_entity_t writer = dds.create_writer();
+    ASSERT_GT(reader, 0);
+    ASSERT_GT(writer, 0);
+
+    Executor executor(1, "test");
+    bool idle_result = true;
+    bool data_result = false;
+    std::atomic<bool> woke{false};
+    {
+        DdsReadWaiter waiter(executor, dds.participant());
+        ASSERT_TRUE(waiter.ok());
+        executor.spawn([](DdsReadWaiter& waiter, dds_entity_t reader, bool& idle_result, bool& data_result,
+                          std::atomic<bool>& woke) -> Task<> {
+            std::vector<dds_entity_t> readers{reader};
+            idle_result = co_await waiter.readable(readers, 50ms);
+            data_result = co_await waiter.readable(readers, 5000ms);
+            woke = true;
+        }(waiter, reader, idle_result, data_result, woke));
+
+        // Keep writing until the waiter has seen a sample, so discovery
+        // timing doesn't matter
+        std::this_thread::sleep_for(100ms);
+        char payload[] = "{\"id\":1,\"value\":1.0,\"timestamp\":1}";
+        Telemetry_JsonMessage msg;
+        msg.payload = payload;
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!woke && std::chrono::steady_clock::now() < deadline) {
+            dds_write(writer, &msg);
+            std::this_thread::sleep_for(20ms);
+        }
+        executor.run();
+    }
+    EXPECT_FALSE(idle_result);
+    EXPECT_TRUE(data_result);
+    dds.close();
+}
+
+// Waits resolved on worker threads, back to back, reuse the reader's read
+// condition; run under ASan this also covers the awaiter's lifetime
+TEST(ExecutorTest, DdsReadWaiterServesRepeatedWaitsFromWorkerThreads) {
+    DdsSession dds;
+    ASSERT_TRUE(dds.open(QosProfile::Default, DDS_DOMAIN_DEFAULT, "test_executor"));
+    dds_entity_t reader = dds.create_reader();
+    dds_entity_t writer = dds.create_writer();
+    ASSERT_GT(reader, 0);
+    ASSERT_GT(writer, 0);
+
+    constexpr int WAITS = 50;
+    Executor executor(2, "test");
+    std::atomic<int> readable{0};
+    std::atomic<int> finished{0};
+    {
+        DdsReadWaiter waiter(executor, dds.participant());
+        ASSERT_TRUE(waiter.ok());
+        for (int i = 0; i < 2; ++i) {
+            executor.spawn([](DdsReadWaiter& waiter, dds_entity_t reader, std::atomic<int>& readable,
+                              std::atomic<int>& finished) -> Task<> {
+                std::vector<dds_entity_t> readers{reader};
+                for (int n = 0; n < WAITS; ++n) {
+                    if (co_await waiter.readable(readers, 5000ms)) {
+                        readable++;
+                    }
+                }
+                finished++;
+            }(waiter, reader, readable, finished));
+        }
+
+        char payload[] = "{\"id\":1,\"value\":1.0,\"timestamp\":1}";
+        Telemetry_JsonMessage msg;
+        msg.payload = payload;
+        auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (finished < 2 && std::chrono::steady_clock::now() < deadline) {
+            dds_write(writer, &msg);
+            std::this_thread::sleep_for(1ms);
+        }
+        executor.run();
+    }
+    EXPECT_EQ(readable.load(), 2 * WAITS);
+    dds.close();
+}
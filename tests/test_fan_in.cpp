@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "../src/core/fan_in.h"
+
+using namespace telemetry;
+
+// ========== HubSessionTable ==========
+
+TEST(HubSessionTableTest, TracksGapsAndDropsStaleSequencesPerHub) {
+    HubSessionTable table(5000);
+    HubKey hub{0, 0xA1};
+    using Verdict = HubSessionTable::Verdict;
+
+    EXPECT_EQ(table.record(hub, "domain 0", 1, 10, 1000), Verdict::NewSession);
+    EXPECT_EQ(table.record(hub, "domain 0", 1, 11, 1001), Verdict::Accepted);
+    EXPECT_EQ(table.record(hub, "domain 0", 1, 14, 1002), Verdict::Accepted);   // 12, 13 missing
+    EXPECT_EQ(table.record(hub, "domain 0", 1, 13, 1003), Verdict::Stale);
+    EXPECT_EQ(table.record(hub, "domain 0", 2, 0, 1004), Verdict::Accepted);    // other sensor, own sequence
+
+    std::vector<HubSession> sessions = table.sessions();
+    ASSERT_EQ(sessions.size(), 1u);
+    EXPECT_EQ(sessions[0].messages, 4u);
+    EXPECT_EQ(sessions[0].gaps, 2u);
+    EXPECT_EQ(sessions[0].stale, 1u);
+    EXPECT_EQ(sessions[0].first_seen_ms, 1000u);
+    EXPECT_EQ(sessions[0].last_seen_ms, 1004u);
+    EXPECT_EQ(sessions[0].origin, "domain 0");
+}
+
+// Two hubs both publish sensor 1 from sequence 0; neither looks like a
+// gap or a duplicate of the other
+TEST(HubSessionTableTest, SameSensorFromDifferentHubsIsIndependent) {
+    HubSessionTable table;
+    HubKey a{0, 1}, b{0, 2}, c{1, 1};   // c: same handle value, other input
+    for (uint64_t seq = 0; seq < 5; ++seq) {
+        table.record(a, "domain 0", 1, seq, 100);
+        table.record(b, "domain 0", 1, seq, 100);
+        table.record(c, "domain 2", 1, seq, 100);
+    }
+    EXPECT_EQ(table.total_count(), 3u);
+    EXPECT_EQ(table.active_count(), 3u);
+    for (const auto& session : table.sessions()) {
+        EXPECT_EQ(session.messages, 5u);
+        EXPECT_EQ(session.gaps, 0u);
+        EXPECT_EQ(session.stale, 0u);
+    }
+}
+
+TEST(HubSessionTableTest, IdleSessionsExpireAndResume) {
+    HubSessionTable table(1000);
+    HubKey quiet{0, 1}, busy{0, 2};
+    table.record(quiet, "domain 0", 0, 0, 0);
+    table.record(busy, "domain 0", 0, 0, 0);
+    table.record(busy, "domain 0", 0, 1, 900);
+
+    EXPECT_TRUE(table.expire(1000).empty());   // not past the timeout yet
+    std::vector<HubSession> ended = table.expire(1500);
+    ASSERT_EQ(ended.size(), 1u);
+    EXPECT_EQ(ended[0].key.writer, 1u);
+    EXPECT_FALSE(ended[0].active);
+    EXPECT_EQ(table.active_count(), 1u);
+    EXPECT_TRUE(table.expire(1600).empty());   // reported once
+
+    EXPECT_EQ(table.record(quiet, "domain 0", 0, 1, 2000), HubSessionTable::Verdict::Accepted);
+    EXPECT_EQ(table.active_count(), 2u);
+}
+
+// Restarted hubs come back under new keys; ended sessions must not pile up
+TEST(HubSessionTableTest, EndedSessionsAreDroppedAfterRetention) {
+    HubSessionTable table(1000, 10000);
+    for (uint64_t restart = 0; restart < 100; ++restart) {
+        uint64_t now = restart * 2000;
+        table.record(HubKey{0, restart}, "domain 0", 0, 0, now);
+        table.expire(now);
+    }
+    // Sessions idle for up to 10 s are kept (ended), older ones dropped
+    EXPECT_EQ(table.total_count(), 6u);
+    EXPECT_EQ(table.active_count(), 1u);
+    EXPECT_EQ(table.total_count() + table.dropped_count(), 100u);
+
+    // A dropped key that comes back starts over as a new session
+    EXPECT_EQ(table.record(HubKey{0, 0}, "domain 0", 0, 5, 300000), HubSessionTable::Verdict::NewSession);
+}
+
+// ========== WindowAggregator ==========
+
+TEST(WindowAggregatorTest, LaterWindowClosesTheOpenOne) {
+    WindowAggregator windows(1000);
+    HubKey a{0, 1}, b{0, 2};
+    WindowSummary closed;
+
+    EXPECT_FALSE(windows.add(3, 10.0, 5100, a, closed));
+    EXPECT_FALSE(windows.add(3, 30.0, 5500, b, closed));
+    EXPECT_FALSE(windows.add(3, 20.0, 5999, a, closed));
+    ASSERT_TRUE(windows.add(3, 99.0, 6000, a, closed));
+
+    EXPECT_EQ(closed.sensor_id, 3);
+    EXPECT_EQ(closed.start_ms, 5000u);
+    EXPECT_EQ(closed.count, 3u);
+    EXPECT_EQ(closed.min, 10.0);
+    EXPECT_EQ(closed.max, 30.0);
+    EXPECT_DOUBLE_EQ(closed.mean(), 20.0);
+    EXPECT_EQ(closed.sources, 2u);
+
+    std::vector<WindowSummary> rest;
+    windows.drain(rest);
+    ASSERT_EQ(rest.size(), 1u);
+    EXPECT_EQ(rest[0].start_ms, 6000u);
+    EXPECT_EQ(rest[0].count, 1u);
+    EXPECT_EQ(rest[0].sources, 1u);
+}
+
+TEST(WindowAggregatorTest, PollClosesQuietWindowsAfterGrace) {
+    WindowAggregator windows(1000, 500);
+    WindowSummary closed;
+    windows.add(1, 1.0, 2200, HubKey{0, 1}, closed);
+    windows.add(2, 2.0, 2700, HubKey{0, 1}, closed);
+
+    std::vector<WindowSummary> out;
+    windows.poll(3499, out);   // window [2000, 3000) + 500 ms grace not over yet
+    EXPECT_TRUE(out.empty());
+    windows.poll(3500, out);
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_EQ(out[0].sensor_id, 1);
+    EXPECT_EQ(out[1].sensor_id, 2);
+
+    out.clear();
+    windows.poll(10000, out);   // nothing left open
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(WindowAggregatorTest, LateSamplesFoldIntoTheOpenWindow) {
+    WindowAggregator windows(1000);
+    WindowSummary closed;
+    windows.add(1, 5.0, 8100, HubKey{0, 1}, closed);
+    EXPECT_FALSE(windows.add(1, 7.0, 7900, HubKey{0, 2}, closed));   // a hub with a slower clock
+    EXPECT_EQ(windows.late_samples(), 1u);
+
+    std::vector<WindowSummary> out;
+    windows.drain(out);
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].start_ms, 8000u);
+    EXPECT_EQ(out[0].count, 2u);
+    EXPECT_EQ(out[0].sources, 2u);
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/core/frame_log.h"
+#include "../src/core/log_sinks.h"
+#include "../src/core/lz_codec.h"
+
+using namespace telemetry;
+
+std::vector<uint8_t> round_trip(const std::vector<uint8_t>& input) {
+    std::vector<uint8_t> compressed, output;
+    lz::compress(input.data(), input.size(), compressed);
+    EXPECT_TRUE(lz::decompress(compressed.data(), compressed.size(), input.size(), output));
+    return output;
+}
+
+TEST(LzCodecTest, RoundTripEdgeCases) {
+    EXPECT_TRUE(round_trip({}).empty());
+
+    std::vector<uint8_t> tiny = {'a', 'b', 'c'};
+    EXPECT_EQ(tiny, round_trip(tiny));
+
+    std::vector<uint8_t> run(10000, 'x');  // long overlapping match
+    EXPECT_EQ(run, round_trip(run));
+
+    std::mt19937 gen(42);
+    std::vector<uint8_t> noise(70000);       // incompressible, > 64K window
+    for (auto& b : noise) b = static_cast<uint8_t>(gen());
+    EXPECT_EQ(noise, round_trip(noise));
+}
+
+TEST(LzCodecTest, CompressesCsvRows) {
+    std::string rows;
+    for (uint64_t seq = 0; seq < 2000; ++seq) {
+        LogRecord r;
+        r.data = SensorData{static_cast<int>(seq % 3), 20.0 + (seq % 97) * 0.1, static_cast<long>(1700000000000L + seq * 500)};
+        r.sequence = seq / 3;
+        r.received_ms = 1700000000000ULL + seq * 500;
+        format_csv_row(r, rows);
+    }
+
+    std::vector<uint8_t> compressed, output;
+    lz::compress(reinterpret_cast<const uint8_t*>(rows.data()), rows.size(), compressed);
+    EXPECT_LT(compressed.size() * 2, rows.size());
+
+    ASSERT_TRUE(lz::decompress(compressed.data(), compressed.size(), rows.size(), output));
+    EXPECT_EQ(rows, std::string(output.begin(), output.end()));
+}
+
+TEST(LzCodecTest, RejectsCorruptInput) {
+    std::vector<uint8_t> output;
+    std::vector<uint8_t> bad_offset = {0x10, 'a', 0x00, 0x10};  // offset beyond output
+    EXPECT_FALSE(lz::decompress(bad_offset.data(), bad_offset.size(), 100, output));
+
+    std::vector<uint8_t> truncated = {0xF0};
+    EXPECT_FALSE(lz::decompress(truncated.data(), truncated.size(), 100, output));
+}
+
+TEST(FrameLogTest, ReaderFindsFramesByTime) {
+    const std::string path = "test_frames.mtz";
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    {
+        CompressedFrameSink sink(path, 4096, 60000);
+        ASSERT_TRUE(sink.open());
+        for (uint64_t seq = 0; seq < 1000; ++seq) {
+            LogRecord r;
+            r.data = SensorData{0, 25.0, static_cast<long>(1000 + seq * 10)};
+            r.sequence = seq;
+            r.received_ms = 1700000000000ULL;
+            sink.write(r);
+        }
+        sink.close();
+    }
+
+    FrameReader reader(path);
+    ASSERT_TRUE(reader.open());
+    ASSERT_GT(reader.frames().size(), 3u);
+
+    // Timestamps 5000..5100 are sequences 400..410
+    auto hits = reader.frames_overlapping(5000, 5100);
+    ASSERT_GE(hits.size(), 1u);
+    EXPECT_LT(hits.size(), reader.frames().size());
+
+    bool found = false;
+    for (const auto& frame : hits) {
+        std::string rows;
+        ASSERT_TRUE(reader.read_frame(frame, rows));
+        size_t pos = 0;
+        while (pos < rows.size()) {
+            size_t nl = rows.find('\n', pos);
+            LogRecord r;
+            ASSERT_TRUE(parse_csv_row(rows.substr(pos, nl - pos), r));
+            if (r.sequence == 405) {
+                EXPECT_EQ(5050, r.data.timestamp);
+                found = true;
+            }
+            pos = nl + 1;
+        }
+    }
+    EXPECT_TRUE(found);
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+}
+
+TEST(FrameLogTest, ReaderRebuildsMissingIndex) {
+    const std::string path = "test_frames_noidx.mtz";
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    size_t written_frames;
+    {
+        CompressedFrameSink sink(path, 1024, 60000);
+        ASSERT_TRUE(sink.open());
+        for (uint64_t seq = 0; seq < 300; ++seq) {
+            LogRecord r;
+            r.data = SensorData{1, 50.0, static_cast<long>(seq)};
+            r.sequence = seq;
+            sink.write(r);
+        }
+        sink.close();
+        FrameReader with_index(path);
+        ASSERT_TRUE(with_index.open());
+        written_frames = with_index.frames().size();
+    }
+    std::remove((path + ".idx").c_str());
+
+    FrameReader reader(path);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(written_frames, reader.frames().size());
+
+    std::remove(path.c_str());
+}
+
+// A crash can leave a torn frame, a torn index line and frames the index
+// never heard of. The next run repairs all three before appending.
+TEST(FrameLogTest, SinkRepairsTornFrameAndIndexOnOpen) {
+    const std::string path = "test_frames_torn.mtz";
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    auto write_run = [&](long first_ts, int rows) {
+        CompressedFrameSink sink(path, 1024, 60000);
+        ASSERT_TRUE(sink.open());
+        for (int i = 0; i < rows; ++i) {
+            LogRecord r;
+            r.data = SensorData{0, 1.0, first_ts + i};
+            r.sequence = static_cast<uint64_t>(first_ts + i);
+            r.received_ms = 1700000000000ULL;
+            sink.write(r);
+        }
+        sink.close();
+    };
+    write_run(0, 200);
+
+    size_t first_run_frames;
+    {
+        FrameReader reader(path);
+        ASSERT_TRUE(reader.open());
+        first_run_frames = reader.frames().size();
+        ASSERT_GE(first_run_frames, 3u);
+    }
+    {
+        // Index: drop the last two lines, then leave half of one behind
+        std::ifstream in(path + ".idx");
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(in, line);) lines.push_back(line);
+        in.close();
+        std::ofstream out(path + ".idx", std::ios::trunc);
+        for (size_t i = 0; i + 2 < lines.size(); ++i) out << lines[i] << "\n";
+        out << lines[lines.size() - 2].substr(0, 5);
+        // Data: half a frame header
+        std::ofstream data(path, std::ios::binary | std::ios::app);
+        data.write("MTFR\x01\x02", 6);
+    }
+
+    write_run(10000, 200);
+
+    FrameReader reader(path);
+    ASSERT_TRUE(reader.open());
+    ASSERT_GT(reader.frames().size(), first_run_frames);
+    std::vector<long> timestamps;
+    std::string rows;
+    for (const auto& frame : reader.frames()) {
+        ASSERT_TRUE(reader.read_frame(frame, rows));
+        std::istringstream lines(rows);
+        std::string line;
+        LogRecord record;
+        while (std::getline(lines, line)) {
+            ASSERT_TRUE(parse_csv_row(line, record)) << line;
+            timestamps.push_back(record.data.timestamp);
+        }
+    }
+    ASSERT_EQ(400u, timestamps.size());
+    EXPECT_EQ(0, timestamps.front());
+    EXPECT_EQ(199, timestamps[199]);   // frames the index had lost are kept
+    EXPECT_EQ(10000, timestamps[200]);
+
+    // The index alone now describes every frame
+    std::ifstream index(path + ".idx");
+    size_t index_lines = 0;
+    for (std::string line; std::getline(index, line);) index_lines++;
+    EXPECT_EQ(reader.frames().size(), index_lines);
+
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+}
@@ -0,0 +1,320 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/core/frame_log.h"
+#include "../src/core/history.h"
+#include "../src/core/log_sinks.h"
+
+using namespace telemetry;
+
+LogRecord history_record(int id, uint64_t seq, long ts) {
+    LogRecord r;
+    r.data = SensorData{id, 20.0 + seq, ts};
+    r.sequence = seq;
+    r.received_ms = 1700000000000ULL;
+    return r;
+}
+
+TEST(HistoryTest, RequestAndBatchRoundTrip) {
+    HistoryRequest request;
+    request.request_id = "monitor-1";
+    request.sensors = {0, 2};
+    request.from_ts = 1000;
+    request.to_ts = 2000;
+    request.max_samples = 50;
+
+    HistoryRequest parsed_request;
+    ASSERT_TRUE(parse_history_request(encode_history_request(request).c_str(), parsed_request));
+    EXPECT_EQ("monitor-1", parsed_request.request_id);
+    EXPECT_EQ(request.sensors, parsed_request.sensors);
+    EXPECT_EQ(1000, parsed_request.from_ts);
+    EXPECT_EQ(2000, parsed_request.to_ts);
+    EXPECT_EQ(50u, parsed_request.max_samples);
+
+    HistoryBatch batch;
+    batch.request_id = "monitor-1";
+    batch.batch = 3;
+    batch.final = true;
+    batch.samples = {history_record(2, 9, 1500)};
+
+    HistoryBatch parsed_batch;
+    ASSERT_TRUE(parse_history_batch(encode_history_batch(batch).c_str(), parsed_batch));
+    EXPECT_EQ(3u, parsed_batch.batch);
+    EXPECT_TRUE(parsed_batch.final);
+    ASSERT_EQ(1u, parsed_batch.samples.size());
+    EXPECT_EQ(2, parsed_batch.samples[0].data.id);
+    EXPECT_EQ(9u, parsed_batch.samples[0].sequence);
+    EXPECT_EQ(1500, parsed_batch.samples[0].data.timestamp);
+
+    EXPECT_FALSE(parse_history_batch("{not json", parsed_batch));
+}
+
+TEST(HistoryTest, ScansCsvInBatches) {
+    const std::string csv = "test_history_log.csv";
+    std::remove(csv.c_str());
+    {
+        CsvSink sink(csv);
+        ASSERT_TRUE(sink.open());
+        for (uint64_t seq = 0; seq < 100; ++seq) {
+            sink.write(history_record(static_cast<int>(seq % 2), seq, static_cast<long>(seq * 10)));
+        }
+        sink.close();
+    }
+
+    HistoryRequest request;
+    request.sensors = {1};
+    request.from_ts = 200;
+    request.to_ts = 599;
+
+    HistorySource source;
+    source.csv_path = csv;
+
+    std::vector<size_t> batch_sizes;
+    std::vector<LogRecord> received;
+    uint64_t total = scan_history(source, request, 7, [&](const std::vector<LogRecord>& batch) {
+        batch_sizes.push_back(batch.size());
+        received.insert(received.end(), batch.begin(), batch.end());
+        return true;
+    });
+
+    // Odd sequences 21..59 -> 20 samples, in batches of at most 7
+    EXPECT_EQ(20u, total);
+    ASSERT_EQ(20u, received.size());
+    EXPECT_EQ(21u, received.front().sequence);
+    EXPECT_EQ(59u, received.back().sequence);
+    for (size_t n : batch_sizes) EXPECT_LE(n, 7u);
+
+    // The requester can stop the stream
+    uint64_t aborted = scan_history(source, request, 5, [](const std::vector<LogRecord>&) {
+        return false;
+    });
+    EXPECT_EQ(5u, aborted);
+
+    request.max_samples = 3;
+    EXPECT_EQ(3u, scan_history(source, request, 100, [](const std::vector<LogRecord>&) {
+        return true;
+    }));
+
+    std::remove(csv.c_str());
+}
+
+TEST(HistoryTest, CombinesSealedFramesWithCsvTail) {
+    const std::string csv = "test_history_tail.csv";
+    const std::string mtz = "test_history_tail.mtz";
+    std::remove(csv.c_str());
+    std::remove(mtz.c_str());
+    std::remove((mtz + ".idx").c_str());
+
+    CsvSink csv_sink(csv);
+    CompressedFrameSink frame_sink(mtz, 512, 60000, csv);
+    ASSERT_TRUE(csv_sink.open());
+    ASSERT_TRUE(frame_sink.open());
+    for (uint64_t seq = 0; seq < 200; ++seq) {
+        LogRecord r = history_record(0, seq, static_cast<long>(seq));
+        csv_sink.write(r);
+        frame_sink.write(r);
+    }
+    csv_sink.flush();
+    frame_sink.flush();   // the last, partial frame stays unsealed
+
+    HistoryRequest request;
+    request.from_ts = 0;
+    request.to_ts = 1000;
+
+    HistorySource source;
+    source.csv_path = csv;
+    source.compressed_path = mtz;
+
+    std::vector<uint64_t> sequences;
+    scan_history(source, request, 64, [&](const std::vector<LogRecord>& batch) {
+        for (const auto& r : batch) sequences.push_back(r.sequence);
+        return true;
+    });
+
+    ASSERT_EQ(200u, sequences.size());
+    for (uint64_t i = 0; i < sequences.size(); ++i) {
+        EXPECT_EQ(i, sequences[i]);
+    }
+
+    csv_sink.close();
+    frame_sink.close();
+    std::remove(csv.c_str());
+    std::remove(mtz.c_str());
+    std::remove((mtz + ".idx").c_str());
+}
+
+namespace {
+
+// Writes `records` to both a CSV log and a compressed log, the way the
+// logger fans them out; frames seal at about 512 raw bytes
+void write_both(const std::string& csv, const std::string& mtz, const std::vector<LogRecord>& records) {
+    CsvSink csv_sink(csv);
+    CompressedFrameSink frame_sink(mtz, 512, 60000, csv);
+    ASSERT_TRUE(csv_sink.open());
+    ASSERT_TRUE(frame_sink.open());
+    for (const auto& r : records) {
+        csv_sink.write(r);
+        frame_sink.write(r);
+    }
+    csv_sink.close();
+    frame_sink.flush();   // the last, partial frame stays unsealed
+}
+
+std::vector<uint64_t> scan_sequences(const HistorySource& source, uint64_t* bad_frames = nullptr) {
+    HistoryRequest request;
+    request.from_ts = 0;
+    request.to_ts = 100000;
+    std::vector<uint64_t> sequences;
+    scan_history(source, request, 64, [&](const std::vector<LogRecord>& batch) {
+        for (const auto& r : batch) sequences.push_back(r.sequence);
+        return true;
+    }, bad_frames);
+    return sequences;
+}
+
+void remove_logs(const std::string& csv, const std::string& mtz) {
+    std::remove(csv.c_str());
+    std::remove(mtz.c_str());
+    std::remove((mtz + ".idx").c_str());
+}
+
+} // namespace
+
+// Timestamps can go backwards (clock steps, several hubs). Rows after the
+// last sealed one are served from the CSV even if they are older than it.
+TEST(HistoryTest, CsvTailKeepsRowsOlderThanTheNewestSealedRow) {
+    const std::string csv = "test_history_order.csv";
+    const std::string mtz = "test_history_order.mtz";
+    remove_logs(csv, mtz);
+
+    std::vector<LogRecord> records;
+    for (uint64_t seq = 0; seq < 200; ++seq) {
+        // Every fourth sample carries a timestamp from well in the past
+        long ts = seq % 4 == 3 ? static_cast<long>(seq) : static_cast<long>(1000 + seq);
+        records.push_back(history_record(static_cast<int>(seq % 2), seq, ts));
+    }
+    write_both(csv, mtz, records);
+
+    HistorySource source;
+    source.csv_path = csv;
+    source.compressed_path = mtz;
+    std::vector<uint64_t> sequences = scan_sequences(source);
+    std::sort(sequences.begin(), sequences.end());
+    ASSERT_EQ(200u, sequences.size());
+    for (uint64_t i = 0; i < sequences.size(); ++i) {
+        EXPECT_EQ(i, sequences[i]);
+    }
+    remove_logs(csv, mtz);
+}
+
+// A damaged frame costs only its own rows, and is reported
+TEST(HistoryTest, UnreadableFrameIsSkippedAndCounted) {
+    const std::string csv = "test_history_corrupt.csv";
+    const std::string mtz = "test_history_corrupt.mtz";
+    remove_logs(csv, mtz);
+
+    std::vector<LogRecord> records;
+    for (uint64_t seq = 0; seq < 200; ++seq) {
+        records.push_back(history_record(0, seq, static_cast<long>(seq)));
+    }
+    write_both(csv, mtz, records);
+
+    FrameReader reader(mtz);
+    ASSERT_TRUE(reader.open());
+    ASSERT_GE(reader.frames().size(), 3u);
+    FrameInfo damaged = reader.frames()[1];
+    {
+        std::fstream data(mtz, std::ios::in | std::ios::out | std::ios::binary);
+        data.seekp(static_cast<std::streamoff>(damaged.offset + FRAME_HEADER_SIZE));
+        std::string garbage(damaged.comp_size, '\xff');
+        data.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+    }
+
+    HistorySource source;
+    source.csv_path = csv;
+    source.compressed_path = mtz;
+    uint64_t bad_frames = 0;
+    std::vector<uint64_t> sequences = scan_sequences(source, &bad_frames);
+    EXPECT_EQ(1u, bad_frames);
+    EXPECT_EQ(200u - damaged.records, sequences.size());
+    EXPECT_EQ(199u, sequences.back());   // later frames and the CSV tail still served
+    remove_logs(csv, mtz);
+}
+
+// A CSV that doesn't line up with the frames (here it starts later) falls
+// back to the newest sealed timestamp
+TEST(HistoryTest, MismatchedCsvFallsBackToSealedTimestamp) {
+    const std::string csv = "test_history_mismatch.csv";
+    const std::string mtz = "test_history_mismatch.mtz";
+    remove_logs(csv, mtz);
+
+    std::vector<LogRecord> records;
+    for (uint64_t seq = 0; seq < 200; ++seq) {
+        records.push_back(history_record(0, seq, static_cast<long>(seq)));
+    }
+    write_both(csv, mtz, records);
+    std::remove(csv.c_str());
+    {
+        CsvSink csv_sink(csv);
+        ASSERT_TRUE(csv_sink.open());
+        for (uint64_t seq = 150; seq < 200; ++seq) {
+            csv_sink.write(records[seq]);
+        }
+        csv_sink.close();
+    }
+
+    HistorySource source;
+    source.csv_path = csv;
+    source.compressed_path = mtz;
+    std::vector<uint64_t> sequences = scan_sequences(source);
+    ASSERT_EQ(200u, sequences.size());
+    for (uint64_t i = 0; i < sequences.size(); ++i) {
+        EXPECT_EQ(i, sequences[i]);
+    }
+    remove_logs(csv, mtz);
+}
+
+// Each indexed frame records where its rows end in the CSV, including
+// after a restart that lost an unsealed frame
+TEST(HistoryTest, FrameIndexPointsIntoCsvAcrossRestarts) {
+    const std::string csv = "test_history_offsets.csv";
+    const std::string mtz = "test_history_offsets.mtz";
+    remove_logs(csv, mtz);
+
+    std::vector<LogRecord> records;
+    for (uint64_t seq = 0; seq < 400; ++seq) {
+        records.push_back(history_record(0, seq, static_cast<long>(seq)));
+    }
+    write_both(csv, mtz, std::vector<LogRecord>(records.begin(), records.begin() + 200));
+    {
+        CsvSink csv_sink(csv);
+        CompressedFrameSink frame_sink(mtz, 512, 60000, csv);
+        ASSERT_TRUE(csv_sink.open());
+        ASSERT_TRUE(frame_sink.open());
+        for (size_t i = 200; i < records.size(); ++i) {
+            csv_sink.write(records[i]);
+            frame_sink.write(records[i]);
+        }
+        csv_sink.close();
+        frame_sink.close();
+    }
+
+    std::ifstream in(csv, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    FrameReader reader(mtz);
+    ASSERT_TRUE(reader.open());
+    ASSERT_GT(reader.frames().size(), 4u);
+    std::string rows;
+    for (const auto& frame : reader.frames()) {
+        ASSERT_TRUE(reader.read_frame(frame, rows));
+        ASSERT_LE(frame.csv_end, contents.size());
+        ASSERT_GE(frame.csv_end, rows.size());
+        EXPECT_EQ(rows, contents.substr(frame.csv_end - rows.size(), rows.size()));
+    }
+    EXPECT_EQ(contents.size(), reader.frames().back().csv_end);
+    remove_logs(csv, mtz);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "../src/core/kernels.h"
+
+using namespace telemetry;
+
+namespace {
+
+std::vector<const Kernels*> simd_variants() {
+    std::vector<const Kernels*> variants;
+    for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (const Kernels* k = kernels_for(isa)) {
+            variants.push_back(k);
+        }
+    }
+    return variants;
+}
+
+std::vector<double> random_values(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> dist(20.0, 15.0);
+    std::vector<double> values(n);
+    for (double& v : values) {
+        v = dist(rng);
+    }
+    return values;
+}
+
+// Compares one variant with the scalar kernels on values[offset, offset + n)
+void expect_matches_scalar(const Kernels& k, const std::vector<double>& values, size_t offset, size_t n) {
+    const Kernels& ref = *kernels_for(Isa::Scalar);
+    const double* p = values.data() + offset;
+    SCOPED_TRACE(std::string(isa_name(k.isa)) + " n=" + std::to_string(n) + " offset=" + std::to_string(offset));
+
+    EXPECT_EQ(k.min(p, n), ref.min(p, n));
+    EXPECT_EQ(k.max(p, n), ref.max(p, n));
+    double sum = ref.sum(p, n);
+    double squares = ref.sum_squares(p, n);
+    EXPECT_NEAR(k.sum(p, n), sum, 1e-12 * (1.0 + squares));
+    EXPECT_NEAR(k.sum_squares(p, n), squares, 1e-12 * (1.0 + squares));
+    EXPECT_EQ(k.count_in_range(p, n, 0.0, 40.0), ref.count_in_range(p, n, 0.0, 40.0));
+
+    std::vector<uint64_t> expected(37, 0), actual(37, 0);
+    ref.histogram(p, n, -10.0, 50.0, expected.data(), expected.size());
+    k.histogram(p, n, -10.0, 50.0, actual.data(), actual.size());
+    EXPECT_EQ(actual, expected);
+}
+
+} // namespace
+
+// ========== Scalar reference ==========
+
+TEST(KernelsTest, ScalarResultsOnKnownBlock) {
+    const Kernels& k = *kernels_for(Isa::Scalar);
+    const double values[] = {3.0, -1.5, 7.25, 0.0, 2.0};
+    EXPECT_EQ(k.min(values, 5), -1.5);
+    EXPECT_EQ(k.max(values, 5), 7.25);
+    EXPECT_DOUBLE_EQ(k.sum(values, 5), 10.75);
+    EXPECT_DOUBLE_EQ(k.sum_squares(values, 5), 9.0 + 2.25 + 52.5625 + 4.0);
+    EXPECT_EQ(k.count_in_range(values, 5, 0.0, 3.0), 3u);   // inclusive at both ends
+
+    uint64_t buckets[4] = {0, 0, 0, 0};
+    k.histogram(values, 5, 0.0, 8.0, buckets, 4);   // [0,2) [2,4) [4,6) [6,8)
+    EXPECT_EQ(buckets[0], 1u);
+    EXPECT_EQ(buckets[1], 2u);
+    EXPECT_EQ(buckets[2], 0u);
+    EXPECT_EQ(buckets[3], 1u);
+}
+
+TEST(KernelsTest, EmptyInputIdentities) {
+    for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        const Kernels* k = kernels_for(isa);
+        if (k == nullptr) continue;
+        SCOPED_TRACE(isa_name(isa));
+        EXPECT_EQ(k->min(nullptr, 0), std::numeric_limits<double>::infinity());
+        EXPECT_EQ(k->max(nullptr, 0), -std::numeric_limits<double>::infinity());
+        EXPECT_EQ(k->sum(nullptr, 0), 0.0);
+        EXPECT_EQ(k->sum_squares(nullptr, 0), 0.0);
+        EXPECT_EQ(k->count_in_range(nullptr, 0, 0.0, 1.0), 0u);
+    }
+}
+
+TEST(KernelsTest, HistogramAccumulatesAndSkipsDegenerateRanges) {
+    const Kernels& k = kernels();
+    std::vector<double> values = {0.5, 1.5, 2.5, 3.5};
+    std::vector<uint64_t> buckets(4, 0);
+    k.histogram(values.data(), values.size(), 0.0, 4.0, buckets.data(), buckets.size());
+    k.histogram(values.data(), values.size(), 0.0, 4.0, buckets.data(), buckets.size());
+    EXPECT_EQ(buckets, (std::vector<uint64_t>{2, 2, 2, 2}));
+
+    k.histogram(values.data(), values.size(), 4.0, 4.0, buckets.data(), buckets.size());
+    k.histogram(values.data(), values.size(), 0.0, 4.0, buckets.data(), 0);
+    EXPECT_EQ(buckets, (std::vector<uint64_t>{2, 2, 2, 2}));
+}
+
+TEST(KernelsTest, DispatchHonoursDetectedIsa) {
+    EXPECT_EQ(kernels().isa, detected_isa());
+    ASSERT_NE(kernels_for(Isa::Scalar), nullptr);
+    EXPECT_STREQ(isa_name(Isa::AVX512), "avx512");
+}
+
+// ========== SIMD variants vs. scalar ==========
+
+TEST(KernelsTest, EveryLengthAndAlignmentMatchesScalar) {
+    std::vector<double> values = random_values(200, 7);
+    for (const Kernels* k : simd_variants()) {
+        for (size_t offset = 0; offset < 8; ++offset) {
+            for (size_t n = 0; n <= 100; ++n) {
+                expect_matches_scalar(*k, values, offset, n);
+            }
+        }
+    }
+}
+
+TEST(KernelsTest, LargeBlocksMatchScalar) {
+    std::vector<double> values = random_values((1 << 20) + 13, 11);
+    for (const Kernels* k : simd_variants()) {
+        expect_matches_scalar(*k, values, 3, values.size() - 3);
+    }
+}
+
+// Values on and either side of bucket edges (0.1 steps over 100 buckets of
+// width 0.1), where the index arithmetic rounds; the SIMD variants must land them in the same buckets
+TEST(KernelsTest, HistogramEdgesMatchScalar) {
+    std::vector<double> values;
+    for (int i = -5; i <= 105; ++i) {
+        double edge = i * 0.1;
+        values.push_back(edge);
+        values.push_back(std::nextafter(edge, -1e9));
+        values.push_back(std::nextafter(edge, 1e9));
+    }
+    values.push_back(std::nan(""));
+    values.push_back(std::numeric_limits<double>::infinity());
+    values.push_back(-std::numeric_limits<double>::infinity());
+
+    const Kernels& ref = *kernels_for(Isa::Scalar);
+    std::vector<uint64_t> expected(100, 0);
+    ref.histogram(values.data(), values.size(), 0.0, 10.0, expected.data(), expected.size());
+
+    for (const Kernels* k : simd_variants()) {
+        SCOPED_TRACE(isa_name(k->isa));
+        std::vector<uint64_t> actual(100, 0);
+        k->histogram(values.data(), values.size(), 0.0, 10.0, actual.data(), actual.size());
+        EXPECT_EQ(actual, expected);
+        EXPECT_EQ(k->count_in_range(values.data(), values.size(), 0.0, 1.0),
+                  ref.count_in_range(values.data(), values.size(), 0.0, 1.0));
+    }
+}
@@ -0,0 +1,336 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/core/bounded_queue.h"
+#include "../src/core/log_sink.h"
+#include "../src/core/log_sinks.h"
+
+using namespace telemetry;
+
+// Sink that records what it receives, optionally sleeping per record
+class CollectingSink : public LogSink {
+public:
+    CollectingSink(std::vector<uint64_t>* out, std::mutex* mutex, int delay_ms = 0)
+        : out_(out), mutex_(mutex), delay_ms_(delay_ms) {}
+
+    const char* name() const override { return "collect"; }
+    bool open() override { return true; }
+    void write(const LogRecord& record) override {
+        if (delay_ms_ > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+        }
+        std::lock_guard<std::mutex> lock(*mutex_);
+        out_->push_back(record.sequence);
+    }
+    void flush() override {}
+    void close() override {}
+
+private:
+    std::vector<uint64_t>* out_;
+    std::mutex* mutex_;
+    int delay_ms_;
+};
+
+LogRecord make_record(int id, uint64_t seq, double value = 25.0, long ts = 1000) {
+    LogRecord r;
+    r.data = SensorData{id, value, ts};
+    r.sequence = seq;
+    r.received_ms = wall_clock_ms();
+    return r;
+}
+
+TEST(BoundedQueueTest, DropNewestRejectsWhenFull) {
+    BoundedQueue<int> queue(2, OverflowPolicy::DropNewest);
+
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_FALSE(queue.push(3));
+
+    int value;
+    ASSERT_TRUE(queue.pop_for(value, std::chrono::milliseconds(10)));
+    EXPECT_EQ(1, value);
+    ASSERT_TRUE(queue.pop_for(value, std::chrono::milliseconds(10)));
+    EXPECT_EQ(2, value);
+    EXPECT_FALSE(queue.pop_for(value, std::chrono::milliseconds(10)));
+}
+
+TEST(BoundedQueueTest, DropOldestEvictsHead) {
+    BoundedQueue<int> queue(2, OverflowPolicy::DropOldest);
+
+    queue.push(1);
+    queue.push(2);
+    EXPECT_FALSE(queue.push(3)); // 1 was evicted
+
+    int value;
+    ASSERT_TRUE(queue.pop_for(value, std::chrono::milliseconds(10)));
+    EXPECT_EQ(2, value);
+    ASSERT_TRUE(queue.pop_for(value, std::chrono::milliseconds(10)));
+    EXPECT_EQ(3, value);
+}
+
+TEST(BoundedQueueTest, BlockWaitsForSpace) {
+    BoundedQueue<int> queue(1, OverflowPolicy::Block);
+    queue.push(1);
+
+    std::thread producer([&queue]() { queue.push(2); });
+
+    int value;
+    ASSERT_TRUE(queue.pop_for(value, std::chrono::milliseconds(100)));
+    EXPECT_EQ(1, value);
+    producer.join();
+    ASSERT_TRUE(queue.pop_for(value, std::chrono::milliseconds(100)));
+    EXPECT_EQ(2, value);
+}
+
+TEST(FanOutLoggerTest, EverySinkSeesEveryRecord) {
+    std::mutex mutex;
+    std::vector<uint64_t> a, b;
+
+    FanOutLogger fanout;
+    fanout.add_sink(std::make_unique<CollectingSink>(&a, &mutex), 64, OverflowPolicy::Block);
+    fanout.add_sink(std::make_unique<CollectingSink>(&b, &mutex), 64, OverflowPolicy::Block);
+    ASSERT_TRUE(fanout.start());
+
+    for (uint64_t seq = 0; seq < 100; ++seq) {
+        fanout.publish(make_record(0, seq));
+    }
+    fanout.stop();
+
+    ASSERT_EQ(100u, a.size());
+    ASSERT_EQ(100u, b.size());
+    EXPECT_EQ(99u, a.back());
+
+    for (const auto& s : fanout.stats()) {
+        EXPECT_EQ(100u, s.enqueued);
+        EXPECT_EQ(100u, s.written);
+        EXPECT_EQ(0u, s.dropped);
+    }
+}
+
+TEST(FanOutLoggerTest, SlowSheddingSinkDoesNotStallFastSink) {
+    std::mutex mutex;
+    std::vector<uint64_t> fast, slow;
+
+    FanOutLogger fanout;
+    fanout.add_sink(std::make_unique<CollectingSink>(&fast, &mutex), 1024, OverflowPolicy::Block);
+    fanout.add_sink(std::make_unique<CollectingSink>(&slow, &mutex, 5), 4, OverflowPolicy::DropNewest);
+    ASSERT_TRUE(fanout.start());
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t seq = 0; seq < 200; ++seq) {
+        fanout.publish(make_record(0, seq));
+    }
+    auto publish_time = std::chrono::steady_clock::now() - start;
+    fanout.stop();
+
+    // 200 records at 5ms each would take a second if the slow sink blocked us
+    EXPECT_LT(publish_time, std::chrono::milliseconds(500));
+    EXPECT_EQ(200u, fast.size());
+
+    auto stats = fanout.stats();
+    EXPECT_GT(stats[1].dropped, 0u);
+    EXPECT_EQ(200u, stats[1].written + stats[1].dropped);
+}
+
+TEST(LogSinksTest, CsvRowFormat) {
+    LogRecord r = make_record(2, 17, 45.678, 1700000000123);
+    std::string row;
+    format_csv_row(r, row);
+
+    EXPECT_EQ(0u, row.find("1700000000123,2,45.68,17,"));
+    EXPECT_EQ('\n', row.back());
+}
+
+TEST(LogSinksTest, BinaryRecordRoundTrip) {
+    LogRecord original = make_record(7, 123456789, -12.5, 1700000000999);
+    unsigned char buf[BinarySegmentSink::RECORD_SIZE];
+    BinarySegmentSink::encode_record(original, buf);
+
+    LogRecord parsed;
+    BinarySegmentSink::decode_record(buf, parsed);
+    EXPECT_EQ(original.data.id, parsed.data.id);
+    EXPECT_DOUBLE_EQ(original.data.value, parsed.data.value);
+    EXPECT_EQ(original.data.timestamp, parsed.data.timestamp);
+    EXPECT_EQ(original.sequence, parsed.sequence);
+    EXPECT_EQ(original.received_ms, parsed.received_ms);
+}
+
+TEST(LogSinksTest, RollupEmitsOneRowPerWindow) {
+    const std::string path = "test_rollup_output.csv";
+    {
+        RollupSink sink(path, 1000);
+        ASSERT_TRUE(sink.open());
+        sink.write(make_record(0, 0, 10.0, 1000));
+        sink.write(make_record(0, 1, 20.0, 1500));
+        sink.write(make_record(0, 2, 30.0, 2100)); // closes window 1000
+        sink.close();                              // flushes window 2000
+    }
+
+    std::ifstream in(path);
+    std::string header, first, second, extra;
+    std::getline(in, header);
+    std::getline(in, first);
+    std::getline(in, second);
+    EXPECT_EQ("1000,0,2,10.00,20.00,15.00", first);
+    EXPECT_EQ("2000,0,1,30.00,30.00,30.00", second);
+    EXPECT_FALSE(std::getline(in, extra));
+    std::remove(path.c_str());
+}
+
+// A late sample from an emitted window must not cut the open one short
+TEST(LogSinksTest, RollupDropsSamplesFromClosedWindows) {
+    const std::string path = "test_rollup_late.csv";
+    std::remove(path.c_str());
+    {
+        RollupSink sink(path, 1000);
+        ASSERT_TRUE(sink.open());
+        sink.write(make_record(0, 0, 10.0, 1000));
+        sink.write(make_record(0, 1, 20.0, 2100)); // closes window 1000
+        sink.write(make_record(0, 2, 99.0, 1900)); // late for window 1000
+        sink.write(make_record(0, 3, 40.0, 2500));
+        EXPECT_EQ(1u, sink.late_dropped());
+        sink.close();
+    }
+
+    std::ifstream in(path);
+    std::string header, first, second, extra;
+    std::getline(in, header);
+    std::getline(in, first);
+    std::getline(in, second);
+    EXPECT_EQ("1000,0,1,10.00,10.00,10.00", first);
+    EXPECT_EQ("2000,0,2,20.00,40.00,30.00", second);
+    EXPECT_FALSE(std::getline(in, extra));
+    std::remove(path.c_str());
+}
+
+TEST(CheckpointTest, SaveLoadRoundTrip) {
+    const std::string path = "test_checkpoint.ckpt";
+    {
+        SequenceCheckpoint checkpoint(path);
+        checkpoint.advance(0, 41, 5000);
+        checkpoint.advance(2, 7, 6000);
+        ASSERT_TRUE(checkpoint.save());
+    }
+
+    SequenceCheckpoint loaded(path);
+    ASSERT_TRUE(loaded.load());
+    EXPECT_TRUE(loaded.covers(0, 41, 5000));
+    EXPECT_TRUE(loaded.covers(0, 10, 3000));
+    EXPECT_FALSE(loaded.covers(0, 42, 5500));
+    EXPECT_FALSE(loaded.covers(1, 0, 100));   // sensor never seen
+    // Restarted hub: low sequence but newer timestamp is new data
+    EXPECT_FALSE(loaded.covers(2, 0, 9000));
+    std::remove(path.c_str());
+}
+
+TEST(CheckpointTest, CsvSinkAppendsAndCommitsMarks) {
+    const std::string csv = "test_restart_log.csv";
+    const std::string ckpt = "test_restart_log.csv.ckpt";
+    std::remove(csv.c_str());
+    std::remove(ckpt.c_str());
+
+    for (uint64_t run = 0; run < 2; ++run) {
+        CsvSink sink(csv, ckpt);
+        ASSERT_TRUE(sink.open());
+        for (uint64_t seq = run * 5; seq < run * 5 + 5; ++seq) {
+            sink.write(make_record(0, seq, 1.0, 1000 + seq));
+        }
+        sink.flush();
+        sink.close();
+    }
+
+    std::ifstream in(csv);
+    std::string line;
+    int header_lines = 0, data_lines = 0;
+    while (std::getline(in, line)) {
+        if (line.rfind("timestamp,", 0) == 0) header_lines++;
+        else data_lines++;
+    }
+    EXPECT_EQ(1, header_lines);
+    EXPECT_EQ(10, data_lines);
+
+    SequenceCheckpoint checkpoint(ckpt);
+    ASSERT_TRUE(checkpoint.load());
+    EXPECT_EQ(9u, checkpoint.marks().at(0).sequence);
+
+    std::remove(csv.c_str());
+    std::remove(ckpt.c_str());
+}
+
+// A crash after the rows hit the file but before the checkpoint save leaves
+// an unsaved tail, maybe ending in a torn row. Reopening cuts the torn row
+// and counts the complete ones as persisted.
+TEST(CheckpointTest, CsvSinkRepairsTornRowAndRecoversUnsavedTail) {
+    const std::string csv = "test_torn_log.csv";
+    const std::string ckpt = "test_torn_log.csv.ckpt";
+    std::remove(csv.c_str());
+    std::remove(ckpt.c_str());
+    {
+        CsvSink sink(csv, ckpt);
+        ASSERT_TRUE(sink.open());
+        for (uint64_t seq = 0; seq < 3; ++seq) {
+            sink.write(make_record(0, seq, 1.0, 1000 + seq));
+        }
+        sink.flush();
+        sink.close();
+    }
+    {
+        std::ofstream out(csv, std::ios::app);
+        std::string rows;
+        format_csv_row(make_record(0, 3, 1.0, 1003), rows);
+        format_csv_row(make_record(0, 4, 1.0, 1004), rows);
+        out << rows << "2024-01-01 00:00:00.005,0,1.0";   // torn mid-row
+    }
+
+    SequenceCheckpoint marks(ckpt);
+    EXPECT_TRUE(recover_csv_marks(csv, marks));
+    EXPECT_TRUE(marks.covers(0, 4, 1004));
+
+    CsvSink sink(csv, ckpt);
+    ASSERT_TRUE(sink.open());
+    sink.write(make_record(0, 5, 1.0, 1005));
+    sink.flush();
+    sink.close();
+
+    std::ifstream in(csv);
+    std::string line;
+    std::vector<uint64_t> sequences;
+    LogRecord record;
+    while (std::getline(in, line)) {
+        if (line.rfind("timestamp,", 0) == 0) continue;
+        ASSERT_TRUE(parse_csv_row(line, record)) << line;
+        sequences.push_back(record.sequence);
+    }
+    EXPECT_EQ(sequences, (std::vector<uint64_t>{0, 1, 2, 3, 4, 5}));
+
+    SequenceCheckpoint saved(ckpt);
+    ASSERT_TRUE(saved.load());
+    EXPECT_EQ(5u, saved.marks().at(0).sequence);
+    std::remove(csv.c_str());
+    std::remove(ckpt.c_str());
+}
+
+// A checkpoint that outlived its CSV file is rebuilt from what is there
+TEST(CheckpointTest, CheckpointPastEndOfCsvIsRebuilt) {
+    const std::string csv = "test_stale_log.csv";
+    const std::string ckpt = "test_stale_log.csv.ckpt";
+    {
+        CsvSink sink(csv, ckpt);
+        ASSERT_TRUE(sink.open());
+        sink.write(make_record(0, 9, 1.0, 1009));
+        sink.flush();
+        sink.close();
+    }
+    std::remove(csv.c_str());
+
+    SequenceCheckpoint marks(ckpt);
+    EXPECT_FALSE(recover_csv_marks(csv, marks));
+    EXPECT_TRUE(marks.empty());
+    EXPECT_EQ(0u, marks.data_offset());
+    std::remove(ckpt.c_str());
+}
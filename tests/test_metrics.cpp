@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "../src/core/metrics.h"
+
+using namespace telemetry;
+
+TEST(MetricsTest, BucketLowerBoundsBracketValues) {
+    size_t previous = 0;
+    for (uint64_t v : {0ull, 1ull, 7ull, 8ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        size_t bucket = histogram_bucket(v);
+        ASSERT_LT(bucket, HISTOGRAM_BUCKETS);
+        EXPECT_GE(bucket, previous);
+        EXPECT_LE(histogram_bucket_lower(bucket), v);
+        // Relative bucket width is bounded by 1/8
+        EXPECT_GE(histogram_bucket_lower(bucket), v - v / 8);
+        previous = bucket;
+    }
+    for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        EXPECT_EQ(b, histogram_bucket(histogram_bucket_lower(b)));
+    }
+}
+
+TEST(MetricsTest, CountersAggregateAcrossThreads) {
+    MetricsRegistry registry;
+    Counter counter = registry.counter("test.events");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([counter] {
+            for (int i = 0; i < 10000; ++i) {
+                counter.add();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    counter.add(5);
+
+    // Exited threads still count
+    EXPECT_EQ(40005u, registry.snapshot().counters.at("test.events"));
+}
+
+TEST(MetricsTest, SameNameSameMetric) {
+    MetricsRegistry registry;
+    registry.counter("a").add(2);
+    registry.counter("a").add(3);
+    registry.gauge("depth").set(7);
+    registry.gauge("depth").set(4);
+
+    MetricsSnapshot snap = registry.snapshot();
+    EXPECT_EQ(5u, snap.counters.at("a"));
+    EXPECT_EQ(4, snap.gauges.at("depth"));
+}
+
+TEST(MetricsTest, RegistriesAreIndependent) {
+    MetricsRegistry first;
+    MetricsRegistry second;
+    Counter a = first.counter("x");
+    Counter b = second.counter("x");
+    a.add(1);
+    b.add(10);
+    a.add(1);
+    EXPECT_EQ(2u, first.snapshot().counters.at("x"));
+    EXPECT_EQ(10u, second.snapshot().counters.at("x"));
+}
+
+TEST(MetricsTest, HistogramPercentiles) {
+    MetricsRegistry registry;
+    Histogram h = registry.histogram("latency");
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        h.record(v);
+    }
+
+    HistogramSnapshot snap = registry.snapshot().histograms.at("latency");
+    EXPECT_EQ(1000u, snap.count);
+    EXPECT_EQ(500500u, snap.sum);
+    EXPECT_EQ(1000u, snap.max);
+    EXPECT_DOUBLE_EQ(500.5, snap.mean());
+    EXPECT_NEAR(500.0, static_cast<double>(snap.percentile(50)), 500.0 / 8);
+    EXPECT_NEAR(990.0, static_cast<double>(snap.percentile(99)), 990.0 / 8);
+    EXPECT_LE(snap.percentile(100), 1000u);
+    EXPECT_GE(snap.percentile(100), 1000u - 1000u / 8);
+}
+
+TEST(MetricsTest, FormatListsEveryMetric) {
+    MetricsRegistry registry;
+    registry.counter("c").add();
+    registry.gauge("g").set(-3);
+    registry.histogram("h").record(42);
+    registry.histogram("empty");
+
+    std::string text = format_metrics(registry.snapshot());
+    EXPECT_NE(std::string::npos, text.find("  c 1\n"));
+    EXPECT_NE(std::string::npos, text.find("  g -3\n"));
+    EXPECT_NE(std::string::npos, text.find("  h count=1 mean=42"));
+    EXPECT_NE(std::string::npos, text.find("  empty count=0\n"));
+}
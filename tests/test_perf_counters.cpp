@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "../src/core/perf_counters.h"
+
+using namespace telemetry;
+
+namespace {
+
+// Enough work that even coarse counters move
+uint64_t busy_loop(uint64_t n) {
+    volatile uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        sum = sum + i * 2654435761ULL;
+    }
+    return sum;
+}
+
+} // namespace
+
+// Must hold whether or not this machine permits perf events
+TEST(PerfCountersTest, ReadsAreMonotonicOrZeroWhenUnavailable) {
+    PerfCounters counters;
+    PerfSample before = counters.read();
+    busy_loop(1000000);
+    PerfSample after = counters.read();
+
+    if (!counters.available()) {
+        EXPECT_EQ(after.cycles, 0u);
+        EXPECT_EQ(after.instructions, 0u);
+        GTEST_SKIP() << "perf events not permitted here";
+    }
+    EXPECT_GT(after.cycles, before.cycles);
+    if (counters.has(PerfCounters::Instructions)) {
+        // At least one instruction per iteration
+        EXPECT_GE(after.instructions - before.instructions, 1000000u);
+    }
+}
+
+TEST(PerfRegionTest, AveragesOverIterations) {
+    PerfRegion region("loop");
+    for (int i = 0; i < 10; ++i) {
+        PerfScope scope(region);
+        busy_loop(10000);
+    }
+    {
+        PerfScope disabled(nullptr);   // not counted
+        busy_loop(10000);
+    }
+
+    std::string summary = region.summary();
+    EXPECT_EQ(summary.rfind("loop: ", 0), 0u) << summary;
+    if (!region.available()) {
+        EXPECT_NE(summary.find("unavailable"), std::string::npos);
+        GTEST_SKIP() << "perf events not permitted here";
+    }
+    EXPECT_EQ(region.iterations(), 10u);
+    EXPECT_GT(region.totals().cycles, 0u);
+    EXPECT_NE(summary.find("(10 iterations)"), std::string::npos) << summary;
+}
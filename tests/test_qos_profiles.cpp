@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "../src/core/dds_bootstrap.h"
+
+using namespace telemetry;
+
+TEST(QosProfileTest, NamesRoundTrip) {
+    for (QosProfile p : {QosProfile::Default, QosProfile::LowLatency,
+                         QosProfile::HighThroughput, QosProfile::LosslessLogging}) {
+        QosProfile parsed;
+        ASSERT_TRUE(parse_qos_profile(qos_profile_name(p), parsed));
+        EXPECT_EQ(p, parsed);
+    }
+
+    QosProfile unchanged = QosProfile::LowLatency;
+    EXPECT_FALSE(parse_qos_profile("fastest", unchanged));
+    EXPECT_EQ(QosProfile::LowLatency, unchanged);
+}
+
+TEST(QosProfileTest, DefaultKeepsOriginalSettings) {
+    QosSettings s = qos_settings(QosProfile::Default);
+    EXPECT_EQ(DDS_RELIABILITY_RELIABLE, s.reliability);
+    EXPECT_EQ(DDS_HISTORY_KEEP_LAST, s.history);
+    EXPECT_EQ(100, s.history_depth);
+    EXPECT_FALSE(s.writer_batching);
+}
+
+TEST(QosProfileTest, ThroughputProfilesAreBoundedKeepAll) {
+    for (QosProfile p : {QosProfile::HighThroughput, QosProfile::LosslessLogging}) {
+        QosSettings s = qos_settings(p);
+        EXPECT_EQ(DDS_RELIABILITY_RELIABLE, s.reliability);
+        EXPECT_EQ(DDS_HISTORY_KEEP_ALL, s.history);
+        EXPECT_GT(s.max_samples, 0);
+        EXPECT_TRUE(s.writer_batching);
+    }
+    EXPECT_EQ(DDS_RELIABILITY_BEST_EFFORT, qos_settings(QosProfile::LowLatency).reliability);
+}
+
+TEST(SensorTopicTest, PerTypeTopicNames) {
+    EXPECT_EQ("lab_telemetry/temperature", sensor_topic_name("temperature"));
+    EXPECT_TRUE(is_valid_sensor_type("relative_humidity_2"));
+    for (const char* bad : {"", "Temperature", "temp-c", "a/b", "a b"}) {
+        EXPECT_FALSE(is_valid_sensor_type(bad)) << bad;
+    }
+}
+
+TEST(ShardingTest, DomainIdsAreBoundedDecimals) {
+    dds_domainid_t domain = 5;
+    EXPECT_TRUE(parse_domain_id("0", domain));
+    EXPECT_EQ(0u, domain);
+    EXPECT_TRUE(parse_domain_id("232", domain));
+    EXPECT_EQ(232u, domain);
+    for (const char* bad : {"", "233", "-1", "1x", "0x10", "99999999999"}) {
+        EXPECT_FALSE(parse_domain_id(bad, domain)) << bad;
+    }
+    EXPECT_EQ(232u, domain);
+}
+
+TEST(ShardingTest, PartitionPatternsAndLabels) {
+    EXPECT_TRUE(is_partition_pattern("site-a/*"));
+    EXPECT_TRUE(is_partition_pattern("line-?"));
+    EXPECT_FALSE(is_partition_pattern("site-a/line-1"));
+
+    EXPECT_EQ("default partition", partition_label({}));
+    EXPECT_EQ("partition site-a", partition_label({"site-a"}));
+    EXPECT_EQ("partitions a, b", partition_label({"a", "b"}));
+    EXPECT_EQ("domain 3", domain_label(3));
+    EXPECT_EQ("default domain", domain_label(DDS_DOMAIN_DEFAULT));
+}
+
+TEST(ShardingTest, PartitionMatchingFollowsWildcards) {
+    EXPECT_TRUE(partitions_match({"site-a/*"}, {"site-a/line-1"}));
+    EXPECT_TRUE(partitions_match({"site-b", "site-a/line-?"}, {"site-a/line-2"}));
+    EXPECT_FALSE(partitions_match({"site-a/*"}, {"site-b/line-1"}));
+    EXPECT_FALSE(partitions_match({"site-a"}, {}));
+    EXPECT_TRUE(partitions_match({}, {}));
+    EXPECT_TRUE(partitions_match({"*"}, {"anything", "else"}));
+}
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <chrono>
 #include <thread>
 #include <vector>
 #include "../src/core/thread_safe_queue.h"
@@ -65,4 +66,22 @@ TEST(ThreadSafeQueueTest, StopSignal) {
     EXPECT_TRUE(queue.pop(value));  // Should get 1
     EXPECT_TRUE(queue.pop(value));  // Should get 2
     EXPECT_FALSE(queue.pop(value)); // Should return false (stopped)
+}
+
+TEST(ThreadSafeQueueTest, TimedPopReturnsOnTimeoutDataAndStop) {
+    ThreadSafeQueue<int> queue;
+    int value = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pop_for(value, std::chrono::milliseconds(20)));  // Timed out
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    queue.push(7);
+    EXPECT_TRUE(queue.pop_for(value, std::chrono::milliseconds(20)));
+    EXPECT_EQ(7, value);
+
+    queue.stop();
+    start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pop_for(value, std::chrono::seconds(10)));      // Stopped, no wait
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/core/transport.h"
+#include "../src/apps/components.h"
+
+using namespace telemetry;
+using namespace std::chrono_literals;
+
+namespace {
+
+void write_config(const std::string& path, const std::string& sensors) {
+    std::ofstream out(path, std::ios::trunc);
+    out << "{\"sensors\": [" << sensors << "]}";
+}
+
+// Samples taken from `subscriber` within `window`
+size_t count_samples(InProcessSubscriber& subscriber, std::chrono::milliseconds window) {
+    size_t count = 0;
+    ReceivedMessage message;
+    auto deadline = std::chrono::steady_clock::now() + window;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (subscriber.take(message)) {
+            count++;
+        } else {
+            std::this_thread::sleep_for(5ms);
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+// A reload may remove every sensor. The hub has nothing to publish then, but
+// must still pick up the next reload and honour --duration.
+TEST(SensorHubTest, ReloadsDownToNoSensorsAndBackUp) {
+    const std::string path = "test_sensor_hub_config.json";
+    const std::string sensor = R"({"id": 7, "name": "Temperature", "min": 20, "max": 30, "rate_hz": 50})";
+    write_config(path, sensor);
+
+    InProcessSubscriber subscriber(inprocess_bus(), "test.hub", OverflowPolicy::DropOldest);
+    auto hub = std::async(std::launch::async, [&path] {
+        std::vector<std::string> args = {"sensor_hub", "--transport", "inproc", "--config", path,
+                                         "--duration", "3", "--no-control"};
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        return sensor_hub_main(static_cast<int>(args.size()), argv.data());
+    });
+
+    EXPECT_GT(count_samples(subscriber, 500ms), 0u);
+
+    write_config(path, "");
+    std::raise(SIGHUP);
+    count_samples(subscriber, 300ms);   // in flight when the sensor paused
+    EXPECT_EQ(count_samples(subscriber, 300ms), 0u);
+
+    write_config(path, sensor);
+    std::raise(SIGHUP);
+    EXPECT_GT(count_samples(subscriber, 500ms), 0u);
+
+    // --duration still ends the run with nothing left to publish
+    write_config(path, "");
+    std::raise(SIGHUP);
+    if (hub.wait_for(10s) != std::future_status::ready) {
+        sensor_hub_stop();
+        ADD_FAILURE() << "hub did not stop after --duration";
+    }
+    EXPECT_EQ(hub.get(), 0);
+    std::remove(path.c_str());
+}
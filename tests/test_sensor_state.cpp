@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "../src/core/sensor_state.h"
+
+using namespace telemetry;
+
+TEST(SequenceWindowTest, RejectsRepeatsAndAcceptsLateArrivals) {
+    SequenceWindow window;
+    EXPECT_TRUE(window.mark(100));
+    EXPECT_FALSE(window.mark(100));
+    EXPECT_TRUE(window.mark(103));      // 101 and 102 missing for now
+    EXPECT_EQ(104u, window.next());
+    EXPECT_TRUE(window.mark(101));      // late, not a duplicate
+    EXPECT_FALSE(window.mark(101));
+    EXPECT_TRUE(window.mark(99));       // older than the first, still in the window
+    EXPECT_FALSE(window.mark(103));
+}
+
+// The window slides with the head: slots reused for new sequences start
+// unseen, and sequences that fell out of it count as seen
+TEST(SequenceWindowTest, SlidesForwardWithoutGrowing) {
+    SequenceWindow window;
+    const uint64_t W = SequenceWindow::WINDOW;
+    for (uint64_t seq = 0; seq < 10 * W; seq += 2) {
+        ASSERT_TRUE(window.mark(seq));
+    }
+    uint64_t head = window.next();                // odd sequences never sent
+    EXPECT_TRUE(window.mark(head - W));           // oldest slot in the window
+    EXPECT_FALSE(window.mark(head - W - 2));      // just outside
+    EXPECT_FALSE(window.mark(3));                 // long gone
+
+    // A jump of more than the window clears it
+    EXPECT_TRUE(window.mark(head + 5 * W));
+    EXPECT_TRUE(window.mark(head + 5 * W - 2));
+    EXPECT_FALSE(window.mark(head + 5 * W - 2));
+}
+
+TEST(SensorStateTest, CountsGapsAndSkipsDuplicates) {
+    SensorState state;
+    EXPECT_TRUE(state.ingest(1.0, 1000, 10, 5));
+    EXPECT_TRUE(state.ingest(3.0, 1001, 13, 6));   // 11, 12 dropped
+    EXPECT_FALSE(state.ingest(9.0, 1001, 13, 7));
+    EXPECT_TRUE(state.ingest(2.0, 1002, 11, 8));   // late: stats, not current
+    EXPECT_EQ(14u, state.expected_seq);
+    EXPECT_EQ(3u, state.message_count);
+    EXPECT_EQ(2u, state.dropped_count);
+    EXPECT_DOUBLE_EQ(3.0, state.current_value);
+    EXPECT_DOUBLE_EQ(1.0, state.min_value);
+    EXPECT_DOUBLE_EQ(3.0, state.max_value);
+    EXPECT_DOUBLE_EQ(6.0, state.sum_value);
+    EXPECT_EQ(8u, state.last_received_ms);
+}
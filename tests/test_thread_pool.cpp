@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "../src/core/thread_pool.h"
+#include "../src/core/work_stealing_deque.h"
+
+using namespace telemetry;
+
+// ========== WorkStealingDeque ==========
+
+TEST(WorkStealingDequeTest, OwnerPopsLifoThievesStealFifo) {
+    WorkStealingDeque<int*> deque(4);
+    int values[3] = {0, 1, 2};
+    for (int& v : values) {
+        deque.push(&v);
+    }
+
+    int* item = nullptr;
+    ASSERT_TRUE(deque.steal(item));
+    EXPECT_EQ(item, &values[0]);
+    ASSERT_TRUE(deque.pop(item));
+    EXPECT_EQ(item, &values[2]);
+    ASSERT_TRUE(deque.pop(item));
+    EXPECT_EQ(item, &values[1]);
+    EXPECT_FALSE(deque.pop(item));
+    EXPECT_FALSE(deque.steal(item));
+}
+
+TEST(WorkStealingDequeTest, GrowsPastInitialCapacity) {
+    WorkStealingDeque<intptr_t> deque(2);
+    for (intptr_t i = 1; i <= 1000; ++i) {
+        deque.push(i);
+    }
+    EXPECT_GE(deque.capacity(), 1000u);
+    EXPECT_EQ(deque.size(), 1000u);
+
+    intptr_t item = 0;
+    for (intptr_t expected = 1000; expected >= 1; --expected) {
+        ASSERT_TRUE(deque.pop(item));
+        EXPECT_EQ(item, expected);
+    }
+}
+
+// Owner pushes (growing the ring as it goes) and pops while thieves steal;
+// every item must be taken exactly once.
+TEST(WorkStealingDequeTest, ConcurrentStealsTakeEachItemOnce) {
+    constexpr intptr_t ITEMS = 200000;
+    constexpr int THIEVES = 3;
+    WorkStealingDeque<intptr_t> deque(8);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    std::atomic<bool> producing{true};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < THIEVES; ++t) {
+        thieves.emplace_back([&] {
+            intptr_t item;
+            while (producing || deque.size() > 0) {
+                if (deque.steal(item)) {
+                    taken[static_cast<size_t>(item)]++;
+                }
+            }
+        });
+    }
+
+    intptr_t item;
+    for (intptr_t i = 0; i < ITEMS; ++i) {
+        deque.push(i);
+        if (i % 3 == 0 && deque.pop(item)) {
+            taken[static_cast<size_t>(item)]++;
+        }
+    }
+    while (deque.pop(item)) {
+        taken[static_cast<size_t>(item)]++;
+    }
+    producing = false;
+    for (auto& t : thieves) {
+        t.join();
+    }
+
+    for (intptr_t i = 0; i < ITEMS; ++i) {
+        ASSERT_EQ(taken[static_cast<size_t>(i)].load(), 1) << "item " << i;
+    }
+}
+
+// ========== ThreadPool ==========
+
+TEST(ThreadPoolTest, RunsEverySubmittedTask) {
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(4, "test");
+        EXPECT_EQ(pool.size(), 4u);
+        for (int i = 0; i < 1000; ++i) {
+            pool.submit([&count] { count++; }, i % 7);
+        }
+        pool.run_until([&count] { return count.load() == 1000; });
+    }
+    EXPECT_EQ(count.load(), 1000);
+}
+
+TEST(ThreadPoolTest, DestructorDrainsQueuedTasks) {
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(2, "test");
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&count] {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                count++;
+            });
+        }
+    }
+    EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPoolTest, TasksSpawnedByWorkersRunAndGetStolen) {
+    ThreadPool pool(4, "test");
+    std::atomic<int> leaves{0};
+    std::atomic<int> worker_seen{-2};
+
+    // One task fans out 64 children onto its own deque; the idle workers
+    // have to steal them
+    pool.submit([&] {
+        worker_seen = pool.current_worker();
+        for (int i = 0; i < 64; ++i) {
+            pool.submit([&leaves] {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                leaves++;
+            });
+        }
+    }, 0);
+    // Wait without helping, so only workers run tasks (a task is counted
+    // as executed just after it returns)
+    while (leaves.load() < 64 || pool.stats().executed < 65) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_GE(worker_seen.load(), 0);
+    EXPECT_EQ(pool.current_worker(), -1);
+    ThreadPool::Stats stats = pool.stats();
+    EXPECT_EQ(stats.executed, 65u);
+    EXPECT_EQ(stats.helped, 0u);
+}
+
+// ========== parallel_for ==========
+
+TEST(ParallelForTest, CoversRangeExactlyOnce) {
+    ThreadPool pool(4, "test");
+    std::vector<std::atomic<int>> hits(100003);
+    parallel_for(pool, 0, hits.size(), 1000, [&](size_t lo, size_t hi) {
+        EXPECT_LE(hi - lo, 1000u);
+        for (size_t i = lo; i < hi; ++i) {
+            hits[i]++;
+        }
+    });
+    for (size_t i = 0; i < hits.size(); ++i) {
+        ASSERT_EQ(hits[i].load(), 1) << "index " << i;
+    }
+}
+
+TEST(ParallelForTest, SumsMatchSequential) {
+    ThreadPool pool(3, "test");
+    std::vector<double> values(1 << 20);
+    std::iota(values.begin(), values.end(), 0.0);
+    std::vector<double> partial(values.size(), 0.0);
+
+    parallel_for(pool, 0, values.size(), 0, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            partial[i] = values[i] * 2.0;
+        }
+    });
+    double expected = std::accumulate(values.begin(), values.end(), 0.0) * 2.0;
+    EXPECT_DOUBLE_EQ(std::accumulate(partial.begin(), partial.end(), 0.0), expected);
+}
+
+TEST(ParallelForTest, NestedLoopsOnWorkersDoNotDeadlock) {
+    ThreadPool pool(2, "test");
+    std::atomic<size_t> total{0};
+    parallel_for(pool, 0, 8, 1, [&](size_t lo, size_t hi) {
+        for (size_t outer = lo; outer < hi; ++outer) {
+            parallel_for(pool, 0, 1000, 10, [&](size_t a, size_t b) { total += b - a; });
+        }
+    });
+    EXPECT_EQ(total.load(), 8000u);
+}
+
+TEST(ParallelForTest, RethrowsFirstException) {
+    ThreadPool pool(2, "test");
+    std::atomic<size_t> covered{0};
+    EXPECT_THROW(
+        parallel_for(pool, 0, 100, 10, [&](size_t lo, size_t hi) {
+            covered += hi - lo;
+            if (lo == 50) throw std::runtime_error("bad chunk");
+        }),
+        std::runtime_error);
+    EXPECT_EQ(covered.load(), 100u);   // the other chunks still ran
+}
+
+TEST(ParallelForTest, SmallRangesRunInline) {
+    std::thread::id caller = std::this_thread::get_id();
+    std::thread::id ran_on;
+    parallel_for(thread_pool(), 0, 10, 100, [&](size_t, size_t) { ran_on = std::this_thread::get_id(); });
+    EXPECT_EQ(ran_on, caller);
+}
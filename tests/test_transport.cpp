@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "telemetry.h"
+#include "../src/core/config.h"
+#include "../src/core/dds_health.h"
+#include "../src/core/transport.h"
+
+using namespace telemetry;
+
+namespace {
+
+TelemetrySample sample(int id, uint64_t sequence) {
+    TelemetrySample s;
+    s.data = {id, 20.0 + id, 1700000000000L + static_cast<long>(sequence)};
+    s.sequence = sequence;
+    return s;
+}
+
+// Valid samples taken from `reader` (loaned, returned straight away)
+size_t take_all(dds_entity_t reader) {
+    size_t taken = 0;
+    void* samples[1] = {nullptr};
+    dds_sample_info_t info;
+    while (dds_take(reader, samples, &info, 1, 1) > 0) {
+        if (info.valid_data) {
+            taken++;
+        }
+        dds_return_loan(reader, samples, 1);
+        samples[0] = nullptr;
+    }
+    return taken;
+}
+
+// Publishes `sample` until `reader` has it, so discovery timing doesn't matter
+bool publish_until_taken(DdsPublisher& publisher, const TelemetrySample& sample, dds_entity_t reader) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        char payload[] = "{\"id\":5,\"sequence\":0,\"timestamp\":1,\"value\":1.0}";
+        publisher.publish(sample, payload, sizeof(payload) - 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (take_all(reader) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+TEST(TransportTest, ParsesTransportNames) {
+    Transport transport;
+    for (Transport t : {Transport::Dds, Transport::Udp, Transport::InProcess}) {
+        ASSERT_TRUE(parse_transport(transport_name(t), transport));
+        EXPECT_EQ(transport, t);
+    }
+    EXPECT_FALSE(parse_transport("shm", transport));
+    EXPECT_FALSE(parse_transport("", transport));
+}
+
+// Every subscriber gets every sample, decoded, and the publisher never asks
+// for an encoded payload
+TEST(TransportTest, InProcessFansOutDecodedSamples) {
+    InProcessBus bus;
+    InProcessSubscriber monitor(bus, "test.monitor", OverflowPolicy::DropOldest);
+    InProcessSubscriber logger(bus, "test.logger", OverflowPolicy::Block);
+    EXPECT_EQ(bus.subscribers(), 2u);
+
+    InProcessPublisher publisher(bus);
+    EXPECT_FALSE(publisher.wants_payload());
+    for (uint64_t seq = 0; seq < 10; ++seq) {
+        TelemetrySample s = sample(static_cast<int>(seq % 3), seq);
+        s.stamps.present = seq == 4;
+        s.stamps.sampled_us = 42;
+        ASSERT_EQ(publisher.publish(s, nullptr, 0), DDS_RETCODE_OK);
+    }
+    EXPECT_EQ(bus.pending(), 20u);
+
+    for (TelemetrySubscriber* subscriber : {static_cast<TelemetrySubscriber*>(&monitor),
+                                            static_cast<TelemetrySubscriber*>(&logger)}) {
+        ReceivedMessage message;
+        for (uint64_t seq = 0; seq < 10; ++seq) {
+            ASSERT_TRUE(subscriber->take(message));
+            EXPECT_TRUE(message.decoded);
+            EXPECT_EQ(message.payload, nullptr);
+            EXPECT_EQ(message.sample.sequence, seq);
+            EXPECT_EQ(message.sample.data.id, static_cast<int>(seq % 3));
+            EXPECT_EQ(message.sample.stamps.present, seq == 4);
+        }
+        EXPECT_FALSE(subscriber->take(message));
+    }
+    EXPECT_EQ(bus.pending(), 0u);
+}
+
+TEST(TransportTest, DropOldestSubscriberKeepsTheNewestSamples) {
+    InProcessBus bus;
+    InProcessSubscriber dashboard(bus, "test.dashboard", OverflowPolicy::DropOldest, 4);
+    for (uint64_t seq = 0; seq < 10; ++seq) {
+        bus.publish(sample(0, seq));
+    }
+    ReceivedMessage message;
+    for (uint64_t seq = 6; seq < 10; ++seq) {
+        ASSERT_TRUE(dashboard.take(message));
+        EXPECT_EQ(message.sample.sequence, seq);
+    }
+    EXPECT_FALSE(dashboard.take(message));
+}
+
+// A publisher blocked on a full queue carries on once that subscriber leaves
+TEST(TransportTest, UnsubscribeReleasesBlockedPublisher) {
+    InProcessBus bus;
+    auto logger = std::make_unique<InProcessSubscriber>(bus, "test.slow", OverflowPolicy::Block, 2);
+    std::atomic<int> published{0};
+    std::thread hub([&] {
+        for (uint64_t seq = 0; seq < 5; ++seq) {
+            bus.publish(sample(1, seq));
+            published++;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(published.load(), 2);
+    logger.reset();
+    hub.join();
+    EXPECT_EQ(published.load(), 5);
+    EXPECT_EQ(bus.subscribers(), 0u);
+}
+
+// The wire transports hand back the encoded message for the caller to parse
+TEST(TransportTest, UdpSubscriberReturnsEncodedPayloads) {
+    UdpReceiver receiver;
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_TRUE(receiver.open(address, "test.transport.udp"));
+    UdpSender sender;
+    ASSERT_TRUE(sender.open({receiver.local_address()}, UdpSenderOptions{}, "test.transport.udp.out"));
+
+    UdpPublisher publisher(sender);
+    EXPECT_TRUE(publisher.wants_payload());
+    TelemetrySample s = sample(2, 7);
+    char payload[MAX_SENSOR_MESSAGE];
+    size_t len = encode_sensor_message(payload, sizeof(payload), s.data, s.sequence);
+    ASSERT_EQ(publisher.publish(s, payload, len), DDS_RETCODE_OK);
+    publisher.flush();
+
+    UdpSubscriber subscriber(receiver);
+    ReceivedMessage message;
+    ASSERT_TRUE(receiver.wait(1000));
+    ASSERT_TRUE(subscriber.take(message));
+    EXPECT_FALSE(message.decoded);
+    ASSERT_EQ(std::string(message.payload, message.len), std::string(payload, len));
+    SensorData data;
+    uint64_t sequence;
+    ASSERT_TRUE(parse_sensor_message(message.payload, data, sequence));
+    EXPECT_EQ(sequence, 7u);
+    EXPECT_EQ(data.id, 2);
+}
+
+// A reload that moves a sensor to another type must move its samples to
+// that type's topic, not keep the writer cached for the old one
+TEST(TransportTest, PerTypeWriterFollowsTypeChangeOnReload) {
+    TelemetryConfig config = default_config();
+    config.per_type_topics = true;
+    config.sensors = {{5, "Probe", "", 0.0, 1.0, 10.0, "alpha"}};
+    config_store().publish(config);
+
+    DdsSession dds;
+    ASSERT_TRUE(dds.open(QosProfile::Default, DDS_DOMAIN_DEFAULT, "test_transport"));
+    dds_entity_t alpha = dds.create_reader(dds.sensor_topic("alpha"), QosProfile::Default);
+    dds_entity_t beta = dds.create_reader(dds.sensor_topic("beta"), QosProfile::Default);
+    ASSERT_GT(alpha, 0);
+    ASSERT_GT(beta, 0);
+    DdsHealth health;
+    DdsPublisher publisher(dds, health, "test.dds");
+    ASSERT_TRUE(publisher.open(true));
+
+    EXPECT_TRUE(publish_until_taken(publisher, sample(5, 0), alpha));
+    take_all(beta);
+
+    config.sensors[0].type = "beta";
+    config_store().publish(config);
+    EXPECT_TRUE(publish_until_taken(publisher, sample(5, 1), beta));
+    EXPECT_EQ(take_all(alpha), 0u);
+
+    config_store().publish(default_config());
+    dds.close();
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <string>
+#include <vector>
+#include "../src/core/udp_transport.h"
+
+using namespace telemetry;
+
+namespace {
+
+sockaddr_in loopback_any_port() {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    return addr;
+}
+
+// Everything the receiver has queued, waiting briefly for stragglers
+std::vector<std::string> drain(UdpReceiver& receiver) {
+    std::vector<std::string> out;
+    while (receiver.wait(200)) {
+        const char* payload;
+        size_t len;
+        bool any = false;
+        while (receiver.take(payload, len)) {
+            EXPECT_EQ(payload[len], '\0');
+            out.emplace_back(payload, len);
+            any = true;
+        }
+        if (!any) {
+            break;
+        }
+    }
+    return out;
+}
+
+std::string message(int i) {
+    return R"({"id":)" + std::to_string(i % 3) + R"(,"sequence":)" + std::to_string(i) + "}";
+}
+
+} // namespace
+
+TEST(UdpTransportTest, ParsesAddresses) {
+    sockaddr_in addr{};
+    ASSERT_TRUE(parse_udp_address("127.0.0.1:17401", "0.0.0.0", addr));
+    EXPECT_EQ(format_udp_address(addr), "127.0.0.1:17401");
+    ASSERT_TRUE(parse_udp_address(":17402", "127.0.0.1", addr));
+    EXPECT_EQ(format_udp_address(addr), "127.0.0.1:17402");
+    ASSERT_TRUE(parse_udp_address("17403", "0.0.0.0", addr));
+    EXPECT_EQ(format_udp_address(addr), "0.0.0.0:17403");
+    for (const char* bad : {"", "127.0.0.1:", "127.0.0.1:0", "host:70000", "1.2.3.4:x"}) {
+        EXPECT_FALSE(parse_udp_address(bad, "0.0.0.0", addr)) << bad;
+    }
+}
+
+TEST(UdpTransportTest, RejectsMalformedFrames) {
+    uint8_t frame[64] = {};
+    UdpFrameHeader header;
+    std::vector<std::pair<size_t, size_t>> records;
+    EXPECT_FALSE(decode_udp_frame(frame, sizeof(frame), header, records));   // no magic
+
+    // Valid header claiming one 100-byte record in a 64-byte frame
+    const uint8_t head[] = {0x54, 0x4c, 0x4d, 0x31, 1, 0, 0, 0, 7, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 100, 0};
+    std::copy(std::begin(head), std::end(head), frame);
+    EXPECT_FALSE(decode_udp_frame(frame, sizeof(frame), header, records));
+    frame[20] = 3;
+    ASSERT_TRUE(decode_udp_frame(frame, sizeof(frame), header, records));
+    EXPECT_EQ(header.sender, 1u);
+    EXPECT_EQ(header.sequence, 7u);
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0], std::make_pair(size_t{22}, size_t{3}));
+}
+
+TEST(UdpTransportTest, FrameLossIsCountedPerSender) {
+    FrameLossTracker loss;
+    loss.record(1, 0);
+    loss.record(1, 1);
+    loss.record(1, 4);   // 2, 3 lost
+    loss.record(2, 10);  // first frame from another sender: no loss
+    loss.record(2, 11);
+    loss.record(1, 3);   // late
+    EXPECT_EQ(loss.lost(), 2u);
+    EXPECT_EQ(loss.reordered(), 1u);
+    EXPECT_EQ(loss.senders(), 2u);
+}
+
+// Both send paths deliver every record in order and pack several per frame
+TEST(UdpTransportTest, LoopbackRoundTripWithAndWithoutGso) {
+    for (bool gso : {false, true}) {
+        UdpReceiver receiver;
+        ASSERT_TRUE(receiver.open(loopback_any_port(), "test.udp.in"));
+        UdpSender sender;
+        UdpSenderOptions options;
+        options.gso = gso;
+        options.batch_frames = 4;
+        ASSERT_TRUE(sender.open({receiver.local_address()}, options, "test.udp.out"));
+
+        const int count = 500;
+        for (int i = 0; i < count; ++i) {
+            std::string text = message(i);
+            ASSERT_TRUE(sender.send(text.data(), text.size()));
+        }
+        ASSERT_TRUE(sender.flush());
+
+        std::vector<std::string> received = drain(receiver);
+        ASSERT_EQ(received.size(), static_cast<size_t>(count)) << "gso=" << gso;
+        for (int i = 0; i < count; ++i) {
+            EXPECT_EQ(received[i], message(i));
+        }
+        EXPECT_GT(sender.stats().frames, 1u);
+        EXPECT_LT(sender.stats().frames, static_cast<uint64_t>(count) / 10);
+        EXPECT_LT(sender.stats().syscalls, sender.stats().frames);
+        EXPECT_EQ(sender.stats().send_errors, 0u);
+        EXPECT_EQ(receiver.stats().frames_lost, 0u);
+        EXPECT_EQ(receiver.stats().malformed, 0u);
+    }
+}
+
+TEST(UdpTransportTest, FansOutToEveryTargetAndDropsOversizedRecords) {
+    UdpReceiver a, b;
+    ASSERT_TRUE(a.open(loopback_any_port(), "test.udp.a"));
+    ASSERT_TRUE(b.open(loopback_any_port(), "test.udp.b"));
+    UdpSender sender;
+    UdpSenderOptions options;
+    options.max_datagram = 256;
+    ASSERT_TRUE(sender.open({a.local_address(), b.local_address()}, options, "test.udp.fan"));
+
+    std::string big(300, 'x');
+    EXPECT_FALSE(sender.send(big.data(), big.size()));
+    EXPECT_EQ(sender.stats().oversized, 1u);
+
+    for (int i = 0; i < 50; ++i) {
+        std::string text = message(i);
+        sender.send(text.data(), text.size());
+    }
+    sender.flush();
+    EXPECT_EQ(drain(a).size(), 50u);
+    EXPECT_EQ(drain(b).size(), 50u);
+    EXPECT_EQ(sender.stats().datagrams, 2 * sender.stats().frames);
+}